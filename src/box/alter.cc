@@ -410,13 +410,14 @@ space_def_new_from_tuple(struct tuple *tuple, uint32_t errcode,
 /**
  * Space old and new space triggers (move the original triggers
  * to the new space, or vice versa, restore the original triggers
- * in the old space).
+ * in the old space). Latency statistics go along with them.
  */
 static void
 space_swap_triggers(struct space *new_space, struct space *old_space)
 {
 	rlist_swap(&new_space->on_replace, &old_space->on_replace);
 	rlist_swap(&new_space->on_stmt_begin, &old_space->on_stmt_begin);
+	SWAP(new_space->latency, old_space->latency);
 }
 
 /**
@@ -454,6 +455,12 @@ public:
 	AlterSpaceOp(struct alter_space *alter);
 	struct rlist link;
 	virtual void alter_def(struct alter_space * /* alter */) {}
+	/**
+	 * Build data structures of the new space. Called
+	 * before any changes are made to the old space, so
+	 * it may yield while the old space is in use.
+	 */
+	virtual void prepare(struct alter_space * /* alter */) {}
 	virtual void alter(struct alter_space * /* alter */) {}
 	virtual void commit(struct alter_space * /* alter */,
 			    int64_t /* signature */) {}
@@ -500,11 +507,28 @@ struct alter_space {
 	 * substantially.
 	 */
 	struct key_def *pk_def;
+	/** Number of operations building index data. */
+	int build_count;
 };
 
+/**
+ * Raise an error if an index of the space is being built by
+ * another DDL statement. The build yields and keeps using the
+ * space, so it must neither be replaced nor freed meanwhile.
+ */
+static void
+space_check_build_in_progress_xc(struct space *space)
+{
+	if (space->is_build_in_progress) {
+		tnt_raise(ClientError, ER_ALTER_SPACE, space_name(space),
+			  "an index build is in progress");
+	}
+}
+
 static struct alter_space *
 alter_space_new(struct space *old_space)
 {
+	space_check_build_in_progress_xc(old_space);
 	struct alter_space *alter =
 		region_calloc_object_xc(&fiber()->gc, struct alter_space);
 	rlist_create(&alter->ops);
@@ -624,7 +648,10 @@ alter_space_rollback(struct trigger *trigger, void * /* event */)
  *   of a space or an index, or other accidental property.
  *   If any data structure needs to be built, e.g. a new index,
  *   only this index is built, not the entire space with all its
- *   indexes.
+ *   indexes. The build may yield, the old space stays intact
+ *   and usable meanwhile.
+ * - the rest of the old space is moved to the new one, without
+ *   yields.
  * - at commit, the new space is coalesced with the old one.
  *   On rollback, the new space is deleted.
  */
@@ -654,6 +681,32 @@ alter_space_do(struct txn *txn, struct alter_space *alter)
 	 */
 	space_prepare_alter_xc(alter->old_space, alter->new_space);
 
+	/*
+	 * Build new indexes. Nothing has been changed in the
+	 * old space yet, so there is nothing to undo on failure.
+	 * The build may yield, other DDL on the old space is
+	 * rejected meanwhile. Changes made to the old space while
+	 * the build yields are applied only to the index being
+	 * built, so allow yields only if it is the only one.
+	 */
+	alter->old_space->is_build_in_progress = true;
+	alter->old_space->can_build_online = alter->build_count == 1;
+	try {
+		rlist_foreach_entry(op, &alter->ops, link)
+			op->prepare(alter);
+	} catch (Exception *e) {
+		alter->old_space->is_build_in_progress = false;
+		alter->old_space->can_build_online = false;
+		throw;
+	}
+	alter->old_space->is_build_in_progress = false;
+	alter->old_space->can_build_online = false;
+
+	/*
+	 * Grants and sequence changes made while the build
+	 * yielded are applied to the old space, so copy them
+	 * only now.
+	 */
 	alter->new_space->sequence = alter->old_space->sequence;
 	alter->new_space->truncate_count = alter->old_space->truncate_count;
 	memcpy(alter->new_space->access, alter->old_space->access,
@@ -948,10 +1001,13 @@ public:
 	CreateIndex(struct alter_space *alter)
 		:AlterSpaceOp(alter),
 		 new_index_def(NULL)
-	{}
+	{
+		alter->build_count++;
+	}
 	/** New index index_def. */
 	struct index_def *new_index_def;
 	virtual void alter_def(struct alter_space *alter);
+	virtual void prepare(struct alter_space *alter);
 	virtual void alter(struct alter_space *alter);
 	virtual void commit(struct alter_space *alter, int64_t lsn);
 	virtual ~CreateIndex();
@@ -975,31 +1031,37 @@ CreateIndex::alter_def(struct alter_space *alter)
  * they are fully enabled at all times.
  */
 void
-CreateIndex::alter(struct alter_space *alter)
+CreateIndex::prepare(struct alter_space *alter)
 {
-	if (new_index_def->iid == 0) {
-		/*
-		 * Adding a primary key: bring the space
-		 * up to speed with the current recovery
-		 * state. During snapshot recovery it
-		 * means preparing the primary key for
-		 * build (beginBuild()). During xlog
-		 * recovery, it means building the primary
-		 * key. After recovery, it means building
-		 * all keys.
-		 */
-		space_add_primary_key_xc(alter->new_space);
+	if (new_index_def->iid == 0)
 		return;
-	}
 	/**
 	 * Get the new index and build it.
 	 */
 	struct index *new_index = index_find_xc(alter->new_space,
 						new_index_def->iid);
-	space_build_secondary_key_xc(alter->new_space,
+	space_build_secondary_key_xc(alter->old_space,
 				     alter->new_space, new_index);
 }
 
+void
+CreateIndex::alter(struct alter_space *alter)
+{
+	if (new_index_def->iid != 0)
+		return;
+	/*
+	 * Adding a primary key: bring the space
+	 * up to speed with the current recovery
+	 * state. During snapshot recovery it
+	 * means preparing the primary key for
+	 * build (beginBuild()). During xlog
+	 * recovery, it means building the primary
+	 * key. After recovery, it means building
+	 * all keys.
+	 */
+	space_add_primary_key_xc(alter->new_space);
+}
+
 void
 CreateIndex::commit(struct alter_space *alter, int64_t signature)
 {
@@ -1031,13 +1093,14 @@ public:
 		/* We may want to rebuild secondary keys as well. */
 		if (new_index_def->iid == 0)
 			alter->pk_def = new_index_def->key_def;
+		alter->build_count++;
 	}
 	/** New index index_def. */
 	struct index_def *new_index_def;
 	/** Old index index_def. */
 	struct index_def *old_index_def;
 	virtual void alter_def(struct alter_space *alter);
-	virtual void alter(struct alter_space *alter);
+	virtual void prepare(struct alter_space *alter);
 	virtual void commit(struct alter_space *alter, int64_t signature);
 	virtual ~RebuildIndex();
 };
@@ -1051,14 +1114,13 @@ RebuildIndex::alter_def(struct alter_space *alter)
 }
 
 void
-RebuildIndex::alter(struct alter_space *alter)
+RebuildIndex::prepare(struct alter_space *alter)
 {
 	/* Get the new index and build it.  */
 	struct index *new_index = space_index(alter->new_space,
 					      new_index_def->iid);
 	assert(new_index != NULL);
-	space_build_secondary_key_xc(new_index_def->iid != 0 ?
-				     alter->new_space : alter->old_space,
+	space_build_secondary_key_xc(alter->old_space,
 				     alter->new_space, new_index);
 }
 
@@ -1581,6 +1643,7 @@ on_replace_dd_truncate(struct trigger * /* trigger */, void *event)
 	 * Check if a write privilege was given, raise an error if not.
 	 */
 	access_check_space_xc(old_space, PRIV_W);
+	space_check_build_in_progress_xc(old_space);
 
 	/*
 	 * Truncate counter is updated - truncate the space.
@@ -47,8 +47,25 @@
 #include "xrow_io.h"
 #include "error.h"
 #include "session.h"
+#include "space.h"
+#include "engine.h"
+#include "schema.h"
+#include "txn.h"
+#include "index.h"
+#include "tuple.h"
+#include "tuple_hash.h"
+#include "assoc.h"
 
 double applier_timeout = 1;
+int applier_fiber_count = 1;
+
+enum {
+	/** Max number of rows applied in one batch. */
+	APPLIER_BATCH_MAX = 1024,
+};
+
+/** Period of applier rps recalculation, in seconds. */
+static const double APPLIER_RPS_PERIOD = 1.0;
 
 STRS(applier_state, applier_STATE);
 
@@ -349,6 +366,346 @@ finish:
 	applier_set_state(applier, APPLIER_READY);
 }
 
+/**
+ * Decode the next row if it has already been read into the
+ * input buffer completely. Never yields.
+ *
+ * @retval true  a row was decoded.
+ * @retval false more data has to be read from the socket.
+ */
+static bool
+applier_read_buffered_xrow(struct ibuf *in, struct xrow_header *row)
+{
+	const char *pos = in->rpos;
+	if (pos == in->wpos || mp_typeof(*pos) != MP_UINT ||
+	    mp_check_uint(pos, in->wpos) > 0)
+		return false;
+	uint32_t len = mp_decode_uint(&pos);
+	if (in->wpos - pos < len)
+		return false;
+	xrow_header_decode_xc(row, &pos, pos + len);
+	in->rpos = (char *) pos;
+	return true;
+}
+
+/**
+ * Return the engine of the space modified by a row if the row
+ * may be applied in one transaction with other rows of the same
+ * engine, NULL otherwise. System spaces are never batched,
+ * since DDL is not allowed in a multi-statement transaction.
+ */
+static struct engine *
+applier_batch_engine(struct xrow_header *row)
+{
+	if (!iproto_type_is_dml(row->type) || row->bodycnt != 1)
+		return NULL;
+	const char *data = (const char *) row->body[0].iov_base;
+	if (mp_typeof(*data) != MP_MAP)
+		return NULL;
+	uint32_t size = mp_decode_map(&data);
+	for (uint32_t i = 0; i < size; i++) {
+		if (mp_typeof(*data) != MP_UINT)
+			return NULL;
+		uint64_t key = mp_decode_uint(&data);
+		if (key != IPROTO_SPACE_ID) {
+			mp_next(&data);
+			continue;
+		}
+		if (mp_typeof(*data) != MP_UINT)
+			return NULL;
+		uint64_t space_id = mp_decode_uint(&data);
+		if (space_id <= BOX_SYSTEM_ID_MAX)
+			return NULL;
+		struct space *space = space_by_id(space_id);
+		return space != NULL ? space->engine : NULL;
+	}
+	return NULL;
+}
+
+/**
+ * Look-ahead of a batch of rows. Rows are applied strictly in
+ * order, since WAL must see LSNs of each replica in ascending
+ * order, but most of the time spent applying a row to a vinyl
+ * space goes to reading the old tuple from disk. So before the
+ * batch is applied, several fibers look up the primary keys
+ * modified by its vinyl rows concurrently, warming up the vinyl
+ * caches, and the batch is then applied without waiting for
+ * disk. Every key is looked up once per batch. Memtx rows are
+ * skipped: a memtx lookup never yields.
+ */
+struct applier_prefetch {
+	/** Requests of the batch modifying vinyl spaces. */
+	struct request *requests;
+	/** Number of requests to look up. */
+	int count;
+	/** Index of the next request to look up. */
+	int next;
+	/** Number of fibers still running. */
+	int active;
+	/** (space id, key hash) pairs looked up so far. */
+	struct mh_i64ptr_t *keys;
+	/** Signalled when the last fiber is done. */
+	struct fiber_cond done;
+};
+
+/**
+ * Decode a row of a batch. Return true if it modifies a vinyl
+ * space, so the old tuple is worth looking up in advance.
+ */
+static bool
+applier_prefetch_decode(struct xrow_header *row, struct request *request)
+{
+	if (row->type != IPROTO_INSERT && row->type != IPROTO_REPLACE &&
+	    row->type != IPROTO_UPDATE && row->type != IPROTO_DELETE)
+		return false;
+	if (row->bodycnt != 1)
+		return false;
+	uint64_t key_map = dml_request_key_map(row->type);
+	if (xrow_decode_dml(row, request, key_map) != 0) {
+		/* The error is reported when the row is applied. */
+		diag_clear(diag_get());
+		return false;
+	}
+	if (request->space_id <= BOX_SYSTEM_ID_MAX)
+		return false;
+	struct space *space = space_by_id(request->space_id);
+	return space != NULL && space_is_vinyl(space);
+}
+
+/** Look up the primary key modified by a request. */
+static int
+applier_prefetch_request(struct applier_prefetch *prefetch,
+			 struct request *request)
+{
+	/* The space may have been dropped while we yielded. */
+	struct space *space = space_by_id(request->space_id);
+	struct index *pk = space != NULL ? space_index(space, 0) : NULL;
+	if (pk == NULL)
+		return 0;
+	struct key_def *key_def = pk->def->key_def;
+	const char *key = request->key;
+	if (request->type == IPROTO_INSERT ||
+	    request->type == IPROTO_REPLACE) {
+		key = tuple_extract_key_raw(request->tuple, request->tuple_end,
+					    key_def, NULL);
+		if (key == NULL)
+			return -1;
+	}
+	const char *parts = key;
+	uint32_t part_count = mp_decode_array(&parts);
+	if (exact_key_validate(key_def, parts, part_count) != 0)
+		return -1;
+	const char *key_end = parts;
+	for (uint32_t i = 0; i < part_count; i++)
+		mp_next(&key_end);
+	uint64_t id = (uint64_t)request->space_id << 32 |
+		      key_hash(parts, key_def);
+	struct mh_i64ptr_t *keys = prefetch->keys;
+	if (mh_i64ptr_find(keys, id, NULL) != mh_end(keys))
+		return 0;
+	const struct mh_i64ptr_node_t node = { id, NULL };
+	if (mh_i64ptr_put(keys, &node, NULL, NULL) == mh_end(keys))
+		return 0;
+	struct tuple *unused;
+	return box_index_get(request->space_id, 0, key, key_end, &unused);
+}
+
+static int
+applier_prefetch_f(va_list ap)
+{
+	struct applier_prefetch *prefetch =
+		va_arg(ap, struct applier_prefetch *);
+	while (prefetch->next < prefetch->count) {
+		struct request *request =
+			&prefetch->requests[prefetch->next++];
+		/* The error is reported when the row is applied. */
+		if (applier_prefetch_request(prefetch, request) != 0)
+			diag_clear(diag_get());
+		fiber_gc();
+	}
+	if (--prefetch->active == 0)
+		fiber_cond_signal(&prefetch->done);
+	return 0;
+}
+
+/**
+ * Look up vinyl rows of a batch in applier_fiber_count fibers
+ * and wait until all of them are done.
+ */
+static void
+applier_prefetch_batch(struct xrow_header *rows, int count)
+{
+	if (applier_fiber_count <= 1)
+		return;
+	struct request *requests = (struct request *)
+		region_alloc(&fiber()->gc, sizeof(*requests) * count);
+	if (requests == NULL) {
+		diag_clear(diag_get());
+		return;
+	}
+	int request_count = 0;
+	for (int i = 0; i < count; i++) {
+		if (applier_prefetch_decode(&rows[i],
+					    &requests[request_count]))
+			request_count++;
+	}
+	int fiber_count = MIN(applier_fiber_count, request_count);
+	if (fiber_count <= 1)
+		return;
+	struct applier_prefetch prefetch;
+	prefetch.requests = requests;
+	prefetch.count = request_count;
+	prefetch.next = 0;
+	prefetch.active = 0;
+	prefetch.keys = mh_i64ptr_new();
+	if (prefetch.keys == NULL)
+		return;
+	fiber_cond_create(&prefetch.done);
+	for (int i = 0; i < fiber_count; i++) {
+		struct fiber *f = fiber_new("applier_prefetch",
+					    applier_prefetch_f);
+		if (f == NULL) {
+			diag_clear(diag_get());
+			break;
+		}
+		prefetch.active++;
+		fiber_start(f, &prefetch);
+	}
+	while (prefetch.active > 0)
+		fiber_cond_wait(&prefetch.done);
+	fiber_cond_destroy(&prefetch.done);
+	mh_i64ptr_delete(prefetch.keys);
+}
+
+/**
+ * Apply a single row unless it has already been applied.
+ */
+static void
+applier_apply_row(struct applier *applier, struct xrow_header *row)
+{
+	if (vclock_get(&replicaset_vclock, row->replica_id) < row->lsn) {
+		/**
+		 * Promote the replica set vclock before
+		 * applying the row. If there is an
+		 * exception (conflict) applying the row,
+		 * the row is skipped when the replication
+		 * is resumed.
+		 */
+		vclock_follow(&replicaset_vclock, row->replica_id,
+			      row->lsn);
+		xstream_write_xc(applier->subscribe_stream, row);
+	}
+}
+
+/**
+ * Apply a group of rows in one transaction so that they are
+ * written to WAL at once. If the transaction fails, rows are
+ * reapplied one by one, so that the outcome is the same as if
+ * they were never grouped.
+ */
+static void
+applier_apply_group(struct applier *applier, struct xrow_header *rows,
+		    int count)
+{
+	if (count == 0)
+		return;
+	if (count == 1) {
+		applier_apply_row(applier, rows);
+		return;
+	}
+	if (box_txn_begin() != 0)
+		diag_raise();
+	int i = 0;
+	try {
+		for (; i < count; i++) {
+			struct xrow_header *row = &rows[i];
+			if (vclock_get(&replicaset_vclock,
+				       row->replica_id) >= row->lsn) {
+				/* Mark as applied by another applier. */
+				row->lsn = 0;
+				continue;
+			}
+			vclock_follow(&replicaset_vclock, row->replica_id,
+				      row->lsn);
+			xstream_write_xc(applier->subscribe_stream, row);
+		}
+		if (box_txn_commit() != 0)
+			diag_raise();
+		return;
+	} catch (FiberIsCancelled *e) {
+		txn_rollback();
+		throw;
+	} catch (Exception *e) {
+		txn_rollback();
+	}
+	/*
+	 * Rows up to the failed one have already been promoted
+	 * in the replica set vclock, apply them unconditionally.
+	 */
+	int promoted = MIN(i + 1, count);
+	for (int j = 0; j < promoted; j++) {
+		if (rows[j].lsn != 0)
+			xstream_write_xc(applier->subscribe_stream, &rows[j]);
+	}
+	for (int j = promoted; j < count; j++)
+		applier_apply_row(applier, &rows[j]);
+}
+
+/**
+ * Apply a batch of rows read from the master. Consecutive rows
+ * modifying user spaces of the same engine are applied in one
+ * transaction.
+ */
+static void
+applier_apply_batch(struct applier *applier, struct xrow_header *rows,
+		    int count)
+{
+	int group_start = 0;
+	struct engine *group_engine = NULL;
+	for (int i = 0; i < count; i++) {
+		struct xrow_header *row = &rows[i];
+		if (iproto_type_is_error(row->type) ||
+		    row->replica_id == REPLICA_ID_NIL ||
+		    row->replica_id >= VCLOCK_MAX) {
+			/* Apply preceding rows before raising. */
+			applier_apply_group(applier, rows + group_start,
+					    i - group_start);
+			group_start = i;
+			break;
+		}
+		struct engine *engine = applier_batch_engine(row);
+		if (engine == NULL || engine != group_engine) {
+			if (i > group_start) {
+				applier_apply_group(applier,
+						    rows + group_start,
+						    i - group_start);
+			}
+			group_start = i;
+			group_engine = engine;
+		}
+		if (engine == NULL) {
+			applier_apply_row(applier, row);
+			group_start = i + 1;
+		}
+	}
+	if (group_start == count)
+		return;
+	struct xrow_header *row = &rows[group_start];
+	if (iproto_type_is_error(row->type))
+		xrow_decode_error_xc(row);  /* error */
+	if (row->replica_id == REPLICA_ID_NIL ||
+	    row->replica_id >= VCLOCK_MAX) {
+		/*
+		 * A safety net, this can only occur
+		 * if we're fed a strangely broken xlog.
+		 */
+		tnt_raise(ClientError, ER_UNKNOWN_REPLICA,
+			  int2str(row->replica_id),
+			  tt_uuid_str(&REPLICASET_UUID));
+	}
+	applier_apply_group(applier, row, count - group_start);
+}
+
 /**
  * Execute and process SUBSCRIBE request (follow updates from a master).
  */
@@ -398,37 +755,36 @@ applier_subscribe(struct applier *applier)
 	applier->last_logged_errcode = 0;
 
 	/*
-	 * Process a stream of rows from the binary log.
+	 * Process a stream of rows from the binary log. Wait for
+	 * at least one row, then take all rows which have already
+	 * arrived with it and apply them as a batch.
 	 */
+	applier->rps_period_start = ev_monotonic_now(loop());
+	applier->rps_period_rows = applier->row_count;
 	while (true) {
-		coio_read_xrow(coio, &iobuf->in, &row);
-		applier->lag = ev_now(loop()) - row.tm;
+		struct xrow_header *rows = (struct xrow_header *)
+			region_alloc_xc(&fiber()->gc,
+					sizeof(*rows) * APPLIER_BATCH_MAX);
+		int count = 0;
+		coio_read_xrow(coio, &iobuf->in, &rows[count++]);
+		while (count < APPLIER_BATCH_MAX &&
+		       applier_read_buffered_xrow(&iobuf->in, &rows[count]))
+			count++;
+		applier->lag = ev_now(loop()) - rows[count - 1].tm;
 		applier->last_row_time = ev_monotonic_now(loop());
 
-		if (iproto_type_is_error(row.type))
-			xrow_decode_error_xc(&row);  /* error */
-		/* Replication request. */
-		if (row.replica_id == REPLICA_ID_NIL ||
-		    row.replica_id >= VCLOCK_MAX) {
-			/*
-			 * A safety net, this can only occur
-			 * if we're fed a strangely broken xlog.
-			 */
-			tnt_raise(ClientError, ER_UNKNOWN_REPLICA,
-				  int2str(row.replica_id),
-				  tt_uuid_str(&REPLICASET_UUID));
-		}
-		if (vclock_get(&replicaset_vclock, row.replica_id) < row.lsn) {
-			/**
-			 * Promote the replica set vclock before
-			 * applying the row. If there is an
-			 * exception (conflict) applying the row,
-			 * the row is skipped when the replication
-			 * is resumed.
-			 */
-			vclock_follow(&replicaset_vclock, row.replica_id,
-				      row.lsn);
-			xstream_write_xc(applier->subscribe_stream, &row);
+		applier_prefetch_batch(rows, count);
+		applier_apply_batch(applier, rows, count);
+
+		applier->row_count += count;
+		applier->batch_count++;
+		double period = applier->last_row_time -
+				applier->rps_period_start;
+		if (period >= APPLIER_RPS_PERIOD) {
+			applier->rps = (applier->row_count -
+					applier->rps_period_rows) / period;
+			applier->rps_period_start = applier->last_row_time;
+			applier->rps_period_rows = applier->row_count;
 		}
 		fiber_cond_signal(&applier->writer_cond);
 		iobuf_reset(iobuf);
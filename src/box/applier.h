@@ -47,6 +47,14 @@
 /** Network timeout */
 extern double applier_timeout;
 
+enum { APPLIER_FIBERS_MAX = 128 };
+
+/**
+ * Number of fibers an applier uses to look up vinyl rows of
+ * a batch before applying it, box.cfg.replication_apply_fibers.
+ */
+extern int applier_fiber_count;
+
 struct xstream;
 
 enum { APPLIER_SOURCE_MAXLEN = 1024 }; /* enough to fit URI with passwords */
@@ -84,6 +92,16 @@ struct applier {
 	ev_tstamp last_row_time;
 	/** Number of seconds this replica is behind the remote master */
 	ev_tstamp lag;
+	/** Number of rows applied by this applier. */
+	int64_t row_count;
+	/** Number of batches the rows were applied in. */
+	int64_t batch_count;
+	/** Rows applied per second, averaged over the last period. */
+	double rps;
+	/** Start of the current rps measurement period. */
+	ev_tstamp rps_period_start;
+	/** Value of row_count at the start of the period. */
+	int64_t rps_period_rows;
 	/** The last box_error_code() logged to avoid log flooding */
 	uint32_t last_logged_errcode;
 	/** Remote UUID */
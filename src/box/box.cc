@@ -43,6 +43,7 @@
 #include "relay.h"
 #include "applier.h"
 #include <rmean.h>
+#include "histogram.h"
 #include "main.h"
 #include "tuple.h"
 #include "session.h"
@@ -69,6 +70,7 @@
 #include "gc.h"
 #include "checkpoint.h"
 #include "sql.h"
+#include "sql_stmt_cache.h"
 #include "systemd.h"
 #include "call.h"
 #include "func.h"
@@ -393,6 +395,18 @@ box_check_replication_timeout(void)
 	return timeout;
 }
 
+static int
+box_check_replication_apply_fibers(void)
+{
+	int count = cfg_geti("replication_apply_fibers");
+	if (count < 1 || count > APPLIER_FIBERS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "replication_apply_fibers",
+			  tt_sprintf("the value must be in range [1, %d]",
+				     APPLIER_FIBERS_MAX));
+	}
+	return count;
+}
+
 static enum wal_mode
 box_check_wal_mode(const char *mode_name)
 {
@@ -423,6 +437,66 @@ box_check_checkpoint_count(int checkpoint_count)
 	}
 }
 
+static void
+box_check_memtx_snapshot_threads(int count)
+{
+	if (count < 1 || count > MEMTX_SNAPSHOT_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "memtx_snapshot_threads",
+			  tt_sprintf("the value must be in range [1, %d]",
+				     MEMTX_SNAPSHOT_THREADS_MAX));
+	}
+}
+
+static void
+box_check_sql_cache_size(int64_t size)
+{
+	if (size < 0) {
+		tnt_raise(ClientError, ER_CFG, "sql_cache_size",
+			  "the value must not be negative");
+	}
+}
+
+static void
+box_check_wal_group_commit(double delay, int64_t size)
+{
+	if (delay < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_group_commit_delay",
+			  "the value must not be negative");
+	}
+	if (size < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_group_commit_size",
+			  "the value must not be negative");
+	}
+}
+
+static void
+box_check_vinyl_page_cache(int64_t size)
+{
+	if (size < 0) {
+		tnt_raise(ClientError, ER_CFG, "vinyl_page_cache",
+			  "the value must not be negative");
+	}
+}
+
+static void
+box_check_non_negative(const char *option)
+{
+	if (cfg_getd(option) < 0) {
+		tnt_raise(ClientError, ER_CFG, option,
+			  "the value must not be negative");
+	}
+}
+
+static void
+box_check_iproto_threads(int count)
+{
+	if (count < 1 || count > IPROTO_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "iproto_threads",
+			  tt_sprintf("the value must be in range [1, %d]",
+				     IPROTO_THREADS_MAX));
+	}
+}
+
 static int64_t
 box_check_wal_max_rows(int64_t wal_max_rows)
 {
@@ -453,12 +527,22 @@ box_check_config()
 	box_check_uri(cfg_gets("listen"), "listen");
 	box_check_replication();
 	box_check_replication_timeout();
+	box_check_replication_apply_fibers();
 	box_check_readahead(cfg_geti("readahead"));
 	box_check_checkpoint_count(cfg_geti("checkpoint_count"));
 	box_check_wal_max_rows(cfg_geti64("rows_per_wal"));
 	box_check_wal_max_size(cfg_geti64("wal_max_size"));
 	box_check_wal_mode(cfg_gets("wal_mode"));
+	box_check_wal_group_commit(cfg_getd("wal_group_commit_delay"),
+				   cfg_geti64("wal_group_commit_size"));
 	box_check_memtx_min_tuple_size(cfg_geti64("memtx_min_tuple_size"));
+	box_check_memtx_snapshot_threads(cfg_geti("memtx_snapshot_threads"));
+	box_check_iproto_threads(cfg_geti("iproto_threads"));
+	box_check_sql_cache_size(cfg_geti64("sql_cache_size"));
+	box_check_vinyl_page_cache(cfg_geti64("vinyl_page_cache"));
+	box_check_non_negative("vinyl_dump_rate_limit");
+	box_check_non_negative("vinyl_compact_rate_limit");
+	box_check_non_negative("vinyl_wal_latency_target");
 	if (cfg_geti64("vinyl_page_size") > cfg_geti64("vinyl_range_size"))
 		tnt_raise(ClientError, ER_CFG, "vinyl_page_size",
 			  "can't be greater than vinyl_range_size");
@@ -556,6 +640,12 @@ box_set_replication_timeout(void)
 	replication_cfg_timeout = relay_timeout = applier_timeout = timeout;
 }
 
+void
+box_set_replication_apply_fibers(void)
+{
+	applier_fiber_count = box_check_replication_apply_fibers();
+}
+
 void
 box_bind(void)
 {
@@ -599,6 +689,17 @@ box_set_snap_io_rate_limit(void)
 			cfg_getd("snap_io_rate_limit"));
 }
 
+void
+box_set_memtx_snapshot_threads(void)
+{
+	int count = cfg_geti("memtx_snapshot_threads");
+	box_check_memtx_snapshot_threads(count);
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_snapshot_threads(memtx, count);
+}
+
 void
 box_set_memtx_max_tuple_size(void)
 {
@@ -609,6 +710,23 @@ box_set_memtx_max_tuple_size(void)
 			cfg_geti("memtx_max_tuple_size"));
 }
 
+void
+box_set_sql_cache_size(void)
+{
+	int64_t size = cfg_geti64("sql_cache_size");
+	box_check_sql_cache_size(size);
+	sql_stmt_cache_set_size(size);
+}
+
+void
+box_set_wal_group_commit(void)
+{
+	double delay = cfg_getd("wal_group_commit_delay");
+	int64_t size = cfg_geti64("wal_group_commit_size");
+	box_check_wal_group_commit(delay, size);
+	wal_set_group_commit(delay, size);
+}
+
 void
 box_set_too_long_threshold(void)
 {
@@ -650,6 +768,50 @@ box_set_vinyl_timeout(void)
 	vinyl_engine_set_timeout(vinyl,	cfg_getd("vinyl_timeout"));
 }
 
+void
+box_set_vinyl_page_cache(void)
+{
+	int64_t size = cfg_geti64("vinyl_page_cache");
+	box_check_vinyl_page_cache(size);
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_page_cache(vinyl, size);
+}
+
+void
+box_set_vinyl_dump_rate_limit(void)
+{
+	box_check_non_negative("vinyl_dump_rate_limit");
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_dump_rate_limit(vinyl,
+			cfg_getd("vinyl_dump_rate_limit") * 1024 * 1024);
+}
+
+void
+box_set_vinyl_compact_rate_limit(void)
+{
+	box_check_non_negative("vinyl_compact_rate_limit");
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_compact_rate_limit(vinyl,
+			cfg_getd("vinyl_compact_rate_limit") * 1024 * 1024);
+}
+
+void
+box_set_vinyl_wal_latency_target(void)
+{
+	box_check_non_negative("vinyl_wal_latency_target");
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_wal_latency_target(vinyl,
+			cfg_getd("vinyl_wal_latency_target"));
+}
+
 /* }}} configuration bindings */
 
 /**
@@ -786,7 +948,15 @@ box_process1(struct request *request, box_tuple_t **result)
 		return -1;
 	if (!space->def->opts.temporary && box_check_writable() != 0)
 		return -1;
-	return process_rw(request, space, result);
+	double start = ev_monotonic_time();
+	int rc = process_rw(request, space, result);
+	/* The space may be altered or dropped during WAL write. */
+	space = space_by_id(request->space_id);
+	if (space != NULL) {
+		histogram_collect(space->latency,
+				  (ev_monotonic_time() - start) * 1e6);
+	}
+	return rc;
 }
 
 int
@@ -861,6 +1031,76 @@ box_select(struct port *port, uint32_t space_id, uint32_t index_id,
 	return 0;
 }
 
+int
+box_select_many(struct port *port, uint32_t *found, uint32_t space_id,
+		uint32_t index_id, int iterator, uint32_t limit,
+		const char *keys, const char *keys_end)
+{
+	(void)keys_end;
+
+	rmean_collect(rmean_box, IPROTO_SELECT_MANY, 1);
+
+	if (iterator < 0 || iterator >= iterator_type_MAX) {
+		diag_set(ClientError, ER_ILLEGAL_PARAMS,
+			 "Invalid iterator type");
+		diag_log();
+		return -1;
+	}
+
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		return -1;
+	if (access_check_space(space, PRIV_R) != 0)
+		return -1;
+	struct index *index = index_find(space, index_id);
+	if (index == NULL)
+		return -1;
+
+	enum iterator_type type = (enum iterator_type) iterator;
+	uint32_t key_count = mp_decode_array(&keys);
+
+	struct txn *txn;
+	if (txn_begin_ro_stmt(space, &txn) != 0)
+		return -1;
+
+	for (uint32_t i = 0; i < key_count; i++) {
+		if (mp_typeof(*keys) != MP_ARRAY) {
+			diag_set(ClientError, ER_ILLEGAL_PARAMS,
+				 "keys must be an array of arrays");
+			goto fail;
+		}
+		const char *key = keys;
+		uint32_t part_count = mp_decode_array(&key);
+		if (key_validate(index->def, type, key, part_count))
+			goto fail;
+		struct iterator *it = index_create_iterator(index, type,
+							    key, part_count);
+		if (it == NULL)
+			goto fail;
+		int rc = 0;
+		struct tuple *tuple;
+		found[i] = 0;
+		while (found[i] < limit) {
+			rc = iterator_next(it, &tuple);
+			if (rc != 0 || tuple == NULL)
+				break;
+			rc = port_add_tuple(port, tuple);
+			if (rc != 0)
+				break;
+			found[i]++;
+		}
+		iterator_delete(it);
+		if (rc != 0)
+			goto fail;
+		mp_next(&keys);
+	}
+	txn_commit_ro_stmt(txn);
+	return 0;
+fail:
+	txn_rollback_stmt();
+	return -1;
+}
+
 int
 box_insert(uint32_t space_id, const char *tuple, const char *tuple_end,
 	   box_tuple_t **result)
@@ -1423,6 +1663,7 @@ engine_init()
 				    cfg_getd("slab_alloc_factor"));
 	engine_register((struct engine *)memtx);
 	box_set_memtx_max_tuple_size();
+	box_set_memtx_snapshot_threads();
 
 	struct sysview_engine *sysview = sysview_engine_new_xc();
 	engine_register((struct engine *)sysview);
@@ -1601,7 +1842,7 @@ box_cfg_xc(void)
 	schema_init();
 	replication_init();
 	port_init();
-	iproto_init();
+	iproto_init(cfg_geti("iproto_threads"));
 	wal_thread_start();
 
 	title("loading");
@@ -1609,6 +1850,7 @@ box_cfg_xc(void)
 	box_set_checkpoint_count();
 	box_set_too_long_threshold();
 	box_set_replication_timeout();
+	box_set_replication_apply_fibers();
 	xstream_create(&join_stream, apply_initial_join_row);
 	xstream_create(&subscribe_stream, apply_row);
 
@@ -149,12 +149,20 @@ void box_set_log_format(void);
 void box_set_io_collect_interval(void);
 void box_set_snap_io_rate_limit(void);
 void box_set_too_long_threshold(void);
+void box_set_wal_group_commit(void);
 void box_set_readahead(void);
 void box_set_checkpoint_count(void);
 void box_set_memtx_max_tuple_size(void);
+void box_set_memtx_snapshot_threads(void);
+void box_set_sql_cache_size(void);
 void box_set_vinyl_max_tuple_size(void);
 void box_set_vinyl_timeout(void);
+void box_set_vinyl_page_cache(void);
+void box_set_vinyl_dump_rate_limit(void);
+void box_set_vinyl_compact_rate_limit(void);
+void box_set_vinyl_wal_latency_target(void);
 void box_set_replication_timeout(void);
+void box_set_replication_apply_fibers(void);
 
 extern "C" {
 #endif /* defined(__cplusplus) */
@@ -167,6 +175,18 @@ box_select(struct port *port, uint32_t space_id, uint32_t index_id,
 	   int iterator, uint32_t offset, uint32_t limit,
 	   const char *key, const char *key_end);
 
+/**
+ * Select tuples matching each key of the MsgPack array @a keys.
+ * The tuples are appended to @a port key after key, the number
+ * of tuples found for the i-th key is stored in @a found[i], which
+ * must have room for all the keys. The space, the index and the
+ * access rights are looked up once for the whole batch.
+ */
+int
+box_select_many(struct port *port, uint32_t *found, uint32_t space_id,
+		uint32_t index_id, int iterator, uint32_t limit,
+		const char *keys, const char *keys_end);
+
 /** \cond public */
 
 /*
@@ -33,6 +33,7 @@
 #include "third_party/PMurHash.h"
 #include "error.h"
 #include "diag.h"
+#include "say.h"
 #include <unicode/ucol.h>
 #include <trivia/config.h>
 
@@ -91,6 +92,39 @@ coll_icu_hash(const char *s, size_t s_len, uint32_t *ph, uint32_t *pcarry,
 	return total_size;
 }
 
+/**
+ * Get the first 8 bytes of the collation sort key of a string.
+ * Sort keys are compared with memcmp(), so a big-endian prefix
+ * padded with zeros preserves the collation order.
+ */
+static uint64_t
+coll_icu_hint(const char *s, size_t s_len, struct coll *coll)
+{
+	UCharIterator itr;
+	uiter_setUTF8(&itr, s, s_len);
+	uint8_t buf[sizeof(uint64_t)];
+	uint32_t state[2] = {0, 0};
+	UErrorCode status = U_ZERO_ERROR;
+	int32_t got = ucol_nextSortKeyPart(coll->icu.collator, &itr, state,
+					   buf, sizeof(buf), &status);
+	/*
+	 * There is no hint that would keep the key in order
+	 * among the others, and hints can't fail, so treat
+	 * it like coll_icu_cmp() does: ICU doesn't fail on a
+	 * valid collator.
+	 */
+	if (U_FAILURE(status))
+		panic("failed to get a collation sort key: %s",
+		      u_errorName(status));
+	uint64_t hint = 0;
+	for (int32_t i = 0; i < (int32_t)sizeof(buf); i++) {
+		hint <<= 8;
+		if (i < got)
+			hint |= buf[i];
+	}
+	return hint;
+}
+
 /**
  * Set up ICU collator and init cmp and hash members of collation.
  * @param coll - collation to set up.
@@ -220,6 +254,7 @@ coll_icu_init_cmp(struct coll *coll, const struct coll_def *def)
 
 	coll->cmp = coll_icu_cmp;
 	coll->hash = coll_icu_hash;
+	coll->hint = coll_icu_hint;
 	return 0;
 }
 
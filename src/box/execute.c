@@ -38,6 +38,7 @@
 #include "small/obuf.h"
 #include "diag.h"
 #include "sql.h"
+#include "sql_stmt_cache.h"
 #include "xrow.h"
 #include "schema.h"
 #include "port.h"
@@ -262,12 +263,14 @@ error:
 
 	uint32_t map_size = mp_decode_map(&data);
 	request->sql_text = NULL;
+	request->stmt_id = 0;
 	request->bind = NULL;
 	request->bind_count = 0;
 	request->sync = row->sync;
 	for (uint32_t i = 0; i < map_size; ++i) {
 		uint8_t key = *data;
-		if (key != IPROTO_SQL_BIND && key != IPROTO_SQL_TEXT) {
+		if (key != IPROTO_SQL_BIND && key != IPROTO_SQL_TEXT &&
+		    key != IPROTO_STMT_ID) {
 			mp_check(&data, end);   /* skip the key */
 			mp_check(&data, end);   /* skip the value */
 			continue;
@@ -278,11 +281,23 @@ error:
 		if (key == IPROTO_SQL_BIND) {
 			if (sql_bind_list_decode(request, value, region) != 0)
 				return -1;
+		} else if (key == IPROTO_STMT_ID) {
+			if (mp_typeof(*value) != MP_UINT)
+				goto error;
+			uint64_t id = mp_decode_uint(&value);
+			if (id == 0 || id > UINT32_MAX)
+				goto error;
+			request->stmt_id = id;
 		} else {
 			request->sql_text = value;
 		}
 	}
-	if (request->sql_text == NULL) {
+	/*
+	 * EXECUTE refers to a statement either by SQL text or
+	 * by id returned by PREPARE, PREPARE needs the text.
+	 */
+	if (request->sql_text == NULL &&
+	    (request->stmt_id == 0 || row->type == IPROTO_PREPARE)) {
 		diag_set(ClientError, ER_MISSING_REQUEST_FIELD,
 			 iproto_key_name(IPROTO_SQL_TEXT));
 		return -1;
@@ -639,32 +654,86 @@ err_execute:
 	return -1;
 }
 
-int
-sql_prepare_and_execute(const struct sql_request *request, struct obuf *out,
-			struct region *region)
+/**
+ * Find a statement referenced by the request in the statement
+ * cache, compiling it if necessary. PREPARE fails if the
+ * statement can't be cached, since it has no id then.
+ */
+static struct sql_stmt *
+sql_stmt_by_request(const struct sql_request *request, bool is_prepare)
 {
+	if (sql_get() == NULL) {
+		diag_set(ClientError, ER_LOADING);
+		return NULL;
+	}
+	if (request->sql_text == NULL)
+		return sql_stmt_cache_find(request->stmt_id);
 	const char *sql = request->sql_text;
 	uint32_t len;
 	sql = mp_decode_str(&sql, &len);
-	struct sqlite3_stmt *stmt;
-	sqlite3 *db = sql_get();
-	if (db == NULL) {
-		diag_set(ClientError, ER_LOADING);
+	if (is_prepare)
+		return sql_stmt_cache_prepare(sql, len);
+	return sql_stmt_cache_get(sql, len);
+}
+
+int
+sql_prepare(const struct sql_request *request, struct obuf *out)
+{
+	struct sql_stmt *stmt = sql_stmt_by_request(request, true);
+	if (stmt == NULL)
 		return -1;
+	struct obuf_svp header_svp;
+	if (iproto_prepare_header(out, &header_svp, IPROTO_SQL_HEADER_LEN) != 0)
+		goto error;
+	int keys = 1;
+	int column_count = sqlite3_column_count(stmt->vdbe);
+	if (column_count > 0) {
+		if (sql_get_description(stmt->vdbe, out, column_count) != 0)
+			goto err_body;
+		keys = 2;
 	}
-	if (sqlite3_prepare_v2(db, sql, len, &stmt, NULL) != SQLITE_OK) {
-		diag_set(ClientError, ER_SQL_EXECUTE, sqlite3_errmsg(db));
-		return -1;
+	if (iproto_reply_map_key(out, 2, IPROTO_SQL_INFO) != 0)
+		goto err_body;
+	int bind_count = sqlite3_bind_parameter_count(stmt->vdbe);
+	size_t size = mp_sizeof_uint(IPROTO_STMT_ID) +
+		      mp_sizeof_uint(stmt->id) +
+		      mp_sizeof_uint(IPROTO_SQL_BIND_COUNT) +
+		      mp_sizeof_uint(bind_count);
+	char *pos = (char *) obuf_alloc(out, size);
+	if (pos == NULL) {
+		diag_set(OutOfMemory, size, "obuf_alloc", "pos");
+		goto err_body;
 	}
-	assert(stmt != NULL);
-	if (sql_bind(request, stmt) != 0)
+	pos = mp_encode_uint(pos, IPROTO_STMT_ID);
+	pos = mp_encode_uint(pos, stmt->id);
+	pos = mp_encode_uint(pos, IPROTO_SQL_BIND_COUNT);
+	pos = mp_encode_uint(pos, bind_count);
+	iproto_reply_sql(out, &header_svp, request->sync, schema_version, keys);
+	sql_stmt_cache_release(stmt);
+	return 0;
+err_body:
+	obuf_rollback_to_svp(out, &header_svp);
+error:
+	sql_stmt_cache_release(stmt);
+	return -1;
+}
+
+int
+sql_prepare_and_execute(const struct sql_request *request, struct obuf *out,
+			struct region *region)
+{
+	struct sql_stmt *stmt = sql_stmt_by_request(request, false);
+	if (stmt == NULL)
+		return -1;
+	sqlite3 *db = sql_get();
+	if (sql_bind(request, stmt->vdbe) != 0)
 		goto err_stmt;
-	if (sql_execute_and_encode(db, stmt, out, request->sync,
+	if (sql_execute_and_encode(db, stmt->vdbe, out, request->sync,
 				   region) != 0)
 		goto err_stmt;
-	sqlite3_finalize(stmt);
+	sql_stmt_cache_release(stmt);
 	return 0;
 err_stmt:
-	sqlite3_finalize(stmt);
+	sql_stmt_cache_release(stmt);
 	return -1;
 }
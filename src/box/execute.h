@@ -43,11 +43,13 @@ struct region;
 struct sql_bind;
 struct xrow_header;
 
-/** EXECUTE request. */
+/** EXECUTE or PREPARE request. */
 struct sql_request {
 	uint64_t sync;
-	/** SQL statement text. */
+	/** SQL statement text. NULL if @stmt_id is set. */
 	const char *sql_text;
+	/** Id of a statement returned by PREPARE, or 0. */
+	uint32_t stmt_id;
 	/** Array of parameters. */
 	struct sql_bind *bind;
 	/** Length of the @bind. */
@@ -55,7 +57,7 @@ struct sql_request {
 };
 
 /**
- * Parse the EXECUTE request.
+ * Parse the EXECUTE or PREPARE request.
  * @param row Encoded data.
  * @param[out] request Request to decode to.
  * @param region Allocator.
@@ -69,7 +71,8 @@ xrow_decode_sql(const struct xrow_header *row, struct sql_request *request,
 
 /**
  * Prepare and execute an SQL statement and encode the response in
- * an iproto message.
+ * an iproto message. Compiled statements are reused from the
+ * statement cache.
  * Response structure:
  * +----------------------------------------------+
  * | IPROTO_OK, sync, schema_version   ...        | iproto_header
@@ -107,6 +110,39 @@ int
 sql_prepare_and_execute(const struct sql_request *request, struct obuf *out,
 			struct region *region);
 
+/**
+ * Compile an SQL statement, put it in the statement cache and
+ * encode its description in an iproto message. The statement
+ * id can be passed in IPROTO_STMT_ID of EXECUTE requests
+ * instead of the statement text to skip the text lookup.
+ * Response structure:
+ * +----------------------------------------------+
+ * | IPROTO_OK, sync, schema_version   ...        | iproto_header
+ * +----------------------------------------------+---------------
+ * | Body - a map with one or two keys.           |
+ * |                                              |
+ * | IPROTO_BODY: {                               |
+ * |     IPROTO_METADATA: [                       |
+ * |         {IPROTO_FIELD_NAME: column name1},   |
+ * |         ...                                  | iproto_body
+ * |     ],                                       |
+ * |     IPROTO_SQL_INFO: {                       |
+ * |         IPROTO_STMT_ID: number,              |
+ * |         IPROTO_SQL_BIND_COUNT: number        |
+ * |     }                                        |
+ * | }                                            |
+ * +----------------------------------------------+
+ * IPROTO_METADATA is present only if the statement returns rows.
+ *
+ * @param request IProto request.
+ * @param out Out buffer of the iproto message.
+ *
+ * @retval  0 Success.
+ * @retval -1 Client or memory error.
+ */
+int
+sql_prepare(const struct sql_request *request, struct obuf *out);
+
 #if defined(__cplusplus)
 } /* extern "C" { */
 #include "diag.h"
@@ -496,7 +496,7 @@ index_delete(struct index *index)
 }
 
 int
-index_build(struct index *index, struct index *pk)
+index_build_feed(struct index *index, struct index *pk)
 {
 	ssize_t n_tuples = index_size(pk);
 	if (n_tuples < 0)
@@ -530,9 +530,14 @@ index_build(struct index *index, struct index *pk)
 			break;
 	}
 	iterator_delete(it);
-	if (rc != 0)
-		return -1;
+	return rc != 0 ? -1 : 0;
+}
 
+int
+index_build(struct index *index, struct index *pk)
+{
+	if (index_build_feed(index, pk) != 0)
+		return -1;
 	index_end_build(index);
 	return 0;
 }
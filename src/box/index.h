@@ -447,6 +447,14 @@ index_delete(struct index *index);
 int
 index_build(struct index *index, struct index *pk);
 
+/**
+ * Begin building this index and feed it all tuples of another
+ * index, but don't finish the build: index_end_build() is up
+ * to the caller.
+ */
+int
+index_build_feed(struct index *index, struct index *pk);
+
 static inline void
 index_commit_create(struct index *index, int64_t signature)
 {
@@ -44,6 +44,7 @@ const struct index_opts index_opts_default = {
 	/* .run_count_per_level = */ 2,
 	/* .run_size_ratio      = */ 3.5,
 	/* .bloom_fpr           = */ 0.05,
+	/* .hint                = */ false,
 	/* .lsn                 = */ 0,
 	/* .sql                 = */ NULL,
 };
@@ -58,6 +59,7 @@ const struct opt_def index_opts_reg[] = {
 	OPT_DEF("run_count_per_level", OPT_INT64, struct index_opts, run_count_per_level),
 	OPT_DEF("run_size_ratio", OPT_FLOAT, struct index_opts, run_size_ratio),
 	OPT_DEF("bloom_fpr", OPT_FLOAT, struct index_opts, bloom_fpr),
+	OPT_DEF("hint", OPT_BOOL, struct index_opts, hint),
 	OPT_DEF("lsn", OPT_INT64, struct index_opts, lsn),
 	OPT_DEF("sql", OPT_STRPTR, struct index_opts, sql),
 	OPT_END,
@@ -201,6 +203,7 @@ index_def_change_requires_rebuild(const struct index_def *old_index_def,
 	if (old_index_def->iid != new_index_def->iid ||
 	    old_index_def->type != new_index_def->type ||
 	    old_index_def->opts.is_unique != new_index_def->opts.is_unique ||
+	    old_index_def->opts.hint != new_index_def->opts.hint ||
 	    !key_part_check_compatibility(old_index_def->key_def->parts,
 					  old_index_def->key_def->part_count,
 					  new_index_def->key_def->parts,
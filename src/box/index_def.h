@@ -91,6 +91,12 @@ struct index_opts {
 	double run_size_ratio;
 	/* Bloom filter false positive rate. */
 	double bloom_fpr;
+	/**
+	 * Store a 64-bit key hint along with each tuple in a
+	 * memtx TREE index to reduce the number of full tuple
+	 * comparisons on lookups.
+	 */
+	bool hint;
 	/**
 	 * LSN from the time of index creation.
 	 */
@@ -143,6 +149,8 @@ index_opts_cmp(const struct index_opts *o1, const struct index_opts *o2)
 		return o1->run_size_ratio < o2->run_size_ratio ? -1 : 1;
 	if (o1->bloom_fpr != o2->bloom_fpr)
 		return o1->bloom_fpr < o2->bloom_fpr ? -1 : 1;
+	if (o1->hint != o2->hint)
+		return o1->hint < o2->hint ? -1 : 1;
 	return 0;
 }
 
@@ -50,6 +50,7 @@
 #include "iobuf.h"
 #include "box.h"
 #include "call.h"
+#include "tuple.h"
 #include "tuple_convert.h"
 #include "session.h"
 #include "xrow.h"
@@ -57,6 +58,8 @@
 #include "replication.h" /* instance_uuid */
 #include "iproto_constants.h"
 #include "rmean.h"
+#include "histogram.h"
+#include "latency.h"
 #include "execute.h"
 
 /* The number of iproto messages in flight */
@@ -86,6 +89,40 @@ iproto_reset_input(struct ibuf *ibuf)
  * from all connections are queued into a single queue
  * and processed in FIFO order.
  */
+enum {
+	/**
+	 * A select reply carrying this many bytes of tuple data
+	 * or more is written to the socket right from the tuples
+	 * instead of being copied to the output buffer.
+	 */
+	IPROTO_ZERO_COPY_MIN = 256 * 1024,
+};
+
+struct iproto_msg;
+
+/**
+ * Tuple data of a big select reply. The reply header is written
+ * to the output buffer as usual, and the tuples follow it from
+ * their own memory. The tuples are referenced until the write
+ * completes, then the chunk goes back to tx to unreference them.
+ */
+struct iproto_zc_chunk {
+	/** Link in iproto_connection::zc_chunks. */
+	struct rlist in_connection;
+	/**
+	 * The message of the reply. The tuple data goes right
+	 * after its write_end position in the output buffer.
+	 */
+	struct iproto_msg *msg;
+	/** Pinned tuples. */
+	struct tuple **tuples;
+	uint32_t tuple_count;
+	/** Tuple data, one iovec per tuple. */
+	struct iovec *iov;
+	/** Index of the first iovec not written yet. */
+	uint32_t iov_pos;
+};
+
 struct iproto_msg: public cmsg
 {
 	struct iproto_connection *connection;
@@ -116,60 +153,33 @@ struct iproto_msg: public cmsg
 	size_t len;
 	/** End of write position in the output buffer */
 	struct obuf_svp write_end;
+	/**
+	 * Tuple data written after write_end, if the reply is
+	 * sent without copying.
+	 */
+	struct iproto_zc_chunk *zc_chunk;
 	/**
 	 * Used in "connect" msgs, true if connect trigger failed
 	 * and the connection must be closed.
 	 */
 	bool close_connection;
+	/** Time the request was read, for latency statistics. */
+	double start;
 };
 
-static struct mempool iproto_msg_pool;
-
 static struct iproto_msg *
-iproto_msg_new(struct iproto_connection *con)
-{
-	struct iproto_msg *msg =
-		(struct iproto_msg *) mempool_alloc_xc(&iproto_msg_pool);
-	msg->connection = con;
-	return msg;
-}
-
-/**
- * Resume stopped connections, if any.
- */
-static void
-iproto_resume();
-
+iproto_msg_new(struct iproto_connection *con);
 
 static inline void
-iproto_msg_delete(struct cmsg *msg)
-{
-	mempool_free(&iproto_msg_pool, msg);
-	iproto_resume();
-}
+iproto_msg_delete(struct iproto_msg *msg);
 
 /* }}} */
 
 /* {{{ iproto connection and requests */
 
-/**
- * A single global queue for all requests in all connections. All
- * requests from all connections are processed concurrently.
- * Is also used as a queue for just established connections and to
- * execute disconnect triggers. A few notes about these triggers:
- * - they need to be run in a fiber
- * - unlike an ordinary request failure, on_connect trigger
- *   failure must lead to connection close.
- * - on_connect trigger must be processed before any other
- *   request on this connection.
- */
-static struct cpipe tx_pipe;
-static struct cpipe net_pipe;
 /* A pointer to the transaction processor cord. */
 struct cord *tx_cord;
 
-struct rmean *rmean_net;
-
 enum rmean_net_name {
 	IPROTO_SENT,
 	IPROTO_RECEIVED,
@@ -178,6 +188,76 @@ enum rmean_net_name {
 
 const char *rmean_net_strings[IPROTO_LAST] = { "SENT", "RECEIVED" };
 
+/**
+ * A network io thread. Each thread owns a subset of client
+ * connections: it accepts them on the shared listening socket,
+ * reads and parses their requests and writes responses. All
+ * threads feed the same tx thread, each through its own pair
+ * of pipes.
+ */
+struct iproto_thread {
+	/** Thread number, 0 for the first thread. */
+	int id;
+	struct cord cord;
+	/**
+	 * A single queue for all requests in all connections of
+	 * the thread. All requests from all connections are
+	 * processed concurrently.
+	 * Is also used as a queue for just established
+	 * connections and to execute disconnect triggers.
+	 * A few notes about these triggers:
+	 * - they need to be run in a fiber
+	 * - unlike an ordinary request failure, on_connect trigger
+	 *   failure must lead to connection close.
+	 * - on_connect trigger must be processed before any other
+	 *   request on this connection.
+	 */
+	struct cpipe tx_pipe;
+	/** A pipe from tx to this thread. */
+	struct cpipe net_pipe;
+	struct mempool iproto_msg_pool;
+	struct mempool iproto_connection_pool;
+	/** Connections stopped due to the request throttling. */
+	struct rlist stopped_connections;
+	/**
+	 * Binary protocol listener. The first thread binds the
+	 * socket, the others accept on its duplicate.
+	 */
+	struct evio_service binary;
+	/** Network statistics, box.stat.net. */
+	struct rmean *rmean_net;
+	/**
+	 * Request latency by request type, box.stat.latency().
+	 * Only the thread itself updates the histograms, the
+	 * tx thread reads them without locking, as rmean_net.
+	 */
+	struct histogram *latency[IPROTO_TYPE_STAT_MAX];
+	/*
+	 * Routes of iproto messages. They go through net_pipe
+	 * of the thread, so each thread has its own copy.
+	 */
+	struct cmsg_hop disconnect_route[2];
+	struct cmsg_hop misc_route[2];
+	struct cmsg_hop select_route[2];
+	struct cmsg_hop select_many_route[2];
+	struct cmsg_hop zc_release_route[2];
+	struct cmsg_hop process1_route[2];
+	struct cmsg_hop sql_route[2];
+	struct cmsg_hop sync_route[2];
+	struct cmsg_hop connect_route[2];
+	const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX];
+};
+
+/** Network io threads, box.cfg.iproto_threads. */
+static struct iproto_thread *iproto_threads;
+static int iproto_thread_count;
+/**
+ * The number of iproto messages in flight per thread. The
+ * total limit is shared between threads to not deplete the
+ * tx fiber pool.
+ */
+static int iproto_msg_max;
+
 /**
  * Context of a single client connection.
  * Interaction scheme:
@@ -249,22 +329,27 @@ struct iproto_connection
 	/* Pre-allocated disconnect msg. */
 	struct iproto_msg *disconnect;
 	struct rlist in_stop_list;
+	/**
+	 * Pinned tuple data of select replies, in the order of
+	 * the replies, waiting to be written.
+	 */
+	struct rlist zc_chunks;
+	/** The network thread serving the connection. */
+	struct iproto_thread *iproto_thread;
 };
 
-static struct mempool iproto_connection_pool;
-static RLIST_HEAD(stopped_connections);
-
 /**
  * Return true if we have not enough spare messages
  * in the message pool. Disconnect messages are
  * discounted: they are mostly reserved and idle.
  */
 static inline bool
-iproto_must_stop_input()
+iproto_must_stop_input(struct iproto_thread *iproto_thread)
 {
-	size_t connection_count = mempool_count(&iproto_connection_pool);
-	size_t request_count = mempool_count(&iproto_msg_pool);
-	return request_count > connection_count + IPROTO_MSG_MAX;
+	size_t connection_count =
+		mempool_count(&iproto_thread->iproto_connection_pool);
+	size_t request_count = mempool_count(&iproto_thread->iproto_msg_pool);
+	return request_count > connection_count + iproto_msg_max;
 }
 
 /**
@@ -274,23 +359,46 @@ iproto_must_stop_input()
  * object in the message pool.
  */
 static void
-iproto_resume()
+iproto_resume(struct iproto_thread *iproto_thread)
 {
 	/*
 	 * Most of the time we have nothing to do here: throttling
 	 * is not active.
 	 */
-	if (rlist_empty(&stopped_connections))
+	if (rlist_empty(&iproto_thread->stopped_connections))
 		return;
-	if (iproto_must_stop_input())
+	if (iproto_must_stop_input(iproto_thread))
 		return;
 
 	struct iproto_connection *con;
-	con = rlist_first_entry(&stopped_connections, struct iproto_connection,
-				in_stop_list);
+	con = rlist_first_entry(&iproto_thread->stopped_connections,
+				struct iproto_connection, in_stop_list);
 	ev_feed_event(con->loop, &con->input, EV_READ);
 }
 
+static struct iproto_msg *
+iproto_msg_new(struct iproto_connection *con)
+{
+	struct mempool *pool = &con->iproto_thread->iproto_msg_pool;
+	struct iproto_msg *msg =
+		(struct iproto_msg *) mempool_alloc_xc(pool);
+	msg->connection = con;
+	msg->zc_chunk = NULL;
+	return msg;
+}
+
+/**
+ * Free a message and resume stopped connections, if any.
+ * The connection of the message must be alive.
+ */
+static inline void
+iproto_msg_delete(struct iproto_msg *msg)
+{
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
+	mempool_free(&iproto_thread->iproto_msg_pool, msg);
+	iproto_resume(iproto_thread);
+}
+
 /**
  * A connection is idle when the client is gone
  * and there are no outstanding msgs in the msg queue.
@@ -318,7 +426,8 @@ iproto_connection_stop(struct iproto_connection *con)
 {
 	assert(rlist_empty(&con->in_stop_list));
 	ev_io_stop(con->loop, &con->input);
-	rlist_add_tail(&stopped_connections, &con->in_stop_list);
+	rlist_add_tail(&con->iproto_thread->stopped_connections,
+		       &con->in_stop_list);
 }
 
 /**
@@ -369,7 +478,7 @@ iproto_connection_delete(struct iproto_connection *con)
 	       con->obuf[1].iov[0].iov_base == NULL);
 	if (con->disconnect)
 		iproto_msg_delete(con->disconnect);
-	mempool_free(&iproto_connection_pool, con);
+	mempool_free(&con->iproto_thread->iproto_connection_pool, con);
 }
 
 static void
@@ -379,15 +488,27 @@ tx_process1(struct cmsg *msg);
 static void
 tx_process_select(struct cmsg *msg);
 static void
+tx_process_select_many(struct cmsg *msg);
+static void
 tx_process_sql(struct cmsg *m);
 static void
 net_send_msg(struct cmsg *msg);
 
+static void
+tx_release_zc_chunk(struct cmsg *msg);
+static void
+net_end_zc_chunk(struct cmsg *msg);
+
 static void
 tx_process_join_subscribe(struct cmsg *msg);
 static void
 net_end_join_subscribe(struct cmsg *msg);
 
+static void
+tx_process_connect(struct cmsg *m);
+static void
+net_send_greeting(struct cmsg *m);
+
 static void
 tx_fiber_init(struct session *session, uint64_t sync)
 {
@@ -439,62 +560,63 @@ static void
 net_finish_disconnect(struct cmsg *m)
 {
 	struct iproto_msg *msg = (struct iproto_msg *) m;
-	/* Runs the trigger, which may yield. */
-	iproto_connection_delete(msg->connection);
+	struct iproto_connection *con = msg->connection;
 	iproto_msg_delete(msg);
+	/* Runs the trigger, which may yield. */
+	iproto_connection_delete(con);
 }
 
-static const struct cmsg_hop disconnect_route[] = {
-	{ tx_process_disconnect, &net_pipe },
-	{ net_finish_disconnect, NULL },
-};
-
-static const struct cmsg_hop misc_route[] = {
-	{ tx_process_misc, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop select_route[] = {
-	{ tx_process_select, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop process1_route[] = {
-	{ tx_process1, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop sql_route[] = {
-	{ tx_process_sql, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX] = {
-	NULL,                                   /* IPROTO_OK */
-	select_route,                           /* IPROTO_SELECT */
-	process1_route,                         /* IPROTO_INSERT */
-	process1_route,                         /* IPROTO_REPLACE */
-	process1_route,                         /* IPROTO_UPDATE */
-	process1_route,                         /* IPROTO_DELETE */
-	misc_route,                             /* IPROTO_CALL_16 */
-	misc_route,                             /* IPROTO_AUTH */
-	misc_route,                             /* IPROTO_EVAL */
-	process1_route,                         /* IPROTO_UPSERT */
-	misc_route,                             /* IPROTO_CALL */
-	sql_route,                              /* IPROTO_EXECUTE */
-};
-
-static const struct cmsg_hop sync_route[] = {
-	{ tx_process_join_subscribe, &net_pipe },
-	{ net_end_join_subscribe, NULL },
-};
+/** Initialize message routes of a network thread. */
+static void
+iproto_thread_init_routes(struct iproto_thread *iproto_thread)
+{
+	struct cpipe *net_pipe = &iproto_thread->net_pipe;
+	iproto_thread->disconnect_route[0] =
+		{ tx_process_disconnect, net_pipe };
+	iproto_thread->disconnect_route[1] = { net_finish_disconnect, NULL };
+	iproto_thread->misc_route[0] = { tx_process_misc, net_pipe };
+	iproto_thread->misc_route[1] = { net_send_msg, NULL };
+	iproto_thread->select_route[0] = { tx_process_select, net_pipe };
+	iproto_thread->select_route[1] = { net_send_msg, NULL };
+	iproto_thread->select_many_route[0] =
+		{ tx_process_select_many, net_pipe };
+	iproto_thread->select_many_route[1] = { net_send_msg, NULL };
+	iproto_thread->zc_release_route[0] = { tx_release_zc_chunk, net_pipe };
+	iproto_thread->zc_release_route[1] = { net_end_zc_chunk, NULL };
+	iproto_thread->process1_route[0] = { tx_process1, net_pipe };
+	iproto_thread->process1_route[1] = { net_send_msg, NULL };
+	iproto_thread->sql_route[0] = { tx_process_sql, net_pipe };
+	iproto_thread->sql_route[1] = { net_send_msg, NULL };
+	iproto_thread->sync_route[0] = { tx_process_join_subscribe, net_pipe };
+	iproto_thread->sync_route[1] = { net_end_join_subscribe, NULL };
+	iproto_thread->connect_route[0] = { tx_process_connect, net_pipe };
+	iproto_thread->connect_route[1] = { net_send_greeting, NULL };
+
+	const struct cmsg_hop **dml_route = iproto_thread->dml_route;
+	dml_route[IPROTO_OK] = NULL;
+	dml_route[IPROTO_SELECT] = iproto_thread->select_route;
+	dml_route[IPROTO_INSERT] = iproto_thread->process1_route;
+	dml_route[IPROTO_REPLACE] = iproto_thread->process1_route;
+	dml_route[IPROTO_UPDATE] = iproto_thread->process1_route;
+	dml_route[IPROTO_DELETE] = iproto_thread->process1_route;
+	dml_route[IPROTO_CALL_16] = iproto_thread->misc_route;
+	dml_route[IPROTO_AUTH] = iproto_thread->misc_route;
+	dml_route[IPROTO_EVAL] = iproto_thread->misc_route;
+	dml_route[IPROTO_UPSERT] = iproto_thread->process1_route;
+	dml_route[IPROTO_CALL] = iproto_thread->misc_route;
+	dml_route[IPROTO_EXECUTE] = iproto_thread->sql_route;
+	dml_route[IPROTO_PREPARE] = iproto_thread->sql_route;
+	dml_route[IPROTO_SELECT_MANY] = iproto_thread->select_many_route;
+}
 
 static struct iproto_connection *
-iproto_connection_new(const char *name, int fd)
+iproto_connection_new(struct iproto_thread *iproto_thread,
+		      const char *name, int fd)
 {
 	(void) name;
 	struct iproto_connection *con = (struct iproto_connection *)
-		mempool_alloc_xc(&iproto_connection_pool);
+		mempool_alloc_xc(&iproto_thread->iproto_connection_pool);
+	con->iproto_thread = iproto_thread;
 	con->input.data = con->output.data = con;
 	con->loop = loop();
 	ev_io_init(&con->input, iproto_connection_on_input, fd, EV_READ);
@@ -507,12 +629,26 @@ iproto_connection_new(const char *name, int fd)
 	con->parse_size = 0;
 	con->session = NULL;
 	rlist_create(&con->in_stop_list);
+	rlist_create(&con->zc_chunks);
 	/* It may be very awkward to allocate at close. */
 	con->disconnect = iproto_msg_new(con);
-	cmsg_init(con->disconnect, disconnect_route);
+	cmsg_init(con->disconnect, iproto_thread->disconnect_route);
 	return con;
 }
 
+/**
+ * Send a written or dropped reply chunk back to tx to
+ * unreference its tuples.
+ */
+static inline void
+iproto_release_zc_chunk(struct iproto_zc_chunk *chunk)
+{
+	struct iproto_msg *msg = chunk->msg;
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
+	cmsg_init(msg, iproto_thread->zc_release_route);
+	cpipe_push(&iproto_thread->tx_pipe, msg);
+}
+
 /**
  * Initiate a connection shutdown. This method may
  * be invoked many times, and does the internal
@@ -538,6 +674,12 @@ iproto_connection_close(struct iproto_connection *con)
 		 */
 		con->p_ibuf->wpos -= con->parse_size;
 	}
+	/* The pinned replies will never be written. */
+	struct iproto_zc_chunk *chunk, *tmp;
+	rlist_foreach_entry_safe(chunk, &con->zc_chunks, in_connection, tmp) {
+		rlist_del_entry(chunk, in_connection);
+		iproto_release_zc_chunk(chunk);
+	}
 	/*
 	 * If the connection has no outstanding requests in the
 	 * input buffer, then no one (e.g. tx thread) is referring
@@ -554,7 +696,7 @@ iproto_connection_close(struct iproto_connection *con)
 		assert(con->disconnect != NULL);
 		struct iproto_msg *msg = con->disconnect;
 		con->disconnect = NULL;
-		cpipe_push(&tx_pipe, msg);
+		cpipe_push(&con->iproto_thread->tx_pipe, msg);
 	}
 	rlist_del(&con->in_stop_list);
 }
@@ -683,6 +825,7 @@ iproto_decode_msg(struct iproto_msg *msg, const char **pos, const char *reqend,
 	xrow_header_decode_xc(&msg->header, pos, reqend);
 	assert(*pos == reqend);
 	uint8_t type = msg->header.type;
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
 
 	/*
 	 * Parse request before putting it into the queue
@@ -698,31 +841,38 @@ iproto_decode_msg(struct iproto_msg *msg, const char **pos, const char *reqend,
 	case IPROTO_UPSERT:
 		xrow_decode_dml_xc(&msg->header, &msg->dml_request,
 				   dml_request_key_map(type));
-		assert(type < sizeof(dml_route)/sizeof(*dml_route));
-		cmsg_init(msg, dml_route[type]);
+		assert(type < IPROTO_TYPE_STAT_MAX);
+		cmsg_init(msg, iproto_thread->dml_route[type]);
+		break;
+	case IPROTO_SELECT_MANY:
+		/* Not a DML request, but has the same body. */
+		xrow_decode_dml_xc(&msg->header, &msg->dml_request,
+				   dml_request_key_map(type));
+		cmsg_init(msg, iproto_thread->dml_route[type]);
 		break;
 	case IPROTO_CALL_16:
 	case IPROTO_CALL:
 	case IPROTO_EVAL:
 		xrow_decode_call_xc(&msg->header, &msg->call_request);
-		cmsg_init(msg, misc_route);
+		cmsg_init(msg, iproto_thread->misc_route);
 		break;
 	case IPROTO_PING:
-		cmsg_init(msg, misc_route);
+		cmsg_init(msg, iproto_thread->misc_route);
 		break;
 	case IPROTO_JOIN:
 	case IPROTO_SUBSCRIBE:
-		cmsg_init(msg, sync_route);
+		cmsg_init(msg, iproto_thread->sync_route);
 		*stop_input = true;
 		break;
 	case IPROTO_EXECUTE:
+	case IPROTO_PREPARE:
 		xrow_decode_sql_xc(&msg->header, &msg->sql_request,
 				   &fiber()->gc);
-		cmsg_init(msg, sql_route);
+		cmsg_init(msg, iproto_thread->sql_route);
 		break;
 	case IPROTO_AUTH:
 		xrow_decode_auth_xc(&msg->header, &msg->auth_request);
-		cmsg_init(msg, misc_route);
+		cmsg_init(msg, iproto_thread->misc_route);
 		break;
 	default:
 		tnt_raise(ClientError, ER_UNKNOWN_REQUEST_TYPE,
@@ -756,6 +906,7 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 		struct iproto_msg *msg = iproto_msg_new(con);
 		msg->p_ibuf = con->p_ibuf;
 		msg->p_obuf = p_obuf;
+		msg->start = ev_monotonic_time();
 		auto guard = make_scoped_guard([=] { iproto_msg_delete(msg); });
 
 		msg->len = reqend - reqstart; /* total request length */
@@ -766,7 +917,7 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 			 * This can't throw, but should not be
 			 * done in case of exception.
 			 */
-			cpipe_push_input(&tx_pipe, msg);
+			cpipe_push_input(&con->iproto_thread->tx_pipe, msg);
 			guard.is_active = false;
 			n_requests++;
 		} catch (Exception *e) {
@@ -832,7 +983,7 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 		 */
 		ev_feed_event(con->loop, &con->input, EV_READ);
 	}
-	cpipe_flush_input(&tx_pipe);
+	cpipe_flush_input(&con->iproto_thread->tx_pipe);
 }
 
 static void
@@ -851,7 +1002,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 		 * resume one more connection which might have
 		 * input.
 		 */
-		iproto_resume();
+		iproto_resume(con->iproto_thread);
 	}
 	/*
 	 * Throttle if there are too many pending requests,
@@ -860,7 +1011,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 	 * another fiber waiting for write to complete).
 	 * Ignore iproto_connection->disconnect messages.
 	 */
-	if (iproto_must_stop_input()) {
+	if (iproto_must_stop_input(con->iproto_thread)) {
 		iproto_connection_stop(con);
 		return;
 	}
@@ -883,7 +1034,8 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 			return;
 		}
 		/* Count statistics */
-		rmean_collect(rmean_net, IPROTO_RECEIVED, nrd);
+		rmean_collect(con->iproto_thread->rmean_net, IPROTO_RECEIVED,
+			      nrd);
 
 		/* Update the read position and connection state. */
 		in->wpos += nrd;
@@ -898,6 +1050,55 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 	}
 }
 
+/** The first pinned reply chunk to write after @a obuf data. */
+static inline struct iproto_zc_chunk *
+iproto_connection_first_zc_chunk(struct iproto_connection *con,
+				 struct obuf *obuf)
+{
+	struct iproto_zc_chunk *chunk;
+	rlist_foreach_entry(chunk, &con->zc_chunks, in_connection) {
+		if (chunk->msg->p_obuf == obuf)
+			return chunk;
+	}
+	return NULL;
+}
+
+/** True if there is nothing to write from @a obuf. */
+static inline bool
+iproto_connection_output_is_empty(struct iproto_connection *con,
+				  struct obuf *obuf)
+{
+	return obuf_used(obuf) == 0 &&
+	       iproto_connection_first_zc_chunk(con, obuf) == NULL;
+}
+
+/**
+ * Write pinned tuple data of a reply. Returns 0 when the chunk
+ * is written completely and -1 if the socket is not ready.
+ */
+static int
+iproto_flush_zc_chunk(struct iproto_connection *con,
+		      struct iproto_zc_chunk *chunk)
+{
+	struct iovec *iov = chunk->iov + chunk->iov_pos;
+	int iovcnt = chunk->tuple_count - chunk->iov_pos;
+	ssize_t nwr = sio_writev(con->output.fd, iov, iovcnt);
+
+	rmean_collect(con->iproto_thread->rmean_net, IPROTO_SENT, nwr);
+	if (nwr <= 0)
+		return -1;
+	size_t offset = 0;
+	chunk->iov_pos += sio_move_iov(iov, nwr, &offset);
+	if (chunk->iov_pos < chunk->tuple_count) {
+		/* Skip the written part of a partially written tuple. */
+		sio_add_to_iov(&chunk->iov[chunk->iov_pos], -offset);
+		return -1;
+	}
+	rlist_del_entry(chunk, in_connection);
+	iproto_release_zc_chunk(chunk);
+	return 0;
+}
+
 /** writev() to the socket and handle the result. */
 
 static int
@@ -905,7 +1106,7 @@ iproto_flush(struct iproto_connection *con)
 {
 	struct ibuf *ibuf = iproto_connection_prev_input(con);
 	struct obuf *obuf = iproto_connection_output_by_input(con, ibuf);
-	if (obuf_used(obuf) == 0) {
+	if (iproto_connection_output_is_empty(con, obuf)) {
 		obuf = iproto_connection_output_by_input(con, con->p_ibuf);
 		/*
 		 * Don't try to write from a newer buffer if an
@@ -914,7 +1115,8 @@ iproto_flush(struct iproto_connection *con)
 		 * salad of different pieces of replies from both
 		 * buffers.
 		 */
-		if (ibuf_used(ibuf) > 0 || obuf_used(obuf) == 0)
+		if (ibuf_used(ibuf) > 0 ||
+		    iproto_connection_output_is_empty(con, obuf))
 			return 1;
 		ibuf = con->p_ibuf;
 	}
@@ -922,6 +1124,18 @@ iproto_flush(struct iproto_connection *con)
 	int fd = con->output.fd;
 	struct obuf_svp *begin = &obuf->wpos;
 	struct obuf_svp *end = &obuf->wend;
+	struct iproto_zc_chunk *chunk =
+		iproto_connection_first_zc_chunk(con, obuf);
+	if (chunk != NULL) {
+		if (chunk->msg->write_end.used == begin->used)
+			return iproto_flush_zc_chunk(con, chunk);
+		/*
+		 * Write the output preceding the chunk first. The
+		 * input buffer can't be idle until the chunk is
+		 * released, so the output buffer isn't reset below.
+		 */
+		end = &chunk->msg->write_end;
+	}
 	assert(begin->used < end->used);
 	struct iovec iov[SMALL_OBUF_IOV_MAX+1];
 	struct iovec *src = obuf->iov;
@@ -938,7 +1152,7 @@ iproto_flush(struct iproto_connection *con)
 	ssize_t nwr = sio_writev(fd, iov, iovcnt);
 
 	/* Count statistics */
-	rmean_collect(rmean_net, IPROTO_SENT, nwr);
+	rmean_collect(con->iproto_thread->rmean_net, IPROTO_SENT, nwr);
 	if (nwr > 0) {
 		if (begin->used + nwr == end->used) {
 			if (ibuf_used(ibuf) == 0) {
@@ -1028,6 +1242,66 @@ error:
 	msg->write_end = obuf_create_svp(out);
 }
 
+/**
+ * Pin the tuples of a big select reply to write them to the
+ * socket right from the tuple data. Returns -1 if the reply is
+ * small or can't be pinned and has to be copied to the output
+ * buffer as usual.
+ */
+static int
+tx_pin_select_reply(struct iproto_msg *msg, struct port *port, size_t *size)
+{
+	size_t data_size = 0;
+	struct port_entry *pe;
+	for (pe = port->first; pe != NULL; pe = pe->next)
+		data_size += tuple_bsize(pe->tuple);
+	if (data_size < IPROTO_ZERO_COPY_MIN)
+		return -1;
+
+	uint32_t count = port->size;
+	size_t alloc_size = sizeof(struct iproto_zc_chunk) +
+		count * (sizeof(struct tuple *) + sizeof(struct iovec));
+	struct iproto_zc_chunk *chunk =
+		(struct iproto_zc_chunk *) malloc(alloc_size);
+	if (chunk == NULL)
+		return -1;
+	chunk->iov = (struct iovec *) (chunk + 1);
+	chunk->tuples = (struct tuple **) (chunk->iov + count);
+	chunk->tuple_count = 0;
+	chunk->iov_pos = 0;
+	for (pe = port->first; pe != NULL; pe = pe->next) {
+		if (tuple_ref(pe->tuple) != 0) {
+			/* Too many references, copy the reply. */
+			diag_clear(diag_get());
+			for (uint32_t i = 0; i < chunk->tuple_count; i++)
+				tuple_unref(chunk->tuples[i]);
+			free(chunk);
+			return -1;
+		}
+		uint32_t bsize;
+		struct iovec *iov = &chunk->iov[chunk->tuple_count];
+		iov->iov_base = (void *) tuple_data_range(pe->tuple, &bsize);
+		iov->iov_len = bsize;
+		chunk->tuples[chunk->tuple_count++] = pe->tuple;
+	}
+	chunk->msg = msg;
+	msg->zc_chunk = chunk;
+	*size = data_size;
+	return 0;
+}
+
+/** Unreference the tuples of a written or dropped reply. */
+static void
+tx_release_zc_chunk(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct iproto_zc_chunk *chunk = msg->zc_chunk;
+	for (uint32_t i = 0; i < chunk->tuple_count; i++)
+		tuple_unref(chunk->tuples[i]);
+	free(chunk);
+	msg->zc_chunk = NULL;
+}
+
 static void
 tx_process_select(struct cmsg *m)
 {
@@ -1035,6 +1309,7 @@ tx_process_select(struct cmsg *m)
 	struct obuf *out = msg->p_obuf;
 	struct obuf_svp svp;
 	struct port port;
+	size_t zc_size;
 	int rc;
 	struct request *req = &msg->dml_request;
 
@@ -1052,6 +1327,12 @@ tx_process_select(struct cmsg *m)
 			req->key, req->key_end);
 	if (rc < 0 || iproto_prepare_select(out, &svp) != 0)
 		goto error;
+	if (tx_pin_select_reply(msg, &port, &zc_size) == 0) {
+		iproto_reply_select_ext(out, &svp, msg->header.sync,
+					::schema_version, port.size, zc_size);
+		msg->write_end = obuf_create_svp(out);
+		return;
+	}
 	if (port_dump(&port, out) != 0) {
 		/* Discard the prepared select. */
 		obuf_rollback_to_svp(out, &svp);
@@ -1067,6 +1348,64 @@ error:
 	msg->write_end = obuf_create_svp(out);
 }
 
+/**
+ * Process a multi-key select. The reply body holds an array with
+ * an array of found tuples per key.
+ */
+static void
+tx_process_select_many(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct obuf *out = msg->p_obuf;
+	struct obuf_svp svp;
+	struct port port;
+	struct request *req = &msg->dml_request;
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint32_t key_count;
+	uint32_t *found;
+	const char *keys;
+
+	tx_fiber_init(msg->connection->session, msg->header.sync);
+
+	port_create(&port);
+	auto port_guard = make_scoped_guard([&](){
+		port_destroy(&port);
+		region_truncate(region, region_svp);
+	});
+
+	if (tx_check_schema(msg->header.schema_version))
+		goto error;
+
+	keys = req->key;
+	key_count = mp_decode_array(&keys);
+	found = (uint32_t *) region_alloc(region,
+					  key_count * sizeof(*found));
+	if (found == NULL) {
+		diag_set(OutOfMemory, key_count * sizeof(*found),
+			 "region_alloc", "found");
+		goto error;
+	}
+	if (box_select_many(&port, found, req->space_id, req->index_id,
+			    req->iterator, req->limit,
+			    req->key, req->key_end) != 0 ||
+	    iproto_prepare_select(out, &svp) != 0)
+		goto error;
+	if (port_dump_groups(&port, found, key_count, out) != 0) {
+		/* Discard the prepared select. */
+		obuf_rollback_to_svp(out, &svp);
+		goto error;
+	}
+	iproto_reply_select(out, &svp, msg->header.sync, ::schema_version,
+			    key_count);
+	msg->write_end = obuf_create_svp(out);
+	return;
+error:
+	iproto_reply_error(out, diag_last_error(&fiber()->diag),
+			   msg->header.sync, ::schema_version);
+	msg->write_end = obuf_create_svp(out);
+}
+
 static void
 tx_process_misc(struct cmsg *m)
 {
@@ -1120,9 +1459,15 @@ tx_process_sql(struct cmsg *m)
 
 	if (tx_check_schema(msg->header.schema_version))
 		goto error;
-	assert(msg->header.type == IPROTO_EXECUTE);
-	if (sql_prepare_and_execute(&msg->sql_request, out,
-				    &fiber()->gc) == 0) {
+	int rc;
+	if (msg->header.type == IPROTO_PREPARE) {
+		rc = sql_prepare(&msg->sql_request, out);
+	} else {
+		assert(msg->header.type == IPROTO_EXECUTE);
+		rc = sql_prepare_and_execute(&msg->sql_request, out,
+					     &fiber()->gc);
+	}
+	if (rc == 0) {
 		msg->write_end = obuf_create_svp(out);
 		return;
 	}
@@ -1169,11 +1514,45 @@ tx_process_join_subscribe(struct cmsg *m)
 	}
 }
 
+/**
+ * Account the time since a request was read in the latency
+ * statistics of the network thread.
+ */
+static inline void
+iproto_msg_collect_latency(struct iproto_msg *msg)
+{
+	uint32_t type = msg->header.type;
+	if (type >= IPROTO_TYPE_STAT_MAX)
+		return;
+	double latency = ev_monotonic_time() - msg->start;
+	histogram_collect(msg->connection->iproto_thread->latency[type],
+			  latency * 1e6);
+}
+
 static void
 net_send_msg(struct cmsg *m)
 {
 	struct iproto_msg *msg = (struct iproto_msg *) m;
 	struct iproto_connection *con = msg->connection;
+	iproto_msg_collect_latency(msg);
+	if (msg->zc_chunk != NULL) {
+		/*
+		 * Keep the request in the input buffer until the
+		 * pinned tuples are written and released, this
+		 * holds the connection and its output buffer.
+		 */
+		msg->p_obuf->wend = msg->write_end;
+		if (evio_has_fd(&con->output)) {
+			rlist_add_tail_entry(&con->zc_chunks, msg->zc_chunk,
+					     in_connection);
+			if (! ev_is_active(&con->output))
+				ev_feed_event(con->loop, &con->output,
+					      EV_WRITE);
+		} else {
+			iproto_release_zc_chunk(msg->zc_chunk);
+		}
+		return;
+	}
 	/* Discard request (see iproto_enqueue_batch()) */
 	msg->p_ibuf->rpos += msg->len;
 	msg->p_obuf->wend = msg->write_end;
@@ -1187,6 +1566,23 @@ net_send_msg(struct cmsg *m)
 	iproto_msg_delete(msg);
 }
 
+/** Discard a request once its pinned reply is released. */
+static void
+net_end_zc_chunk(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct iproto_connection *con = msg->connection;
+	msg->p_ibuf->rpos += msg->len;
+	if (evio_has_fd(&con->output)) {
+		/* Newer output may wait for this buffer to drain. */
+		if (! ev_is_active(&con->output))
+			ev_feed_event(con->loop, &con->output, EV_WRITE);
+	} else if (iproto_connection_is_idle(con)) {
+		iproto_connection_close(con);
+	}
+	iproto_msg_delete(msg);
+}
+
 static void
 net_end_join_subscribe(struct cmsg *m)
 {
@@ -1254,7 +1650,8 @@ net_send_greeting(struct cmsg *m)
 						 obuf_iovcnt(out));
 
 			/* Count statistics */
-			rmean_collect(rmean_net, IPROTO_SENT, nwr);
+			rmean_collect(con->iproto_thread->rmean_net,
+				      IPROTO_SENT, nwr);
 		} catch (Exception *e) {
 			e->log();
 		}
@@ -1275,103 +1672,144 @@ net_send_greeting(struct cmsg *m)
 	iproto_msg_delete(msg);
 }
 
-static const struct cmsg_hop connect_route[] = {
-	{ tx_process_connect, &net_pipe },
-	{ net_send_greeting, NULL },
-};
-
 /** }}} */
 
 /**
  * Create a connection and start input.
  */
 static void
-iproto_on_accept(struct evio_service * /* service */, int fd,
+iproto_on_accept(struct evio_service *service, int fd,
 		 struct sockaddr *addr, socklen_t addrlen)
 {
 	char name[SERVICE_NAME_MAXLEN];
 	snprintf(name, sizeof(name), "%s/%s", "iobuf",
 		sio_strfaddr(addr, addrlen));
 
+	struct iproto_thread *iproto_thread =
+		(struct iproto_thread *) service->on_accept_param;
 	struct iproto_connection *con;
 
-	con = iproto_connection_new(name, fd);
+	con = iproto_connection_new(iproto_thread, name, fd);
 	/*
 	 * Ignore msg allocation failure - the queue size is
 	 * fixed so there is a limited number of msgs in
 	 * use, all stored in just a few blocks of the memory pool.
 	 */
 	struct iproto_msg *msg = iproto_msg_new(con);
-	cmsg_init(msg, connect_route);
+	cmsg_init(msg, iproto_thread->connect_route);
 	msg->p_ibuf = con->p_ibuf;
 	msg->p_obuf = iproto_connection_output_by_input(con, con->p_ibuf);
 	msg->close_connection = false;
-	cpipe_push(&tx_pipe, msg);
+	cpipe_push(&iproto_thread->tx_pipe, msg);
 }
 
-static struct evio_service binary; /* iproto binary listener */
+/**
+ * The first thread keeps the historical names of the cord
+ * and its endpoint, the others get their number appended.
+ */
+static void
+iproto_thread_endpoint_name(struct iproto_thread *iproto_thread,
+			    char *buf, size_t size)
+{
+	if (iproto_thread->id == 0)
+		snprintf(buf, size, "net");
+	else
+		snprintf(buf, size, "net%d", iproto_thread->id);
+}
 
 /**
  * The network io thread main function:
  * begin serving the message bus.
  */
 static int
-net_cord_f(va_list /* ap */)
+net_cord_f(va_list ap)
 {
+	struct iproto_thread *iproto_thread = va_arg(ap, struct iproto_thread *);
 	/* Got to be called in every thread using iobuf */
 	iobuf_init();
-	mempool_create(&iproto_msg_pool, &cord()->slabc,
+	mempool_create(&iproto_thread->iproto_msg_pool, &cord()->slabc,
 		       sizeof(struct iproto_msg));
-	mempool_create(&iproto_connection_pool, &cord()->slabc,
+	mempool_create(&iproto_thread->iproto_connection_pool, &cord()->slabc,
 		       sizeof(struct iproto_connection));
+	rlist_create(&iproto_thread->stopped_connections);
 
-	evio_service_init(loop(), &binary, "binary",
-			  iproto_on_accept, NULL);
+	evio_service_init(loop(), &iproto_thread->binary, "binary",
+			  iproto_on_accept, iproto_thread);
 
 
 	/* Init statistics counter */
-	rmean_net = rmean_new(rmean_net_strings, IPROTO_LAST);
+	iproto_thread->rmean_net = rmean_new(rmean_net_strings, IPROTO_LAST);
 
-	if (rmean_net == NULL) {
+	if (iproto_thread->rmean_net == NULL) {
 		tnt_raise(OutOfMemory, sizeof(struct rmean),
 			  "rmean", "struct rmean");
 	}
 
 	struct cbus_endpoint endpoint;
 	/* Create "net" endpoint. */
-	cbus_endpoint_create(&endpoint, "net", fiber_schedule_cb, fiber());
+	char name[FIBER_NAME_MAX];
+	iproto_thread_endpoint_name(iproto_thread, name, sizeof(name));
+	cbus_endpoint_create(&endpoint, name, fiber_schedule_cb, fiber());
 	/* Create a pipe to "tx" thread. */
-	cpipe_create(&tx_pipe, "tx");
-	cpipe_set_max_input(&tx_pipe, IPROTO_MSG_MAX/2);
+	cpipe_create(&iproto_thread->tx_pipe, "tx");
+	cpipe_set_max_input(&iproto_thread->tx_pipe, iproto_msg_max / 2);
 	/* Process incomming messages. */
 	cbus_loop(&endpoint);
 
-	cpipe_destroy(&tx_pipe);
+	cpipe_destroy(&iproto_thread->tx_pipe);
 	/*
 	 * Nothing to do in the fiber so far, the service
 	 * will take care of creating events for incoming
 	 * connections.
 	 */
-	if (evio_service_is_active(&binary))
-		evio_service_stop(&binary);
+	if (iproto_thread->id != 0)
+		evio_service_detach(&iproto_thread->binary);
+	else if (evio_service_is_active(&iproto_thread->binary))
+		evio_service_stop(&iproto_thread->binary);
 
-	rmean_delete(rmean_net);
+	rmean_delete(iproto_thread->rmean_net);
 	return 0;
 }
 
-/** Initialize the iproto subsystem and start network io thread */
+/** Initialize the iproto subsystem and start network io threads */
 void
-iproto_init()
+iproto_init(int thread_count)
 {
 	tx_cord = cord();
 
-	static struct cord net_cord;
-	if (cord_costart(&net_cord, "iproto", net_cord_f, NULL))
-		panic("failed to initialize iproto thread");
-
-	/* Create a pipe to "net" thread. */
-	cpipe_create(&net_pipe, "net");
-	cpipe_set_max_input(&net_pipe, IPROTO_MSG_MAX/2);
+	assert(thread_count > 0);
+	iproto_thread_count = thread_count;
+	iproto_msg_max = MAX(IPROTO_MSG_MAX / thread_count, 2);
+	iproto_threads = (struct iproto_thread *)
+		calloc(thread_count, sizeof(struct iproto_thread));
+	if (iproto_threads == NULL)
+		panic("failed to allocate iproto threads");
+
+	for (int i = 0; i < thread_count; i++) {
+		struct iproto_thread *iproto_thread = &iproto_threads[i];
+		iproto_thread->id = i;
+		iproto_thread_init_routes(iproto_thread);
+		for (int type = 0; type < IPROTO_TYPE_STAT_MAX; type++) {
+			iproto_thread->latency[type] = latency_histogram_new();
+			if (iproto_thread->latency[type] == NULL)
+				panic("failed to allocate iproto statistics");
+		}
+		char name[FIBER_NAME_MAX];
+		if (i == 0)
+			snprintf(name, sizeof(name), "iproto");
+		else
+			snprintf(name, sizeof(name), "iproto%d", i);
+		if (cord_costart(&iproto_thread->cord, name, net_cord_f,
+				 iproto_thread))
+			panic("failed to initialize iproto thread");
+
+		iproto_thread_endpoint_name(iproto_thread, name, sizeof(name));
+
+		/* Create a pipe to "net" thread. */
+		cpipe_create(&iproto_thread->net_pipe, name);
+		cpipe_set_max_input(&iproto_thread->net_pipe,
+				    iproto_msg_max / 2);
+	}
 }
 
 /**
@@ -1383,17 +1821,21 @@ iproto_init()
 struct iproto_bind_msg: public cbus_call_msg
 {
 	const char *uri;
+	/** The thread the message is sent to. */
+	struct iproto_thread *iproto_thread;
 };
 
 static int
 iproto_do_bind(struct cbus_call_msg *m)
 {
 	const char *uri  = ((struct iproto_bind_msg *) m)->uri;
+	struct evio_service *binary =
+		&((struct iproto_bind_msg *) m)->iproto_thread->binary;
 	try {
-		if (evio_service_is_active(&binary))
-			evio_service_stop(&binary);
+		if (evio_service_is_active(binary))
+			evio_service_stop(binary);
 		if (uri != NULL)
-			evio_service_bind(&binary, uri);
+			evio_service_bind(binary, uri);
 	} catch (Exception *e) {
 		return -1;
 	}
@@ -1403,34 +1845,121 @@ iproto_do_bind(struct cbus_call_msg *m)
 static int
 iproto_do_listen(struct cbus_call_msg *m)
 {
-	(void) m;
+	struct evio_service *binary =
+		&((struct iproto_bind_msg *) m)->iproto_thread->binary;
 	try {
-		if (evio_service_is_active(&binary))
-			evio_service_listen(&binary);
+		if (evio_service_is_active(binary))
+			evio_service_listen(binary);
 	} catch (Exception *e) {
 		return -1;
 	}
 	return 0;
 }
 
-void
-iproto_bind(const char *uri)
+/** Stop accepting connections in a secondary thread. */
+static int
+iproto_do_detach(struct cbus_call_msg *m)
+{
+	struct evio_service *binary =
+		&((struct iproto_bind_msg *) m)->iproto_thread->binary;
+	evio_service_detach(binary);
+	return 0;
+}
+
+/**
+ * Start accepting connections in a secondary thread on the
+ * listening socket of the first thread, if there is one.
+ */
+static int
+iproto_do_attach(struct cbus_call_msg *m)
+{
+	struct evio_service *binary =
+		&((struct iproto_bind_msg *) m)->iproto_thread->binary;
+	/*
+	 * The first thread does not touch its service until
+	 * the next bind request, which is not sent until
+	 * this one completes.
+	 */
+	struct evio_service *master = &iproto_threads[0].binary;
+	try {
+		if (evio_service_is_active(master))
+			evio_service_attach(binary, master);
+	} catch (Exception *e) {
+		return -1;
+	}
+	return 0;
+}
+
+/** Send a bind message to a network thread and wait for it. */
+static void
+iproto_thread_call(struct iproto_thread *iproto_thread, cbus_call_f func,
+		   const char *uri)
 {
+	/* Declare static to avoid stack corruption on fiber cancel. */
 	static struct iproto_bind_msg m;
 	m.uri = uri;
-	if (cbus_call(&net_pipe, &tx_pipe, &m, iproto_do_bind,
-		      NULL, TIMEOUT_INFINITY))
+	m.iproto_thread = iproto_thread;
+	if (cbus_call(&iproto_thread->net_pipe, &iproto_thread->tx_pipe, &m,
+		      func, NULL, TIMEOUT_INFINITY))
 		diag_raise();
 }
 
+void
+iproto_bind(const char *uri)
+{
+	/*
+	 * Secondary threads duplicate the socket of the first
+	 * one, so release the duplicates before rebinding.
+	 * They are reattached in iproto_listen().
+	 */
+	for (int i = 1; i < iproto_thread_count; i++)
+		iproto_thread_call(&iproto_threads[i], iproto_do_detach, NULL);
+	iproto_thread_call(&iproto_threads[0], iproto_do_bind, uri);
+}
+
 void
 iproto_listen()
 {
-	/* Declare static to avoid stack corruption on fiber cancel. */
-	static struct cbus_call_msg m;
-	if (cbus_call(&net_pipe, &tx_pipe, &m, iproto_do_listen,
-		      NULL, TIMEOUT_INFINITY))
-		diag_raise();
+	iproto_thread_call(&iproto_threads[0], iproto_do_listen, NULL);
+	for (int i = 1; i < iproto_thread_count; i++)
+		iproto_thread_call(&iproto_threads[i], iproto_do_attach, NULL);
+}
+
+int
+iproto_rmean_foreach(int thread_id, rmean_cb cb, void *cb_ctx)
+{
+	if (thread_id >= 0) {
+		assert(thread_id < iproto_thread_count);
+		return rmean_foreach(iproto_threads[thread_id].rmean_net,
+				     cb, cb_ctx);
+	}
+	/* Sum up statistics of all threads. */
+	for (int name = 0; name < IPROTO_LAST; name++) {
+		int64_t rps = 0, total = 0;
+		for (int i = 0; i < iproto_thread_count; i++) {
+			struct rmean *rmean = iproto_threads[i].rmean_net;
+			rps += rmean_mean(rmean, name);
+			total += rmean_total(rmean, name);
+		}
+		int rc = cb(rmean_net_strings[name], rps, total, cb_ctx);
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
+}
+
+void
+iproto_latency_merge(uint32_t type, struct histogram *hist)
+{
+	assert(type < IPROTO_TYPE_STAT_MAX);
+	for (int i = 0; i < iproto_thread_count; i++)
+		histogram_merge(hist, iproto_threads[i].latency[type]);
+}
+
+int
+iproto_get_thread_count(void)
+{
+	return iproto_thread_count;
 }
 
 /* vim: set foldmethod=marker */
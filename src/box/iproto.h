@@ -30,8 +30,44 @@
  * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
  */
+#include "rmean.h"
+
+/** The upper limit of box.cfg.iproto_threads. */
+enum { IPROTO_THREADS_MAX = 1000 };
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Iterate over network statistics, box.stat.net.
+ * @param thread_id Network thread number or -1 to iterate
+ *        over totals of all threads.
+ */
+int
+iproto_rmean_foreach(int thread_id, rmean_cb cb, void *cb_ctx);
+
+struct histogram;
+
+/**
+ * Add latencies of requests of the given type, from the time
+ * a request is read till its reply is ready to be sent, to
+ * @a hist. The histogram must be created with
+ * latency_histogram_new(). Used by box.stat.latency().
+ */
+void
+iproto_latency_merge(uint32_t type, struct histogram *hist);
+
+/** The number of network threads, box.cfg.iproto_threads. */
+int
+iproto_get_thread_count(void);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+
+/** Start @a thread_count network threads. */
 void
-iproto_init();
+iproto_init(int thread_count);
 
 void
 iproto_bind(const char *uri);
@@ -39,4 +75,6 @@ iproto_bind(const char *uri);
 void
 iproto_listen();
 
+#endif /* defined(__cplusplus) */
+
 #endif
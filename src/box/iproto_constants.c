@@ -104,6 +104,8 @@ const char *iproto_type_strs[] =
 	"UPSERT",
 	"CALL",
 	"EXECUTE",
+	"PREPARE",
+	"SELECT_MANY",
 };
 
 #define bit(c) (1ULL<<IPROTO_##c)
@@ -118,6 +120,10 @@ const uint64_t iproto_body_key_map[IPROTO_TYPE_STAT_MAX] = {
 	0,                                                     /* AUTH */
 	0,                                                     /* EVAL */
 	bit(SPACE_ID) | bit(OPS) | bit(TUPLE),                 /* UPSERT */
+	0,                                                     /* CALL */
+	0,                                                     /* EXECUTE */
+	0,                                                     /* PREPARE */
+	bit(SPACE_ID) | bit(LIMIT) | bit(KEY),                 /* SELECT_MANY */
 };
 #undef bit
 
@@ -191,6 +197,8 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"SQL options",      /* 0x42 */
 	"SQL info",         /* 0x43 */
 	"SQL row count",    /* 0x44 */
+	"statement id",     /* 0x45 */
+	"SQL bind count",   /* 0x46 */
 };
 
 const char *vy_page_info_key_strs[VY_PAGE_INFO_KEY_MAX] = {
@@ -200,7 +208,8 @@ const char *vy_page_info_key_strs[VY_PAGE_INFO_KEY_MAX] = {
 	"unpacked size",
 	"row count",
 	"min key",
-	"row index offset"
+	"row index offset",
+	"bloom filter"
 };
 
 const char *vy_run_info_key_strs[VY_RUN_INFO_KEY_MAX] = {
@@ -112,6 +112,10 @@ enum iproto_key {
 	 */
 	IPROTO_SQL_INFO = 0x43,
 	IPROTO_SQL_ROW_COUNT = 0x44,
+	/** Id of a statement in the SQL statement cache. */
+	IPROTO_STMT_ID = 0x45,
+	/** Number of parameters of a prepared statement. */
+	IPROTO_SQL_BIND_COUNT = 0x46,
 	IPROTO_KEY_MAX
 };
 
@@ -176,6 +180,10 @@ enum iproto_type {
 	IPROTO_CALL = 10,
 	/** Execute an SQL statement. */
 	IPROTO_EXECUTE = 11,
+	/** Compile an SQL statement and put it in the cache. */
+	IPROTO_PREPARE = 12,
+	/** SELECT by several keys, one result set per key */
+	IPROTO_SELECT_MANY = 13,
 	/** The maximum typecode used for box.stat() */
 	IPROTO_TYPE_STAT_MAX,
 
@@ -253,7 +261,7 @@ static inline uint64_t
 dml_request_key_map(uint32_t type)
 {
 	/** Advanced requests don't have a defined key map. */
-	assert(iproto_type_is_dml(type));
+	assert(iproto_type_is_dml(type) || type == IPROTO_SELECT_MANY);
 	extern const uint64_t iproto_body_key_map[];
 	return iproto_body_key_map[type];
 }
@@ -354,6 +362,8 @@ enum vy_page_info_key {
 	VY_PAGE_INFO_MIN_KEY = 5,
 	/** Offset of the row index in the page. */
 	VY_PAGE_INFO_ROW_INDEX_OFFSET = 6,
+	/** Bloom filter for keys stored in the page. */
+	VY_PAGE_INFO_BLOOM = 7,
 	/** The last key in this enum + 1 */
 	VY_PAGE_INFO_KEY_MAX
 };
@@ -187,6 +187,28 @@ lbox_cfg_set_memtx_max_tuple_size(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_sql_cache_size(struct lua_State *L)
+{
+	try {
+		box_set_sql_cache_size();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_memtx_snapshot_threads(struct lua_State *L)
+{
+	try {
+		box_set_memtx_snapshot_threads();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_vinyl_max_tuple_size(struct lua_State *L)
 {
@@ -209,6 +231,61 @@ lbox_cfg_set_vinyl_timeout(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_wal_group_commit(struct lua_State *L)
+{
+	try {
+		box_set_wal_group_commit();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_vinyl_page_cache(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_page_cache();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_vinyl_dump_rate_limit(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_dump_rate_limit();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_vinyl_compact_rate_limit(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_compact_rate_limit();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_vinyl_wal_latency_target(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_wal_latency_target();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_worker_pool_threads(struct lua_State *L)
 {
@@ -229,6 +306,17 @@ lbox_cfg_set_replication_timeout(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_replication_apply_fibers(struct lua_State *L)
+{
+	try {
+		box_set_replication_apply_fibers();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 void
 box_lua_cfg_init(struct lua_State *L)
 {
@@ -247,9 +335,20 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_checkpoint_count", lbox_cfg_set_checkpoint_count},
 		{"cfg_set_read_only", lbox_cfg_set_read_only},
 		{"cfg_set_memtx_max_tuple_size", lbox_cfg_set_memtx_max_tuple_size},
+		{"cfg_set_memtx_snapshot_threads", lbox_cfg_set_memtx_snapshot_threads},
+		{"cfg_set_sql_cache_size", lbox_cfg_set_sql_cache_size},
 		{"cfg_set_vinyl_max_tuple_size", lbox_cfg_set_vinyl_max_tuple_size},
 		{"cfg_set_vinyl_timeout", lbox_cfg_set_vinyl_timeout},
+		{"cfg_set_vinyl_page_cache", lbox_cfg_set_vinyl_page_cache},
+		{"cfg_set_vinyl_dump_rate_limit",
+			lbox_cfg_set_vinyl_dump_rate_limit},
+		{"cfg_set_vinyl_compact_rate_limit",
+			lbox_cfg_set_vinyl_compact_rate_limit},
+		{"cfg_set_vinyl_wal_latency_target",
+			lbox_cfg_set_vinyl_wal_latency_target},
+		{"cfg_set_wal_group_commit", lbox_cfg_set_wal_group_commit},
 		{"cfg_set_replication_timeout", lbox_cfg_set_replication_timeout},
+		{"cfg_set_replication_apply_fibers", lbox_cfg_set_replication_apply_fibers},
 		{NULL, NULL}
 	};
 
@@ -52,6 +52,7 @@
 #include "fiber.h"
 
 #include "box/vinyl.h"
+#include "box/sql_stmt_cache.h"
 
 static void
 lbox_pushvclock(struct lua_State *L, const struct vclock *vclock)
@@ -92,6 +93,20 @@ lbox_pushapplier(lua_State *L, struct applier *applier)
 			       applier->last_row_time);
 		lua_settable(L, -3);
 
+		lua_pushstring(L, "rows");
+		luaL_pushint64(L, applier->row_count);
+		lua_settable(L, -3);
+
+		lua_pushstring(L, "rps");
+		lua_pushnumber(L, applier->rps);
+		lua_settable(L, -3);
+
+		lua_pushstring(L, "batch");
+		lua_pushnumber(L, applier->batch_count == 0 ? 0 :
+			       (double)applier->row_count /
+			       applier->batch_count);
+		lua_settable(L, -3);
+
 		struct error *e = diag_last_error(&applier->reader->diag);
 		if (e != NULL) {
 			lua_pushstring(L, "message");
@@ -383,6 +398,33 @@ lbox_info_vinyl(struct lua_State *L)
 	return 1;
 }
 
+static int
+lbox_info_sql_call(struct lua_State *L)
+{
+	struct info_handler h;
+	luaT_info_handler_create(&h, L);
+	info_begin(&h);
+	sql_stmt_cache_info(&h);
+	info_end(&h);
+	return 1;
+}
+
+static int
+lbox_info_sql(struct lua_State *L)
+{
+	lua_newtable(L);
+
+	lua_newtable(L); /* metatable */
+
+	lua_pushstring(L, "__call");
+	lua_pushcfunction(L, lbox_info_sql_call);
+	lua_settable(L, -3);
+
+	lua_setmetatable(L, -2);
+
+	return 1;
+}
+
 static const struct luaL_Reg lbox_info_dynamic_meta[] = {
 	{"id", lbox_info_id},
 	{"uuid", lbox_info_uuid},
@@ -396,6 +438,7 @@ static const struct luaL_Reg lbox_info_dynamic_meta[] = {
 	{"pid", lbox_info_pid},
 	{"cluster", lbox_info_cluster},
 	{"vinyl", lbox_info_vinyl},
+	{"sql", lbox_info_sql},
 	{NULL, NULL}
 };
 
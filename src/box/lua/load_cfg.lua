@@ -12,6 +12,8 @@ local default_cfg = {
     memtx_memory        = 256 * 1024 *1024,
     memtx_min_tuple_size = 16,
     memtx_max_tuple_size = 1024 * 1024,
+    memtx_snapshot_threads = 1,
+    iproto_threads      = 1,
     slab_alloc_factor   = 1.05,
     work_dir            = nil,
     memtx_dir           = ".",
@@ -20,6 +22,7 @@ local default_cfg = {
     vinyl_dir           = '.',
     vinyl_memory        = 128 * 1024 * 1024,
     vinyl_cache         = 128 * 1024 * 1024,
+    vinyl_page_cache    = 64 * 1024 * 1024,
     vinyl_max_tuple_size = 1024 * 1024,
     vinyl_read_threads  = 1,
     vinyl_write_threads = 2,
@@ -29,6 +32,9 @@ local default_cfg = {
     vinyl_range_size          = 1024 * 1024 * 1024,
     vinyl_page_size           = 8 * 1024,
     vinyl_bloom_fpr           = 0.05,
+    vinyl_dump_rate_limit     = nil, -- no limit
+    vinyl_compact_rate_limit  = nil, -- no limit
+    vinyl_wal_latency_target  = nil, -- no adaptive throttling
     log                 = nil,
     log_nonblock        = true,
     log_level           = 5,
@@ -41,6 +47,8 @@ local default_cfg = {
     rows_per_wal        = 500000,
     wal_max_size        = 256 * 1024 * 1024,
     wal_dir_rescan_delay= 2,
+    wal_group_commit_delay = 0,
+    wal_group_commit_size = 1024 * 1024,
     force_recovery      = false,
     replication         = nil,
     custom_proc_title   = nil,
@@ -54,6 +62,8 @@ local default_cfg = {
     checkpoint_count    = 2,
     worker_pool_threads = 4,
     replication_timeout = 1,
+    replication_apply_fibers = 1,
+    sql_cache_size      = 5 * 1024 * 1024,
 }
 
 -- types of available options
@@ -63,6 +73,8 @@ local template_cfg = {
     memtx_memory        = 'number',
     memtx_min_tuple_size  = 'number',
     memtx_max_tuple_size  = 'number',
+    memtx_snapshot_threads = 'number',
+    iproto_threads      = 'number',
     slab_alloc_factor   = 'number',
     work_dir            = 'string',
     memtx_dir            = 'string',
@@ -70,6 +82,7 @@ local template_cfg = {
     vinyl_dir           = 'string',
     vinyl_memory        = 'number',
     vinyl_cache               = 'number',
+    vinyl_page_cache          = 'number',
     vinyl_max_tuple_size      = 'number',
     vinyl_read_threads        = 'number',
     vinyl_write_threads       = 'number',
@@ -79,6 +92,9 @@ local template_cfg = {
     vinyl_range_size          = 'number',
     vinyl_page_size           = 'number',
     vinyl_bloom_fpr           = 'number',
+    vinyl_dump_rate_limit     = 'number',
+    vinyl_compact_rate_limit  = 'number',
+    vinyl_wal_latency_target  = 'number',
 
     log              = 'string',
     log_nonblock     = 'boolean',
@@ -92,6 +108,8 @@ local template_cfg = {
     rows_per_wal        = 'number',
     wal_max_size        = 'number',
     wal_dir_rescan_delay= 'number',
+    wal_group_commit_delay = 'number',
+    wal_group_commit_size = 'number',
     force_recovery      = 'boolean',
     replication         = 'string, number, table',
     custom_proc_title   = 'string',
@@ -105,6 +123,8 @@ local template_cfg = {
     hot_standby         = 'boolean',
     worker_pool_threads = 'number',
     replication_timeout = 'number',
+    replication_apply_fibers = 'number',
+    sql_cache_size      = 'number',
 }
 
 local function normalize_uri(port)
@@ -159,11 +179,19 @@ local dynamic_cfg = {
     snap_io_rate_limit      = private.cfg_set_snap_io_rate_limit,
     read_only               = private.cfg_set_read_only,
     memtx_max_tuple_size    = private.cfg_set_memtx_max_tuple_size,
+    memtx_snapshot_threads  = private.cfg_set_memtx_snapshot_threads,
     vinyl_max_tuple_size    = private.cfg_set_vinyl_max_tuple_size,
     vinyl_timeout           = private.cfg_set_vinyl_timeout,
+    vinyl_page_cache        = private.cfg_set_vinyl_page_cache,
+    vinyl_dump_rate_limit   = private.cfg_set_vinyl_dump_rate_limit,
+    vinyl_compact_rate_limit = private.cfg_set_vinyl_compact_rate_limit,
+    vinyl_wal_latency_target = private.cfg_set_vinyl_wal_latency_target,
     checkpoint_count        = private.cfg_set_checkpoint_count,
     checkpoint_interval     = private.checkpoint_daemon.set_checkpoint_interval,
     worker_pool_threads     = private.cfg_set_worker_pool_threads,
+    sql_cache_size          = private.cfg_set_sql_cache_size,
+    wal_group_commit_delay  = private.cfg_set_wal_group_commit,
+    wal_group_commit_size   = private.cfg_set_wal_group_commit,
     -- do nothing, affects new replicas, which query this value on start
     wal_dir_rescan_delay    = function() end,
     custom_proc_title       = function()
@@ -171,6 +199,7 @@ local dynamic_cfg = {
     end,
     force_recovery          = function() end,
     replication_timeout     = private.cfg_set_replication_timeout,
+    replication_apply_fibers = private.cfg_set_replication_apply_fibers,
 }
 
 local dynamic_cfg_skip_at_load = {
@@ -178,6 +207,7 @@ local dynamic_cfg_skip_at_load = {
     listen                  = true,
     replication             = true,
     replication_timeout     = true,
+    replication_apply_fibers = true,
     wal_dir_rescan_delay    = true,
     custom_proc_title       = true,
     force_recovery          = true,
@@ -111,6 +111,53 @@ lbox_select(lua_State *L)
 	return 1; /* lua table with tuples */
 }
 
+/**
+ * index:get_many(): select tuples matching each of the given
+ * keys. Returns a table with a table of found tuples per key.
+ */
+static int
+lbox_select_many(lua_State *L)
+{
+	if (lua_gettop(L) != 5 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
+	    !lua_isnumber(L, 3) || !lua_isnumber(L, 4) || !lua_istable(L, 5)) {
+		return luaL_error(L, "Usage index:get_many(keys, opts)");
+	}
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	uint32_t index_id = lua_tonumber(L, 2);
+	int iterator = lua_tonumber(L, 3);
+	uint32_t limit = lua_tonumber(L, 4);
+
+	size_t keys_len;
+	const char *keys = lbox_encode_tuple_on_gc(L, 5, &keys_len);
+	uint32_t key_count = lua_objlen(L, 5);
+	uint32_t *found = (uint32_t *)
+		region_alloc_xc(&fiber()->gc, key_count * sizeof(*found));
+
+	struct port port;
+	port_create(&port);
+	if (box_select_many(&port, found, space_id, index_id, iterator,
+			    limit, keys, keys + keys_len) != 0) {
+		port_destroy(&port);
+		return luaT_error(L);
+	}
+
+	/* See the comment in lbox_select() about leaking the port. */
+	lua_createtable(L, key_count, 0);
+	struct port_entry *entry = port.first;
+	for (uint32_t i = 0; i < key_count; i++) {
+		lua_createtable(L, found[i], 0);
+		for (uint32_t j = 0; j < found[i]; j++) {
+			luaT_pushtuple(L, entry->tuple);
+			lua_rawseti(L, -2, j + 1);
+			entry = entry->next;
+		}
+		lua_rawseti(L, -2, i + 1);
+	}
+	port_destroy(&port);
+	return 1; /* lua table with a table of tuples per key */
+}
+
 /* }}} */
 
 void
@@ -118,6 +165,7 @@ box_lua_misc_init(struct lua_State *L)
 {
 	static const struct luaL_Reg boxlib_internal[] = {
 		{"select", lbox_select},
+		{"select_many", lbox_select_many},
 		{NULL, NULL}
 	};
 
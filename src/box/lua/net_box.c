@@ -268,6 +268,54 @@ netbox_encode_select(lua_State *L)
 	return 0;
 }
 
+static int
+netbox_encode_select_many(lua_State *L)
+{
+	if (lua_gettop(L) < 8 || !lua_istable(L, 8))
+		return luaL_error(L, "Usage netbox.encode_select_many(ibuf, "
+				  "sync, schema_version, space_id, index_id, "
+				  "iterator, limit, keys)");
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_SELECT_MANY);
+
+	luamp_encode_map(cfg, &stream, 5);
+
+	uint32_t space_id = lua_tonumber(L, 4);
+	uint32_t index_id = lua_tonumber(L, 5);
+	int iterator = lua_tointeger(L, 6);
+	uint32_t limit = lua_tonumber(L, 7);
+
+	/* encode space_id */
+	luamp_encode_uint(cfg, &stream, IPROTO_SPACE_ID);
+	luamp_encode_uint(cfg, &stream, space_id);
+
+	/* encode index_id */
+	luamp_encode_uint(cfg, &stream, IPROTO_INDEX_ID);
+	luamp_encode_uint(cfg, &stream, index_id);
+
+	/* encode iterator */
+	luamp_encode_uint(cfg, &stream, IPROTO_ITERATOR);
+	luamp_encode_uint(cfg, &stream, iterator);
+
+	/* encode limit */
+	luamp_encode_uint(cfg, &stream, IPROTO_LIMIT);
+	luamp_encode_uint(cfg, &stream, limit);
+
+	/* encode keys, each one is converted like a select key */
+	luamp_encode_uint(cfg, &stream, IPROTO_KEY);
+	uint32_t key_count = lua_objlen(L, 8);
+	luamp_encode_array(cfg, &stream, key_count);
+	for (uint32_t i = 1; i <= key_count; i++) {
+		lua_rawgeti(L, 8, i);
+		luamp_convert_key(L, cfg, &stream, lua_gettop(L));
+		lua_pop(L, 1);
+	}
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
 static inline int
 netbox_encode_insert_or_replace(lua_State *L, uint32_t reqtype)
 {
@@ -554,6 +602,33 @@ handle_error:
 	return 2;
 }
 
+/**
+ * Encode bind parameters and options of an EXECUTE request.
+ * The statement is referenced by the value at stack index 4,
+ * which is encoded under @a key.
+ */
+static void
+netbox_encode_execute_body(lua_State *L, struct mpstream *stream,
+			   enum iproto_key key)
+{
+	luamp_encode_map(cfg, stream, 3);
+
+	luamp_encode_uint(cfg, stream, key);
+	if (key == IPROTO_STMT_ID) {
+		luamp_encode_uint(cfg, stream, lua_tointeger(L, 4));
+	} else {
+		size_t len;
+		const char *query = lua_tolstring(L, 4, &len);
+		luamp_encode_str(cfg, stream, query, len);
+	}
+
+	luamp_encode_uint(cfg, stream, IPROTO_SQL_BIND);
+	luamp_encode_tuple(L, cfg, stream, 5);
+
+	luamp_encode_uint(cfg, stream, IPROTO_SQL_OPTIONS);
+	luamp_encode_tuple(L, cfg, stream, 6);
+}
+
 static int
 netbox_encode_execute(lua_State *L)
 {
@@ -563,20 +638,41 @@ netbox_encode_execute(lua_State *L)
 				  "options)");
 	struct mpstream stream;
 	size_t svp = netbox_prepare_request(L, &stream, IPROTO_EXECUTE);
+	netbox_encode_execute_body(L, &stream, IPROTO_SQL_TEXT);
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
 
-	luamp_encode_map(cfg, &stream, 3);
+static int
+netbox_encode_execute_prepared(lua_State *L)
+{
+	if (lua_gettop(L) < 6)
+		return luaL_error(L, "Usage: netbox.encode_execute_prepared("\
+				  "ibuf, sync, schema_version, stmt_id, "\
+				  "parameters, options)");
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_EXECUTE);
+	netbox_encode_execute_body(L, &stream, IPROTO_STMT_ID);
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+static int
+netbox_encode_prepare(lua_State *L)
+{
+	if (lua_gettop(L) < 4)
+		return luaL_error(L, "Usage: netbox.encode_prepare(ibuf, "\
+				  "sync, schema_version, query)");
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_PREPARE);
+
+	luamp_encode_map(cfg, &stream, 1);
 
 	size_t len;
 	const char *query = lua_tolstring(L, 4, &len);
 	luamp_encode_uint(cfg, &stream, IPROTO_SQL_TEXT);
 	luamp_encode_str(cfg, &stream, query, len);
 
-	luamp_encode_uint(cfg, &stream, IPROTO_SQL_BIND);
-	luamp_encode_tuple(L, cfg, &stream, 5);
-
-	luamp_encode_uint(cfg, &stream, IPROTO_SQL_OPTIONS);
-	luamp_encode_tuple(L, cfg, &stream, 6);
-
 	netbox_encode_request(&stream, svp);
 	return 0;
 }
@@ -590,12 +686,15 @@ luaopen_net_box(struct lua_State *L)
 		{ "encode_call",    netbox_encode_call },
 		{ "encode_eval",    netbox_encode_eval },
 		{ "encode_select",  netbox_encode_select },
+		{ "encode_select_many", netbox_encode_select_many },
 		{ "encode_insert",  netbox_encode_insert },
 		{ "encode_replace", netbox_encode_replace },
 		{ "encode_delete",  netbox_encode_delete },
 		{ "encode_update",  netbox_encode_update },
 		{ "encode_upsert",  netbox_encode_upsert },
 		{ "encode_execute", netbox_encode_execute},
+		{ "encode_execute_prepared", netbox_encode_execute_prepared},
+		{ "encode_prepare", netbox_encode_prepare},
 		{ "encode_auth",    netbox_encode_auth },
 		{ "decode_greeting",netbox_decode_greeting },
 		{ "communicate",    netbox_communicate },
@@ -39,6 +39,8 @@ local IPROTO_SCHEMA_VERSION_KEY = 0x05
 local IPROTO_METADATA_KEY = 0x32
 local IPROTO_SQL_INFO_KEY = 0x43
 local IPROTO_SQL_ROW_COUNT_KEY = 0x44
+local IPROTO_STMT_ID_KEY = 0x45
+local IPROTO_SQL_BIND_COUNT_KEY = 0x46
 local IPROTO_FIELD_NAME_KEY = 0x29
 local IPROTO_DATA_KEY      = 0x30
 local IPROTO_ERROR_KEY     = 0x31
@@ -64,7 +66,10 @@ local method_codec           = {
     update  = internal.encode_update,
     upsert  = internal.encode_upsert,
     select  = internal.encode_select,
+    select_many = internal.encode_select_many,
     execute = internal.encode_execute,
+    execute_prepared = internal.encode_execute_prepared,
+    prepare = internal.encode_prepare,
     -- inject raw data into connection, used by console and tests
     inject = function(buf, id, schema_version, bytes)
         local ptr = buf:reserve(#bytes)
@@ -77,7 +82,9 @@ local function next_id(id) return band(id + 1, 0x7FFFFFFF) end
 
 -- function create_transport(host, port, user, password, callback)
 --
--- Transport methods: connect(), close(), perfrom_request(), wait_state()
+-- Transport methods: connect(), close(), perfrom_request(), wait_state(),
+-- perform_async_request(), is_request_ready(), wait_request(),
+-- discard_request()
 --
 -- Basically, *transport* is a TCP connection speaking one of
 -- Tarantool network protocols. This is a low-level interface.
@@ -224,11 +231,17 @@ local function create_transport(host, port, user, password, callback)
     end
 
     -- REQUEST/RESPONSE --
-    local function perform_request(timeout, buffer, method, schema_version, ...)
+
+    -- Encode a request into the send buffer and register it as
+    -- 'in flight' without waiting for the response. The caller
+    -- must keep a reference to the returned request object: the
+    -- requests table is weak. Requests encoded without a yield
+    -- in between share one worker wakeup and go out in a single
+    -- write.
+    local function perform_async_request(buffer, method, schema_version, ...)
         if state ~= 'active' then
-            return last_errno or E_NO_CONNECTION, last_error
+            return nil, last_errno or E_NO_CONNECTION, last_error
         end
-        local deadline = fiber_clock() + (timeout or TIMEOUT_INFINITY)
         -- alert worker to notify it of the queued outgoing data;
         -- if the buffer wasn't empty, assume the worker was already alerted
         if send_buf:size() == 0 then
@@ -237,31 +250,92 @@ local function create_transport(host, port, user, password, callback)
         local id = next_request_id
         method_codec[method](send_buf, id, schema_version, ...)
         next_request_id = next_id(id)
-        -- reserve space for 8 keys: client, method,
+        -- reserve space for 9 keys: id, client, method,
         -- schema_version, buffer, errno, response, metadata,
         -- sql_info.
-        local request = table_new(0, 8)
-        request.client = fiber_self()
+        local request = table_new(0, 9)
+        request.id = id
         request.method = method
         request.schema_version = schema_version
         request.buffer = buffer
         requests[id] = request
+        return request
+    end
+
+    -- Check if the response to a request has arrived or the
+    -- request has been cancelled.
+    local function is_request_ready(request)
+        return requests[request.id] ~= request
+    end
+
+    -- Wait for a request completion until the deadline.
+    -- Returns false on timeout, the request stays in flight.
+    -- Several fibers may wait for the same request: the first
+    -- one is stored in request.client, the others in the
+    -- request.clients set, allocated only when needed.
+    local function wait_request(request, deadline)
+        local client = fiber_self()
+        local is_first = request.client == nil
+        if is_first then
+            request.client = client
+        else
+            if request.clients == nil then
+                request.clients = {}
+            end
+            request.clients[client] = true
+        end
+        local is_ready = true
         repeat
             local timeout = max(0, deadline - fiber_clock())
             if not state_cond:wait(timeout) then
-                requests[id] = nil
-                return E_TIMEOUT, 'Timeout exceeded'
+                is_ready = is_request_ready(request)
+                break
             end
-        until requests[id] == nil -- i.e. completed (beware spurious wakeups)
+        until is_request_ready(request) -- beware spurious wakeups
+        if is_first then
+            request.client = nil
+        else
+            request.clients[client] = nil
+        end
+        return is_ready
+    end
+
+    -- Forget a request, its response will be dropped.
+    local function discard_request(request)
+        if requests[request.id] == request then
+            requests[request.id] = nil
+        end
+    end
+
+    local function perform_request(timeout, buffer, method, schema_version, ...)
+        local deadline = fiber_clock() + (timeout or TIMEOUT_INFINITY)
+        local request, errno, err = perform_async_request(buffer, method,
+                                                          schema_version, ...)
+        if request == nil then
+            return errno, err
+        end
+        if not wait_request(request, deadline) then
+            discard_request(request)
+            return E_TIMEOUT, 'Timeout exceeded'
+        end
         return request.errno, request.response, request.metadata, request.info
     end
 
     local function wakeup_client(client)
-        if client:status() ~= 'dead' then
+        if client ~= nil and client:status() ~= 'dead' then
             client:wakeup()
         end
     end
 
+    local function wakeup_clients(request)
+        wakeup_client(request.client)
+        if request.clients ~= nil then
+            for client in pairs(request.clients) do
+                wakeup_client(client)
+            end
+        end
+    end
+
     local function dispatch_response_iproto(hdr, body_rpos, body_end)
         local id = hdr[IPROTO_SYNC_KEY]
         local request = requests[id]
@@ -278,7 +352,7 @@ local function create_transport(host, port, user, password, callback)
             assert(body_end == body_end_check, "invalid xrow length")
             request.errno = band(status, IPROTO_ERRNO_MASK)
             request.response = body[IPROTO_ERROR_KEY]
-            wakeup_client(request.client)
+            wakeup_clients(request)
             return
         end
 
@@ -289,7 +363,7 @@ local function create_transport(host, port, user, password, callback)
             local wpos = buffer:alloc(body_len)
             ffi.copy(wpos, body_rpos, body_len)
             request.response = tonumber(body_len)
-            wakeup_client(request.client)
+            wakeup_clients(request)
             return
         end
 
@@ -299,7 +373,7 @@ local function create_transport(host, port, user, password, callback)
         request.response = body[IPROTO_DATA_KEY]
         request.metadata = body[IPROTO_METADATA_KEY]
         request.info = body[IPROTO_SQL_INFO_KEY]
-        wakeup_client(request.client)
+        wakeup_clients(request)
     end
 
     local function new_request_id()
@@ -410,7 +484,7 @@ local function create_transport(host, port, user, password, callback)
             end
             requests[rid] = nil
             request.response = response
-            wakeup_client(request.client)
+            wakeup_clients(request)
             return console_sm(next_id(rid))
         end
     end
@@ -517,7 +591,11 @@ local function create_transport(host, port, user, password, callback)
         close           = close,
         connect         = connect,
         wait_state      = wait_state,
-        perform_request = perform_request
+        perform_request = perform_request,
+        perform_async_request = perform_async_request,
+        is_request_ready = is_request_ready,
+        wait_request    = wait_request,
+        discard_request = discard_request
     }
 end
 
@@ -710,12 +788,143 @@ function remote_methods:request_timeout(request_opts)
     return timeout
 end
 
+-- Convert a response body to what a request method returns.
+local function request_result(method, res)
+    setmetatable(res, sequence_mt)
+    local tnew = box.tuple.new
+    if method == 'select_many' then
+        -- A table of tuples per key.
+        for _, tuples in pairs(res) do
+            setmetatable(tuples, sequence_mt)
+            for i, v in pairs(tuples) do
+                tuples[i] = tnew(v)
+            end
+        end
+    elseif method ~= 'eval' and method ~= 'call_17' then
+        for i, v in pairs(res) do
+            res[i] = tnew(v)
+        end
+    end
+    return res
+end
+
+--
+-- A future is returned by a request issued with {is_async = true}.
+-- It references the request in flight, so the response is not
+-- lost even if nobody waits for it at the moment. A request that
+-- fails because of a schema change is transparently resent when
+-- the future is waited for, like a synchronous one.
+--
+local future_methods = {}
+local future_mt = {
+    __index = future_methods,
+    __serialize = function(self)
+        return {method = self.method, is_ready = self:is_ready()}
+    end,
+}
+
+-- Create a box error object without raising it.
+local function make_error(code, reason)
+    local _, err = pcall(box.error, {code = code, reason = reason})
+    return err
+end
+
+local function future_new(remote, request, method, buffer, ...)
+    return setmetatable({
+        remote = remote, request = request, method = method,
+        buffer = buffer, args = {n = select('#', ...), ...},
+    }, future_mt)
+end
+
+local function check_future_arg(future, method)
+    if type(future) ~= 'table' or future.remote == nil then
+        local fmt = 'Use future:%s(...) instead of future.%s(...)'
+        box.error(E_PROC_LUA, string.format(fmt, method, method))
+    end
+end
+
+function future_methods:is_ready()
+    check_future_arg(self, 'is_ready')
+    return self.request == nil or
+           self.remote._transport.is_request_ready(self.request)
+end
+
+--
+-- Wait for the response. Returns the result on success or nil
+-- and the error object on failure or timeout. A timed out future
+-- can be waited for again.
+--
+function future_methods:wait_result(timeout)
+    check_future_arg(self, 'wait_result')
+    local remote = self.remote
+    local transport = remote._transport
+    local deadline = fiber_clock() + (timeout or TIMEOUT_INFINITY)
+    local method, buffer, args = self.method, self.buffer, self.args
+    while true do
+        local request = self.request
+        if request == nil then
+            if self.errno ~= E_WRONG_SCHEMA_VERSION then
+                break
+            end
+            -- Resend the request with the new schema version.
+            transport.wait_state('active', max(0, deadline - fiber_clock()))
+            local errno, err
+            self.request, errno, err =
+                transport.perform_async_request(buffer, method,
+                                                remote.schema_version,
+                                                unpack(args, 1, args.n))
+            self.errno, self.response = errno, err
+        else
+            if not transport.wait_request(request, deadline) then
+                return nil, make_error(E_TIMEOUT, 'Timeout exceeded')
+            end
+            -- Skip if discarded or resent by another fiber
+            -- while we were waiting.
+            if self.request == request then
+                self.request = nil
+                self.errno, self.response = request.errno, request.response
+                if not self.errno and buffer == nil then
+                    self.response = request_result(method, self.response)
+                end
+            end
+        end
+    end
+    if self.errno then
+        return nil, make_error(self.errno, self.response)
+    end
+    return self.response
+end
+
+--
+-- Drop the request: the response, if it arrives, is ignored and
+-- wait_result() fails.
+--
+function future_methods:discard()
+    check_future_arg(self, 'discard')
+    if self.request ~= nil then
+        self.remote._transport.discard_request(self.request)
+        self.request = nil
+        self.errno, self.response = E_PROC_LUA, 'Response is discarded'
+    end
+end
+
 function remote_methods:_request(method, opts, ...)
     local this_fiber = fiber_self()
     local transport = self._transport
     local perform_request = transport.perform_request
     local wait_state = transport.wait_state
     local deadline = nil
+    local buffer = opts and opts.buffer
+    if opts and opts.is_async then
+        local request, err, res =
+            transport.perform_async_request(buffer, method,
+                                            self.schema_version, ...)
+        local future = future_new(self, request, method, buffer, ...)
+        if request == nil then
+            future.errno, future.response = err, res
+        end
+        return future
+    end
     if opts and opts.timeout then
         -- conn.space:request(, { timeout = timeout })
         deadline = fiber_clock() + opts.timeout
@@ -724,7 +933,6 @@ function remote_methods:_request(method, opts, ...)
         -- @deprecated since 1.7.4
         deadline = self._deadlines[this_fiber]
     end
-    local buffer = opts and opts.buffer
     local err, res
     repeat
         local timeout = deadline and max(0, deadline - fiber_clock())
@@ -737,15 +945,7 @@ function remote_methods:_request(method, opts, ...)
         if not err and buffer ~= nil then
             return res -- the length of xrow.body
         elseif not err then
-            setmetatable(res, sequence_mt)
-            local postproc = method ~= 'eval' and method ~= 'call_17'
-            if postproc then
-                local tnew = box.tuple.new
-                for i, v in pairs(res) do
-                    res[i] = tnew(v)
-                end
-            end
-            return res
+            return request_result(method, res)
         elseif err == E_WRONG_SCHEMA_VERSION then
             err = nil
         end
@@ -753,6 +953,38 @@ function remote_methods:_request(method, opts, ...)
     box.error({code = err, reason = res})
 end
 
+--
+-- Send a batch of calls and evals in one go and return an array
+-- of futures, one per request. Each entry of the batch is
+-- {'call', func_name, args} or {'eval', expression, args}. All
+-- requests are encoded into the send buffer without yielding, so
+-- the whole batch leaves with a single write and no fiber is
+-- spawned per request.
+--
+function remote_methods:pipeline(batch, opts)
+    check_remote_arg(self, 'pipeline')
+    if type(batch) ~= 'table' then
+        error("Use remote:pipeline({{'call', func_name, args}, ...}, opts)")
+    end
+    local buffer = opts and opts.buffer
+    local async_opts = {is_async = true, buffer = buffer}
+    local futures = table_new(#batch, 0)
+    for i, req in ipairs(batch) do
+        local kind, name, args = req[1], req[2], req[3]
+        if kind == 'call' then
+            check_call_args(args)
+            futures[i] = self:_request('call_17', async_opts,
+                                       tostring(name), args or {})
+        elseif kind == 'eval' then
+            check_eval_args(args)
+            futures[i] = self:_request('eval', async_opts, name, args or {})
+        else
+            error("pipeline() supports only 'call' and 'eval' requests")
+        end
+    end
+    return futures
+end
+
 function remote_methods:ping(opts)
     check_remote_arg(self, 'ping')
     local timeout = self:request_timeout(opts)
@@ -778,7 +1010,7 @@ function remote_methods:call(func_name, args, opts)
     check_call_args(args)
     args = args or {}
     local res = self:_request('call_17', opts, tostring(func_name), args)
-    if type(res) ~= 'table' then
+    if type(res) ~= 'table' or (opts and opts.is_async) then
         return res
     end
     return unpack(res)
@@ -795,12 +1027,21 @@ function remote_methods:eval(code, args, opts)
     check_eval_args(args)
     args = args or {}
     local res = self:_request('eval', opts, code, args)
-    if type(res) ~= 'table' then
+    if type(res) ~= 'table' or (opts and opts.is_async) then
         return res
     end
     return unpack(res)
 end
 
+-- Set readable names for the metadata fields.
+local function sql_decode_metadata(metadata)
+    for i, field_meta in pairs(metadata) do
+        field_meta["name"] = field_meta[IPROTO_FIELD_NAME_KEY]
+        field_meta[IPROTO_FIELD_NAME_KEY] = nil
+    end
+    return metadata
+end
+
 function remote_methods:execute(query, parameters, sql_opts, netbox_opts)
     check_remote_arg(self, "execute")
     if sql_opts ~= nil then
@@ -810,8 +1051,14 @@ function remote_methods:execute(query, parameters, sql_opts, netbox_opts)
     local buffer = netbox_opts and netbox_opts.buffer
     parameters = parameters or {}
     sql_opts = sql_opts or {}
+    -- A statement returned by prepare() is referenced by id.
+    local method = 'execute'
+    if type(query) == 'table' and query.stmt_id ~= nil then
+        method = 'execute_prepared'
+        query = query.stmt_id
+    end
     local err, res, metadata, info = self._transport.perform_request(timeout,
-                                    buffer, 'execute', self.schema_version,
+                                    buffer, method, self.schema_version,
                                     query, parameters, sql_opts)
     if err then
         box.error({code = err, reason = res})
@@ -825,13 +1072,23 @@ function remote_methods:execute(query, parameters, sql_opts, netbox_opts)
         assert(info[IPROTO_SQL_ROW_COUNT_KEY] ~= nil)
         return {rowcount = info[IPROTO_SQL_ROW_COUNT_KEY]}
     end
-    -- Set readable names for the metadata fields.
-    for i, field_meta in pairs(metadata) do
-        field_meta["name"] = field_meta[IPROTO_FIELD_NAME_KEY]
-        field_meta[IPROTO_FIELD_NAME_KEY] = nil
-    end
     setmetatable(res, sequence_mt)
-    return {metadata = metadata, rows = res}
+    return {metadata = sql_decode_metadata(metadata), rows = res}
+end
+
+function remote_methods:prepare(query, netbox_opts)
+    check_remote_arg(self, "prepare")
+    local timeout = self:request_timeout(netbox_opts)
+    local err, res, metadata, info = self._transport.perform_request(timeout,
+                                    nil, 'prepare', self.schema_version,
+                                    query)
+    if err then
+        box.error({code = err, reason = res})
+    end
+    assert(info ~= nil and info[IPROTO_STMT_ID_KEY] ~= nil)
+    return {stmt_id = info[IPROTO_STMT_ID_KEY],
+            bind_count = info[IPROTO_SQL_BIND_COUNT_KEY],
+            metadata = metadata and sql_decode_metadata(metadata)}
 end
 
 function remote_methods:wait_state(state, timeout)
@@ -975,7 +1232,7 @@ function console_methods:eval(line, timeout)
 end
 
 local function one_tuple(tab)
-    if type(tab) ~= 'table' then
+    if type(tab) ~= 'table' or getmetatable(tab) == future_mt then
         return tab
     elseif tab[1] ~= nil then
         return tab[1]
@@ -1021,6 +1278,11 @@ space_metatable = function(remote)
         return check_primary_index(self):get(key, opts)
     end
 
+    function methods:get_many(keys, opts)
+        check_space_arg(self, 'get_many')
+        return check_primary_index(self):get_many(keys, opts)
+    end
+
     function methods:format(format)
         if format == nil then
             return self._format
@@ -1051,17 +1313,38 @@ index_metatable = function(remote)
         if opts and opts.buffer then
             error("index:get() doesn't support `buffer` argument")
         end
+        if opts and opts.is_async then
+            error("index:get() doesn't support `is_async` argument")
+        end
         local res = remote:_request('select', opts, self.space.id, self.id,
                                     box.index.EQ, 0, 2, key)
         if res[2] ~= nil then box.error(box.error.MORE_THAN_ONE_TUPLE) end
         if res[1] ~= nil then return res[1] end
     end
 
+    -- Look up a batch of keys with a single request. Returns a
+    -- table with a table of tuples per key, at most opts.limit
+    -- (1 by default) tuples each.
+    function methods:get_many(keys, opts)
+        check_index_arg(self, 'get_many')
+        if type(keys) ~= 'table' then
+            box.error(box.error.ILLEGAL_PARAMS,
+                      "Usage: index:get_many({key1, key2, ...}, opts)")
+        end
+        local iterator = check_iterator_type(opts, false)
+        local limit = tonumber(opts and opts.limit) or 1
+        return remote:_request('select_many', opts, self.space.id, self.id,
+                               iterator, limit, keys)
+    end
+
     function methods:min(key, opts)
         check_index_arg(self, 'min')
         if opts and opts.buffer then
             error("index:min() doesn't support `buffer` argument")
         end
+        if opts and opts.is_async then
+            error("index:min() doesn't support `is_async` argument")
+        end
         local res = remote:_request('select', opts, self.space.id, self.id,
                                     box.index.GE, 0, 1, key)
         return one_tuple(res)
@@ -1072,6 +1355,9 @@ index_metatable = function(remote)
         if opts and opts.buffer then
             error("index:max() doesn't support `buffer` argument")
         end
+        if opts and opts.is_async then
+            error("index:max() doesn't support `is_async` argument")
+        end
         local res = remote:_request('select', opts, self.space.id, self.id,
                                     box.index.LE, 0, 1, key)
         return one_tuple(res)
@@ -1082,6 +1368,9 @@ index_metatable = function(remote)
         if opts and opts.buffer then
             error("index:count() doesn't support `buffer` argument")
         end
+        if opts and opts.is_async then
+            error("index:count() doesn't support `is_async` argument")
+        end
         local code = string.format('box.space.%s.index.%s:count',
                                    self.space.name, self.name)
         return remote:_request('call_16', opts, code, { key })[1][1]
@@ -359,6 +359,7 @@ box.schema.space.create = function(name, options)
         user = 'string, number',
         format = 'table',
         temporary = 'boolean',
+        full_field_map = 'boolean',
     }
     local options_defaults = {
         engine = 'memtx',
@@ -402,6 +403,7 @@ box.schema.space.create = function(name, options)
     -- filter out global parameters from the options array
     local space_options = setmap({
         temporary = options.temporary and true or nil,
+        full_field_map = options.full_field_map and true or nil,
     })
     _space:insert{id, uid, name, options.engine, options.field_count,
         space_options, format}
@@ -607,6 +609,7 @@ local index_options = {
     range_size = 'number',
     page_size = 'number',
     bloom_fpr = 'number',
+    hint = 'boolean',
 }
 
 --
@@ -698,6 +701,7 @@ box.schema.index.create = function(space_id, name, options)
             run_count_per_level = options.run_count_per_level,
             run_size_ratio = options.run_size_ratio,
             bloom_fpr = options.bloom_fpr,
+            hint = options.hint,
     }
     local field_type_aliases = {
         num = 'unsigned'; -- Deprecated since 1.7.2
@@ -1229,6 +1233,25 @@ function box.schema.space.bless(space)
             offset, limit, key)
     end
 
+    -- Select tuples matching each key of a batch in one call.
+    -- Returns a table with a table of tuples per key, at most
+    -- opts.limit (1 by default) tuples each.
+    index_mt.get_many = function(index, keys, opts)
+        check_index_arg(index, 'get_many')
+        if type(keys) ~= 'table' then
+            box.error(box.error.ILLEGAL_PARAMS,
+                      "Usage: index:get_many({key1, key2, ...}, opts)")
+        end
+        local mkeys = {}
+        for i, key in ipairs(keys) do
+            mkeys[i] = keify(key)
+        end
+        local iterator = check_iterator_type(opts, false)
+        local limit = opts and opts.limit or 1
+        return internal.select_many(index.space_id, index.id, iterator,
+                                    limit, mkeys)
+    end
+
     index_mt.update = function(index, key, ops)
         check_index_arg(index, 'update')
         return internal.update(index.space_id, index.id, keify(key), ops);
@@ -1304,6 +1327,10 @@ function box.schema.space.bless(space)
         check_space_arg(space, 'get')
         return check_primary_index(space):get(key)
     end
+    space_mt.get_many = function(space, keys, opts)
+        check_space_arg(space, 'get_many')
+        return check_primary_index(space):get_many(keys, opts)
+    end
     space_mt.select = function(space, key, opts)
         check_space_arg(space, 'select')
         return check_primary_index(space):select(key, opts)
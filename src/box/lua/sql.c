@@ -1,5 +1,6 @@
 #include "sql.h"
 #include "box/sql.h"
+#include "box/sql_stmt_cache.h"
 
 #include "box/sql/sqlite3.h"
 #include "box/info.h"
@@ -189,6 +190,100 @@ lua_push_row(struct lua_State *L, struct prep_stmt_list *l)
 	lua_rawseti(L, -2, 0);
 }
 
+/**
+ * Run the last statement of the list and push its result set,
+ * if the statement returns rows, on the stack.
+ * @param L Lua stack, the statement is at index 1.
+ * @param pl Statement list, may be reallocated.
+ * @param[out] rc Result code of the last sqlite3_step().
+ *
+ * @retval  0 Success or SQL error, see @a rc.
+ * @retval -1 Out of memory.
+ */
+static int
+lua_sql_execute_stmt(struct lua_State *L, struct prep_stmt_list **pl, int *rc)
+{
+	struct prep_stmt_list *l = *pl;
+	struct prep_stmt *ps = l->stmt + l->stmt_count - 1;
+	int column_count = sqlite3_column_count(ps->stmt);
+	if (column_count == 0) {
+		while ((*rc = sqlite3_step(ps->stmt)) == SQLITE_ROW) { ; }
+		return 0;
+	}
+	char *typestr;
+	l->column_count = column_count;
+	l->last_select_stmt_index = l->stmt_count - 1;
+
+	assert(l->pool_size == 0);
+	/* This might possibly call realloc() and ruin *ps.  */
+	typestr = prep_stmt_list_palloc(pl, column_count, 1);
+	if (typestr == NULL)
+		return -1;
+	l = *pl;
+	/* Refill *ps.  */
+	ps = l->stmt + l->stmt_count - 1;
+
+	lua_settop(L, 1); /* discard any results */
+
+	/* create result table */
+	lua_createtable(L, 7, 0);
+	lua_pushvalue(L, lua_upvalueindex(1));
+	lua_setmetatable(L, -2);
+	lua_push_column_names(L, l);
+	lua_rawseti(L, -2, 0);
+
+	int row_count = 0;
+	while ((*rc = sqlite3_step(ps->stmt)) == SQLITE_ROW) {
+		lua_push_row(L, l);
+		row_count++;
+		lua_rawseti(L, -2, row_count);
+	}
+	l->pool_size = 0;
+	return 0;
+}
+
+/**
+ * Execute a statement from the statement cache, referenced by
+ * a table returned by box.sql.prepare().
+ */
+static int
+lua_sql_execute_prepared(struct lua_State *L)
+{
+	lua_getfield(L, 1, "stmt_id");
+	if (!lua_isnumber(L, -1))
+		return luaL_error(L, "usage: box.sql.execute(stmt)");
+	uint32_t stmt_id = lua_tointeger(L, -1);
+	lua_pop(L, 1);
+	struct sql_stmt *stmt = sql_stmt_cache_find(stmt_id);
+	if (stmt == NULL)
+		return luaT_error(L);
+
+	struct prep_stmt_list *l, stock_l;
+	l = prep_stmt_list_init(&stock_l);
+	struct prep_stmt *ps = prep_stmt_list_push(&l);
+	if (ps == NULL)
+		goto outofmem;
+	ps->stmt = stmt->vdbe;
+	int rc;
+	if (lua_sql_execute_stmt(L, &l, &rc) != 0)
+		goto outofmem;
+	/* The statement is owned by the cache, do not finalize it. */
+	l->stmt_count = 0;
+	prep_stmt_list_free(l);
+	if (rc != SQLITE_OK && rc != SQLITE_DONE) {
+		lua_pushstring(L, sqlite3_errmsg(sql_get()));
+		sql_stmt_cache_release(stmt);
+		return lua_error(L);
+	}
+	sql_stmt_cache_release(stmt);
+	return lua_gettop(L) - 1;
+outofmem:
+	l->stmt_count = 0;
+	prep_stmt_list_free(l);
+	sql_stmt_cache_release(stmt);
+	return luaL_error(L, "out of memory");
+}
+
 static int
 lua_sql_execute(struct lua_State *L)
 {
@@ -201,6 +296,9 @@ lua_sql_execute(struct lua_State *L)
 	if (db == NULL)
 		return luaL_error(L, "not ready");
 
+	if (lua_istable(L, 1))
+		return lua_sql_execute_prepared(L);
+
 	sql = lua_tolstring(L, 1, &length);
 	if (sql == NULL)
 		return luaL_error(L, "usage: box.sql.execute(sqlstring)");
@@ -226,39 +324,8 @@ lua_sql_execute(struct lua_State *L)
 			break;
 		}
 
-		int column_count = sqlite3_column_count(ps->stmt);
-		if (column_count == 0) {
-			while ((rc = sqlite3_step(ps->stmt)) == SQLITE_ROW) { ; }
-		} else {
-			char *typestr;
-			l->column_count = column_count;
-			l->last_select_stmt_index = l->stmt_count - 1;
-
-			assert(l->pool_size == 0);
-			/* This might possibly call realloc() and ruin *ps.  */
-			typestr = prep_stmt_list_palloc(&l, column_count, 1);
-			if (typestr == NULL)
-				goto outofmem;
-			/* Refill *ps.  */
-			ps = l->stmt + l->stmt_count - 1;
-
-			lua_settop(L, 1); /* discard any results */
-
-			/* create result table */
-			lua_createtable(L, 7, 0);
-			lua_pushvalue(L, lua_upvalueindex(1));
-			lua_setmetatable(L, -2);
-			lua_push_column_names(L, l);
-			lua_rawseti(L, -2, 0);
-
-			int row_count = 0;
-			while ((rc = sqlite3_step(ps->stmt)) == SQLITE_ROW) {
-				lua_push_row(L, l);
-				row_count++;
-				lua_rawseti(L, -2, row_count);
-			}
-			l->pool_size = 0;
-		}
+		if (lua_sql_execute_stmt(L, &l, &rc) != 0)
+			goto outofmem;
         if (rc != SQLITE_OK && rc != SQLITE_DONE)
             goto sqlerror;
 	} while (sql != sql_end);
@@ -273,6 +340,32 @@ outofmem:
 	return luaL_error(L, "out of memory");
 }
 
+/**
+ * Compile a statement and put it in the statement cache.
+ * Returns a table with the statement id and the number of
+ * parameters, which can be passed to box.sql.execute().
+ */
+static int
+lua_sql_prepare(struct lua_State *L)
+{
+	if (sql_get() == NULL)
+		return luaL_error(L, "not ready");
+	size_t length;
+	const char *sql = lua_tolstring(L, 1, &length);
+	if (sql == NULL)
+		return luaL_error(L, "usage: box.sql.prepare(sqlstring)");
+	struct sql_stmt *stmt = sql_stmt_cache_prepare(sql, length);
+	if (stmt == NULL)
+		return luaT_error(L);
+	lua_createtable(L, 0, 2);
+	lua_pushinteger(L, stmt->id);
+	lua_setfield(L, -2, "stmt_id");
+	lua_pushinteger(L, sqlite3_bind_parameter_count(stmt->vdbe));
+	lua_setfield(L, -2, "bind_count");
+	sql_stmt_cache_release(stmt);
+	return 1;
+}
+
 static int
 lua_sql_debug(struct lua_State *L)
 {
@@ -287,6 +380,7 @@ box_lua_sqlite_init(struct lua_State *L)
 {
 	static const struct luaL_Reg module_funcs [] = {
 		{"execute", lua_sql_execute},
+		{"prepare", lua_sql_prepare},
 		{"debug", lua_sql_debug},
 		{NULL, NULL}
 	};
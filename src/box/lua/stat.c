@@ -39,11 +39,16 @@
 #include <lualib.h>
 
 #include "lua/utils.h"
+#include "cbus.h"
+#include "box/iproto.h"
+#include "box/iproto_constants.h"
+#include "box/wal.h"
+#include "box/schema.h"
+#include "histogram.h"
+#include "latency.h"
 
 extern struct rmean *rmean_box;
 extern struct rmean *rmean_error;
-/** network statistics (iproto & cbus) */
-extern struct rmean *rmean_net;
 extern struct rmean *rmean_tx_wal_bus;
 
 static void
@@ -109,18 +114,165 @@ lbox_stat_call(struct lua_State *L)
 	return 1;
 }
 
+/**
+ * box.stat.net.thread: an array with network statistics of
+ * each iproto thread.
+ */
+static int
+lbox_stat_net_thread(struct lua_State *L)
+{
+	int thread_count = iproto_get_thread_count();
+	lua_createtable(L, thread_count, 0);
+	for (int i = 0; i < thread_count; i++) {
+		lua_newtable(L);
+		iproto_rmean_foreach(i, set_stat_item, L);
+		lua_rawseti(L, -2, i + 1);
+	}
+	return 1;
+}
+
 static int
 lbox_stat_net_index(struct lua_State *L)
 {
-	luaL_checkstring(L, -1);
-	return rmean_foreach(rmean_net, seek_stat_item, L);
+	const char *key = luaL_checkstring(L, -1);
+	if (strcmp(key, "thread") == 0)
+		return lbox_stat_net_thread(L);
+	return iproto_rmean_foreach(-1, seek_stat_item, L);
 }
 
 static int
 lbox_stat_net_call(struct lua_State *L)
 {
 	lua_newtable(L);
-	rmean_foreach(rmean_net, set_stat_item, L);
+	iproto_rmean_foreach(-1, set_stat_item, L);
+	return 1;
+}
+
+static void
+fill_percentiles(struct lua_State *L, const char *name, int64_t p50,
+		 int64_t p90, int64_t p99, int64_t max)
+{
+	lua_pushstring(L, name);
+	lua_newtable(L);
+	lua_pushnumber(L, p50);
+	lua_setfield(L, -2, "p50");
+	lua_pushnumber(L, p90);
+	lua_setfield(L, -2, "p90");
+	lua_pushnumber(L, p99);
+	lua_setfield(L, -2, "p99");
+	lua_pushnumber(L, max);
+	lua_setfield(L, -2, "max");
+	lua_settable(L, -3);
+}
+
+static int
+lbox_stat_wal_call(struct lua_State *L)
+{
+	struct wal_stat stat;
+	wal_get_stat(&stat);
+	lua_newtable(L);
+	lua_pushnumber(L, stat.write_count);
+	lua_setfield(L, -2, "writes");
+	fill_percentiles(L, "batch", stat.batch.p50, stat.batch.p90,
+			 stat.batch.p99, stat.batch.max);
+	fill_percentiles(L, "latency", stat.latency.p50, stat.latency.p90,
+			 stat.latency.p99, stat.latency.max);
+	return 1;
+}
+
+/**
+ * box.stat.cbus(): message statistics of each endpoint of the
+ * inter-thread bus.
+ */
+static int
+lbox_stat_cbus_call(struct lua_State *L)
+{
+	int count = cbus_get_stat(NULL, 0);
+	struct cbus_endpoint_stat *stat = (struct cbus_endpoint_stat *)
+		lua_newuserdata(L, count * sizeof(*stat));
+	count = MIN(count, cbus_get_stat(stat, count));
+	lua_newtable(L);
+	for (int i = 0; i < count; i++) {
+		lua_newtable(L);
+		lua_pushnumber(L, stat[i].wakeups);
+		lua_setfield(L, -2, "wakeups");
+		lua_pushnumber(L, stat[i].fetches);
+		lua_setfield(L, -2, "fetches");
+		lua_pushnumber(L, stat[i].messages);
+		lua_setfield(L, -2, "messages");
+		lua_setfield(L, -2, stat[i].name);
+	}
+	return 1;
+}
+
+/**
+ * Push a table with the number of observations and latency
+ * percentiles, in microseconds.
+ */
+static void
+push_latency(struct lua_State *L, struct histogram *hist)
+{
+	lua_newtable(L);
+	lua_pushnumber(L, hist->total);
+	lua_setfield(L, -2, "count");
+	lua_pushnumber(L, histogram_permille(hist, 500));
+	lua_setfield(L, -2, "p50");
+	lua_pushnumber(L, histogram_permille(hist, 990));
+	lua_setfield(L, -2, "p99");
+	lua_pushnumber(L, histogram_permille(hist, 999));
+	lua_setfield(L, -2, "p999");
+}
+
+static int
+set_space_latency(struct space *space, void *cb_ctx)
+{
+	struct lua_State *L = (struct lua_State *) cb_ctx;
+	if (space->latency->total == 0)
+		return 0;
+	push_latency(L, space->latency);
+	lua_setfield(L, -2, space_name(space));
+	return 0;
+}
+
+/**
+ * box.stat.latency(): latency of network requests by request
+ * type, of DML requests by space and of WAL writes. Only
+ * request types, spaces and WAL with observations are shown.
+ */
+static int
+lbox_stat_latency_call(struct lua_State *L)
+{
+	lua_newtable(L);
+
+	lua_newtable(L);
+	for (uint32_t type = 0; type < IPROTO_TYPE_STAT_MAX; type++) {
+		if (iproto_type_strs[type] == NULL)
+			continue;
+		struct histogram *hist = latency_histogram_new();
+		if (hist == NULL)
+			return luaL_error(L, "failed to allocate histogram");
+		iproto_latency_merge(type, hist);
+		if (hist->total > 0) {
+			push_latency(L, hist);
+			lua_setfield(L, -2, iproto_type_strs[type]);
+		}
+		histogram_delete(hist);
+	}
+	lua_setfield(L, -2, "net");
+
+	lua_newtable(L);
+	space_foreach(set_space_latency, L);
+	lua_setfield(L, -2, "space");
+
+	struct histogram *hist = latency_histogram_new();
+	if (hist == NULL)
+		return luaL_error(L, "failed to allocate histogram");
+	wal_latency_merge(hist);
+	if (hist->total > 0) {
+		push_latency(L, hist);
+		lua_setfield(L, -2, "wal");
+	}
+	histogram_delete(hist);
 	return 1;
 }
 
@@ -136,6 +288,21 @@ static const struct luaL_Reg lbox_stat_net_meta [] = {
 	{NULL, NULL}
 };
 
+static const struct luaL_Reg lbox_stat_wal_meta [] = {
+	{"__call",  lbox_stat_wal_call},
+	{NULL, NULL}
+};
+
+static const struct luaL_Reg lbox_stat_cbus_meta [] = {
+	{"__call",  lbox_stat_cbus_call},
+	{NULL, NULL}
+};
+
+static const struct luaL_Reg lbox_stat_latency_meta [] = {
+	{"__call",  lbox_stat_latency_call},
+	{NULL, NULL}
+};
+
 /** Initialize box.stat package. */
 void
 box_lua_stat_init(struct lua_State *L)
@@ -158,5 +325,26 @@ box_lua_stat_init(struct lua_State *L)
 	luaL_register(L, NULL, lbox_stat_net_meta);
 	lua_setmetatable(L, -2);
 	lua_pop(L, 1); /* stat net module */
+
+	luaL_register_module(L, "box.stat.wal", statlib);
+
+	lua_newtable(L);
+	luaL_register(L, NULL, lbox_stat_wal_meta);
+	lua_setmetatable(L, -2);
+	lua_pop(L, 1); /* stat wal module */
+
+	luaL_register_module(L, "box.stat.cbus", statlib);
+
+	lua_newtable(L);
+	luaL_register(L, NULL, lbox_stat_cbus_meta);
+	lua_setmetatable(L, -2);
+	lua_pop(L, 1); /* stat cbus module */
+
+	luaL_register_module(L, "box.stat.latency", statlib);
+
+	lua_newtable(L);
+	luaL_register(L, NULL, lbox_stat_latency_meta);
+	lua_setmetatable(L, -2);
+	lua_pop(L, 1); /* stat latency module */
 }
 
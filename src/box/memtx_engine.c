@@ -33,6 +33,7 @@
 #include "memtx_tuple.h"
 
 #include <small/mempool.h>
+#include <pmatomic.h>
 
 #include "coio_file.h"
 #include "tuple.h"
@@ -45,6 +46,9 @@
 #include "replication.h"
 #include "schema.h"
 #include "gc.h"
+#include "tt_pthread.h"
+#include "fiber_cond.h"
+#include "cbus.h"
 
 /** For all memory used by all indexes.
  * If you decide to use memtx_index_arena or
@@ -89,16 +93,102 @@ memtx_end_build_primary_key(struct space *space, void *param)
 }
 
 /**
- * Secondary indexes are built in bulk after all data is
- * recovered. This function enables secondary keys on a space.
- * Data dictionary spaces are an exception, they are fully
- * built right from the start.
+ * Secondary tree indexes whose tuples have been collected,
+ * but not sorted yet, @sa memtx_build_secondary_keys().
+ */
+struct memtx_build_queue {
+	struct memtx_tree_index **indexes;
+	int count;
+	int capacity;
+	/** The next index to be sorted, updated atomically. */
+	int next;
+};
+
+static int
+memtx_build_queue_push(struct memtx_build_queue *queue,
+		       struct memtx_tree_index *index)
+{
+	if (queue->count == queue->capacity) {
+		int capacity = queue->capacity > 0 ? queue->capacity * 2 : 16;
+		struct memtx_tree_index **indexes = realloc(queue->indexes,
+						capacity * sizeof(*indexes));
+		if (indexes == NULL) {
+			diag_set(OutOfMemory, capacity * sizeof(*indexes),
+				 "realloc", "memtx build queue");
+			return -1;
+		}
+		queue->indexes = indexes;
+		queue->capacity = capacity;
+	}
+	queue->indexes[queue->count++] = index;
+	return 0;
+}
+
+static void *
+memtx_build_queue_sort_f(void *arg)
+{
+	struct memtx_build_queue *queue = arg;
+	int i;
+	while ((i = pm_atomic_fetch_add(&queue->next, 1)) < queue->count)
+		memtx_tree_index_sort_build_array(queue->indexes[i], 1);
+	return NULL;
+}
+
+/**
+ * Sort tuples of all queued indexes using up to @thread_count
+ * threads, the current one included. Doesn't yield.
+ */
+static void
+memtx_build_queue_sort(struct memtx_build_queue *queue, int thread_count)
+{
+	if (queue->count < thread_count) {
+		/*
+		 * Too few indexes to keep all threads busy,
+		 * sort each of them in all threads instead.
+		 */
+		for (int i = 0; i < queue->count; i++) {
+			memtx_tree_index_sort_build_array(queue->indexes[i],
+							  thread_count);
+		}
+		return;
+	}
+	if (thread_count > queue->count)
+		thread_count = queue->count;
+	struct cord *cords = NULL;
+	if (thread_count > 1) {
+		cords = calloc(thread_count - 1, sizeof(*cords));
+		if (cords == NULL)
+			thread_count = 1;
+	}
+	int started = 0;
+	for (; started < thread_count - 1; started++) {
+		char name[FIBER_NAME_MAX];
+		snprintf(name, sizeof(name), "build.%d", started + 1);
+		if (cord_start(&cords[started], name,
+			       memtx_build_queue_sort_f, queue) != 0) {
+			diag_log();
+			break;
+		}
+	}
+	memtx_build_queue_sort_f(queue);
+	for (int i = 0; i < started; i++) {
+		if (cord_join(&cords[i]) != 0)
+			panic("failed to join index build thread");
+	}
+	free(cords);
+}
+
+/**
+ * Enable secondary keys on a space. Tuples of tree indexes
+ * are only collected here, sorting them is deferred so that
+ * it can be done for all spaces at once in parallel.
  */
 static int
-memtx_build_secondary_keys(struct space *space, void *param)
+memtx_prepare_secondary_keys(struct space *space, void *param)
 {
+	struct memtx_build_queue *queue = param;
 	struct memtx_space *memtx_space = (struct memtx_space *)space;
-	if (space->engine != param || space_index(space, 0) == NULL ||
+	if (!space_is_memtx(space) || space_index(space, 0) == NULL ||
 	    memtx_space->replace == memtx_space_replace_all_keys)
 		return 0;
 
@@ -113,18 +203,51 @@ memtx_build_secondary_keys(struct space *space, void *param)
 		}
 
 		for (uint32_t j = 1; j < space->index_count; j++) {
-			if (index_build(space->index[j], pk) < 0)
+			struct index *index = space->index[j];
+			if (index->def->type != TREE) {
+				if (index_build(index, pk) < 0)
+					return -1;
+				continue;
+			}
+			if (index_build_feed(index, pk) != 0 ||
+			    memtx_build_queue_push(queue,
+					(struct memtx_tree_index *)index) != 0)
 				return -1;
 		}
-
-		if (n_tuples > 0) {
-			say_info("Space '%s': done", space_name(space));
-		}
 	}
 	memtx_space->replace = memtx_space_replace_all_keys;
 	return 0;
 }
 
+/**
+ * Secondary indexes are built in bulk after all data is
+ * recovered. This function enables secondary keys on all
+ * memtx spaces. Data dictionary spaces are an exception,
+ * they are fully built right from the start.
+ *
+ * Sorting tuples is the most expensive part of building a
+ * tree index, so tree indexes of all spaces are sorted in
+ * parallel threads. The tuples are only read while sorting,
+ * and the tx thread is blocked until it's over, so neither
+ * tuples nor indexes may change meanwhile.
+ */
+static int
+memtx_build_secondary_keys(struct memtx_engine *memtx)
+{
+	struct memtx_build_queue queue;
+	memset(&queue, 0, sizeof(queue));
+	int rc = space_foreach(memtx_prepare_secondary_keys, &queue);
+	if (rc == 0) {
+		memtx_build_queue_sort(&queue, memtx->snapshot_threads);
+		for (int i = 0; i < queue.count; i++)
+			index_end_build(&queue.indexes[i]->base);
+		if (queue.count > 0)
+			say_info("Secondary indexes: done");
+	}
+	free(queue.indexes);
+	return rc;
+}
+
 static void
 memtx_engine_shutdown(struct engine *engine)
 {
@@ -146,6 +269,252 @@ static int
 memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
 				  struct xrow_header *row);
 
+enum {
+	/** Max number of rows in a snapshot reader batch. */
+	SNAPSHOT_BATCH_ROWS = 4096,
+};
+
+struct snapshot_reader;
+
+/**
+ * A batch of rows read from a snapshot by the reader thread.
+ * Row bodies aren't copied: they point to the mapped file or
+ * to buffers of decompressed transactions owned by batches.
+ */
+struct snapshot_batch {
+	struct cmsg base;
+	struct snapshot_reader *reader;
+	/** Decoded rows. */
+	struct xrow_header rows[SNAPSHOT_BATCH_ROWS];
+	int row_count;
+	/**
+	 * Transaction buffers freed by the reader thread when
+	 * the batch is reused, i.e. after it has been applied.
+	 * A buffer is handed to a batch only after the batch
+	 * gets a row of the next transaction, so there is at
+	 * most one buffer per row plus the last one.
+	 */
+	struct ibuf tx_bufs[SNAPSHOT_BATCH_ROWS + 1];
+	int tx_buf_count;
+	/** Set if the end of file has been reached. */
+	bool is_eof;
+	/** Set when the batch is back to the tx thread. */
+	bool is_ready;
+	/** Read status and error. */
+	int rc;
+	struct diag diag;
+};
+
+/**
+ * A thread reading a snapshot ahead of recovery: it reads,
+ * decompresses and decodes rows of the next batch while the
+ * tx thread applies rows of the previous one.
+ */
+struct snapshot_reader {
+	struct cord cord;
+	/** Pipe from tx to the reader thread. */
+	struct cpipe reader_pipe;
+	/** Pipe from the reader thread to tx. */
+	struct cpipe tx_pipe;
+	struct cmsg_hop route[2];
+	/** Signalled when a batch is back to tx. */
+	struct fiber_cond cond;
+	/** Snapshot file name and cursor, used in the reader thread. */
+	const char *filename;
+	struct xlog_cursor cursor;
+	bool is_open;
+	bool force_recovery;
+	/**
+	 * Buffer of the transaction read last. Its rows may
+	 * still be added to the next batch, so it's handed to
+	 * a batch only when another transaction is started.
+	 */
+	struct ibuf tx_buf;
+	bool has_tx_buf;
+	/** Set if the snapshot has an EOF marker. */
+	bool has_eof_marker;
+	/** Two batches: one is applied while the other is read. */
+	struct snapshot_batch batch[2];
+};
+
+/** Hand the last transaction buffer over to a batch. */
+static void
+snapshot_reader_flush_tx_buf(struct snapshot_reader *reader,
+			     struct snapshot_batch *batch)
+{
+	if (!reader->has_tx_buf)
+		return;
+	assert(batch->tx_buf_count <= batch->row_count);
+	batch->tx_bufs[batch->tx_buf_count++] = reader->tx_buf;
+	reader->has_tx_buf = false;
+}
+
+static void
+snapshot_batch_free_tx_bufs(struct snapshot_batch *batch)
+{
+	for (int i = 0; i < batch->tx_buf_count; i++)
+		ibuf_destroy(&batch->tx_bufs[i]);
+	batch->tx_buf_count = 0;
+}
+
+/** Read the next batch of rows, called in the reader thread. */
+static void
+snapshot_reader_read(struct cmsg *msg)
+{
+	struct snapshot_batch *batch = (struct snapshot_batch *)msg;
+	struct snapshot_reader *reader = batch->reader;
+	struct xlog_cursor *cursor = &reader->cursor;
+	/* The rows of the batch have been applied by now. */
+	snapshot_batch_free_tx_bufs(batch);
+	batch->row_count = 0;
+	batch->is_eof = false;
+	batch->rc = 0;
+	if (!reader->is_open) {
+		/*
+		 * Decode rows straight from the mapped file,
+		 * fall back on reading it if it can't be mapped.
+		 */
+		if (xlog_cursor_mmap(cursor, reader->filename) < 0) {
+			diag_log();
+			if (xlog_cursor_open(cursor, reader->filename) < 0)
+				goto fail;
+		}
+		reader->is_open = true;
+	}
+	while (batch->row_count < SNAPSHOT_BATCH_ROWS) {
+		struct xrow_header *row = &batch->rows[batch->row_count];
+		int rc = xlog_cursor_next(cursor, row,
+					  reader->force_recovery);
+		if (rc < 0)
+			goto fail;
+		if (rc > 0) {
+			batch->is_eof = true;
+			reader->has_eof_marker = xlog_cursor_is_eof(cursor);
+			snapshot_reader_flush_tx_buf(reader, batch);
+			break;
+		}
+		batch->row_count++;
+		struct ibuf tx_buf;
+		if (xlog_cursor_detach_tx(cursor, &tx_buf)) {
+			/*
+			 * The row starts a new transaction, so
+			 * the previous one isn't needed after
+			 * this batch is applied.
+			 */
+			snapshot_reader_flush_tx_buf(reader, batch);
+			reader->tx_buf = tx_buf;
+			reader->has_tx_buf = true;
+		}
+	}
+	fiber_gc();
+	return;
+fail:
+	batch->rc = -1;
+	diag_move(diag_get(), &batch->diag);
+	fiber_gc();
+}
+
+/** Return a batch to the waiting fiber, called in tx. */
+static void
+snapshot_reader_done(struct cmsg *msg)
+{
+	struct snapshot_batch *batch = (struct snapshot_batch *)msg;
+	batch->is_ready = true;
+	fiber_cond_signal(&batch->reader->cond);
+}
+
+static void
+snapshot_reader_push(struct snapshot_reader *reader,
+		     struct snapshot_batch *batch)
+{
+	batch->is_ready = false;
+	cmsg_init(&batch->base, reader->route);
+	cpipe_push(&reader->reader_pipe, &batch->base);
+}
+
+static void
+snapshot_reader_wait(struct snapshot_reader *reader,
+		     struct snapshot_batch *batch)
+{
+	while (!batch->is_ready)
+		fiber_cond_wait(&reader->cond);
+}
+
+static int
+snapshot_reader_f(va_list ap)
+{
+	struct snapshot_reader *reader = va_arg(ap, struct snapshot_reader *);
+	struct cbus_endpoint endpoint;
+
+	cpipe_create(&reader->tx_pipe, "tx_prio");
+	cbus_endpoint_create(&endpoint, cord_name(cord()),
+			     fiber_schedule_cb, fiber());
+	cbus_loop(&endpoint);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	cpipe_destroy(&reader->tx_pipe);
+	if (reader->is_open)
+		xlog_cursor_close(&reader->cursor, false);
+	/* The buffers belong to the slab cache of this thread. */
+	for (int i = 0; i < 2; i++)
+		snapshot_batch_free_tx_bufs(&reader->batch[i]);
+	if (reader->has_tx_buf)
+		ibuf_destroy(&reader->tx_buf);
+	return 0;
+}
+
+/**
+ * Start a snapshot reader thread. The reader is too big for
+ * a fiber stack, so it is allocated on the heap and freed by
+ * snapshot_reader_stop().
+ */
+static struct snapshot_reader *
+snapshot_reader_start(const char *filename, bool force_recovery)
+{
+	struct snapshot_reader *reader = calloc(1, sizeof(*reader));
+	if (reader == NULL) {
+		diag_set(OutOfMemory, sizeof(*reader), "calloc",
+			 "snapshot reader");
+		return NULL;
+	}
+	reader->filename = filename;
+	reader->force_recovery = force_recovery;
+	for (int i = 0; i < 2; i++) {
+		struct snapshot_batch *batch = &reader->batch[i];
+		batch->reader = reader;
+		batch->is_ready = true;
+		diag_create(&batch->diag);
+	}
+	fiber_cond_create(&reader->cond);
+	reader->route[0].f = snapshot_reader_read;
+	reader->route[0].pipe = &reader->tx_pipe;
+	reader->route[1].f = snapshot_reader_done;
+	reader->route[1].pipe = NULL;
+	if (cord_costart(&reader->cord, "snapshot_reader",
+			 snapshot_reader_f, reader) != 0) {
+		fiber_cond_destroy(&reader->cond);
+		free(reader);
+		return NULL;
+	}
+	cpipe_create(&reader->reader_pipe, "snapshot_reader");
+	return reader;
+}
+
+static void
+snapshot_reader_stop(struct snapshot_reader *reader)
+{
+	/* Wait for the batch which may still be in flight. */
+	for (int i = 0; i < 2; i++)
+		snapshot_reader_wait(reader, &reader->batch[i]);
+	cbus_stop_loop(&reader->reader_pipe);
+	cpipe_destroy(&reader->reader_pipe);
+	if (cord_join(&reader->cord) != 0)
+		panic("failed to join snapshot reader thread");
+	for (int i = 0; i < 2; i++)
+		diag_destroy(&reader->batch[i].diag);
+	fiber_cond_destroy(&reader->cond);
+	free(reader);
+}
+
 int
 memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 			      const struct vclock *vclock)
@@ -157,32 +526,56 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 						    signature, NONE);
 
 	say_info("recovering from `%s'", filename);
-	struct xlog_cursor cursor;
-	if (xlog_cursor_open(&cursor, filename) < 0)
+	struct snapshot_reader *reader =
+		snapshot_reader_start(filename, memtx->force_recovery);
+	if (reader == NULL)
 		return -1;
-	INSTANCE_UUID = cursor.meta.instance_uuid;
 
-	int rc;
-	struct xrow_header row;
+	int rc = 0;
 	uint64_t row_count = 0;
-	while ((rc = xlog_cursor_next(&cursor, &row,
-				      memtx->force_recovery)) == 0) {
-		row.lsn = signature;
-		rc = memtx_engine_recover_snapshot_row(memtx, &row);
-		if (rc < 0) {
-			if (!memtx->force_recovery)
-				break;
-			say_error("can't apply row: ");
-			diag_log();
+	struct snapshot_batch *batch = &reader->batch[0];
+	snapshot_reader_push(reader, batch);
+	while (true) {
+		snapshot_reader_wait(reader, batch);
+		if (batch->rc != 0) {
+			diag_move(&batch->diag, diag_get());
+			rc = -1;
+			break;
 		}
-		++row_count;
-		if (row_count % 100000 == 0) {
-			say_info("%.1fM rows processed",
-				 row_count / 1000000.);
-			fiber_yield_timeout(0);
+		if (row_count == 0)
+			INSTANCE_UUID = reader->cursor.meta.instance_uuid;
+		/* Read the next batch while this one is applied. */
+		struct snapshot_batch *next = batch == &reader->batch[0] ?
+					      &reader->batch[1] :
+					      &reader->batch[0];
+		if (!batch->is_eof)
+			snapshot_reader_push(reader, next);
+		for (int i = 0; i < batch->row_count; i++) {
+			struct xrow_header *row = &batch->rows[i];
+			row->lsn = signature;
+			rc = memtx_engine_recover_snapshot_row(memtx, row);
+			if (rc < 0) {
+				if (!memtx->force_recovery)
+					break;
+				say_error("can't apply row: ");
+				diag_log();
+			}
+			++row_count;
+			if (row_count % 100000 == 0) {
+				say_info("%.1fM rows processed",
+					 row_count / 1000000.);
+				fiber_yield_timeout(0);
+			}
 		}
+		if (rc < 0 && !memtx->force_recovery)
+			break;
+		rc = 0;
+		if (batch->is_eof)
+			break;
+		batch = next;
 	}
-	xlog_cursor_close(&cursor, false);
+	bool has_eof_marker = reader->has_eof_marker;
+	snapshot_reader_stop(reader);
 	if (rc < 0)
 		return -1;
 
@@ -191,7 +584,7 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 	 * marker - such snapshots are very likely corrupted and
 	 * should not be trusted.
 	 */
-	if (!xlog_cursor_is_eof(&cursor))
+	if (!has_eof_marker)
 		panic("snapshot `%s' has no EOF marker", filename);
 
 	return 0;
@@ -280,7 +673,7 @@ memtx_engine_begin_final_recovery(struct engine *engine)
 		 * unique keys.
 		 */
 		memtx->state = MEMTX_OK;
-		if (space_foreach(memtx_build_secondary_keys, memtx) != 0)
+		if (memtx_build_secondary_keys(memtx) != 0)
 			return -1;
 	}
 	return 0;
@@ -299,7 +692,7 @@ memtx_engine_end_recovery(struct engine *engine)
 	if (memtx->state != MEMTX_OK) {
 		assert(memtx->state == MEMTX_FINAL_RECOVERY);
 		memtx->state = MEMTX_OK;
-		if (space_foreach(memtx_build_secondary_keys, memtx) != 0)
+		if (memtx_build_secondary_keys(memtx) != 0)
 			return -1;
 	}
 	return 0;
@@ -376,6 +769,13 @@ memtx_engine_rollback_statement(struct engine *engine, struct txn *txn,
 	struct memtx_space *memtx_space = (struct memtx_space *)space;
 	int index_count;
 
+	if (stmt->old_tuple == stmt->new_tuple) {
+		memtx_space_rollback_update_in_place(space, stmt);
+		stmt->old_tuple = NULL;
+		stmt->new_tuple = NULL;
+		return;
+	}
+
 	/* Only roll back the changes if they were made. */
 	if (stmt->engine_savepoint == NULL)
 		index_count = 0;
@@ -398,9 +798,12 @@ memtx_engine_rollback_statement(struct engine *engine, struct txn *txn,
 		}
 	}
 	/** Reset to old bsize, if it was changed. */
-	if (stmt->engine_savepoint != NULL)
+	if (stmt->engine_savepoint != NULL) {
 		memtx_space_update_bsize(space, stmt->new_tuple,
 					 stmt->old_tuple);
+		memtx_space_log_change(memtx_space, stmt->new_tuple,
+				       stmt->old_tuple);
+	}
 
 	if (stmt->new_tuple)
 		tuple_unref(stmt->new_tuple);
@@ -456,16 +859,88 @@ memtx_engine_bootstrap(struct engine *engine)
 	return rc < 0 ? -1 : 0;
 }
 
+struct checkpoint_entry {
+	struct space *space;
+	struct snapshot_iterator *iterator;
+	struct rlist link;
+};
+
+struct checkpoint {
+	/**
+	 * List of MemTX spaces to snapshot, with consistent
+	 * read view iterators.
+	 */
+	struct rlist entries;
+	uint64_t snap_io_rate_limit;
+	/** The number of threads writing the snapshot. */
+	int thread_count;
+	struct cord cord;
+	bool waiting_for_snap_thread;
+	/** The vclock of the snapshot file. */
+	struct vclock *vclock;
+	struct xdir dir;
+	/**
+	 * Do nothing, just touch the snapshot file - the
+	 * checkpoint already exists.
+	 */
+	bool touch;
+	/**
+	 * The snapshot file. Tx blocks are prepared by writer
+	 * threads in parallel, but appended to the file one
+	 * by one, under @mutex.
+	 */
+	struct xlog snap;
+	/** Protects @snap, @next_entry and @is_failed. */
+	pthread_mutex_t mutex;
+	/** The next entry to be taken by a writer thread. */
+	struct rlist *next_entry;
+	/** Set if a writer failed, tells the others to stop. */
+	bool is_failed;
+	/** The number of rows written so far, updated atomically. */
+	int64_t rows;
+	/** Timestamp of all rows written to the snapshot. */
+	double tm;
+};
+
+/**
+ * A thread writing a part of a snapshot. Each writer takes
+ * spaces from the checkpoint list one by one and encodes and
+ * compresses their tuples into its own tx buffer, so that
+ * only appending of ready tx blocks to the file is serialized.
+ */
+struct checkpoint_writer {
+	struct checkpoint *ckpt;
+	/** Row accumulator and compression context. */
+	struct xlog buf;
+	struct cord cord;
+};
+
 static int
-checkpoint_write_row(struct xlog *l, struct xrow_header *row)
+checkpoint_writer_flush(struct checkpoint_writer *writer)
 {
-	static ev_tstamp last = 0;
-	if (last == 0) {
-		ev_now_update(loop());
-		last = ev_now(loop());
+	struct xlog *buf = &writer->buf;
+	if (buf->tx_rows == 0)
+		return 0;
+	struct checkpoint *ckpt = writer->ckpt;
+	ssize_t written = -1;
+	struct obuf *tx = xlog_tx_encode(buf);
+	if (tx != NULL) {
+		tt_pthread_mutex_lock(&ckpt->mutex);
+		written = xlog_write_tx(&ckpt->snap, tx, buf->tx_rows);
+		tt_pthread_mutex_unlock(&ckpt->mutex);
 	}
+	xlog_tx_reset(buf);
+	return written < 0 ? -1 : 0;
+}
+
+static int
+checkpoint_write_row(struct checkpoint_writer *writer,
+		     struct xrow_header *row)
+{
+	struct checkpoint *ckpt = writer->ckpt;
+	int64_t rows = pm_atomic_fetch_add(&ckpt->rows, 1) + 1;
 
-	row->tm = last;
+	row->tm = ckpt->tm;
 	row->replica_id = 0;
 	/**
 	 * Rows in snapshot are numbered from 1 to %rows.
@@ -474,22 +949,25 @@ checkpoint_write_row(struct xlog *l, struct xrow_header *row)
 	 * WAL. @sa the place which skips old rows in
 	 * recovery_apply_row().
 	 */
-	row->lsn = l->rows + l->tx_rows;
+	row->lsn = rows - 1;
 	row->sync = 0; /* don't write sync to wal */
 
-	ssize_t written = xlog_write_row(l, row);
+	ssize_t written = xlog_write_row(&writer->buf, row);
 	fiber_gc();
 	if (written < 0)
 		return -1;
+	if (xlog_tx_is_full(&writer->buf) &&
+	    checkpoint_writer_flush(writer) != 0)
+		return -1;
 
-	if ((l->rows + l->tx_rows) % 100000 == 0)
-		say_crit("%.1fM rows written", (l->rows + l->tx_rows) / 1000000.0);
+	if (rows % 100000 == 0)
+		say_crit("%.1fM rows written", rows / 1000000.0);
 	return 0;
 
 }
 
 static int
-checkpoint_write_tuple(struct xlog *l, uint32_t space_id,
+checkpoint_write_tuple(struct checkpoint_writer *writer, uint32_t space_id,
 		       const char *data, uint32_t size)
 {
 	struct request_replace_body body;
@@ -508,42 +986,18 @@ checkpoint_write_tuple(struct xlog *l, uint32_t space_id,
 	row.body[0].iov_len = sizeof(body);
 	row.body[1].iov_base = (char *)data;
 	row.body[1].iov_len = size;
-	return checkpoint_write_row(l, &row);
+	return checkpoint_write_row(writer, &row);
 }
 
-struct checkpoint_entry {
-	struct space *space;
-	struct snapshot_iterator *iterator;
-	struct rlist link;
-};
-
-struct checkpoint {
-	/**
-	 * List of MemTX spaces to snapshot, with consistent
-	 * read view iterators.
-	 */
-	struct rlist entries;
-	uint64_t snap_io_rate_limit;
-	struct cord cord;
-	bool waiting_for_snap_thread;
-	/** The vclock of the snapshot file. */
-	struct vclock *vclock;
-	struct xdir dir;
-	/**
-	 * Do nothing, just touch the snapshot file - the
-	 * checkpoint already exists.
-	 */
-	bool touch;
-};
-
 static int
 checkpoint_init(struct checkpoint *ckpt, const char *snap_dirname,
-		uint64_t snap_io_rate_limit)
+		uint64_t snap_io_rate_limit, int thread_count)
 {
 	rlist_create(&ckpt->entries);
 	ckpt->waiting_for_snap_thread = false;
 	xdir_create(&ckpt->dir, snap_dirname, SNAP, &INSTANCE_UUID);
 	ckpt->snap_io_rate_limit = snap_io_rate_limit;
+	ckpt->thread_count = thread_count;
 	/* May be used in abortCheckpoint() */
 	ckpt->vclock = malloc(sizeof(*ckpt->vclock));
 	if (ckpt->vclock == NULL) {
@@ -553,6 +1007,11 @@ checkpoint_init(struct checkpoint *ckpt, const char *snap_dirname,
 	}
 	vclock_create(ckpt->vclock);
 	ckpt->touch = false;
+	tt_pthread_mutex_init(&ckpt->mutex, NULL);
+	ckpt->next_entry = &ckpt->entries;
+	ckpt->is_failed = false;
+	ckpt->rows = 0;
+	ckpt->tm = 0;
 	return 0;
 }
 
@@ -566,6 +1025,7 @@ checkpoint_destroy(struct checkpoint *ckpt)
 	rlist_create(&ckpt->entries);
 	xdir_destroy(&ckpt->dir);
 	free(ckpt->vclock);
+	tt_pthread_mutex_destroy(&ckpt->mutex);
 }
 
 
@@ -597,6 +1057,131 @@ checkpoint_add_space(struct space *sp, void *data)
 	return 0;
 };
 
+/**
+ * Take the next space to write from the checkpoint list.
+ * If @system_only is set, return NULL as soon as the first
+ * user space is reached.
+ */
+static struct checkpoint_entry *
+checkpoint_next_entry(struct checkpoint *ckpt, bool system_only)
+{
+	struct checkpoint_entry *entry = NULL;
+	tt_pthread_mutex_lock(&ckpt->mutex);
+	if (!ckpt->is_failed && ckpt->next_entry->next != &ckpt->entries) {
+		entry = rlist_entry(ckpt->next_entry->next,
+				    struct checkpoint_entry, link);
+		if (system_only && !space_is_system(entry->space))
+			entry = NULL;
+		else
+			ckpt->next_entry = &entry->link;
+	}
+	tt_pthread_mutex_unlock(&ckpt->mutex);
+	return entry;
+}
+
+/**
+ * Write spaces from the checkpoint list until it's empty
+ * or (if @system_only is set) a user space is reached.
+ */
+static int
+checkpoint_writer_run(struct checkpoint_writer *writer, bool system_only)
+{
+	struct checkpoint *ckpt = writer->ckpt;
+	struct checkpoint_entry *entry;
+	while ((entry = checkpoint_next_entry(ckpt, system_only)) != NULL) {
+		uint32_t size;
+		const char *data;
+		struct snapshot_iterator *it = entry->iterator;
+		for (data = it->next(it, &size); data != NULL;
+		     data = it->next(it, &size)) {
+			if (checkpoint_write_tuple(writer,
+					space_id(entry->space),
+					data, size) != 0)
+				goto fail;
+		}
+	}
+	if (checkpoint_writer_flush(writer) != 0)
+		goto fail;
+	return 0;
+fail:
+	tt_pthread_mutex_lock(&ckpt->mutex);
+	ckpt->is_failed = true;
+	tt_pthread_mutex_unlock(&ckpt->mutex);
+	return -1;
+}
+
+static int
+checkpoint_writer_f(va_list ap)
+{
+	struct checkpoint_writer *writer =
+		va_arg(ap, struct checkpoint_writer *);
+	if (xlog_create_buffer(&writer->buf) != 0) {
+		tt_pthread_mutex_lock(&writer->ckpt->mutex);
+		writer->ckpt->is_failed = true;
+		tt_pthread_mutex_unlock(&writer->ckpt->mutex);
+		return -1;
+	}
+	int rc = checkpoint_writer_run(writer, false);
+	xlog_destroy_buffer(&writer->buf);
+	return rc;
+}
+
+/**
+ * Write all spaces of the checkpoint list to the snapshot
+ * file, using up to ckpt->thread_count threads, the current
+ * one included.
+ */
+static int
+checkpoint_write(struct checkpoint *ckpt)
+{
+	struct checkpoint_writer self;
+	self.ckpt = ckpt;
+	if (xlog_create_buffer(&self.buf) != 0)
+		return -1;
+	/*
+	 * System spaces must precede user spaces in the snapshot,
+	 * because recovery of a space needs its definition to be
+	 * loaded first, so write them before spawning other
+	 * writers. Since each space is written by one thread,
+	 * tuples of a space are still stored in key order.
+	 */
+	if (checkpoint_writer_run(&self, true) != 0) {
+		xlog_destroy_buffer(&self.buf);
+		return -1;
+	}
+
+	int thread_count = ckpt->thread_count - 1;
+	struct checkpoint_writer *writers = NULL;
+	if (thread_count > 0) {
+		writers = calloc(thread_count, sizeof(*writers));
+		if (writers == NULL) {
+			say_warn("failed to allocate snapshot writers, "
+				 "writing the snapshot in one thread");
+			thread_count = 0;
+		}
+	}
+	int started = 0;
+	for (; started < thread_count; started++) {
+		struct checkpoint_writer *writer = &writers[started];
+		writer->ckpt = ckpt;
+		char name[FIBER_NAME_MAX];
+		snprintf(name, sizeof(name), "snapshot.%d", started + 1);
+		if (cord_costart(&writer->cord, name, checkpoint_writer_f,
+				 writer) != 0) {
+			diag_log();
+			break;
+		}
+	}
+	int rc = checkpoint_writer_run(&self, false);
+	for (int i = 0; i < started; i++) {
+		if (cord_cojoin(&writers[i].cord) != 0)
+			rc = -1;
+	}
+	free(writers);
+	xlog_destroy_buffer(&self.buf);
+	return rc;
+}
+
 static int
 checkpoint_f(va_list ap)
 {
@@ -612,30 +1197,20 @@ checkpoint_f(va_list ap)
 		ckpt->touch = false;
 	}
 
-	struct xlog snap;
-	if (xdir_create_xlog(&ckpt->dir, &snap, ckpt->vclock) != 0)
+	if (xdir_create_xlog(&ckpt->dir, &ckpt->snap, ckpt->vclock) != 0)
 		return -1;
 
-	snap.rate_limit = ckpt->snap_io_rate_limit;
+	ckpt->snap.rate_limit = ckpt->snap_io_rate_limit;
+	ev_now_update(loop());
+	ckpt->tm = ev_now(loop());
 
-	say_info("saving snapshot `%s'", snap.filename);
-	struct checkpoint_entry *entry;
-	rlist_foreach_entry(entry, &ckpt->entries, link) {
-		uint32_t size;
-		const char *data;
-		struct snapshot_iterator *it = entry->iterator;
-		for (data = it->next(it, &size); data != NULL;
-		     data = it->next(it, &size)) {
-			if (checkpoint_write_tuple(&snap,
-					space_id(entry->space),
-					data, size) != 0) {
-				xlog_close(&snap, false);
-				return -1;
-			}
-		}
+	say_info("saving snapshot `%s'", ckpt->snap.filename);
+	if (checkpoint_write(ckpt) != 0) {
+		xlog_close(&ckpt->snap, false);
+		return -1;
 	}
-	xlog_flush(&snap);
-	xlog_close(&snap, false);
+	xlog_flush(&ckpt->snap);
+	xlog_close(&ckpt->snap, false);
 	say_info("done");
 	return 0;
 }
@@ -654,7 +1229,8 @@ memtx_engine_begin_checkpoint(struct engine *engine)
 	}
 
 	if (checkpoint_init(memtx->checkpoint, memtx->snap_dir.dirname,
-			    memtx->snap_io_rate_limit) != 0)
+			    memtx->snap_io_rate_limit,
+			    memtx->snapshot_threads) != 0)
 		return -1;
 
 	if (space_foreach(checkpoint_add_space, memtx->checkpoint) != 0) {
@@ -921,6 +1497,7 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 
 	memtx->state = MEMTX_INITIALIZED;
 	memtx->force_recovery = force_recovery;
+	memtx->snapshot_threads = 1;
 
 	memtx->base.vtab = &memtx_engine_vtab;
 	memtx->base.name = "memtx";
@@ -933,6 +1510,12 @@ memtx_engine_set_snap_io_rate_limit(struct memtx_engine *memtx, double limit)
 	memtx->snap_io_rate_limit = limit * 1024 * 1024;
 }
 
+void
+memtx_engine_set_snapshot_threads(struct memtx_engine *memtx, int count)
+{
+	memtx->snapshot_threads = count;
+}
+
 void
 memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size)
 {
@@ -89,6 +89,11 @@ struct memtx_engine {
 	struct xdir snap_dir;
 	/** Limit disk usage of checkpointing (bytes per second). */
 	uint64_t snap_io_rate_limit;
+	/**
+	 * The number of threads used for writing a snapshot
+	 * and for building secondary keys after recovery.
+	 */
+	int snapshot_threads;
 	/** Skip invalid snapshot records if this flag is set. */
 	bool force_recovery;
 	/** Memory pool for tree index iterator. */
@@ -101,6 +106,9 @@ struct memtx_engine {
 	struct mempool bitset_iterator_pool;
 };
 
+/** Max value of box.cfg.memtx_snapshot_threads. */
+enum { MEMTX_SNAPSHOT_THREADS_MAX = 1000 };
+
 struct memtx_engine *
 memtx_engine_new(const char *snap_dirname, bool force_recovery,
 		 uint64_t tuple_arena_max_size,
@@ -113,6 +121,9 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 void
 memtx_engine_set_snap_io_rate_limit(struct memtx_engine *memtx, double limit);
 
+void
+memtx_engine_set_snapshot_threads(struct memtx_engine *memtx, int count);
+
 void
 memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size);
 
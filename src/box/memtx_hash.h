@@ -37,11 +37,11 @@ extern "C" {
 #endif /* defined(__cplusplus) */
 
 struct memtx_engine;
-struct light_index_core;
+struct swiss_index_core;
 
 struct memtx_hash_index {
 	struct index base;
-	struct light_index_core *hash_table;
+	struct swiss_index_core *hash_table;
 };
 
 struct memtx_hash_index *
@@ -30,6 +30,7 @@
  */
 #include "memtx_space.h"
 #include "space.h"
+#include "memtx_engine.h"
 #include "iproto_constants.h"
 #include "txn.h"
 #include "tuple_compare.h"
@@ -58,14 +59,29 @@ memtx_space_bsize(struct space *space)
 
 /* {{{ DML */
 
+/**
+ * Size of a tuple accounted in the space bsize: the tuple data
+ * and, for a space with a full field map, the field map.
+ */
+static inline ssize_t
+memtx_space_tuple_bsize(struct space *space, const struct tuple *tuple)
+{
+	if (tuple == NULL)
+		return 0;
+	ssize_t bsize = box_tuple_bsize(tuple);
+	if (space->def->opts.full_field_map)
+		bsize += tuple_format(tuple)->field_map_size;
+	return bsize;
+}
+
 void
 memtx_space_update_bsize(struct space *space,
 			 const struct tuple *old_tuple,
 			 const struct tuple *new_tuple)
 {
 	struct memtx_space *memtx_space = (struct memtx_space *)space;
-	ssize_t old_bsize = old_tuple ? box_tuple_bsize(old_tuple) : 0;
-	ssize_t new_bsize = new_tuple ? box_tuple_bsize(new_tuple) : 0;
+	ssize_t old_bsize = memtx_space_tuple_bsize(space, old_tuple);
+	ssize_t new_bsize = memtx_space_tuple_bsize(space, new_tuple);
 	assert((ssize_t)memtx_space->bsize + new_bsize - old_bsize >= 0);
 	memtx_space->bsize += new_bsize - old_bsize;
 }
@@ -267,6 +283,8 @@ memtx_space_replace_all_keys(struct space *space, struct txn_stmt *stmt,
 	stmt->old_tuple = old_tuple;
 	stmt->engine_savepoint = stmt;
 	memtx_space_update_bsize(space, old_tuple, new_tuple);
+	memtx_space_log_change((struct memtx_space *)space,
+			       old_tuple, new_tuple);
 	return 0;
 
 rollback:
@@ -352,6 +370,112 @@ memtx_space_execute_delete(struct space *space, struct txn *txn,
 	return 0;
 }
 
+/**
+ * Try to apply UPDATE right to the data of the old tuple. This
+ * saves a tuple allocation and an index replace for updates that
+ * change neither indexed fields nor field sizes, e.g. counter
+ * increments.
+ *
+ * Tuples look immutable to their users, so it is not possible
+ * if the tuple is referenced by anyone but the space: a Lua
+ * object, a reply being sent, a statement of a transaction in
+ * progress. Nor if the tuple is frozen by a checkpoint, or the
+ * space has on_replace triggers, which expect the old and the
+ * new tuple to differ, or an index of the space is being built
+ * in background and may need the old data.
+ *
+ * On success the statement has old_tuple == new_tuple and its
+ * engine_savepoint points at the undo record.
+ */
+static bool
+memtx_space_update_in_place(struct space *space, struct txn_stmt *stmt,
+			    struct request *request)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	struct tuple *tuple = stmt->old_tuple;
+	if (tuple->refs != 1 || !rlist_empty(&space->on_replace) ||
+	    !memtx_tuple_is_mutable(tuple))
+		return false;
+	if (memtx_space->replace != memtx_space_replace_all_keys &&
+	    memtx_space->replace != memtx_space_replace_primary_key)
+		return false;
+	if (memtx_space->build_log != NULL)
+		return false;
+	uint64_t key_mask = 0;
+	for (uint32_t i = 0; i < space->index_count; i++)
+		key_mask |= space->index[i]->def->key_def->column_mask;
+	struct tuple_update_undo *undo =
+		region_alloc_object(&fiber()->gc, struct tuple_update_undo);
+	if (undo == NULL)
+		return false;
+	uint32_t bsize;
+	char *data = (char *) tuple_data_range(tuple, &bsize);
+	if (!tuple_update_in_place(region_aligned_alloc_cb, &fiber()->gc,
+				   request->tuple, request->tuple_end,
+				   data, data + bsize, request->index_base,
+				   key_mask, undo))
+		return false;
+	/* Released on commit, as any old tuple. */
+	tuple_ref(tuple);
+	stmt->new_tuple = tuple;
+	stmt->engine_savepoint = undo;
+	return true;
+}
+
+void
+memtx_space_rollback_update_in_place(struct space *space,
+				     struct txn_stmt *stmt)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	struct tuple *tuple = stmt->new_tuple;
+	struct tuple_update_undo *undo =
+		(struct tuple_update_undo *)stmt->engine_savepoint;
+	assert(stmt->old_tuple == tuple && undo != NULL);
+	uint32_t bsize;
+	char *data = (char *) tuple_data_range(tuple, &bsize);
+	if (tuple->refs == 2 && memtx_tuple_is_mutable(tuple) &&
+	    memtx_space->build_log == NULL) {
+		memcpy(data + undo->offset, undo->data, undo->size);
+		tuple_unref(tuple);
+		return;
+	}
+	/*
+	 * The new data may be seen by someone else now: a Lua
+	 * object or a reply holding the update result, a fiber
+	 * that read the tuple while the update waited for WAL,
+	 * a checkpoint or an index build started after the update.
+	 * Restore the old data in a copy.
+	 */
+	char *buf = (char *) region_alloc(&fiber()->gc, bsize);
+	if (buf == NULL)
+		panic("failed to rollback change");
+	memcpy(buf, data, bsize);
+	memcpy(buf + undo->offset, undo->data, undo->size);
+	struct tuple *old_tuple = memtx_tuple_new(space->format, buf,
+						  buf + bsize);
+	if (old_tuple == NULL)
+		panic("failed to rollback change");
+	tuple_ref(old_tuple);
+	uint32_t index_count =
+		memtx_space->replace == memtx_space_replace_all_keys ?
+		space->index_count : 1;
+	for (uint32_t i = 0; i < index_count; i++) {
+		struct tuple *unused;
+		struct index *index = space->index[i];
+		/* Rollback must not fail. */
+		if (index_replace(index, tuple, old_tuple,
+				  DUP_INSERT, &unused) != 0) {
+			diag_log();
+			unreachable();
+			panic("failed to rollback change");
+		}
+	}
+	memtx_space_log_change(memtx_space, tuple, old_tuple);
+	/* Drop the references of the statement and of the space. */
+	tuple_unref(tuple);
+	tuple_unref(tuple);
+}
+
 static int
 memtx_space_execute_update(struct space *space, struct txn *txn,
 			   struct request *request, struct tuple **result)
@@ -373,6 +497,10 @@ memtx_space_execute_update(struct space *space, struct txn *txn,
 		*result = NULL;
 		return 0;
 	}
+	if (memtx_space_update_in_place(space, stmt, request)) {
+		*result = stmt->new_tuple;
+		return 0;
+	}
 
 	/* Update the tuple; legacy, request ops are in request->tuple */
 	uint32_t new_size = 0, bsize;
@@ -530,6 +658,12 @@ memtx_space_check_index_def(struct space *space, struct index_def *index_def)
 			return -1;
 		}
 	}
+	if (index_def->opts.hint && index_def->type != TREE) {
+		diag_set(ClientError, ER_MODIFY_INDEX,
+			 index_def->name, space_name(space),
+			 "key hints are only supported by TREE index");
+		return -1;
+	}
 	switch (index_def->type) {
 	case HASH:
 		if (! index_def->opts.is_unique) {
@@ -748,6 +882,281 @@ memtx_init_system_space(struct space *space)
 	memtx_space_do_add_primary_key(space, MEMTX_OK);
 }
 
+/* {{{ Online index build */
+
+enum {
+	/**
+	 * Indexes of spaces smaller than that are built right
+	 * away: starting a thread would take longer.
+	 */
+	MEMTX_BUILD_ONLINE_MIN = 10000,
+	/** Logged changes applied to the new index per yield. */
+	MEMTX_BUILD_LOG_BATCH = 1000,
+};
+
+/** A change of a space made while its index is being built. */
+struct memtx_build_change {
+	struct tuple *old_tuple;
+	struct tuple *new_tuple;
+};
+
+/**
+ * Changes made to the primary key of a space, including
+ * rollbacks, in the order they were applied, while a new
+ * index is being built from a read view of the space.
+ * Tuples of the log are referenced.
+ */
+struct memtx_build_log {
+	struct memtx_build_change *changes;
+	size_t count;
+	size_t capacity;
+	/** Number of changes applied to the new index. */
+	size_t applied;
+	/** Set if a change was lost for lack of memory. */
+	bool is_broken;
+};
+
+void
+memtx_build_log_append(struct memtx_build_log *log,
+		       struct tuple *old_tuple, struct tuple *new_tuple)
+{
+	if (log->is_broken)
+		return;
+	if (log->count == log->capacity) {
+		size_t capacity = log->capacity > 0 ? log->capacity * 2 :
+				  MEMTX_BUILD_LOG_BATCH;
+		struct memtx_build_change *changes =
+			realloc(log->changes, capacity * sizeof(*changes));
+		if (changes == NULL) {
+			log->is_broken = true;
+			return;
+		}
+		log->changes = changes;
+		log->capacity = capacity;
+	}
+	struct memtx_build_change *change = &log->changes[log->count++];
+	change->old_tuple = old_tuple;
+	change->new_tuple = new_tuple;
+	if (old_tuple != NULL)
+		tuple_ref(old_tuple);
+	if (new_tuple != NULL)
+		tuple_ref(new_tuple);
+}
+
+static void
+memtx_build_log_destroy(struct memtx_build_log *log)
+{
+	for (size_t i = log->applied; i < log->count; i++) {
+		struct memtx_build_change *change = &log->changes[i];
+		if (change->old_tuple != NULL)
+			tuple_unref(change->old_tuple);
+		if (change->new_tuple != NULL)
+			tuple_unref(change->new_tuple);
+	}
+	free(log->changes);
+}
+
+/**
+ * Apply logged changes to the new index, yielding every now
+ * and then. New changes may be logged while we yield, so
+ * return only when the index has caught up with the space.
+ */
+static int
+memtx_build_log_apply(struct memtx_build_log *log, struct space *space,
+		      struct index *index)
+{
+	while (true) {
+		if (log->is_broken) {
+			diag_set(OutOfMemory, log->capacity * 2 *
+				 sizeof(*log->changes), "realloc",
+				 "memtx build log");
+			return -1;
+		}
+		if (log->applied == log->count)
+			return 0;
+		struct memtx_build_change *change =
+			&log->changes[log->applied];
+		if (change->new_tuple != NULL &&
+		    tuple_validate(space->format, change->new_tuple) != 0)
+			return -1;
+		struct tuple *unused;
+		if (index_replace(index, change->old_tuple, change->new_tuple,
+				  DUP_INSERT, &unused) != 0)
+			return -1;
+		if (change->old_tuple != NULL)
+			tuple_unref(change->old_tuple);
+		if (change->new_tuple != NULL)
+			tuple_unref(change->new_tuple);
+		if (++log->applied % MEMTX_BUILD_LOG_BATCH == 0)
+			fiber_sleep(0);
+	}
+}
+
+/**
+ * Formats of the tuples fed to a new index. The build thread
+ * looks them up by id, while the tx thread may delete the last
+ * tuple of a format, and the format along with it. So they are
+ * referenced until the thread is done.
+ */
+struct memtx_build_formats {
+	struct tuple_format **formats;
+	uint32_t count;
+	uint32_t capacity;
+};
+
+static int
+memtx_build_formats_ref(struct memtx_build_formats *formats,
+			struct memtx_tree_index *index)
+{
+	struct tuple_format *last = NULL;
+	for (size_t i = 0; i < index->build_array_size; i++) {
+		struct tuple_format *format =
+			tuple_format(index->build_array[i].tuple);
+		if (format == last)
+			continue;
+		last = format;
+		uint32_t j;
+		for (j = 0; j < formats->count; j++) {
+			if (formats->formats[j] == format)
+				break;
+		}
+		if (j < formats->count)
+			continue;
+		if (formats->count == formats->capacity) {
+			uint32_t capacity = formats->capacity > 0 ?
+					    formats->capacity * 2 : 4;
+			struct tuple_format **new_formats =
+				realloc(formats->formats,
+					capacity * sizeof(*new_formats));
+			if (new_formats == NULL) {
+				diag_set(OutOfMemory,
+					 capacity * sizeof(*new_formats),
+					 "realloc", "memtx build formats");
+				return -1;
+			}
+			formats->formats = new_formats;
+			formats->capacity = capacity;
+		}
+		tuple_format_ref(format);
+		formats->formats[formats->count++] = format;
+	}
+	return 0;
+}
+
+static void
+memtx_build_formats_unref(struct memtx_build_formats *formats)
+{
+	for (uint32_t i = 0; i < formats->count; i++)
+		tuple_format_unref(formats->formats[i]);
+	free(formats->formats);
+}
+
+/** Arguments of the index build thread. */
+struct memtx_build_sort {
+	struct memtx_tree_index *index;
+	/** Format of the space the index is built for. */
+	struct tuple_format *format;
+	const char *space_name;
+	int thread_count;
+};
+
+static int
+memtx_build_sort_f(va_list ap)
+{
+	struct memtx_build_sort *sort = va_arg(ap, struct memtx_build_sort *);
+	struct memtx_tree_index *index = sort->index;
+	for (size_t i = 0; i < index->build_array_size; i++) {
+		if (tuple_validate(sort->format,
+				   index->build_array[i].tuple) != 0)
+			return -1;
+	}
+	memtx_tree_index_sort_build_array(index, sort->thread_count);
+	if (memtx_tree_index_find_build_dup(index) != NULL) {
+		diag_set(ClientError, ER_TUPLE_FOUND, index->base.def->name,
+			 sort->space_name);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Check if a secondary index can be built without blocking
+ * the tx thread. The new index is invisible until the DDL
+ * statement completes, so we are free to yield as long as
+ * the statement belongs to a single-statement transaction:
+ * a yield aborts a multi-statement one. Nor can we yield if
+ * the statement builds other indexes, e.g. rebuilds the
+ * primary key: they wouldn't get the changes made meanwhile.
+ */
+static bool
+memtx_space_can_build_online(struct space *space, struct index *pk,
+			     struct index *new_index)
+{
+	struct txn *txn = in_txn();
+	return new_index->def->iid != 0 && new_index->def->type == TREE &&
+	       space->can_build_online &&
+	       txn != NULL && txn->is_autocommit &&
+	       index_size(pk) >= MEMTX_BUILD_ONLINE_MIN;
+}
+
+/**
+ * Build a tree index without blocking DML on the space.
+ *
+ * The primary key is scanned into the build array of the new
+ * index at once, which gives a consistent view of the space.
+ * Tuples are validated and sorted in a separate thread, while
+ * the tx thread goes on serving requests. Changes made to the
+ * space meanwhile are logged and applied to the new index once
+ * it is loaded from the sorted array. Since the new index is
+ * not visible until the DDL statement is over, it is published
+ * atomically along with the new space.
+ */
+static int
+memtx_space_build_secondary_key_online(struct space *old_space,
+				       struct space *new_space,
+				       struct index *new_index,
+				       struct index *pk)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)old_space;
+	struct memtx_engine *memtx = (struct memtx_engine *)old_space->engine;
+	struct memtx_build_log log;
+	memset(&log, 0, sizeof(log));
+	struct memtx_build_formats formats;
+	memset(&formats, 0, sizeof(formats));
+	/*
+	 * Freeze the tuples fed to the index: neither free nor
+	 * update them in place until the sort is over.
+	 */
+	memtx_tuple_begin_snapshot();
+	int rc = index_build_feed(new_index, pk);
+	if (rc == 0)
+		rc = memtx_build_formats_ref(&formats,
+				(struct memtx_tree_index *)new_index);
+	if (rc == 0) {
+		memtx_space->build_log = &log;
+		struct memtx_build_sort sort;
+		sort.index = (struct memtx_tree_index *)new_index;
+		sort.format = new_space->format;
+		sort.space_name = space_name(old_space);
+		sort.thread_count = memtx->snapshot_threads;
+		struct cord cord;
+		rc = cord_costart(&cord, "build", memtx_build_sort_f, &sort);
+		if (rc == 0)
+			rc = cord_cojoin(&cord);
+	}
+	memtx_tuple_end_snapshot();
+	memtx_build_formats_unref(&formats);
+	if (rc == 0) {
+		index_end_build(new_index);
+		rc = memtx_build_log_apply(&log, new_space, new_index);
+	}
+	memtx_space->build_log = NULL;
+	memtx_build_log_destroy(&log);
+	return rc;
+}
+
+/* }}} Online index build */
+
 static int
 memtx_space_build_secondary_key(struct space *old_space,
 				struct space *new_space,
@@ -773,6 +1182,11 @@ memtx_space_build_secondary_key(struct space *old_space,
 		return -1;
 	}
 
+	if (memtx_space_can_build_online(old_space, pk, new_index)) {
+		return memtx_space_build_secondary_key_online(old_space,
+					new_space, new_index, pk);
+	}
+
 	/* Now deal with any kind of add index during normal operation. */
 	struct iterator *it = index_create_iterator(pk, ITER_ALL, NULL, 0);
 	if (it == NULL)
@@ -934,7 +1348,8 @@ memtx_space_new(struct memtx_engine *memtx,
 		keys[key_count++] = index_def->key_def;
 
 	struct tuple_format *format = tuple_format_new(&memtx_tuple_format_vtab,
-			keys, key_count, 0, def->fields, def->field_count);
+			keys, key_count, 0, def->fields, def->field_count,
+			def->opts.full_field_map);
 	if (format == NULL) {
 		free(memtx_space);
 		return NULL;
@@ -954,5 +1369,6 @@ memtx_space_new(struct memtx_engine *memtx,
 
 	memtx_space->bsize = 0;
 	memtx_space->replace = memtx_space_replace_no_keys;
+	memtx_space->build_log = NULL;
 	return (struct space *)memtx_space;
 }
@@ -37,6 +37,7 @@ extern "C" {
 #endif /* defined(__cplusplus) */
 
 struct memtx_engine;
+struct memtx_build_log;
 
 struct memtx_space {
 	struct space base;
@@ -48,8 +49,35 @@ struct memtx_space {
 	 */
 	int (*replace)(struct space *, struct txn_stmt *,
 		       enum dup_replace_mode);
+	/**
+	 * Changes of the space made while a new index is being
+	 * built in background, NULL if there is no such build.
+	 */
+	struct memtx_build_log *build_log;
 };
 
+/**
+ * Remember that @a old_tuple was replaced with @a new_tuple,
+ * so that the change can be applied to an index built in
+ * background once it is ready. Never fails: if there is no
+ * memory to log the change, the build is aborted.
+ */
+void
+memtx_build_log_append(struct memtx_build_log *log,
+		       struct tuple *old_tuple, struct tuple *new_tuple);
+
+/**
+ * Log a change of the primary key of a space, if the space
+ * has an index being built in background.
+ */
+static inline void
+memtx_space_log_change(struct memtx_space *space,
+		       struct tuple *old_tuple, struct tuple *new_tuple)
+{
+	if (space->build_log != NULL)
+		memtx_build_log_append(space->build_log, old_tuple, new_tuple);
+}
+
 /**
  * Change binary size of a space subtracting old tuple's size and
  * adding new tuple's size. Used also for rollback by swaping old
@@ -77,6 +105,14 @@ int
 memtx_space_replace_all_keys(struct space *, struct txn_stmt *,
 			     enum dup_replace_mode);
 
+/**
+ * Undo an UPDATE applied right to the data of the old tuple,
+ * i.e. a statement with old_tuple == new_tuple.
+ */
+void
+memtx_space_rollback_update_in_place(struct space *space,
+				     struct txn_stmt *stmt);
+
 struct space *
 memtx_space_new(struct memtx_engine *memtx,
 		struct space_def *def, struct rlist *key_list);
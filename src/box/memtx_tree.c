@@ -40,43 +40,20 @@
 
 /* {{{ Utilities. *************************************************/
 
-static int
-memtx_tree_qcompare(const void* a, const void *b, void *c)
-{
-	return tuple_compare(*(struct tuple **)a,
-		*(struct tuple **)b, (struct key_def *)c);
-}
-
-/* {{{ MemtxTree Iterators ****************************************/
-struct tree_iterator {
-	struct iterator base;
-	const struct memtx_tree *tree;
-	struct index_def *index_def;
-	struct memtx_tree_iterator tree_iterator;
-	enum iterator_type type;
-	struct memtx_tree_key_data key_data;
-	struct tuple *current_tuple;
-	/** Memory pool the iterator was allocated from. */
-	struct mempool *pool;
-};
-
-static void
-tree_iterator_free(struct iterator *iterator);
-
-static inline struct tree_iterator *
-tree_iterator(struct iterator *it)
-{
-	assert(it->free == tree_iterator_free);
-	return (struct tree_iterator *) it;
-}
-
-static void
-tree_iterator_free(struct iterator *iterator)
+/**
+ * Use extended key def for non-unique and nullable
+ * indexes. Unique, but nullable, index can store
+ * multiple NULLs. To correctly compare these NULLs
+ * extended key def must be used. For details @sa
+ * tuple_compare.cc.
+ */
+static struct key_def *
+memtx_tree_index_cmp_def(struct memtx_tree_index *index)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	if (it->current_tuple != NULL)
-		tuple_unref(it->current_tuple);
-	mempool_free(it->pool, it);
+	struct index_def *def = index->base.def;
+	if (def->opts.is_unique && !def->key_def->is_nullable)
+		return def->key_def;
+	return def->cmp_def;
 }
 
 static int
@@ -87,358 +64,16 @@ tree_iterator_dummie(struct iterator *iterator, struct tuple **ret)
 	return 0;
 }
 
-static int
-tree_iterator_next(struct iterator *iterator, struct tuple **ret)
-{
-	struct tuple **res;
-	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current_tuple != NULL);
-	struct tuple **check = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
-	if (check == NULL || *check != it->current_tuple)
-		it->tree_iterator =
-			memtx_tree_upper_bound_elem(it->tree, it->current_tuple,
-						    NULL);
-	else
-		memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	tuple_unref(it->current_tuple);
-	it->current_tuple = NULL;
-	res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
-	if (res == NULL) {
-		iterator->next = tree_iterator_dummie;
-		*ret = NULL;
-	} else {
-		*ret = it->current_tuple = *res;
-		tuple_ref(it->current_tuple);
-	}
-	return 0;
-}
-
-static int
-tree_iterator_prev(struct iterator *iterator, struct tuple **ret)
-{
-	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current_tuple != NULL);
-	struct tuple **check = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
-	if (check == NULL || *check != it->current_tuple)
-		it->tree_iterator =
-			memtx_tree_lower_bound_elem(it->tree, it->current_tuple,
-						    NULL);
-	memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-	tuple_unref(it->current_tuple);
-	it->current_tuple = NULL;
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
-	if (!res) {
-		iterator->next = tree_iterator_dummie;
-		*ret = NULL;
-	} else {
-		*ret = it->current_tuple = *res;
-		tuple_ref(it->current_tuple);
-	}
-	return 0;
-}
-
-static int
-tree_iterator_next_equal(struct iterator *iterator, struct tuple **ret)
-{
-	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current_tuple != NULL);
-	struct tuple **check = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
-	if (check == NULL || *check != it->current_tuple)
-		it->tree_iterator =
-			memtx_tree_upper_bound_elem(it->tree, it->current_tuple,
-						    NULL);
-	else
-		memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	tuple_unref(it->current_tuple);
-	it->current_tuple = NULL;
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
-	/* Use user key def to save a few loops. */
-	if (!res || memtx_tree_compare_key(*res, &it->key_data,
-					   it->index_def->key_def) != 0) {
-		iterator->next = tree_iterator_dummie;
-		*ret = NULL;
-	} else {
-		*ret = it->current_tuple = *res;
-		tuple_ref(it->current_tuple);
-	}
-	return 0;
-}
-
-static int
-tree_iterator_prev_equal(struct iterator *iterator, struct tuple **ret)
-{
-	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current_tuple != NULL);
-	struct tuple **check = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
-	if (check == NULL || *check != it->current_tuple)
-		it->tree_iterator =
-			memtx_tree_lower_bound_elem(it->tree, it->current_tuple,
-						    NULL);
-	memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-	tuple_unref(it->current_tuple);
-	it->current_tuple = NULL;
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
-	/* Use user key def to save a few loops. */
-	if (!res || memtx_tree_compare_key(*res, &it->key_data,
-					   it->index_def->key_def) != 0) {
-		iterator->next = tree_iterator_dummie;
-		*ret = NULL;
-	} else {
-		*ret = it->current_tuple = *res;
-		tuple_ref(it->current_tuple);
-	}
-	return 0;
-}
-
-static void
-tree_iterator_set_next_method(struct tree_iterator *it)
-{
-	assert(it->current_tuple != NULL);
-	switch (it->type) {
-	case ITER_EQ:
-		it->base.next = tree_iterator_next_equal;
-		break;
-	case ITER_REQ:
-		it->base.next = tree_iterator_prev_equal;
-		break;
-	case ITER_ALL:
-		it->base.next = tree_iterator_next;
-		break;
-	case ITER_LT:
-	case ITER_LE:
-		it->base.next = tree_iterator_prev;
-		break;
-	case ITER_GE:
-	case ITER_GT:
-		it->base.next = tree_iterator_next;
-		break;
-	default:
-		/* The type was checked in initIterator */
-		assert(false);
-	}
-}
-
-static int
-tree_iterator_start(struct iterator *iterator, struct tuple **ret)
-{
-	*ret = NULL;
-	struct tree_iterator *it = tree_iterator(iterator);
-	it->base.next = tree_iterator_dummie;
-	const struct memtx_tree *tree = it->tree;
-	enum iterator_type type = it->type;
-	bool exact = false;
-	assert(it->current_tuple == NULL);
-	if (it->key_data.key == 0) {
-		if (iterator_type_is_reverse(it->type))
-			it->tree_iterator = memtx_tree_iterator_last(tree);
-		else
-			it->tree_iterator = memtx_tree_iterator_first(tree);
-	} else {
-		if (type == ITER_ALL || type == ITER_EQ ||
-		    type == ITER_GE || type == ITER_LT) {
-			it->tree_iterator =
-				memtx_tree_lower_bound(tree, &it->key_data,
-						       &exact);
-			if (type == ITER_EQ && !exact)
-				return 0;
-		} else { // ITER_GT, ITER_REQ, ITER_LE
-			it->tree_iterator =
-				memtx_tree_upper_bound(tree, &it->key_data,
-						       &exact);
-			if (type == ITER_REQ && !exact)
-				return 0;
-		}
-		if (iterator_type_is_reverse(type)) {
-			/*
-			 * Because of limitations of tree search API we use use
-			 * lower_bound for LT search and upper_bound for LE
-			 * and REQ searches. Thus we found position to the
-			 * right of the target one. Let's make a step to the
-			 * left to reach target position.
-			 * If we found an invalid iterator all the elements in
-			 * the tree are less (less or equal) to the key, and
-			 * iterator_next call will convert the iterator to the
-			 * last position in the tree, that's what we need.
-			 */
-			memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-		}
-	}
-
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
-	if (!res)
-		return 0;
-	*ret = it->current_tuple = *res;
-	tuple_ref(it->current_tuple);
-	tree_iterator_set_next_method(it);
-	return 0;
-}
-
 /* }}} */
 
-/* {{{ MemtxTree  **********************************************************/
-
-static void
-memtx_tree_index_destroy(struct index *base)
-{
-	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
-	memtx_tree_destroy(&index->tree);
-	free(index->build_array);
-	free(index);
-}
-
-static ssize_t
-memtx_tree_index_size(struct index *base)
-{
-	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
-	return memtx_tree_size(&index->tree);
-}
-
-static ssize_t
-memtx_tree_index_bsize(struct index *base)
-{
-	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
-	return memtx_tree_mem_used(&index->tree);
-}
-
-static int
-memtx_tree_index_random(struct index *base, uint32_t rnd, struct tuple **result)
-{
-	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
-	struct tuple **res = memtx_tree_random(&index->tree, rnd);
-	*result = res != NULL ? *res : NULL;
-	return 0;
-}
-
-static ssize_t
-memtx_tree_index_count(struct index *base, enum iterator_type type,
-		       const char *key, uint32_t part_count)
-{
-	if (type == ITER_ALL)
-		return memtx_tree_index_size(base); /* optimization */
-	return generic_index_count(base, type, key, part_count);
-}
-
-static int
-memtx_tree_index_get(struct index *base, const char *key,
-		     uint32_t part_count, struct tuple **result)
-{
-	assert(base->def->opts.is_unique &&
-	       part_count == base->def->key_def->part_count);
-	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
-	struct memtx_tree_key_data key_data;
-	key_data.key = key;
-	key_data.part_count = part_count;
-	struct tuple **res = memtx_tree_find(&index->tree, &key_data);
-	*result = res != NULL ? *res : NULL;
-	return 0;
-}
-
-static int
-memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
-			 struct tuple *new_tuple, enum dup_replace_mode mode,
-			 struct tuple **result)
-{
-	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
-	if (new_tuple) {
-		struct tuple *dup_tuple = NULL;
-
-		/* Try to optimistically replace the new_tuple. */
-		int tree_res = memtx_tree_insert(&index->tree,
-						 new_tuple, &dup_tuple);
-		if (tree_res) {
-			diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
-				 "memtx_tree_index", "replace");
-			return -1;
-		}
-
-		uint32_t errcode = replace_check_dup(old_tuple,
-						     dup_tuple, mode);
-		if (errcode) {
-			memtx_tree_delete(&index->tree, new_tuple);
-			if (dup_tuple)
-				memtx_tree_insert(&index->tree, dup_tuple, 0);
-			struct space *sp = space_cache_find(base->def->space_id);
-			if (sp != NULL)
-				diag_set(ClientError, errcode, base->def->name,
-					 space_name(sp));
-			return -1;
-		}
-		if (dup_tuple) {
-			*result = dup_tuple;
-			return 0;
-		}
-	}
-	if (old_tuple) {
-		memtx_tree_delete(&index->tree, old_tuple);
-	}
-	*result = old_tuple;
-	return 0;
-}
-
-static struct iterator *
-memtx_tree_index_create_iterator(struct index *base, enum iterator_type type,
-				 const char *key, uint32_t part_count)
-{
-	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
-	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
-
-	assert(part_count == 0 || key != NULL);
-	if (type > ITER_GT) {
-		diag_set(UnsupportedIndexFeature, base->def,
-			 "requested iterator type");
-		return NULL;
-	}
-
-	if (part_count == 0) {
-		/*
-		 * If no key is specified, downgrade equality
-		 * iterators to a full range.
-		 */
-		type = iterator_type_is_reverse(type) ? ITER_LE : ITER_GE;
-		key = NULL;
-	}
-
-	struct tree_iterator *it = mempool_alloc(&memtx->tree_iterator_pool);
-	if (it == NULL) {
-		diag_set(OutOfMemory, sizeof(struct tree_iterator),
-			 "memtx_tree_index", "iterator");
-		return NULL;
-	}
-	iterator_create(&it->base, base);
-	it->pool = &memtx->tree_iterator_pool;
-	it->base.next = tree_iterator_start;
-	it->base.free = tree_iterator_free;
-	it->type = type;
-	it->key_data.key = key;
-	it->key_data.part_count = part_count;
-	it->index_def = base->def;
-	it->tree = &index->tree;
-	it->tree_iterator = memtx_tree_invalid_iterator();
-	it->current_tuple = NULL;
-	return (struct iterator *)it;
-}
-
-static void
-memtx_tree_index_begin_build(struct index *base)
-{
-	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
-	assert(memtx_tree_size(&index->tree) == 0);
-	(void)index;
-}
-
 static int
 memtx_tree_index_reserve(struct index *base, uint32_t size_hint)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
 	if (size_hint < index->build_array_alloc_size)
 		return 0;
-	struct tuple **tmp = (struct tuple **)realloc(index->build_array,
-						      size_hint * sizeof(*tmp));
+	struct memtx_tree_data *tmp = (struct memtx_tree_data *)
+		realloc(index->build_array, size_hint * sizeof(*tmp));
 	if (tmp == NULL) {
 		diag_set(OutOfMemory, size_hint * sizeof(*tmp),
 			 "memtx_tree_index", "reserve");
@@ -454,20 +89,21 @@ memtx_tree_index_build_next(struct index *base, struct tuple *tuple)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
 	if (index->build_array == NULL) {
-		index->build_array = (struct tuple **)malloc(MEMTX_EXTENT_SIZE);
+		index->build_array =
+			(struct memtx_tree_data *)malloc(MEMTX_EXTENT_SIZE);
 		if (index->build_array == NULL) {
 			diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
 				 "memtx_tree_index", "build_next");
 			return -1;
 		}
 		index->build_array_alloc_size =
-			MEMTX_EXTENT_SIZE / sizeof(struct tuple*);
+			MEMTX_EXTENT_SIZE / sizeof(struct memtx_tree_data);
 	}
 	assert(index->build_array_size <= index->build_array_alloc_size);
 	if (index->build_array_size == index->build_array_alloc_size) {
 		index->build_array_alloc_size = index->build_array_alloc_size +
 					index->build_array_alloc_size / 2;
-		struct tuple **tmp = (struct tuple **)
+		struct memtx_tree_data *tmp = (struct memtx_tree_data *)
 			realloc(index->build_array,
 				index->build_array_alloc_size * sizeof(*tmp));
 		if (tmp == NULL) {
@@ -477,106 +113,233 @@ memtx_tree_index_build_next(struct index *base, struct tuple *tuple)
 		}
 		index->build_array = tmp;
 	}
-	index->build_array[index->build_array_size++] = tuple;
+	struct memtx_tree_data *data =
+		&index->build_array[index->build_array_size++];
+	data->tuple = tuple;
+	/* Hints are calculated by the sort. */
+	data->hint = 0;
 	return 0;
 }
 
-static void
-memtx_tree_index_end_build(struct index *base)
-{
-	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
-	/** Use extended key def only for non-unique indexes. */
-	struct key_def *cmp_def = base->def->opts.is_unique ?
-			base->def->key_def : base->def->cmp_def;
-	qsort_arg(index->build_array, index->build_array_size,
-		  sizeof(struct tuple *),
-		  memtx_tree_qcompare, cmp_def);
-	memtx_tree_build(&index->tree, index->build_array,
-			 index->build_array_size);
+/* {{{ Bulk build sort ********************************************/
+
+enum {
+	/** Don't sort in parallel arrays smaller than that. */
+	MEMTX_TREE_SORT_PARALLEL_MIN = 64 * 1024,
+};
 
-	free(index->build_array);
-	index->build_array = NULL;
-	index->build_array_size = 0;
-	index->build_array_alloc_size = 0;
+static int
+memtx_tree_sort_elem_compare(const void *a, const void *b, void *arg)
+{
+	return memtx_hint_tree_compare((const struct memtx_tree_data *)a,
+				       (const struct memtx_tree_data *)b,
+				       (struct key_def *)arg);
 }
 
-struct tree_snapshot_iterator {
-	struct snapshot_iterator base;
-	struct memtx_tree *tree;
-	struct memtx_tree_iterator tree_iterator;
+/**
+ * A unit of work of the parallel sort: either sort
+ * src[begin, end) in place or merge sorted src[begin, mid)
+ * and src[mid, end) into dst[begin, end).
+ */
+struct memtx_tree_sort_task {
+	struct memtx_tree_data *src;
+	struct memtx_tree_data *dst;
+	size_t begin, mid, end;
+	struct key_def *cmp_def;
 };
 
-static void
-tree_snapshot_iterator_free(struct snapshot_iterator *iterator)
+static void *
+memtx_tree_sort_task_sort_f(void *arg)
 {
-	assert(iterator->free == tree_snapshot_iterator_free);
-	struct tree_snapshot_iterator *it =
-		(struct tree_snapshot_iterator *)iterator;
-	struct memtx_tree *tree = (struct memtx_tree *)it->tree;
-	memtx_tree_iterator_destroy(tree, &it->tree_iterator);
-	free(iterator);
+	struct memtx_tree_sort_task *task = arg;
+	qsort_arg(task->src + task->begin, task->end - task->begin,
+		  sizeof(*task->src), memtx_tree_sort_elem_compare,
+		  task->cmp_def);
+	return NULL;
 }
 
-static const char *
-tree_snapshot_iterator_next(struct snapshot_iterator *iterator, uint32_t *size)
+static void *
+memtx_tree_sort_task_merge_f(void *arg)
 {
-	assert(iterator->free == tree_snapshot_iterator_free);
-	struct tree_snapshot_iterator *it =
-		(struct tree_snapshot_iterator *)iterator;
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
-	if (res == NULL)
-		return NULL;
-	memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	return tuple_data_range(*res, size);
+	struct memtx_tree_sort_task *task = arg;
+	struct memtx_tree_data *src = task->src;
+	struct memtx_tree_data *dst = task->dst + task->begin;
+	size_t i = task->begin, j = task->mid;
+	while (i < task->mid && j < task->end) {
+		if (memtx_tree_sort_elem_compare(&src[j], &src[i],
+						 task->cmp_def) < 0)
+			*dst++ = src[j++];
+		else
+			*dst++ = src[i++];
+	}
+	memcpy(dst, src + i, (task->mid - i) * sizeof(*dst));
+	dst += task->mid - i;
+	memcpy(dst, src + j, (task->end - j) * sizeof(*dst));
+	return NULL;
 }
 
 /**
- * Create an ALL iterator with personal read view so further
- * index modifications will not affect the iteration results.
- * Must be destroyed by iterator->free after usage.
+ * Run @count tasks, each in its own thread, the current
+ * thread included. Tasks that can't get a thread are run
+ * in the current one.
  */
-static struct snapshot_iterator *
-memtx_tree_index_create_snapshot_iterator(struct index *base)
+static void
+memtx_tree_sort_run(void *(*f)(void *), struct memtx_tree_sort_task *tasks,
+		    int count)
 {
-	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
-	struct tree_snapshot_iterator *it = (struct tree_snapshot_iterator *)
-		calloc(1, sizeof(*it));
-	if (it == NULL) {
-		diag_set(OutOfMemory, sizeof(struct tree_snapshot_iterator),
-			 "memtx_tree_index", "create_snapshot_iterator");
-		return NULL;
+	struct cord *cords = NULL;
+	if (count > 1)
+		cords = calloc(count - 1, sizeof(*cords));
+	int started = 0;
+	for (int i = 1; i < count; i++) {
+		char name[FIBER_NAME_MAX];
+		snprintf(name, sizeof(name), "sort.%d", i);
+		if (cords == NULL ||
+		    cord_start(&cords[started], name, f, &tasks[i]) != 0) {
+			f(&tasks[i]);
+			continue;
+		}
+		started++;
 	}
+	f(&tasks[0]);
+	for (int i = 0; i < started; i++) {
+		if (cord_join(&cords[i]) != 0)
+			panic("failed to join index sort thread");
+	}
+	free(cords);
+}
 
-	it->base.free = tree_snapshot_iterator_free;
-	it->base.next = tree_snapshot_iterator_next;
-	it->tree = &index->tree;
-	it->tree_iterator = memtx_tree_iterator_first(&index->tree);
-	memtx_tree_iterator_freeze(&index->tree, &it->tree_iterator);
-	return (struct snapshot_iterator *) it;
+/**
+ * Sort an array of elements in @thread_count threads:
+ * each thread sorts its own chunk, then sorted runs are
+ * merged pairwise, pairs being merged in parallel, too.
+ * Returns the array the result ended up in: @elems or @buf.
+ */
+static struct memtx_tree_data *
+memtx_tree_sort_elems(struct memtx_tree_data *elems,
+		      struct memtx_tree_data *buf, size_t count,
+		      struct key_def *cmp_def, int thread_count)
+{
+	struct memtx_tree_sort_task *tasks =
+		calloc(thread_count, sizeof(*tasks));
+	size_t *bounds = calloc(thread_count + 1, sizeof(*bounds));
+	if (tasks == NULL || bounds == NULL)
+		thread_count = 1;
+	if (thread_count == 1) {
+		qsort_arg(elems, count, sizeof(*elems),
+			  memtx_tree_sort_elem_compare, cmp_def);
+		free(tasks);
+		free(bounds);
+		return elems;
+	}
+	int run_count = thread_count;
+	for (int i = 0; i <= run_count; i++)
+		bounds[i] = count * i / run_count;
+	for (int i = 0; i < run_count; i++) {
+		tasks[i].src = elems;
+		tasks[i].begin = bounds[i];
+		tasks[i].end = bounds[i + 1];
+		tasks[i].cmp_def = cmp_def;
+	}
+	memtx_tree_sort_run(memtx_tree_sort_task_sort_f, tasks, run_count);
+
+	struct memtx_tree_data *src = elems, *dst = buf;
+	while (run_count > 1) {
+		int task_count = 0;
+		for (int i = 0; i < run_count; i += 2) {
+			struct memtx_tree_sort_task *task = &tasks[task_count++];
+			task->src = src;
+			task->dst = dst;
+			task->begin = bounds[i];
+			task->end = bounds[MIN(i + 2, run_count)];
+			task->mid = i + 1 < run_count ? bounds[i + 1] :
+					task->end;
+			task->cmp_def = cmp_def;
+		}
+		memtx_tree_sort_run(memtx_tree_sort_task_merge_f, tasks,
+				    task_count);
+		for (int i = 0; i <= task_count; i++)
+			bounds[i] = bounds[MIN(i * 2, run_count)];
+		run_count = task_count;
+		SWAP(src, dst);
+	}
+	free(tasks);
+	free(bounds);
+	return src;
 }
 
-static const struct index_vtab memtx_tree_index_vtab = {
-	/* .destroy = */ memtx_tree_index_destroy,
-	/* .commit_create = */ generic_index_commit_create,
-	/* .commit_drop = */ generic_index_commit_drop,
-	/* .size = */ memtx_tree_index_size,
-	/* .bsize = */ memtx_tree_index_bsize,
-	/* .min = */ generic_index_min,
-	/* .max = */ generic_index_max,
-	/* .random = */ memtx_tree_index_random,
-	/* .count = */ memtx_tree_index_count,
-	/* .get = */ memtx_tree_index_get,
-	/* .replace = */ memtx_tree_index_replace,
-	/* .create_iterator = */ memtx_tree_index_create_iterator,
-	/* .create_snapshot_iterator = */
-		memtx_tree_index_create_snapshot_iterator,
-	/* .info = */ generic_index_info,
-	/* .begin_build = */ memtx_tree_index_begin_build,
-	/* .reserve = */ memtx_tree_index_reserve,
-	/* .build_next = */ memtx_tree_index_build_next,
-	/* .end_build = */ memtx_tree_index_end_build,
-};
+/* }}} */
+
+void
+memtx_tree_index_sort_build_array(struct memtx_tree_index *index,
+				  int thread_count)
+{
+	struct key_def *cmp_def = memtx_tree_index_cmp_def(index);
+	size_t count = index->build_array_size;
+	if (count < MEMTX_TREE_SORT_PARALLEL_MIN)
+		thread_count = 1;
+	struct memtx_tree_data *tmp = NULL;
+	if (thread_count > 1) {
+		tmp = malloc(count * sizeof(*tmp));
+		if (tmp == NULL)
+			thread_count = 1;
+	}
+	/*
+	 * Hints speed up the sort even if the index doesn't
+	 * store them, so calculate them anyway.
+	 */
+	for (size_t i = 0; i < count; i++) {
+		struct memtx_tree_data *data = &index->build_array[i];
+		data->hint = tuple_hint(data->tuple, cmp_def);
+	}
+	struct memtx_tree_data *sorted =
+		memtx_tree_sort_elems(index->build_array, tmp, count,
+				      cmp_def, thread_count);
+	if (sorted == tmp) {
+		free(index->build_array);
+		index->build_array = tmp;
+		index->build_array_alloc_size = count;
+	} else {
+		free(tmp);
+	}
+	index->build_array_is_sorted = true;
+}
+
+struct tuple *
+memtx_tree_index_find_build_dup(struct memtx_tree_index *index)
+{
+	assert(index->build_array_is_sorted);
+	if (!index->base.def->opts.is_unique)
+		return NULL;
+	/*
+	 * A unique nullable index compares primary key parts
+	 * only if the key contains NULL, so it is enough to
+	 * compare neighbours with cmp_def.
+	 */
+	struct key_def *cmp_def = memtx_tree_index_cmp_def(index);
+	for (size_t i = 1; i < index->build_array_size; i++) {
+		struct memtx_tree_data *data = &index->build_array[i];
+		if (memtx_hint_tree_compare(data - 1, data, cmp_def) == 0)
+			return data->tuple;
+	}
+	return NULL;
+}
+
+#define MEMTX_TREE_NAME memtx_tree
+#define MEMTX_TREE_MEMBER tree
+#define MEMTX_TREE_HINT 0
+#include "memtx_tree_impl.h"
+#undef MEMTX_TREE_NAME
+#undef MEMTX_TREE_MEMBER
+#undef MEMTX_TREE_HINT
+
+#define MEMTX_TREE_NAME memtx_hint_tree
+#define MEMTX_TREE_MEMBER hint_tree
+#define MEMTX_TREE_HINT 1
+#include "memtx_tree_impl.h"
+#undef MEMTX_TREE_NAME
+#undef MEMTX_TREE_MEMBER
+#undef MEMTX_TREE_HINT
 
 struct memtx_tree_index *
 memtx_tree_index_new(struct memtx_engine *memtx, struct index_def *def)
@@ -584,8 +347,10 @@ memtx_tree_index_new(struct memtx_engine *memtx, struct index_def *def)
 	memtx_index_arena_init();
 
 	if (!mempool_is_initialized(&memtx->tree_iterator_pool)) {
+		size_t size = MAX(sizeof(struct memtx_tree_index_iterator),
+				  sizeof(struct memtx_hint_tree_index_iterator));
 		mempool_create(&memtx->tree_iterator_pool, cord_slab_cache(),
-			       sizeof(struct tree_iterator));
+			       size);
 	}
 
 	struct memtx_tree_index *index =
@@ -595,26 +360,24 @@ memtx_tree_index_new(struct memtx_engine *memtx, struct index_def *def)
 			 "malloc", "struct memtx_tree_index");
 		return NULL;
 	}
+	const struct index_vtab *vtab = def->opts.hint ?
+					&memtx_hint_tree_index_vtab :
+					&memtx_tree_index_vtab;
 	if (index_create(&index->base, (struct engine *)memtx,
-			 &memtx_tree_index_vtab, def) != 0) {
+			 vtab, def) != 0) {
 		free(index);
 		return NULL;
 	}
 
-	/**
-	 * Use extended key def for non-unique and nullable
-	 * indexes. Unique, but nullable, index can store
-	 * multiple NULLs. To correctly compare these NULLs
-	 * extended key def must be used. For details @sa
-	 * tuple_compare.cc.
-	 */
-	struct key_def *cmp_def;
-	if (def->opts.is_unique && !def->key_def->is_nullable)
-		cmp_def = index->base.def->key_def;
-	else
-		cmp_def = index->base.def->cmp_def;
-	memtx_tree_create(&index->tree, cmp_def,
-			  memtx_index_extent_alloc,
-			  memtx_index_extent_free, NULL);
+	struct key_def *cmp_def = memtx_tree_index_cmp_def(index);
+	if (def->opts.hint) {
+		memtx_hint_tree_create(&index->hint_tree, cmp_def,
+				       memtx_index_extent_alloc,
+				       memtx_index_extent_free, NULL);
+	} else {
+		memtx_tree_create(&index->tree, cmp_def,
+				  memtx_index_extent_alloc,
+				  memtx_index_extent_free, NULL);
+	}
 	return index;
 }
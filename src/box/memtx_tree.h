@@ -52,6 +52,19 @@ struct memtx_tree_key_data
 	const char *key;
 	/** Number of msgpacked search fields */
 	uint32_t part_count;
+	/** Key hint, only set for indexes with hints, @sa key_hint(). */
+	uint64_t hint;
+};
+
+/**
+ * An element of a TREE index with key hints: a tuple along with
+ * an order-preserving hint of its first key part, @sa tuple_hint().
+ * Most comparisons are resolved by hints without touching the
+ * tuple, tuple_compare() is only called on ties.
+ */
+struct memtx_tree_data {
+	struct tuple *tuple;
+	uint64_t hint;
 };
 
 /**
@@ -73,6 +86,36 @@ memtx_tree_compare_key(const struct tuple *tuple,
 				      key_data->part_count, def);
 }
 
+/**
+ * Hinted BPS tree element comparator.
+ * Tuples are only compared if their hints are equal.
+ */
+static inline int
+memtx_hint_tree_compare(const struct memtx_tree_data *a,
+			const struct memtx_tree_data *b,
+			struct key_def *def)
+{
+	if (a->hint != b->hint)
+		return a->hint < b->hint ? -1 : 1;
+	return tuple_compare(a->tuple, b->tuple, def);
+}
+
+/**
+ * Hinted BPS tree element vs key comparator.
+ * An empty key is equal to any element, hence its hint
+ * must not be looked at.
+ */
+static inline int
+memtx_hint_tree_compare_key(const struct memtx_tree_data *data,
+			    const struct memtx_tree_key_data *key_data,
+			    struct key_def *def)
+{
+	if (key_data->part_count > 0 && data->hint != key_data->hint)
+		return data->hint < key_data->hint ? -1 : 1;
+	return tuple_compare_with_key(data->tuple, key_data->key,
+				      key_data->part_count, def);
+}
+
 #define BPS_TREE_NAME memtx_tree
 #define BPS_TREE_BLOCK_SIZE (512)
 #define BPS_TREE_EXTENT_SIZE MEMTX_EXTENT_SIZE
@@ -93,16 +136,73 @@ memtx_tree_compare_key(const struct tuple *tuple,
 #undef bps_tree_key_t
 #undef bps_tree_arg_t
 
+/* Debug self-check routines compare elements with ==. */
+#define BPS_TREE_NO_DEBUG
+#define BPS_TREE_NAME memtx_hint_tree
+#define BPS_TREE_BLOCK_SIZE (512)
+#define BPS_TREE_EXTENT_SIZE MEMTX_EXTENT_SIZE
+#define BPS_TREE_COMPARE(a, b, arg) memtx_hint_tree_compare(&(a), &(b), arg)
+#define BPS_TREE_COMPARE_KEY(a, b, arg) memtx_hint_tree_compare_key(&(a), b, arg)
+#define bps_tree_elem_t struct memtx_tree_data
+#define bps_tree_key_t struct memtx_tree_key_data *
+#define bps_tree_arg_t struct key_def *
+
+#include "salad/bps_tree.h"
+
+#undef BPS_TREE_NAME
+#undef BPS_TREE_BLOCK_SIZE
+#undef BPS_TREE_EXTENT_SIZE
+#undef BPS_TREE_COMPARE
+#undef BPS_TREE_COMPARE_KEY
+#undef bps_tree_elem_t
+#undef bps_tree_key_t
+#undef bps_tree_arg_t
+#undef BPS_TREE_NO_DEBUG
+
 struct memtx_tree_index {
 	struct index base;
-	struct memtx_tree tree;
-	struct tuple **build_array;
+	union {
+		/** Tree of tuples, used unless opts.hint is set. */
+		struct memtx_tree tree;
+		/** Tree of tuples with key hints. */
+		struct memtx_hint_tree hint_tree;
+	};
+	/**
+	 * Tuples fed to the index in build mode, along with
+	 * their hints once the array is sorted. The hints are
+	 * used by the sort even if the index doesn't store them.
+	 */
+	struct memtx_tree_data *build_array;
 	size_t build_array_size, build_array_alloc_size;
+	/** Set if build_array has been sorted before end_build(). */
+	bool build_array_is_sorted;
 };
 
 struct memtx_tree_index *
 memtx_tree_index_new(struct memtx_engine *memtx, struct index_def *def);
 
+/**
+ * Sort tuples fed to the index in build mode, so that
+ * end_build() only has to load them into the tree. Doesn't
+ * touch the tree itself, hence may be called from any thread
+ * as long as the index isn't used concurrently. A big array
+ * is sorted in up to @thread_count threads, the calling one
+ * included.
+ */
+void
+memtx_tree_index_sort_build_array(struct memtx_tree_index *index,
+				  int thread_count);
+
+/**
+ * Look up a tuple whose key is equal to the key of its
+ * neighbour in the build array of a unique index, which
+ * must have been sorted. Returns NULL if there are no
+ * duplicates. May be called from any thread, just like
+ * memtx_tree_index_sort_build_array().
+ */
+struct tuple *
+memtx_tree_index_find_build_dup(struct memtx_tree_index *index);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
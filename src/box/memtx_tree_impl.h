@@ -0,0 +1,611 @@
+/*
+ * Copyright 2010-2017, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * TREE index implementation template, included by memtx_tree.c
+ * once per kind of tree. Parameters:
+ *
+ * MEMTX_TREE_NAME   - name of the BPS tree, memtx_tree.h,
+ *                     functions defined here are prefixed with
+ *                     MEMTX_TREE_NAME##_index_
+ * MEMTX_TREE_MEMBER - the tree member of struct memtx_tree_index
+ * MEMTX_TREE_HINT   - 1 if tree elements are struct memtx_tree_data
+ *                     with key hints, 0 if they are bare tuples
+ */
+
+#ifndef MEMTX_TREE_NAME
+#error "MEMTX_TREE_NAME must be defined"
+#endif
+
+#define tree_(name) CONCAT3(MEMTX_TREE_NAME, _, name)
+#define index_(name) CONCAT3(MEMTX_TREE_NAME, _index_, name)
+#define memtx_tree_elem_t index_(elem_t)
+
+#if MEMTX_TREE_HINT
+typedef struct memtx_tree_data memtx_tree_elem_t;
+#else
+typedef struct tuple *memtx_tree_elem_t;
+#endif
+
+/* {{{ Elements and keys ******************************************/
+
+static inline struct tuple *
+index_(elem_tuple)(const memtx_tree_elem_t *elem)
+{
+#if MEMTX_TREE_HINT
+	return elem->tuple;
+#else
+	return *elem;
+#endif
+}
+
+static inline void
+index_(elem_create)(memtx_tree_elem_t *elem, struct tuple *tuple,
+		    struct key_def *cmp_def)
+{
+#if MEMTX_TREE_HINT
+	elem->tuple = tuple;
+	elem->hint = tuple != NULL ? tuple_hint(tuple, cmp_def) : 0;
+#else
+	(void)cmp_def;
+	*elem = tuple;
+#endif
+}
+
+static inline void
+index_(key_data_create)(struct memtx_tree_key_data *key_data,
+			const char *key, uint32_t part_count,
+			struct key_def *cmp_def)
+{
+	key_data->key = key;
+	key_data->part_count = part_count;
+#if MEMTX_TREE_HINT
+	key_data->hint = key_hint(key, part_count, cmp_def);
+#else
+	(void)cmp_def;
+	key_data->hint = 0;
+#endif
+}
+
+static inline int
+index_(compare_key)(const memtx_tree_elem_t *elem,
+		    const struct memtx_tree_key_data *key_data,
+		    struct key_def *def)
+{
+#if MEMTX_TREE_HINT
+	return memtx_hint_tree_compare_key(elem, key_data, def);
+#else
+	return memtx_tree_compare_key(*elem, key_data, def);
+#endif
+}
+
+/* }}} */
+
+/* {{{ MemtxTree Iterators ****************************************/
+
+struct index_(iterator) {
+	struct iterator base;
+	const struct MEMTX_TREE_NAME *tree;
+	struct index_def *index_def;
+	struct tree_(iterator) tree_iterator;
+	enum iterator_type type;
+	struct memtx_tree_key_data key_data;
+	/** Last returned element, its tuple is referenced. */
+	memtx_tree_elem_t current;
+	/** Memory pool the iterator was allocated from. */
+	struct mempool *pool;
+};
+
+static void
+index_(iterator_free)(struct iterator *iterator);
+
+static inline struct index_(iterator) *
+index_(iterator)(struct iterator *it)
+{
+	assert(it->free == index_(iterator_free));
+	return (struct index_(iterator) *) it;
+}
+
+static inline struct tuple *
+index_(iterator_current)(struct index_(iterator) *it)
+{
+	return index_(elem_tuple)(&it->current);
+}
+
+static void
+index_(iterator_free)(struct iterator *iterator)
+{
+	struct index_(iterator) *it = index_(iterator)(iterator);
+	struct tuple *current = index_(iterator_current)(it);
+	if (current != NULL)
+		tuple_unref(current);
+	mempool_free(it->pool, it);
+}
+
+/**
+ * Set the iterator to the element it points to in the tree,
+ * or to a dead end if there is none. Returns the new tuple.
+ */
+static inline struct tuple *
+index_(iterator_fetch)(struct index_(iterator) *it, memtx_tree_elem_t *res)
+{
+	struct tuple *current = index_(iterator_current)(it);
+	tuple_unref(current);
+	if (res == NULL) {
+		it->base.next = tree_iterator_dummie;
+		index_(elem_create)(&it->current, NULL, NULL);
+		return NULL;
+	}
+	it->current = *res;
+	current = index_(iterator_current)(it);
+	tuple_ref(current);
+	return current;
+}
+
+static int
+index_(iterator_next)(struct iterator *iterator, struct tuple **ret)
+{
+	struct index_(iterator) *it = index_(iterator)(iterator);
+	assert(index_(iterator_current)(it) != NULL);
+	memtx_tree_elem_t *check =
+		tree_(iterator_get_elem)(it->tree, &it->tree_iterator);
+	if (check == NULL || index_(elem_tuple)(check) !=
+			     index_(iterator_current)(it))
+		it->tree_iterator =
+			tree_(upper_bound_elem)(it->tree, it->current, NULL);
+	else
+		tree_(iterator_next)(it->tree, &it->tree_iterator);
+	memtx_tree_elem_t *res =
+		tree_(iterator_get_elem)(it->tree, &it->tree_iterator);
+	*ret = index_(iterator_fetch)(it, res);
+	return 0;
+}
+
+static int
+index_(iterator_prev)(struct iterator *iterator, struct tuple **ret)
+{
+	struct index_(iterator) *it = index_(iterator)(iterator);
+	assert(index_(iterator_current)(it) != NULL);
+	memtx_tree_elem_t *check =
+		tree_(iterator_get_elem)(it->tree, &it->tree_iterator);
+	if (check == NULL || index_(elem_tuple)(check) !=
+			     index_(iterator_current)(it))
+		it->tree_iterator =
+			tree_(lower_bound_elem)(it->tree, it->current, NULL);
+	tree_(iterator_prev)(it->tree, &it->tree_iterator);
+	memtx_tree_elem_t *res =
+		tree_(iterator_get_elem)(it->tree, &it->tree_iterator);
+	*ret = index_(iterator_fetch)(it, res);
+	return 0;
+}
+
+static int
+index_(iterator_next_equal)(struct iterator *iterator, struct tuple **ret)
+{
+	struct index_(iterator) *it = index_(iterator)(iterator);
+	assert(index_(iterator_current)(it) != NULL);
+	memtx_tree_elem_t *check =
+		tree_(iterator_get_elem)(it->tree, &it->tree_iterator);
+	if (check == NULL || index_(elem_tuple)(check) !=
+			     index_(iterator_current)(it))
+		it->tree_iterator =
+			tree_(upper_bound_elem)(it->tree, it->current, NULL);
+	else
+		tree_(iterator_next)(it->tree, &it->tree_iterator);
+	memtx_tree_elem_t *res =
+		tree_(iterator_get_elem)(it->tree, &it->tree_iterator);
+	/* Use user key def to save a few loops. */
+	if (res != NULL && index_(compare_key)(res, &it->key_data,
+					       it->index_def->key_def) != 0)
+		res = NULL;
+	*ret = index_(iterator_fetch)(it, res);
+	return 0;
+}
+
+static int
+index_(iterator_prev_equal)(struct iterator *iterator, struct tuple **ret)
+{
+	struct index_(iterator) *it = index_(iterator)(iterator);
+	assert(index_(iterator_current)(it) != NULL);
+	memtx_tree_elem_t *check =
+		tree_(iterator_get_elem)(it->tree, &it->tree_iterator);
+	if (check == NULL || index_(elem_tuple)(check) !=
+			     index_(iterator_current)(it))
+		it->tree_iterator =
+			tree_(lower_bound_elem)(it->tree, it->current, NULL);
+	tree_(iterator_prev)(it->tree, &it->tree_iterator);
+	memtx_tree_elem_t *res =
+		tree_(iterator_get_elem)(it->tree, &it->tree_iterator);
+	/* Use user key def to save a few loops. */
+	if (res != NULL && index_(compare_key)(res, &it->key_data,
+					       it->index_def->key_def) != 0)
+		res = NULL;
+	*ret = index_(iterator_fetch)(it, res);
+	return 0;
+}
+
+static void
+index_(iterator_set_next_method)(struct index_(iterator) *it)
+{
+	assert(index_(iterator_current)(it) != NULL);
+	switch (it->type) {
+	case ITER_EQ:
+		it->base.next = index_(iterator_next_equal);
+		break;
+	case ITER_REQ:
+		it->base.next = index_(iterator_prev_equal);
+		break;
+	case ITER_ALL:
+		it->base.next = index_(iterator_next);
+		break;
+	case ITER_LT:
+	case ITER_LE:
+		it->base.next = index_(iterator_prev);
+		break;
+	case ITER_GE:
+	case ITER_GT:
+		it->base.next = index_(iterator_next);
+		break;
+	default:
+		/* The type was checked in initIterator */
+		assert(false);
+	}
+}
+
+static int
+index_(iterator_start)(struct iterator *iterator, struct tuple **ret)
+{
+	*ret = NULL;
+	struct index_(iterator) *it = index_(iterator)(iterator);
+	it->base.next = tree_iterator_dummie;
+	const struct MEMTX_TREE_NAME *tree = it->tree;
+	enum iterator_type type = it->type;
+	bool exact = false;
+	assert(index_(iterator_current)(it) == NULL);
+	if (it->key_data.key == 0) {
+		if (iterator_type_is_reverse(it->type))
+			it->tree_iterator = tree_(iterator_last)(tree);
+		else
+			it->tree_iterator = tree_(iterator_first)(tree);
+	} else {
+		if (type == ITER_ALL || type == ITER_EQ ||
+		    type == ITER_GE || type == ITER_LT) {
+			it->tree_iterator =
+				tree_(lower_bound)(tree, &it->key_data,
+						   &exact);
+			if (type == ITER_EQ && !exact)
+				return 0;
+		} else { // ITER_GT, ITER_REQ, ITER_LE
+			it->tree_iterator =
+				tree_(upper_bound)(tree, &it->key_data,
+						   &exact);
+			if (type == ITER_REQ && !exact)
+				return 0;
+		}
+		if (iterator_type_is_reverse(type)) {
+			/*
+			 * Because of limitations of tree search API we use use
+			 * lower_bound for LT search and upper_bound for LE
+			 * and REQ searches. Thus we found position to the
+			 * right of the target one. Let's make a step to the
+			 * left to reach target position.
+			 * If we found an invalid iterator all the elements in
+			 * the tree are less (less or equal) to the key, and
+			 * iterator_next call will convert the iterator to the
+			 * last position in the tree, that's what we need.
+			 */
+			tree_(iterator_prev)(it->tree, &it->tree_iterator);
+		}
+	}
+
+	memtx_tree_elem_t *res =
+		tree_(iterator_get_elem)(it->tree, &it->tree_iterator);
+	if (!res)
+		return 0;
+	it->current = *res;
+	*ret = index_(iterator_current)(it);
+	tuple_ref(*ret);
+	index_(iterator_set_next_method)(it);
+	return 0;
+}
+
+/* }}} */
+
+/* {{{ MemtxTree  **********************************************************/
+
+static void
+index_(destroy)(struct index *base)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	tree_(destroy)(&index->MEMTX_TREE_MEMBER);
+	free(index->build_array);
+	free(index);
+}
+
+static ssize_t
+index_(size)(struct index *base)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	return tree_(size)(&index->MEMTX_TREE_MEMBER);
+}
+
+static ssize_t
+index_(bsize)(struct index *base)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	return tree_(mem_used)(&index->MEMTX_TREE_MEMBER);
+}
+
+static int
+index_(random)(struct index *base, uint32_t rnd, struct tuple **result)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	memtx_tree_elem_t *res = tree_(random)(&index->MEMTX_TREE_MEMBER, rnd);
+	*result = res != NULL ? index_(elem_tuple)(res) : NULL;
+	return 0;
+}
+
+static ssize_t
+index_(count)(struct index *base, enum iterator_type type,
+	      const char *key, uint32_t part_count)
+{
+	if (type == ITER_ALL)
+		return index_(size)(base); /* optimization */
+	return generic_index_count(base, type, key, part_count);
+}
+
+static int
+index_(get)(struct index *base, const char *key,
+	    uint32_t part_count, struct tuple **result)
+{
+	assert(base->def->opts.is_unique &&
+	       part_count == base->def->key_def->part_count);
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct MEMTX_TREE_NAME *tree = &index->MEMTX_TREE_MEMBER;
+	struct memtx_tree_key_data key_data;
+	index_(key_data_create)(&key_data, key, part_count, tree->arg);
+	memtx_tree_elem_t *res = tree_(find)(tree, &key_data);
+	*result = res != NULL ? index_(elem_tuple)(res) : NULL;
+	return 0;
+}
+
+static int
+index_(replace)(struct index *base, struct tuple *old_tuple,
+		struct tuple *new_tuple, enum dup_replace_mode mode,
+		struct tuple **result)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct MEMTX_TREE_NAME *tree = &index->MEMTX_TREE_MEMBER;
+	if (new_tuple) {
+		memtx_tree_elem_t new_elem, dup_elem;
+		index_(elem_create)(&new_elem, new_tuple, tree->arg);
+		index_(elem_create)(&dup_elem, NULL, NULL);
+
+		/* Try to optimistically replace the new_tuple. */
+		int tree_res = tree_(insert)(tree, new_elem, &dup_elem);
+		if (tree_res) {
+			diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
+				 "memtx_tree_index", "replace");
+			return -1;
+		}
+
+		struct tuple *dup_tuple = index_(elem_tuple)(&dup_elem);
+		uint32_t errcode = replace_check_dup(old_tuple,
+						     dup_tuple, mode);
+		if (errcode) {
+			tree_(delete)(tree, new_elem);
+			if (dup_tuple)
+				tree_(insert)(tree, dup_elem, 0);
+			struct space *sp = space_cache_find(base->def->space_id);
+			if (sp != NULL)
+				diag_set(ClientError, errcode, base->def->name,
+					 space_name(sp));
+			return -1;
+		}
+		if (dup_tuple) {
+			*result = dup_tuple;
+			return 0;
+		}
+	}
+	if (old_tuple) {
+		memtx_tree_elem_t old_elem;
+		index_(elem_create)(&old_elem, old_tuple, tree->arg);
+		tree_(delete)(tree, old_elem);
+	}
+	*result = old_tuple;
+	return 0;
+}
+
+static struct iterator *
+index_(create_iterator)(struct index *base, enum iterator_type type,
+			const char *key, uint32_t part_count)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
+
+	assert(part_count == 0 || key != NULL);
+	if (type > ITER_GT) {
+		diag_set(UnsupportedIndexFeature, base->def,
+			 "requested iterator type");
+		return NULL;
+	}
+
+	if (part_count == 0) {
+		/*
+		 * If no key is specified, downgrade equality
+		 * iterators to a full range.
+		 */
+		type = iterator_type_is_reverse(type) ? ITER_LE : ITER_GE;
+		key = NULL;
+	}
+
+	struct index_(iterator) *it =
+		mempool_alloc(&memtx->tree_iterator_pool);
+	if (it == NULL) {
+		diag_set(OutOfMemory, sizeof(struct index_(iterator)),
+			 "memtx_tree_index", "iterator");
+		return NULL;
+	}
+	iterator_create(&it->base, base);
+	it->pool = &memtx->tree_iterator_pool;
+	it->base.next = index_(iterator_start);
+	it->base.free = index_(iterator_free);
+	it->type = type;
+	it->tree = &index->MEMTX_TREE_MEMBER;
+	index_(key_data_create)(&it->key_data, key, part_count,
+				it->tree->arg);
+	it->index_def = base->def;
+	it->tree_iterator = tree_(invalid_iterator)();
+	index_(elem_create)(&it->current, NULL, NULL);
+	return (struct iterator *)it;
+}
+
+static void
+index_(begin_build)(struct index *base)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	assert(tree_(size)(&index->MEMTX_TREE_MEMBER) == 0);
+	(void)index;
+}
+
+static void
+index_(end_build)(struct index *base)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
+	if (!index->build_array_is_sorted)
+		memtx_tree_index_sort_build_array(index,
+						  memtx->snapshot_threads);
+#if MEMTX_TREE_HINT
+	memtx_tree_elem_t *elems = index->build_array;
+#else
+	/*
+	 * The tree doesn't store hints, squeeze them out.
+	 * Safe to do in place, because elements only move
+	 * to the left.
+	 */
+	memtx_tree_elem_t *elems = (memtx_tree_elem_t *)index->build_array;
+	for (size_t i = 0; i < index->build_array_size; i++)
+		elems[i] = index->build_array[i].tuple;
+#endif
+	tree_(build)(&index->MEMTX_TREE_MEMBER, elems,
+		     index->build_array_size);
+
+	free(index->build_array);
+	index->build_array = NULL;
+	index->build_array_size = 0;
+	index->build_array_alloc_size = 0;
+	index->build_array_is_sorted = false;
+}
+
+struct index_(snapshot_iterator) {
+	struct snapshot_iterator base;
+	struct MEMTX_TREE_NAME *tree;
+	struct tree_(iterator) tree_iterator;
+};
+
+static void
+index_(snapshot_iterator_free)(struct snapshot_iterator *iterator)
+{
+	assert(iterator->free == index_(snapshot_iterator_free));
+	struct index_(snapshot_iterator) *it =
+		(struct index_(snapshot_iterator) *)iterator;
+	tree_(iterator_destroy)(it->tree, &it->tree_iterator);
+	free(iterator);
+}
+
+static const char *
+index_(snapshot_iterator_next)(struct snapshot_iterator *iterator,
+			       uint32_t *size)
+{
+	assert(iterator->free == index_(snapshot_iterator_free));
+	struct index_(snapshot_iterator) *it =
+		(struct index_(snapshot_iterator) *)iterator;
+	memtx_tree_elem_t *res =
+		tree_(iterator_get_elem)(it->tree, &it->tree_iterator);
+	if (res == NULL)
+		return NULL;
+	tree_(iterator_next)(it->tree, &it->tree_iterator);
+	return tuple_data_range(index_(elem_tuple)(res), size);
+}
+
+/**
+ * Create an ALL iterator with personal read view so further
+ * index modifications will not affect the iteration results.
+ * Must be destroyed by iterator->free after usage.
+ */
+static struct snapshot_iterator *
+index_(create_snapshot_iterator)(struct index *base)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct index_(snapshot_iterator) *it =
+		(struct index_(snapshot_iterator) *)calloc(1, sizeof(*it));
+	if (it == NULL) {
+		diag_set(OutOfMemory, sizeof(*it),
+			 "memtx_tree_index", "create_snapshot_iterator");
+		return NULL;
+	}
+
+	it->base.free = index_(snapshot_iterator_free);
+	it->base.next = index_(snapshot_iterator_next);
+	it->tree = &index->MEMTX_TREE_MEMBER;
+	it->tree_iterator = tree_(iterator_first)(it->tree);
+	tree_(iterator_freeze)(it->tree, &it->tree_iterator);
+	return (struct snapshot_iterator *) it;
+}
+
+static const struct index_vtab index_(vtab) = {
+	/* .destroy = */ index_(destroy),
+	/* .commit_create = */ generic_index_commit_create,
+	/* .commit_drop = */ generic_index_commit_drop,
+	/* .size = */ index_(size),
+	/* .bsize = */ index_(bsize),
+	/* .min = */ generic_index_min,
+	/* .max = */ generic_index_max,
+	/* .random = */ index_(random),
+	/* .count = */ index_(count),
+	/* .get = */ index_(get),
+	/* .replace = */ index_(replace),
+	/* .create_iterator = */ index_(create_iterator),
+	/* .create_snapshot_iterator = */
+		index_(create_snapshot_iterator),
+	/* .info = */ generic_index_info,
+	/* .begin_build = */ index_(begin_build),
+	/* .reserve = */ memtx_tree_index_reserve,
+	/* .build_next = */ memtx_tree_index_build_next,
+	/* .end_build = */ index_(end_build),
+};
+
+/* }}} */
+
+#undef tree_
+#undef index_
+#undef memtx_tree_elem_t
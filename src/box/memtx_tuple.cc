@@ -60,6 +60,12 @@ struct small_alloc memtx_alloc; /* used box box.slab.info() */
 /* The maximal allowed tuple size, box.cfg.memtx_max_tuple_size */
 size_t memtx_max_tuple_size = 1 * 1024 * 1024; /* set dynamically */
 uint32_t snapshot_version;
+/**
+ * Number of tuple freezes in progress: checkpoints and online
+ * index builds may overlap, delayed free stays on until the
+ * last of them is over.
+ */
+static int snapshot_freeze_count;
 
 enum {
 	/** Lowest allowed slab_alloc_minimal */
@@ -167,15 +173,28 @@ memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 		smfree_delayed(&memtx_alloc, memtx_tuple, total);
 }
 
+bool
+memtx_tuple_is_mutable(const struct tuple *tuple)
+{
+	const struct memtx_tuple *memtx_tuple =
+		container_of(tuple, struct memtx_tuple, base);
+	/* @sa memtx_tuple_delete() */
+	return memtx_alloc.free_mode != SMALL_DELAYED_FREE ||
+	       memtx_tuple->version == snapshot_version;
+}
+
 void
 memtx_tuple_begin_snapshot()
 {
 	snapshot_version++;
-	small_alloc_setopt(&memtx_alloc, SMALL_DELAYED_FREE_MODE, true);
+	if (snapshot_freeze_count++ == 0)
+		small_alloc_setopt(&memtx_alloc, SMALL_DELAYED_FREE_MODE, true);
 }
 
 void
 memtx_tuple_end_snapshot()
 {
-	small_alloc_setopt(&memtx_alloc, SMALL_DELAYED_FREE_MODE, false);
+	assert(snapshot_freeze_count > 0);
+	if (--snapshot_freeze_count == 0)
+		small_alloc_setopt(&memtx_alloc, SMALL_DELAYED_FREE_MODE, false);
 }
@@ -63,6 +63,13 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end);
 void
 memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple);
 
+/**
+ * Return true if the tuple data may be changed in place, i.e.
+ * the tuple can't be seen by a checkpoint in progress.
+ */
+bool
+memtx_tuple_is_mutable(const struct tuple *tuple);
+
 /** Maximal allowed tuple size (box.cfg.memtx_max_tuple_size) */
 extern size_t memtx_max_tuple_size;
 
@@ -31,6 +31,7 @@
 #include "port.h"
 #include "tuple.h"
 #include "tuple_convert.h"
+#include <msgpuck.h>
 #include <small/obuf.h>
 #include <small/slab_cache.h>
 #include <small/mempool.h>
@@ -108,6 +109,31 @@ port_dump(struct port *port, struct obuf *out)
 	return 0;
 }
 
+int
+port_dump_groups(struct port *port, const uint32_t *group_size,
+		 uint32_t group_count, struct obuf *out)
+{
+	struct port_entry *pe = port->first;
+	for (uint32_t i = 0; i < group_count; i++) {
+		char *pos = (char *) obuf_alloc(out,
+					mp_sizeof_array(group_size[i]));
+		if (pos == NULL) {
+			diag_set(OutOfMemory, mp_sizeof_array(group_size[i]),
+				 "obuf_alloc", "pos");
+			return -1;
+		}
+		mp_encode_array(pos, group_size[i]);
+		for (uint32_t j = 0; j < group_size[i]; j++) {
+			assert(pe != NULL);
+			if (tuple_to_obuf(pe->tuple, out) != 0)
+				return -1;
+			pe = pe->next;
+		}
+	}
+	assert(pe == NULL);
+	return 0;
+}
+
 void
 port_init(void)
 {
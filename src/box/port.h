@@ -82,6 +82,14 @@ port_destroy(struct port *port);
 int
 port_dump(struct port *port, struct obuf *out);
 
+/**
+ * Dump the tuples of a port as @a group_count MsgPack arrays,
+ * the i-th array holding the next @a group_size[i] tuples.
+ */
+int
+port_dump_groups(struct port *port, const uint32_t *group_size,
+		 uint32_t group_count, struct obuf *out);
+
 int
 port_add_tuple(struct port *port, struct tuple *tuple);
 
@@ -30,6 +30,8 @@
  */
 #include "relay.h"
 
+#include <limits.h>
+
 #include "trivia/config.h"
 #include "trivia/util.h"
 #include "cbus.h"
@@ -37,6 +39,9 @@
 #include "errinj.h"
 #include "fiber.h"
 #include "say.h"
+#include "scoped_guard.h"
+#include "small/ibuf.h"
+#include "small/obuf.h"
 
 #include "coio.h"
 #include "coio_task.h"
@@ -56,6 +61,23 @@
 /** Network timeout */
 double relay_timeout;
 
+enum {
+	/**
+	 * Rows are accumulated in the relay output vector and
+	 * sent to the replica with a single writev() once they
+	 * grow that large or there are no more rows to send at
+	 * the moment.
+	 */
+	RELAY_BATCH_SIZE = 128 * 1024,
+	/** Max number of rows in the relay output vector. */
+	RELAY_BATCH_ROWS = IOV_MAX / XROW_IOVMAX,
+	/**
+	 * Bodies of WAL rows are sent without copying if they
+	 * belong to a transaction at least that large.
+	 */
+	RELAY_TX_REF_MIN = RELAY_BATCH_SIZE / 8,
+};
+
 /**
  * Cbus message to send status updates from relay to tx thread.
  */
@@ -108,6 +130,27 @@ struct relay {
 	struct vclock recv_vclock;
 	/** Replicatoin slave version. */
 	uint32_t version_id;
+	/**
+	 * Rows encoded but not sent to the replica yet, array
+	 * of struct iovec. Allocated in the thread which feeds
+	 * the relay, as all send buffers below.
+	 */
+	struct ibuf send_iov;
+	/** Total size of the rows referenced by send_iov. */
+	size_t send_size;
+	/**
+	 * Row headers and the row bodies which may be gone
+	 * before the rows are sent.
+	 */
+	struct obuf send_buf;
+	/**
+	 * Buffers of xlog transactions taken over from the
+	 * recovery cursor, array of struct ibuf. Bodies of WAL
+	 * rows are sent right from these buffers, so they are
+	 * freed only after a flush. The last one may still be
+	 * read by the cursor.
+	 */
+	struct ibuf tx_bufs;
 
 	/** Relay endpoint */
 	struct cbus_endpoint endpoint;
@@ -136,6 +179,12 @@ static void
 relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row);
 static void
 relay_send_row(struct xstream *stream, struct xrow_header *row);
+static void
+relay_flush(struct relay *relay);
+static void
+relay_create_send_buf(struct relay *relay);
+static void
+relay_destroy_send_buf(struct relay *relay);
 
 static inline void
 relay_init(struct relay *relay, int fd, uint64_t sync,
@@ -170,7 +219,12 @@ relay_initial_join(int fd, uint64_t sync, struct vclock *vclock)
 	struct relay relay;
 	relay_init(&relay, fd, sync, relay_send_initial_join_row);
 	assert(relay.stream.write != NULL);
+	relay_create_send_buf(&relay);
+	auto buf_guard = make_scoped_guard([&]{
+		relay_destroy_send_buf(&relay);
+	});
 	engine_join_xc(vclock, &relay.stream);
+	relay_flush(&relay);
 }
 
 int
@@ -179,11 +233,16 @@ relay_final_join_f(va_list ap)
 	struct relay *relay = va_arg(ap, struct relay *);
 	coio_enable();
 	relay_set_cord_name(relay->io.fd);
+	relay_create_send_buf(relay);
+	auto buf_guard = make_scoped_guard([=]{
+		relay_destroy_send_buf(relay);
+	});
 
 	/* Send all WALs until stop_vclock */
 	assert(relay->stream.write != NULL);
 	recover_remaining_wals(relay->r, &relay->stream,
 			       &relay->stop_vclock, true);
+	relay_flush(relay);
 	assert(vclock_compare(&relay->r->vclock, &relay->stop_vclock) == 0);
 	return 0;
 }
@@ -283,6 +342,7 @@ relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 	try {
 		recover_remaining_wals(relay->r, &relay->stream, NULL,
 				       (events & WAL_EVENT_ROTATE) != 0);
+		relay_flush(relay);
 	} catch (Exception *e) {
 		e->log();
 		diag_move(diag_get(), &relay->diag);
@@ -346,6 +406,7 @@ relay_subscribe_f(va_list ap)
 	struct recovery *r = relay->r;
 
 	coio_enable();
+	relay_create_send_buf(relay);
 	cbus_endpoint_create(&relay->endpoint, cord_name(cord()),
 			     fiber_schedule_cb, fiber());
 	cbus_pair("tx", cord_name(cord()), &relay->tx_pipe, &relay->relay_pipe,
@@ -413,6 +474,7 @@ relay_subscribe_f(va_list ap)
 	cbus_unpair(&relay->tx_pipe, &relay->relay_pipe,
 		    NULL, NULL, cbus_process);
 	cbus_endpoint_destroy(&relay->endpoint, cbus_process);
+	relay_destroy_send_buf(relay);
 	if (!diag_is_empty(&relay->diag)) {
 		/* An error has occured while ACKs of xlog reading */
 		diag_move(&relay->diag, diag_get());
@@ -473,16 +535,156 @@ relay_subscribe(int fd, uint64_t sync, struct replica *replica,
 		diag_raise();
 }
 
+static void
+relay_create_send_buf(struct relay *relay)
+{
+	ibuf_create(&relay->send_iov, &cord()->slabc,
+		    RELAY_BATCH_ROWS * XROW_IOVMAX * sizeof(struct iovec));
+	relay->send_size = 0;
+	obuf_create(&relay->send_buf, &cord()->slabc, RELAY_BATCH_SIZE);
+	ibuf_create(&relay->tx_bufs, &cord()->slabc,
+		    RELAY_BATCH_SIZE / RELAY_TX_REF_MIN * sizeof(struct ibuf));
+}
+
+/**
+ * Free the xlog transaction buffers taken over by the relay.
+ * Keep the last one if the recovery cursor may still read it.
+ */
+static void
+relay_free_tx_bufs(struct relay *relay, bool keep_last)
+{
+	struct ibuf *bufs = (struct ibuf *)relay->tx_bufs.rpos;
+	size_t count = ibuf_used(&relay->tx_bufs) / sizeof(*bufs);
+	if (count == 0)
+		return;
+	if (keep_last)
+		count--;
+	for (size_t i = 0; i < count; i++)
+		ibuf_destroy(&bufs[i]);
+	if (keep_last) {
+		/* The memory is reserved, so this can't fail. */
+		struct ibuf last = bufs[count];
+		ibuf_reset(&relay->tx_bufs);
+		*(struct ibuf *)ibuf_alloc(&relay->tx_bufs,
+					   sizeof(last)) = last;
+	} else {
+		ibuf_reset(&relay->tx_bufs);
+	}
+}
+
+static void
+relay_destroy_send_buf(struct relay *relay)
+{
+	relay_free_tx_bufs(relay, false);
+	ibuf_destroy(&relay->tx_bufs);
+	obuf_destroy(&relay->send_buf);
+	ibuf_destroy(&relay->send_iov);
+}
+
+/**
+ * Take over the buffer of the xlog transaction the recovery
+ * cursor is reading now, unless it has been taken already.
+ */
+static void
+relay_detach_tx_buf(struct relay *relay)
+{
+	/*
+	 * The buffer is allocated in big chunks, so holding it
+	 * until the flush for a small transaction would waste
+	 * memory. Rows of such transactions are copied.
+	 */
+	if (relay->r->cursor.tx_cursor.size < RELAY_TX_REF_MIN)
+		return;
+	struct ibuf buf;
+	/* Don't leak the buffer if we fail to remember it. */
+	ibuf_reserve_xc(&relay->tx_bufs, sizeof(buf));
+	if (xlog_cursor_detach_tx(&relay->r->cursor, &buf))
+		*(struct ibuf *)ibuf_alloc(&relay->tx_bufs, sizeof(buf)) = buf;
+}
+
+/**
+ * Check if data is stored in a buffer owned by the relay,
+ * so that it stays valid until the next flush.
+ */
+static bool
+relay_owns_data(struct relay *relay, const char *data, size_t size)
+{
+	if (ibuf_used(&relay->tx_bufs) == 0)
+		return false;
+	/* Rows come in order, so only the last buffer matters. */
+	struct ibuf *buf = (struct ibuf *)relay->tx_bufs.wpos - 1;
+	return data >= buf->buf && data + size <= buf->wpos;
+}
+
+/** Append data to the relay output vector. */
+static void
+relay_add_iov(struct relay *relay, char *data, size_t size)
+{
+	struct ibuf *send_iov = &relay->send_iov;
+	relay->send_size += size;
+	if (ibuf_used(send_iov) > 0) {
+		struct iovec *last = (struct iovec *)send_iov->wpos - 1;
+		if ((char *)last->iov_base + last->iov_len == data) {
+			last->iov_len += size;
+			return;
+		}
+	}
+	struct iovec *iov = (struct iovec *)
+		ibuf_alloc_xc(send_iov, sizeof(*iov));
+	iov->iov_base = data;
+	iov->iov_len = size;
+}
+
+/** Send all buffered rows to the replica. */
+static void
+relay_flush(struct relay *relay)
+{
+	struct ibuf *send_iov = &relay->send_iov;
+	if (relay->send_size == 0)
+		return;
+	coio_writev(&relay->io, (struct iovec *)send_iov->rpos,
+		    ibuf_used(send_iov) / sizeof(struct iovec),
+		    relay->send_size);
+	ibuf_reset(send_iov);
+	relay->send_size = 0;
+	obuf_reset(&relay->send_buf);
+	relay_free_tx_bufs(relay, true);
+}
+
+/**
+ * Queue a row for sending. The row header is encoded on the
+ * fiber region, so it is copied to the relay output buffer.
+ * The body is referenced in place if the relay owns it, as it
+ * does for WAL rows, and copied otherwise.
+ */
 static void
 relay_send(struct relay *relay, struct xrow_header *packet)
 {
 	packet->sync = relay->sync;
-	coio_write_xrow(&relay->io, packet);
+	struct iovec iov[XROW_IOVMAX];
+	int iovcnt = xrow_to_iovec_xc(packet, iov);
+	if (ibuf_used(&relay->send_iov) / sizeof(*iov) + iovcnt > IOV_MAX)
+		relay_flush(relay);
+	for (int i = 0; i < iovcnt; i++) {
+		char *data = (char *)iov[i].iov_base;
+		size_t size = iov[i].iov_len;
+		if (i == 0 || !relay_owns_data(relay, data, size)) {
+			char *copy = (char *)obuf_alloc_xc(&relay->send_buf,
+							   size);
+			memcpy(copy, data, size);
+			data = copy;
+		}
+		relay_add_iov(relay, data, size);
+	}
 	fiber_gc();
+	if (relay->send_size >= RELAY_BATCH_SIZE)
+		relay_flush(relay);
 
 	struct errinj *inj = errinj(ERRINJ_RELAY_TIMEOUT, ERRINJ_DOUBLE);
-	if (inj != NULL && inj->dparam > 0)
+	if (inj != NULL && inj->dparam > 0) {
+		relay_flush(relay);
 		fiber_sleep(inj->dparam);
+	}
 }
 
 static void
@@ -505,6 +707,7 @@ relay_send_row(struct xstream *stream, struct xrow_header *packet)
 	 */
 	if (relay->replica == NULL ||
 	    packet->replica_id != relay->replica->id) {
+		relay_detach_tx_buf(relay);
 		relay_send(relay, packet);
 	}
 }
@@ -39,6 +39,8 @@
 #include "xrow.h"
 #include "iproto_constants.h"
 #include "sequence.h"
+#include "histogram.h"
+#include "latency.h"
 
 int
 access_check_space(struct space *space, uint8_t access)
@@ -121,6 +123,13 @@ space_create(struct space *space, struct engine *engine,
 	if (space->def == NULL)
 		goto fail;
 
+	space->latency = latency_histogram_new();
+	if (space->latency == NULL) {
+		diag_set(OutOfMemory, sizeof(struct histogram),
+			 "malloc", "latency");
+		goto fail;
+	}
+
 	/* Create indexes and fill the index map. */
 	space->index_map = (struct index **)
 		calloc(index_count + index_id_max + 1, sizeof(struct index *));
@@ -147,6 +156,8 @@ fail_free_indexes:
 	}
 fail:
 	free(space->index_map);
+	if (space->latency != NULL)
+		histogram_delete(space->latency);
 	if (space->def != NULL)
 		space_def_delete(space->def);
 	if (space->format != NULL)
@@ -172,6 +183,7 @@ space_delete(struct space *space)
 			index_delete(index);
 	}
 	free(space->index_map);
+	histogram_delete(space->latency);
 	if (space->format != NULL)
 		tuple_format_unref(space->format);
 	trigger_destroy(&space->on_replace);
@@ -270,6 +282,12 @@ space_def_check_compatibility(const struct space_def *old_def,
 			 "can not switch temporary flag on a non-empty space");
 		return -1;
 	}
+	if (new_def->opts.full_field_map != old_def->opts.full_field_map) {
+		diag_set(ClientError, ER_ALTER_SPACE, old_def->name,
+			 "can not switch full_field_map flag on a non-empty "
+			 "space");
+		return -1;
+	}
 	uint32_t field_count = MIN(new_def->field_count, old_def->field_count);
 	for (uint32_t i = 0; i < field_count; ++i) {
 		enum field_type old_type = old_def->fields[i].type;
@@ -49,6 +49,7 @@ struct txn;
 struct request;
 struct port;
 struct tuple;
+struct histogram;
 
 struct space_vtab {
 	/** Free a space instance. */
@@ -174,6 +175,20 @@ struct space {
 	uint64_t truncate_count;
 	/** Enable/disable triggers. */
 	bool run_triggers;
+	/**
+	 * Set while a DDL statement builds a new index of the
+	 * space. The build may yield, so any other DDL on the
+	 * space is rejected until it is over.
+	 */
+	bool is_build_in_progress;
+	/**
+	 * Set if the index being built is the only data structure
+	 * the DDL statement builds, so the build may yield and
+	 * catch up with the changes made to the space meanwhile.
+	 * Otherwise indexes built before it by the same statement
+	 * would miss these changes.
+	 */
+	bool can_build_online;
 	/**
 	 * Space format or NULL if space does not have format
 	 * (sysview engine, for example).
@@ -189,6 +204,11 @@ struct space {
 	 * of index id.
 	 */
 	struct index **index;
+	/**
+	 * DML request latency in microseconds, box.stat.latency().
+	 * Passed on to the new space on alter.
+	 */
+	struct histogram *latency;
 };
 
 /** Initialize a base space instance. */
@@ -34,11 +34,13 @@
 
 const struct space_opts space_opts_default = {
 	/* .temporary = */ false,
+	/* .full_field_map = */ false,
 	/* .sql        = */ NULL,
 };
 
 const struct opt_def space_opts_reg[] = {
 	OPT_DEF("temporary", OPT_BOOL, struct space_opts, temporary),
+	OPT_DEF("full_field_map", OPT_BOOL, struct space_opts, full_field_map),
 	OPT_DEF("sql", OPT_STRPTR, struct space_opts, sql),
 	OPT_END,
 };
@@ -49,6 +49,12 @@ struct space_opts {
 	 * - changes are not part of a snapshot
 	 */
 	bool temporary;
+	/**
+	 * Tuples of the space store offsets of all fields of
+	 * the space format, so that any of them is accessible
+	 * in O(1), not only indexed ones.
+	 */
+	bool full_field_map;
 	/**
 	 * SQL statement that produced this space.
 	 */
@@ -54,6 +54,7 @@
 #include "fiber.h"
 #include "small/region.h"
 #include "session.h"
+#include "sql_stmt_cache.h"
 
 static sqlite3 *db;
 
@@ -90,11 +91,13 @@ sql_init()
 	}
 
 	assert(db != NULL);
+	sql_stmt_cache_init();
 }
 
 void
 sql_free()
 {
+	sql_stmt_cache_free();
 	sqlite3_close(db); db = NULL;
 }
 
@@ -0,0 +1,359 @@
+/*
+ * Copyright 2010-2017, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "sql_stmt_cache.h"
+
+#include "assoc.h"
+#include "diag.h"
+#include "errcode.h"
+#include "info.h"
+#include "say.h"
+#include "schema.h"
+#include "sql.h"
+#include "sql/sqlite3.h"
+#include "trivia/util.h"
+
+/** Statement cache of the instance. */
+static struct sql_stmt_cache {
+	/** SQL text -> struct sql_stmt. */
+	struct mh_strnptr_t *by_text;
+	/** Statement id -> struct sql_stmt. */
+	struct mh_i32ptr_t *by_id;
+	/** Cached statements, most recently used first. */
+	struct rlist lru;
+	/** Memory occupied by cached statements. */
+	size_t mem_used;
+	/** Memory limit, box.cfg.sql_cache_size. */
+	size_t mem_quota;
+	/** Id of the next compiled statement. */
+	uint32_t next_id;
+	/** Number of cached statements. */
+	uint32_t stmt_count;
+	/** Number of lookups that found a ready statement. */
+	int64_t hit;
+	/** Number of lookups that had to compile a statement. */
+	int64_t miss;
+	/** Number of statements evicted due to memory limit. */
+	int64_t evict;
+} cache;
+
+void
+sql_stmt_cache_init(void)
+{
+	cache.by_text = mh_strnptr_new();
+	cache.by_id = mh_i32ptr_new();
+	if (cache.by_text == NULL || cache.by_id == NULL)
+		panic("failed to allocate SQL statement cache");
+	rlist_create(&cache.lru);
+	cache.mem_used = 0;
+	cache.next_id = 1;
+	cache.stmt_count = 0;
+	cache.hit = cache.miss = cache.evict = 0;
+}
+
+/**
+ * Compile a statement without putting it in the cache.
+ * Memory occupied by the compiled statement is estimated by
+ * the change of SQLite memory usage, since compilation never
+ * yields.
+ */
+static struct sql_stmt *
+sql_stmt_new(const char *sql, uint32_t len)
+{
+	sqlite3 *db = sql_get();
+	assert(db != NULL);
+	size_t size = sizeof(struct sql_stmt) + len + 1;
+	struct sql_stmt *stmt = (struct sql_stmt *) malloc(size);
+	if (stmt == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "struct sql_stmt");
+		return NULL;
+	}
+	int64_t mem_used = sqlite3_memory_used();
+	if (sqlite3_prepare_v2(db, sql, len, &stmt->vdbe, NULL) != SQLITE_OK) {
+		diag_set(ClientError, ER_SQL_EXECUTE, sqlite3_errmsg(db));
+		free(stmt);
+		return NULL;
+	}
+	assert(stmt->vdbe != NULL);
+	mem_used = sqlite3_memory_used() - mem_used;
+	stmt->mem_used = size + MAX(mem_used, 0);
+	stmt->id = 0;
+	stmt->schema_version = schema_version;
+	stmt->refs = 1;
+	stmt->is_cached = false;
+	rlist_create(&stmt->in_lru);
+	stmt->sql_len = len;
+	memcpy(stmt->sql, sql, len);
+	stmt->sql[len] = '\0';
+	return stmt;
+}
+
+static void
+sql_stmt_delete(struct sql_stmt *stmt)
+{
+	assert(stmt->refs == 0);
+	assert(!stmt->is_cached);
+	sqlite3_finalize(stmt->vdbe);
+	free(stmt);
+}
+
+/** Remove a statement from the cache. */
+static void
+sql_stmt_cache_remove(struct sql_stmt *stmt)
+{
+	assert(stmt->is_cached);
+	mh_int_t k = mh_strnptr_find_inp(cache.by_text, stmt->sql,
+					 stmt->sql_len);
+	assert(k != mh_end(cache.by_text));
+	mh_strnptr_del(cache.by_text, k, NULL);
+	k = mh_i32ptr_find(cache.by_id, stmt->id, NULL);
+	assert(k != mh_end(cache.by_id));
+	mh_i32ptr_del(cache.by_id, k, NULL);
+	rlist_del_entry(stmt, in_lru);
+	assert(cache.mem_used >= stmt->mem_used);
+	cache.mem_used -= stmt->mem_used;
+	cache.stmt_count--;
+	stmt->is_cached = false;
+	/* A statement being executed is deleted on release. */
+	if (stmt->refs == 0)
+		sql_stmt_delete(stmt);
+}
+
+/**
+ * Evict the least recently used statements until the cache
+ * fits in the memory limit.
+ */
+static void
+sql_stmt_cache_evict(void)
+{
+	while (cache.mem_used > cache.mem_quota) {
+		assert(!rlist_empty(&cache.lru));
+		struct sql_stmt *victim = rlist_last_entry(&cache.lru,
+							   struct sql_stmt,
+							   in_lru);
+		sql_stmt_cache_remove(victim);
+		cache.evict++;
+	}
+}
+
+/**
+ * Put a compiled statement in the cache and assign it an id.
+ * A statement larger than the memory limit is not cached and
+ * serves the current request only.
+ *
+ * @retval  0 The statement is cached.
+ * @retval -1 The statement is not cached, diag is set.
+ */
+static int
+sql_stmt_cache_put(struct sql_stmt *stmt)
+{
+	assert(!stmt->is_cached && stmt->id == 0);
+	if (stmt->mem_used > cache.mem_quota) {
+		diag_set(ClientError, ER_SQL, cache.mem_quota == 0 ?
+			 "statement cache is disabled" :
+			 "statement is larger than sql_cache_size");
+		return -1;
+	}
+	struct mh_strnptr_node_t text_node = {
+		stmt->sql, stmt->sql_len,
+		mh_strn_hash(stmt->sql, stmt->sql_len), stmt
+	};
+	if (mh_strnptr_put(cache.by_text, &text_node, NULL,
+			   NULL) == mh_end(cache.by_text)) {
+		diag_set(OutOfMemory, sizeof(text_node), "mh_strnptr_put",
+			 "sql statement cache");
+		return -1;
+	}
+	struct mh_i32ptr_node_t id_node = { cache.next_id, stmt };
+	if (mh_i32ptr_put(cache.by_id, &id_node, NULL,
+			  NULL) == mh_end(cache.by_id)) {
+		mh_int_t k = mh_strnptr_find_inp(cache.by_text, stmt->sql,
+						 stmt->sql_len);
+		mh_strnptr_del(cache.by_text, k, NULL);
+		diag_set(OutOfMemory, sizeof(id_node), "mh_i32ptr_put",
+			 "sql statement cache");
+		return -1;
+	}
+	stmt->id = cache.next_id;
+	/* Zero id means "not cached", skip it on overflow. */
+	if (++cache.next_id == 0)
+		cache.next_id = 1;
+	stmt->is_cached = true;
+	rlist_add_entry(&cache.lru, stmt, in_lru);
+	cache.mem_used += stmt->mem_used;
+	cache.stmt_count++;
+	sql_stmt_cache_evict();
+	return 0;
+}
+
+/**
+ * Recompile a cached statement against the current schema.
+ * The statement keeps its id, so clients which prepared it
+ * need not know about the schema change.
+ */
+static int
+sql_stmt_recompile(struct sql_stmt *stmt)
+{
+	assert(stmt->refs == 0 && stmt->is_cached);
+	struct sql_stmt *fresh = sql_stmt_new(stmt->sql, stmt->sql_len);
+	if (fresh == NULL) {
+		sql_stmt_cache_remove(stmt);
+		return -1;
+	}
+	sqlite3_finalize(stmt->vdbe);
+	stmt->vdbe = fresh->vdbe;
+	stmt->schema_version = fresh->schema_version;
+	cache.mem_used -= stmt->mem_used;
+	stmt->mem_used = fresh->mem_used;
+	cache.mem_used += stmt->mem_used;
+	free(fresh);
+	return 0;
+}
+
+/**
+ * Reference a cached statement. If the statement is executed
+ * by another request right now, which is possible since
+ * execution may yield, compile a private copy.
+ */
+static struct sql_stmt *
+sql_stmt_cache_acquire(struct sql_stmt *stmt)
+{
+	if (stmt->refs > 0) {
+		cache.miss++;
+		struct sql_stmt *copy = sql_stmt_new(stmt->sql, stmt->sql_len);
+		/* The copy is executed instead of the cached one. */
+		if (copy != NULL)
+			copy->id = stmt->id;
+		return copy;
+	}
+	if (stmt->schema_version != schema_version) {
+		cache.miss++;
+		if (sql_stmt_recompile(stmt) != 0)
+			return NULL;
+	} else {
+		cache.hit++;
+	}
+	rlist_move_entry(&cache.lru, stmt, in_lru);
+	stmt->refs++;
+	return stmt;
+}
+
+/**
+ * Find a statement by SQL text or compile it and put it in
+ * the cache. Fail if @a must_cache is set and the statement
+ * can't be cached.
+ */
+static struct sql_stmt *
+sql_stmt_cache_lookup(const char *sql, uint32_t len, bool must_cache)
+{
+	mh_int_t k = mh_strnptr_find_inp(cache.by_text, sql, len);
+	if (k != mh_end(cache.by_text)) {
+		return sql_stmt_cache_acquire((struct sql_stmt *)
+				mh_strnptr_node(cache.by_text, k)->val);
+	}
+	cache.miss++;
+	struct sql_stmt *stmt = sql_stmt_new(sql, len);
+	if (stmt == NULL)
+		return NULL;
+	if (sql_stmt_cache_put(stmt) != 0 && must_cache) {
+		sql_stmt_cache_release(stmt);
+		return NULL;
+	}
+	return stmt;
+}
+
+struct sql_stmt *
+sql_stmt_cache_get(const char *sql, uint32_t len)
+{
+	return sql_stmt_cache_lookup(sql, len, false);
+}
+
+struct sql_stmt *
+sql_stmt_cache_prepare(const char *sql, uint32_t len)
+{
+	return sql_stmt_cache_lookup(sql, len, true);
+}
+
+struct sql_stmt *
+sql_stmt_cache_find(uint32_t id)
+{
+	mh_int_t k = mh_i32ptr_find(cache.by_id, id, NULL);
+	if (k == mh_end(cache.by_id)) {
+		diag_set(ClientError, ER_SQL_STMT_NOT_FOUND, id);
+		return NULL;
+	}
+	return sql_stmt_cache_acquire((struct sql_stmt *)
+				      mh_i32ptr_node(cache.by_id, k)->val);
+}
+
+void
+sql_stmt_cache_release(struct sql_stmt *stmt)
+{
+	assert(stmt->refs > 0);
+	sqlite3_reset(stmt->vdbe);
+	sqlite3_clear_bindings(stmt->vdbe);
+	if (--stmt->refs == 0 && !stmt->is_cached)
+		sql_stmt_delete(stmt);
+}
+
+void
+sql_stmt_cache_set_size(size_t size)
+{
+	cache.mem_quota = size;
+	if (cache.by_text != NULL)
+		sql_stmt_cache_evict();
+}
+
+void
+sql_stmt_cache_free(void)
+{
+	while (!rlist_empty(&cache.lru)) {
+		struct sql_stmt *stmt = rlist_first_entry(&cache.lru,
+							  struct sql_stmt,
+							  in_lru);
+		sql_stmt_cache_remove(stmt);
+	}
+	mh_strnptr_delete(cache.by_text);
+	mh_i32ptr_delete(cache.by_id);
+	cache.by_text = NULL;
+	cache.by_id = NULL;
+}
+
+void
+sql_stmt_cache_info(struct info_handler *h)
+{
+	info_table_begin(h, "cache");
+	info_append_int(h, "size", cache.mem_used);
+	info_append_int(h, "stmt_count", cache.stmt_count);
+	info_append_int(h, "hit", cache.hit);
+	info_append_int(h, "miss", cache.miss);
+	info_append_int(h, "evict", cache.evict);
+	info_table_end(h);
+}
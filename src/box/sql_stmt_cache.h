@@ -0,0 +1,150 @@
+#ifndef TARANTOOL_SQL_STMT_CACHE_H_INCLUDED
+#define TARANTOOL_SQL_STMT_CACHE_H_INCLUDED
+/*
+ * Copyright 2010-2017, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "small/rlist.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct sqlite3_stmt;
+struct info_handler;
+
+/**
+ * Compiled SQL statement stored in the statement cache.
+ *
+ * Statements are looked up either by SQL text (EXECUTE with
+ * IPROTO_SQL_TEXT) or by id returned to the client in response
+ * to PREPARE (EXECUTE with IPROTO_STMT_ID). A statement is
+ * referenced while it is being executed: execution may yield,
+ * and a referenced statement is neither reused by another
+ * request nor finalized on eviction.
+ */
+struct sql_stmt {
+	/** Compiled statement. */
+	struct sqlite3_stmt *vdbe;
+	/** Statement id, unique within the instance, 0 if not cached. */
+	uint32_t id;
+	/** Schema version the statement was compiled against. */
+	uint32_t schema_version;
+	/** Memory occupied by the statement, approximately. */
+	size_t mem_used;
+	/** Number of requests executing the statement. */
+	int refs;
+	/**
+	 * True if the statement is in the cache, false if it
+	 * was evicted or compiled for a single request only.
+	 * Such statement is finalized on the last release.
+	 */
+	bool is_cached;
+	/** Link in the LRU list of cached statements. */
+	struct rlist in_lru;
+	/** Length of the SQL text. */
+	uint32_t sql_len;
+	/** SQL text of the statement. */
+	char sql[0];
+};
+
+/** Initialize the statement cache. */
+void
+sql_stmt_cache_init(void);
+
+/** Finalize all cached statements. */
+void
+sql_stmt_cache_free(void);
+
+/**
+ * Set the memory limit of the statement cache. Statements
+ * exceeding the limit are evicted in the LRU order. Zero
+ * disables caching.
+ */
+void
+sql_stmt_cache_set_size(size_t size);
+
+/**
+ * Find a statement by SQL text. If there is no statement in
+ * the cache or the cached statement was compiled against an
+ * old schema, compile it and store in the cache.
+ * @param sql SQL text.
+ * @param len Length of @a sql.
+ *
+ * @retval not NULL Referenced statement.
+ * @retval NULL Compilation or memory error.
+ */
+struct sql_stmt *
+sql_stmt_cache_get(const char *sql, uint32_t len);
+
+/**
+ * Same as sql_stmt_cache_get(), but fail if the statement
+ * can't be cached, e.g. because the cache is disabled or the
+ * statement exceeds its size. Used by PREPARE, which returns
+ * the statement id to the client.
+ *
+ * @retval not NULL Referenced cached statement.
+ * @retval NULL Compilation or memory error, or the statement
+ *         can't be cached.
+ */
+struct sql_stmt *
+sql_stmt_cache_prepare(const char *sql, uint32_t len);
+
+/**
+ * Find a statement by id returned by PREPARE. Recompile it if
+ * the schema has changed since it was compiled.
+ * @param id Statement id.
+ *
+ * @retval not NULL Referenced statement.
+ * @retval NULL The statement was evicted or failed to compile.
+ */
+struct sql_stmt *
+sql_stmt_cache_find(uint32_t id);
+
+/**
+ * Release a statement after execution: reset the virtual
+ * machine and unbind parameters, which may point to the
+ * request memory.
+ */
+void
+sql_stmt_cache_release(struct sql_stmt *stmt);
+
+/** Append the statement cache statistics to box.info.sql(). */
+void
+sql_stmt_cache_info(struct info_handler *h);
+
+#if defined(__cplusplus)
+} /* extern "C" { */
+#endif
+
+#endif /* TARANTOOL_SQL_STMT_CACHE_H_INCLUDED */
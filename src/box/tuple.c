@@ -389,7 +389,7 @@ tuple_init(field_name_hash_f hash)
 	 */
 	RLIST_HEAD(empty_list);
 	tuple_format_runtime = tuple_format_new(&tuple_format_runtime_vtab,
-						NULL, 0, 0, NULL, 0);
+						NULL, 0, 0, NULL, 0, false);
 	if (tuple_format_runtime == NULL)
 		return -1;
 
@@ -471,7 +471,7 @@ box_tuple_format_new(struct key_def **keys, uint16_t key_count)
 {
 	box_tuple_format_t *format =
 		tuple_format_new(&tuple_format_runtime_vtab,
-				 keys, key_count, 0, NULL, 0);
+				 keys, key_count, 0, NULL, 0, false);
 	if (format != NULL)
 		tuple_format_ref(format);
 	return format;
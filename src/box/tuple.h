@@ -311,7 +311,8 @@ box_tuple_extract_key(const box_tuple_t *tuple, uint32_t space_id,
  *   +----------------------+-----------------------+
  *    @sa tuple_format_new()   uint32  ...  uint32
  *
- * Each 'off_i' is the offset to the i-th indexed field.
+ * Each 'off_i' is the offset to the i-th indexed field, or to
+ * the i-th field of the format if the space has full_field_map.
  */
 struct PACKED tuple
 {
@@ -903,9 +903,358 @@ static const comparator_signature cmp_arr[] = {
 
 #undef COMPARATOR
 
+/* {{{ Typed comparators */
+
+/*
+ * Comparators specialized by types of key parts, but not by
+ * their field numbers, so that any key of a common composite
+ * schema is compared without a switch on each part type.
+ * Parts of a sequential key are decoded one after another,
+ * fields of other keys are looked up in the field map.
+ */
+
+/**
+ * Pseudo field type of a string key part with a collation,
+ * only used to look up a typed comparator.
+ */
+enum { FIELD_TYPE_STRING_COLL = field_type_MAX };
+
+static inline uint32_t
+key_part_compare_type(const struct key_part *part)
+{
+	if (part->type == FIELD_TYPE_STRING && part->coll != NULL)
+		return FIELD_TYPE_STRING_COLL;
+	return part->type;
+}
+
+template <int TYPE>
+static inline int
+field_compare_typed(const char *field_a, const char *field_b,
+		    const struct key_part *part);
+
+template <>
+inline int
+field_compare_typed<FIELD_TYPE_UNSIGNED>(const char *field_a,
+					 const char *field_b,
+					 const struct key_part *)
+{
+	return mp_compare_uint(field_a, field_b);
+}
+
+template <>
+inline int
+field_compare_typed<FIELD_TYPE_STRING>(const char *field_a,
+				       const char *field_b,
+				       const struct key_part *)
+{
+	return mp_compare_str(field_a, field_b);
+}
+
+template <>
+inline int
+field_compare_typed<FIELD_TYPE_STRING_COLL>(const char *field_a,
+					    const char *field_b,
+					    const struct key_part *part)
+{
+	return mp_compare_str_coll(field_a, field_b, part->coll);
+}
+
+template <>
+inline int
+field_compare_typed<FIELD_TYPE_INTEGER>(const char *field_a,
+					const char *field_b,
+					const struct key_part *)
+{
+	return mp_compare_integer_with_hint(field_a, mp_typeof(*field_a),
+					    field_b, mp_typeof(*field_b));
+}
+
+template <>
+inline int
+field_compare_typed<FIELD_TYPE_NUMBER>(const char *field_a,
+				       const char *field_b,
+				       const struct key_part *)
+{
+	return mp_compare_number(field_a, field_b);
+}
+
+/**
+ * NULL is less than any other value. Two NULLs are equal,
+ * @a was_null_met is set then.
+ */
+template <bool IS_NULLABLE, int TYPE>
+static inline int
+field_compare_typed_nullable(const char *field_a, const char *field_b,
+			     const struct key_part *part, bool *was_null_met)
+{
+	if (IS_NULLABLE) {
+		bool a_is_null = mp_typeof(*field_a) == MP_NIL;
+		bool b_is_null = mp_typeof(*field_b) == MP_NIL;
+		if (a_is_null && b_is_null) {
+			*was_null_met = true;
+			return 0;
+		}
+		if (a_is_null || b_is_null)
+			return a_is_null ? -1 : 1;
+	}
+	return field_compare_typed<TYPE>(field_a, field_b, part);
+}
+
+/** Move to the field of the next key part. */
+template <bool IS_SEQUENTIAL>
+static inline const char *
+tuple_field_typed_next(const struct tuple *tuple,
+		       const struct tuple_format *format,
+		       const char *field, const struct key_part *next_part)
+{
+	if (IS_SEQUENTIAL) {
+		mp_next(&field);
+		return field;
+	}
+	return tuple_field_raw(format, tuple_data(tuple),
+			       tuple_field_map(tuple), next_part->fieldno);
+}
+
+template <bool IS_SEQUENTIAL>
+static inline const char *
+tuple_field_typed_first(const struct tuple *tuple,
+			const struct tuple_format *format,
+			const struct key_part *part)
+{
+	if (IS_SEQUENTIAL) {
+		const char *field = tuple_data(tuple);
+		mp_decode_array(&field);
+		return field;
+	}
+	return tuple_field_raw(format, tuple_data(tuple),
+			       tuple_field_map(tuple), part->fieldno);
+}
+
+namespace /* local symbols */ {
+
+template <bool IS_NULLABLE, bool IS_SEQUENTIAL, int TYPE, int ...MORE_TYPES>
+struct TypedFieldCompare {};
+
+template <bool IS_NULLABLE, bool IS_SEQUENTIAL, int TYPE, int TYPE2,
+	  int ...MORE_TYPES>
+struct TypedFieldCompare<IS_NULLABLE, IS_SEQUENTIAL, TYPE, TYPE2,
+			 MORE_TYPES...>
+{
+	inline static int
+	compare(const struct tuple *tuple_a, const struct tuple *tuple_b,
+		const struct tuple_format *format_a,
+		const struct tuple_format *format_b,
+		const char *field_a, const char *field_b,
+		const struct key_part *part,
+		const struct key_part *unique_end, bool *was_null_met)
+	{
+		/* @sa tuple_compare_slowpath(). */
+		if (IS_NULLABLE && part == unique_end && !*was_null_met)
+			return 0;
+		int rc = field_compare_typed_nullable<IS_NULLABLE, TYPE>(
+				field_a, field_b, part, was_null_met);
+		if (rc != 0)
+			return rc;
+		field_a = tuple_field_typed_next<IS_SEQUENTIAL>(tuple_a,
+					format_a, field_a, part + 1);
+		field_b = tuple_field_typed_next<IS_SEQUENTIAL>(tuple_b,
+					format_b, field_b, part + 1);
+		return TypedFieldCompare<IS_NULLABLE, IS_SEQUENTIAL, TYPE2,
+					 MORE_TYPES...>::
+			compare(tuple_a, tuple_b, format_a, format_b,
+				field_a, field_b, part + 1, unique_end,
+				was_null_met);
+	}
+};
+
+template <bool IS_NULLABLE, bool IS_SEQUENTIAL, int TYPE>
+struct TypedFieldCompare<IS_NULLABLE, IS_SEQUENTIAL, TYPE>
+{
+	inline static int
+	compare(const struct tuple *, const struct tuple *,
+		const struct tuple_format *, const struct tuple_format *,
+		const char *field_a, const char *field_b,
+		const struct key_part *part,
+		const struct key_part *unique_end, bool *was_null_met)
+	{
+		if (IS_NULLABLE && part == unique_end && !*was_null_met)
+			return 0;
+		return field_compare_typed_nullable<IS_NULLABLE, TYPE>(
+				field_a, field_b, part, was_null_met);
+	}
+};
+
+template <bool IS_NULLABLE, bool IS_SEQUENTIAL, int TYPE, int ...MORE_TYPES>
+struct TypedFieldCompareWithKey {};
+
+template <bool IS_NULLABLE, bool IS_SEQUENTIAL, int TYPE, int TYPE2,
+	  int ...MORE_TYPES>
+struct TypedFieldCompareWithKey<IS_NULLABLE, IS_SEQUENTIAL, TYPE, TYPE2,
+				MORE_TYPES...>
+{
+	inline static int
+	compare(const struct tuple *tuple, const struct tuple_format *format,
+		const char *field, const char *key, uint32_t part_count,
+		const struct key_part *part)
+	{
+		bool was_null_met;
+		int rc = field_compare_typed_nullable<IS_NULLABLE, TYPE>(
+				field, key, part, &was_null_met);
+		if (rc != 0 || part_count == 1)
+			return rc;
+		field = tuple_field_typed_next<IS_SEQUENTIAL>(tuple, format,
+							      field, part + 1);
+		mp_next(&key);
+		return TypedFieldCompareWithKey<IS_NULLABLE, IS_SEQUENTIAL,
+						TYPE2, MORE_TYPES...>::
+			compare(tuple, format, field, key, part_count - 1,
+				part + 1);
+	}
+};
+
+template <bool IS_NULLABLE, bool IS_SEQUENTIAL, int TYPE>
+struct TypedFieldCompareWithKey<IS_NULLABLE, IS_SEQUENTIAL, TYPE>
+{
+	inline static int
+	compare(const struct tuple *, const struct tuple_format *,
+		const char *field, const char *key, uint32_t,
+		const struct key_part *part)
+	{
+		bool was_null_met;
+		return field_compare_typed_nullable<IS_NULLABLE, TYPE>(
+				field, key, part, &was_null_met);
+	}
+};
+
+} /* end of anonymous namespace */
+
+template <bool IS_NULLABLE, bool IS_SEQUENTIAL, int ...TYPES>
+static int
+tuple_compare_typed(const struct tuple *tuple_a, const struct tuple *tuple_b,
+		    const struct key_def *key_def)
+{
+	assert(key_def->part_count == sizeof...(TYPES));
+	assert(IS_NULLABLE == key_def->is_nullable);
+	assert(IS_SEQUENTIAL == key_def_is_sequential(key_def));
+	const struct key_part *part = key_def->parts;
+	const struct tuple_format *format_a = tuple_format(tuple_a);
+	const struct tuple_format *format_b = tuple_format(tuple_b);
+	const char *field_a, *field_b;
+	field_a = tuple_field_typed_first<IS_SEQUENTIAL>(tuple_a, format_a,
+							 part);
+	field_b = tuple_field_typed_first<IS_SEQUENTIAL>(tuple_b, format_b,
+							 part);
+	bool was_null_met = false;
+	return TypedFieldCompare<IS_NULLABLE, IS_SEQUENTIAL, TYPES...>::
+		compare(tuple_a, tuple_b, format_a, format_b, field_a, field_b,
+			part, part + key_def->unique_part_count,
+			&was_null_met);
+}
+
+template <bool IS_NULLABLE, bool IS_SEQUENTIAL, int ...TYPES>
+static int
+tuple_compare_with_key_typed(const struct tuple *tuple, const char *key,
+			     uint32_t part_count,
+			     const struct key_def *key_def)
+{
+	assert(part_count <= key_def->part_count);
+	assert(key_def->part_count == sizeof...(TYPES));
+	/* Part count can be 0 in wildcard searches. */
+	if (part_count == 0)
+		return 0;
+	const struct key_part *part = key_def->parts;
+	const struct tuple_format *format = tuple_format(tuple);
+	const char *field = tuple_field_typed_first<IS_SEQUENTIAL>(tuple,
+							format, part);
+	return TypedFieldCompareWithKey<IS_NULLABLE, IS_SEQUENTIAL, TYPES...>::
+		compare(tuple, format, field, key, part_count, part);
+}
+
+struct typed_comparator_signature {
+	/** Comparators indexed by [is_nullable][is_sequential]. */
+	tuple_compare_t compare[2][2];
+	tuple_compare_with_key_t compare_with_key[2][2];
+	/** Part types, UINT32_MAX terminated. */
+	uint32_t types[4];
+};
+
+#define TYPED_COMPARATOR(...) {						\
+	{{ tuple_compare_typed<false, false, __VA_ARGS__>,		\
+	   tuple_compare_typed<false, true, __VA_ARGS__> },		\
+	 { tuple_compare_typed<true, false, __VA_ARGS__>,		\
+	   tuple_compare_typed<true, true, __VA_ARGS__> }},		\
+	{{ tuple_compare_with_key_typed<false, false, __VA_ARGS__>,	\
+	   tuple_compare_with_key_typed<false, true, __VA_ARGS__> },	\
+	 { tuple_compare_with_key_typed<true, false, __VA_ARGS__>,	\
+	   tuple_compare_with_key_typed<true, true, __VA_ARGS__> }},	\
+	{ __VA_ARGS__, UINT32_MAX } },
+
+#define U FIELD_TYPE_UNSIGNED
+#define S FIELD_TYPE_STRING
+#define I FIELD_TYPE_INTEGER
+#define N FIELD_TYPE_NUMBER
+#define C FIELD_TYPE_STRING_COLL
+
+/**
+ * Typical schemas: a single part, a compound primary key,
+ * a non-unique secondary key merged with the primary key.
+ */
+static const struct typed_comparator_signature typed_cmp_arr[] = {
+	TYPED_COMPARATOR(U)
+	TYPED_COMPARATOR(S)
+	TYPED_COMPARATOR(I)
+	TYPED_COMPARATOR(N)
+	TYPED_COMPARATOR(C)
+	TYPED_COMPARATOR(U, U)
+	TYPED_COMPARATOR(S, U)
+	TYPED_COMPARATOR(U, S)
+	TYPED_COMPARATOR(S, S)
+	TYPED_COMPARATOR(I, U)
+	TYPED_COMPARATOR(U, I)
+	TYPED_COMPARATOR(I, I)
+	TYPED_COMPARATOR(N, U)
+	TYPED_COMPARATOR(C, U)
+	TYPED_COMPARATOR(U, U, U)
+	TYPED_COMPARATOR(S, U, U)
+	TYPED_COMPARATOR(U, S, U)
+	TYPED_COMPARATOR(S, S, U)
+	TYPED_COMPARATOR(I, U, U)
+	TYPED_COMPARATOR(C, U, U)
+};
+
+#undef U
+#undef S
+#undef I
+#undef N
+#undef C
+#undef TYPED_COMPARATOR
+
+static const struct typed_comparator_signature *
+typed_comparator_find(const struct key_def *def)
+{
+	for (uint32_t k = 0;
+	     k < sizeof(typed_cmp_arr) / sizeof(typed_cmp_arr[0]); k++) {
+		const uint32_t *types = typed_cmp_arr[k].types;
+		uint32_t i = 0;
+		for (; i < def->part_count; i++) {
+			if (key_part_compare_type(&def->parts[i]) != types[i])
+				break;
+		}
+		if (i == def->part_count && types[i] == UINT32_MAX)
+			return &typed_cmp_arr[k];
+	}
+	return NULL;
+}
+
+/* }}} Typed comparators */
+
 tuple_compare_t
 tuple_compare_create(const struct key_def *def) {
+	const struct typed_comparator_signature *typed =
+		typed_comparator_find(def);
 	if (def->is_nullable) {
+		if (typed != NULL)
+			return typed->compare[1][key_def_is_sequential(def)];
 		if (key_def_is_sequential(def))
 			return tuple_compare_sequential_nullable;
 		return tuple_compare_slowpath<true>;
@@ -926,6 +1275,8 @@ tuple_compare_create(const struct key_def *def) {
 				return cmp_arr[k].f;
 		}
 	}
+	if (typed != NULL)
+		return typed->compare[0][key_def_is_sequential(def)];
 	if (key_def_is_sequential(def))
 		return tuple_compare_sequential;
 	return tuple_compare_slowpath<false>;
@@ -1113,7 +1464,13 @@ static const comparator_with_key_signature cmp_wk_arr[] = {
 tuple_compare_with_key_t
 tuple_compare_with_key_create(const struct key_def *def)
 {
+	const struct typed_comparator_signature *typed =
+		typed_comparator_find(def);
 	if (def->is_nullable) {
+		if (typed != NULL) {
+			return typed->compare_with_key[1]
+					[key_def_is_sequential(def)];
+		}
 		if (key_def_is_sequential(def))
 			return tuple_compare_with_key_sequential<true>;
 		return tuple_compare_with_key_slowpath<true>;
@@ -1137,6 +1494,8 @@ tuple_compare_with_key_create(const struct key_def *def)
 				return cmp_wk_arr[k].f;
 		}
 	}
+	if (typed != NULL)
+		return typed->compare_with_key[0][key_def_is_sequential(def)];
 	if (key_def_is_sequential(def))
 		return tuple_compare_with_key_sequential<false>;
 	return tuple_compare_with_key_slowpath<false>;
@@ -1144,6 +1503,80 @@ tuple_compare_with_key_create(const struct key_def *def)
 
 /* }}} tuple_compare_with_key */
 
+/* {{{ tuple_hint */
+
+/**
+ * Calculate an order-preserving 64-bit hint of a non-NULL key
+ * field: if field_a < field_b then hint(field_a) <= hint(field_b).
+ * Types which can't be mapped to an integer get a constant hint.
+ */
+static uint64_t
+field_hint(const char *field, const struct key_part *part)
+{
+	switch (part->type) {
+	case FIELD_TYPE_UNSIGNED:
+		return mp_decode_uint(&field);
+	case FIELD_TYPE_INTEGER:
+		if (mp_typeof(*field) == MP_UINT) {
+			uint64_t val = mp_decode_uint(&field);
+			if (val > INT64_MAX)
+				return UINT64_MAX;
+			return val + (uint64_t)INT64_MAX + 1;
+		}
+		assert(mp_typeof(*field) == MP_INT);
+		return (uint64_t)mp_decode_int(&field) +
+		       (uint64_t)INT64_MAX + 1;
+	case FIELD_TYPE_STRING: {
+		uint32_t len;
+		const char *str = mp_decode_str(&field, &len);
+		if (part->coll != NULL)
+			return part->coll->hint(str, len, part->coll);
+		uint64_t hint = 0;
+		for (uint32_t i = 0; i < sizeof(hint); i++) {
+			hint <<= 8;
+			if (i < len)
+				hint |= (unsigned char)str[i];
+		}
+		return hint;
+	}
+	default:
+		return 0;
+	}
+}
+
+/**
+ * Hint of a possibly nullable key field. NULL is less than any
+ * other value and gets the minimal hint.
+ */
+static inline uint64_t
+key_part_hint(const char *field, const struct key_part *part)
+{
+	if (!part->is_nullable)
+		return field_hint(field, part);
+	if (field == NULL || mp_typeof(*field) == MP_NIL)
+		return 0;
+	uint64_t hint = field_hint(field, part);
+	return hint == UINT64_MAX ? hint : hint + 1;
+}
+
+uint64_t
+tuple_hint(const struct tuple *tuple, const struct key_def *key_def)
+{
+	const struct key_part *part = &key_def->parts[0];
+	const char *field = tuple_field(tuple, part->fieldno);
+	return key_part_hint(field, part);
+}
+
+uint64_t
+key_hint(const char *key, uint32_t part_count, const struct key_def *key_def)
+{
+	if (part_count == 0)
+		return 0;
+	return key_part_hint(key, &key_def->parts[0]);
+}
+
+/* }}} tuple_hint */
+
 int
 box_tuple_compare(const box_tuple_t *tuple_a, const box_tuple_t *tuple_b,
 		  const box_key_def_t *key_def)
@@ -106,6 +106,30 @@ tuple_compare_with_key(const struct tuple *tuple, const char *key,
 	return key_def->tuple_compare_with_key(tuple, key, part_count, key_def);
 }
 
+/**
+ * Calculate a 64-bit hint of the first key part of a tuple.
+ * Hints preserve the order defined by the key definition:
+ * if tuple_a < tuple_b then hint(tuple_a) <= hint(tuple_b),
+ * so tuples with different hints needn't be compared at all.
+ * @param tuple tuple
+ * @param key_def key definition
+ * @returns the hint
+ */
+uint64_t
+tuple_hint(const struct tuple *tuple, const struct key_def *key_def);
+
+/**
+ * Calculate a hint of a key, compatible with tuple_hint().
+ * An empty key gets the minimal hint; the caller must not
+ * compare hints of a key with @a part_count == 0.
+ * @param key key parts without MessagePack array header
+ * @param part_count the number of parts in @a key
+ * @param key_def key definition
+ * @returns the hint
+ */
+uint64_t
+key_hint(const char *key, uint32_t part_count, const struct key_def *key_def);
+
 /** \cond public */
 
 /**
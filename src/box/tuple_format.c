@@ -56,11 +56,15 @@ struct mh_strnu32_node_t {
 #define MH_SOURCE 1
 #include "salad/mhash.h" /* Create mh_strnu32_t hash. */
 
-/** Global table of tuple formats */
-struct tuple_format **tuple_formats;
+/**
+ * Global table of tuple formats. It is never reallocated, since
+ * threads other than tx may look formats up while tx registers
+ * new ones, e.g. when an index is built in background.
+ */
+struct tuple_format *tuple_formats[FORMAT_ID_NIL + 1];
 static intptr_t recycled_format_ids = FORMAT_ID_NIL;
 
-static uint32_t formats_size = 0, formats_capacity = 0;
+static uint32_t formats_size = 0;
 
 static const struct tuple_field tuple_field_default = {
 	FIELD_TYPE_ANY, TUPLE_OFFSET_SLOT_NIL, false, NULL, false,
@@ -110,7 +114,7 @@ tuple_format_add_name(struct tuple_format *format, const char *name,
 static int
 tuple_format_create(struct tuple_format *format, struct key_def * const *keys,
 		    uint16_t key_count, const struct field_def *fields,
-		    uint32_t field_count)
+		    uint32_t field_count, bool full_field_map)
 {
 	if (format->field_count == 0) {
 		format->field_map_size = 0;
@@ -188,6 +192,17 @@ tuple_format_create(struct tuple_format *format, struct key_def * const *keys,
 			}
 		}
 	}
+	/*
+	 * Make any field of the format accessible in O(1), at
+	 * the cost of a bigger field map in each tuple.
+	 */
+	if (full_field_map) {
+		for (uint32_t i = 1; i < format->field_count; i++) {
+			struct tuple_field *field = &format->fields[i];
+			if (field->offset_slot == TUPLE_OFFSET_SLOT_NIL)
+				field->offset_slot = --current_slot;
+		}
+	}
 
 	assert(format->fields[0].offset_slot == TUPLE_OFFSET_SLOT_NIL);
 	size_t field_map_size = -current_slot * sizeof(uint32_t);
@@ -209,26 +224,9 @@ tuple_format_register(struct tuple_format *format)
 		format->id = (uint16_t) recycled_format_ids;
 		recycled_format_ids = (intptr_t) tuple_formats[recycled_format_ids];
 	} else {
-		if (formats_size == formats_capacity) {
-			uint32_t new_capacity = formats_capacity ?
-						formats_capacity * 2 : 16;
-			struct tuple_format **formats;
-			formats = (struct tuple_format **)
-				realloc(tuple_formats, new_capacity *
-						       sizeof(tuple_formats[0]));
-			if (formats == NULL) {
-				diag_set(OutOfMemory,
-					 sizeof(struct tuple_format), "malloc",
-					 "tuple_formats");
-				return -1;
-			}
-
-			formats_capacity = new_capacity;
-			tuple_formats = formats;
-		}
 		if (formats_size == FORMAT_ID_MAX + 1) {
 			diag_set(ClientError, ER_TUPLE_FORMAT_LIMIT,
-				 (unsigned) formats_capacity);
+				 (unsigned) lengthof(tuple_formats));
 			return -1;
 		}
 		format->id = formats_size++;
@@ -330,7 +328,8 @@ tuple_format_delete(struct tuple_format *format)
 struct tuple_format *
 tuple_format_new(struct tuple_format_vtab *vtab, struct key_def * const *keys,
 		 uint16_t key_count, uint16_t extra_size,
-		 const struct field_def *space_fields, uint32_t space_field_count)
+		 const struct field_def *space_fields, uint32_t space_field_count,
+		 bool full_field_map)
 {
 	struct tuple_format *format =
 		tuple_format_alloc(keys, key_count, space_fields,
@@ -345,7 +344,7 @@ tuple_format_new(struct tuple_format_vtab *vtab, struct key_def * const *keys,
 		return NULL;
 	}
 	if (tuple_format_create(format, keys, key_count, space_fields,
-				space_field_count) < 0) {
+				space_field_count, full_field_map) < 0) {
 		tuple_format_delete(format);
 		return NULL;
 	}
@@ -496,7 +495,6 @@ tuple_format_free()
 			free(*format);
 		}
 	}
-	free(tuple_formats);
 }
 
 void
@@ -145,7 +145,7 @@ struct tuple_format {
 	struct tuple_field fields[0];
 };
 
-extern struct tuple_format **tuple_formats;
+extern struct tuple_format *tuple_formats[];
 
 static inline uint32_t
 tuple_format_id(const struct tuple_format *format)
@@ -187,6 +187,8 @@ tuple_format_unref(struct tuple_format *format)
  * @param extra_size Extra bytes to reserve in tuples metadata.
  * @param space_fields Array of fields, defined in a space format.
  * @param space_field_count Length of @a space_fields.
+ * @param full_field_map Store offsets of all fields of the
+ *        format in tuples, not only of indexed ones.
  *
  * @retval not NULL Tuple format.
  * @retval     NULL Memory error.
@@ -195,7 +197,7 @@ struct tuple_format *
 tuple_format_new(struct tuple_format_vtab *vtab, struct key_def * const *keys,
 		 uint16_t key_count, uint16_t extra_size,
 		 const struct field_def *space_fields,
-		 uint32_t space_field_count);
+		 uint32_t space_field_count, bool full_field_map);
 
 /**
  * Check that two tuple formats are identical.
@@ -68,6 +68,32 @@ key_hash(const char *key, const struct key_def *key_def)
 	return key_def->key_hash(key, key_def);
 }
 
+/**
+ * Calculate a hash value for the first @a part_count parts
+ * of a tuple key. The result matches key_hash_prefix() of
+ * the same key, but may differ from tuple_hash() even if
+ * @a part_count equals the number of parts in @a key_def.
+ * @param tuple - a tuple
+ * @param key_def - key_def for field description
+ * @param part_count - number of key parts to hash
+ * @return - hash value
+ */
+uint32_t
+tuple_hash_prefix(const struct tuple *tuple, const struct key_def *key_def,
+		  uint32_t part_count);
+
+/**
+ * Calculate a hash value for the first @a part_count parts
+ * of a key, see tuple_hash_prefix().
+ * @param key - key (msgpack fields w/o array marker)
+ * @param key_def - key_def for field description
+ * @param part_count - number of key parts to hash
+ * @return - hash value
+ */
+uint32_t
+key_hash_prefix(const char *key, const struct key_def *key_def,
+		uint32_t part_count);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -1213,6 +1213,142 @@ tuple_update_execute(tuple_update_alloc_func alloc, void *alloc_ctx,
 	return update_finish(&update, p_tuple_len);
 }
 
+/** MsgPack type of an arithmetic operation result. */
+static inline enum mp_type
+mp_typeof_op_arith_arg(struct op_arith_arg arg)
+{
+	if (arg.type == AT_INT) {
+		return int96_is_uint64(&arg.int96) ? MP_UINT : MP_INT;
+	} else if (arg.type == AT_DOUBLE) {
+		return MP_DOUBLE;
+	} else {
+		assert(arg.type == AT_FLOAT);
+		return MP_FLOAT;
+	}
+}
+
+/**
+ * Evaluate a single operation against an old field for an
+ * in-place update.
+ * @retval true The new value has the same MsgPack type and
+ *         size as the old one, it is stored in @a op.
+ * @retval false Otherwise, or the operation failed.
+ */
+static bool
+update_op_fits_in_place(struct tuple_update *update, struct update_op *op,
+			const char *old, uint32_t old_len)
+{
+	enum mp_type old_type = mp_typeof(*old);
+	switch (op->opcode) {
+	case '=':
+		return op->arg.set.length == old_len &&
+		       mp_typeof(*op->arg.set.value) == old_type;
+	case '+':
+	case '-': {
+		struct op_arith_arg left_arg;
+		if (mp_read_arith_arg(update->index_base, op, &old,
+				      &left_arg) != 0)
+			return false;
+		if (make_arith_operation(left_arg, op->arg.arith, op->opcode,
+					 update->index_base + op->field_no,
+					 &op->arg.arith) != 0)
+			return false;
+		return mp_sizeof_op_arith_arg(op->arg.arith) == old_len &&
+		       mp_typeof_op_arith_arg(op->arg.arith) == old_type;
+	}
+	case '&':
+	case '^':
+	case '|': {
+		struct op_bit_arg *arg = &op->arg.bit;
+		uint64_t val;
+		if (mp_read_uint(update->index_base, op, &old, &val) != 0)
+			return false;
+		if (op->opcode == '&')
+			arg->val &= val;
+		else if (op->opcode == '^')
+			arg->val ^= val;
+		else
+			arg->val |= val;
+		return mp_sizeof_uint(arg->val) == old_len;
+	}
+	default:
+		return false;
+	}
+}
+
+bool
+tuple_update_in_place(tuple_update_alloc_func alloc, void *alloc_ctx,
+		      const char *expr, const char *expr_end,
+		      char *data, const char *data_end, int index_base,
+		      uint64_t key_mask, struct tuple_update_undo *undo)
+{
+	struct tuple_update update;
+	update_init(&update, alloc, alloc_ctx, index_base);
+	const char *fields = data;
+	uint32_t field_count = mp_decode_array(&fields);
+
+	if (update_read_ops(&update, expr, expr_end, field_count) != 0)
+		goto fallback;
+	if (update.op_count == 0 || (update.column_mask & key_mask) != 0)
+		goto fallback;
+	char **old = (char **) alloc(alloc_ctx,
+				     update.op_count * sizeof(*old));
+	if (old == NULL)
+		goto fallback;
+	/*
+	 * Evaluate all operations before changing anything, so
+	 * that the data is either fully updated or left intact.
+	 */
+	uint64_t field_mask = 0;
+	char *undo_begin = (char *) data_end;
+	char *undo_end = data;
+	for (uint32_t i = 0; i < update.op_count; i++) {
+		struct update_op *op = &update.ops[i];
+		if (op->field_no < 0)
+			op->field_no += field_count;
+		/*
+		 * Fields past the column mask width are left to
+		 * the generic path, which is also responsible for
+		 * the "double update of the same field" error.
+		 */
+		if (op->field_no < 0 || op->field_no >= (int32_t) field_count ||
+		    op->field_no >= 64 ||
+		    (field_mask & (1ULL << op->field_no)) != 0)
+			goto fallback;
+		field_mask |= 1ULL << op->field_no;
+		const char *field = fields;
+		for (int32_t j = 0; j < op->field_no; j++)
+			mp_next(&field);
+		const char *field_end = field;
+		mp_next(&field_end);
+		if (!update_op_fits_in_place(&update, op, field,
+					     field_end - field))
+			goto fallback;
+		op->new_field_len = field_end - field;
+		old[i] = (char *) field;
+		if (old[i] < undo_begin)
+			undo_begin = old[i];
+		if (field_end > undo_end)
+			undo_end = (char *) field_end;
+	}
+	assert(undo_begin < undo_end && undo_end <= data_end);
+	undo->offset = undo_begin - data;
+	undo->size = undo_end - undo_begin;
+	undo->data = (char *) alloc(alloc_ctx, undo->size);
+	if (undo->data == NULL)
+		goto fallback;
+	memcpy(undo->data, undo_begin, undo->size);
+	for (uint32_t i = 0; i < update.op_count; i++) {
+		struct update_op *op = &update.ops[i];
+		op->meta->store(&op->arg, old[i], old[i]);
+	}
+	return true;
+fallback:
+	/* The generic path reports the error, if any. */
+	diag_clear(diag_get());
+	return false;
+}
+
 const char *
 tuple_upsert_execute(tuple_update_alloc_func alloc, void *alloc_ctx,
 		     const char *expr,const char *expr_end,
@@ -57,6 +57,41 @@ tuple_update_execute(tuple_update_alloc_func alloc, void *alloc_ctx,
 		     uint32_t *p_new_size, int index_base,
 		     uint64_t *column_mask);
 
+/** Tuple data overwritten by tuple_update_in_place(). */
+struct tuple_update_undo {
+	/** Offset of the changed range in the tuple data. */
+	uint32_t offset;
+	/** Size of the changed range. */
+	uint32_t size;
+	/** A copy of the range taken before the update. */
+	char *data;
+};
+
+/**
+ * Try to apply update operations right to the tuple data,
+ * without building a new tuple. This is possible if every
+ * operation is '=', arithmetic or bitwise, each one changes
+ * a different existing field among the first 64 ones, none
+ * of the changed fields is in @a key_mask, and every new value
+ * has the same MsgPack type and size as the old one.
+ *
+ * The data is either fully updated or not changed at all.
+ *
+ * @param key_mask A column mask of fields which must not be
+ *        changed in place, e.g. indexed fields.
+ * @param[out] undo The changed range and its old contents,
+ *        allocated with @a alloc.
+ *
+ * @retval true The update is applied.
+ * @retval false The update has to be done by
+ *         tuple_update_execute(), which reports errors, if any.
+ */
+bool
+tuple_update_in_place(tuple_update_alloc_func alloc, void *alloc_ctx,
+		      const char *expr, const char *expr_end,
+		      char *data, const char *data_end, int index_base,
+		      uint64_t key_mask, struct tuple_update_undo *undo);
+
 const char *
 tuple_upsert_execute(tuple_update_alloc_func alloc, void *alloc_ctx,
 		     const char *expr, const char *expr_end,
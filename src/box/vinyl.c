@@ -30,6 +30,8 @@
  */
 #include "vinyl.h"
 
+#include <unistd.h>
+
 #include "vy_mem.h"
 #include "vy_run.h"
 #include "vy_range.h"
@@ -45,6 +47,7 @@
 
 #include <small/lsregion.h>
 #include <coio_file.h>
+#include <third_party/qsort_arg.h>
 
 #include "coio_task.h"
 #include "cbus.h"
@@ -60,6 +63,7 @@
 #include "column_mask.h"
 #include "trigger.h"
 #include "checkpoint.h"
+#include "wal.h"
 
 #define HEAP_FORWARD_DECLARATION
 #include "salad/heap.h"
@@ -128,6 +132,20 @@ struct vy_env {
 	int read_threads;
 	/** Max number of threads used for writing. */
 	int write_threads;
+	/**
+	 * Compaction write rate limit set by the user, in bytes
+	 * per second, 0 if unlimited. The actual limit can be
+	 * lower, see vy_env_update_compact_rate().
+	 */
+	double compact_rate_limit;
+	/**
+	 * Max average WAL commit latency, in seconds. Compaction
+	 * is slowed down while it is exceeded. 0 disables this.
+	 */
+	double wal_latency_target;
+	/** WAL commit latency totals as of the last rate update. */
+	double wal_latency_sum;
+	int64_t wal_latency_count;
 };
 
 /** Mask passed to vy_gc(). */
@@ -587,6 +605,33 @@ struct vy_task {
 	 */
 	double bloom_fpr;
 	int64_t page_size;
+	/** Throttle limiting the rate the run is written at. */
+	struct vy_run_throttle *throttle;
+	/**
+	 * Parts of a partitioned compaction task, linked by
+	 * vy_task::in_parent. A partitioned task is not executed
+	 * itself: its parts are, each by its own worker thread.
+	 * Empty if the task is not partitioned.
+	 */
+	struct rlist parts;
+	/** Link in the parent's list of parts. */
+	struct rlist in_parent;
+	/** For a part of a compaction task: the task it belongs to. */
+	struct vy_task *parent;
+	/** Number of parts that haven't been processed yet. */
+	int pending_parts;
+	/**
+	 * For a part of a compaction task: the key range the part
+	 * compacts, [begin, end). NULL means unbounded.
+	 */
+	struct tuple *begin, *end;
+	/**
+	 * For a part of a compaction task: slices cut from the
+	 * compacted slices to fit in [begin, end), fed to the
+	 * part's write iterator.
+	 */
+	struct vy_slice **cut_slices;
+	int cut_slice_count;
 };
 
 /**
@@ -610,13 +655,21 @@ vy_task_new(struct mempool *pool, struct vy_index *index,
 	task->index = index;
 	vy_index_ref(index);
 	diag_create(&task->diag);
+	rlist_create(&task->parts);
 	return task;
 }
 
-/** Free a task allocated with vy_task_new(). */
+/** Free a task allocated with vy_task_new() and all its parts. */
 static void
 vy_task_delete(struct mempool *pool, struct vy_task *task)
 {
+	struct vy_task *part, *next_part;
+	rlist_foreach_entry_safe(part, &task->parts, in_parent, next_part)
+		vy_task_delete(pool, part);
+	if (task->begin != NULL)
+		tuple_unref(task->begin);
+	if (task->end != NULL)
+		tuple_unref(task->end);
 	vy_index_unref(task->index);
 	diag_destroy(&task->diag);
 	TRASH(task);
@@ -632,7 +685,7 @@ vy_task_dump_execute(struct vy_task *task)
 			    index->space_id, index->id, task->wi,
 			    task->page_size, index->cmp_def,
 			    index->key_def, task->max_output_count,
-			    task->bloom_fpr);
+			    task->bloom_fpr, task->throttle);
 }
 
 static int
@@ -947,6 +1000,7 @@ vy_task_dump_new(struct vy_scheduler *scheduler, struct vy_index *index,
 	task->max_output_count = max_output_count;
 	task->bloom_fpr = index->opts.bloom_fpr;
 	task->page_size = index->opts.page_size;
+	task->throttle = &scheduler->env->run_env.dump_throttle;
 
 	index->is_dumping = true;
 	vy_scheduler_update_index(scheduler, index);
@@ -981,16 +1035,98 @@ err:
 	return -1;
 }
 
+/**
+ * Compaction of a range can be split into parts by key so that
+ * the parts are written by different worker threads in parallel.
+ * Each part produces a run of its own. Slices of the new runs are
+ * bounded by the part boundaries and are adjacent, so that they
+ * are treated as one run by vy_range_update_compact_priority().
+ *
+ * Only compactions that process at least this many bytes
+ * per part are partitioned.
+ */
+enum { VY_COMPACT_PART_SIZE_MIN = 64 * 1024 * 1024 };
+
+/** Max number of parts a compaction task can be split into. */
+enum { VY_COMPACT_PART_COUNT_MAX = 8 };
+
+/**
+ * First part of a compaction task, in key order.
+ * A task that isn't partitioned is its own only part.
+ */
+static struct vy_task *
+vy_task_first_part(struct vy_task *task)
+{
+	if (rlist_empty(&task->parts))
+		return task;
+	return rlist_first_entry(&task->parts, struct vy_task, in_parent);
+}
+
+/** Part following @part or NULL if @part is the last one. */
+static struct vy_task *
+vy_task_next_part(struct vy_task *task, struct vy_task *part)
+{
+	if (part == task || rlist_next(&part->in_parent) == &task->parts)
+		return NULL;
+	return rlist_next_entry(part, in_parent);
+}
+
+#define vy_task_foreach_part(task, part)				\
+	for (part = vy_task_first_part(task); part != NULL;		\
+	     part = vy_task_next_part(task, part))
+
+/** Return the number of compaction task part @part. */
+static int
+vy_task_part_no(struct vy_task *part)
+{
+	int part_no = 0;
+	struct vy_task *task = part->parent, *p;
+	vy_task_foreach_part(task, p) {
+		if (p == part)
+			break;
+		part_no++;
+	}
+	return part_no;
+}
+
 static int
 vy_task_compact_execute(struct vy_task *task)
 {
 	struct vy_index *index = task->index;
 
+	struct errinj *inj = errinj(ERRINJ_VY_COMPACT_PART_FAIL, ERRINJ_INT);
+	if (inj != NULL && task->parent != NULL &&
+	    inj->iparam == vy_task_part_no(task)) {
+		diag_set(ClientError, ER_INJECTION, "vinyl compaction part");
+		return -1;
+	}
+
 	return vy_run_write(task->new_run, index->env->path,
 			    index->space_id, index->id, task->wi,
 			    task->page_size, index->cmp_def,
 			    index->key_def, task->max_output_count,
-			    task->bloom_fpr);
+			    task->bloom_fpr, task->throttle);
+}
+
+/**
+ * Close the write iterator of a compaction task part and delete
+ * the slices cut for it. Since cut slices reference compacted
+ * runs, this must be done before checking if the runs are still
+ * in use. The function may be called more than once.
+ */
+static void
+vy_task_compact_part_cleanup(struct vy_task *part)
+{
+	/* The iterator has been cleaned up in worker. */
+	if (part->wi != NULL) {
+		part->wi->iface->close(part->wi);
+		part->wi = NULL;
+	}
+	for (int i = 0; i < part->cut_slice_count; i++)
+		vy_slice_delete(part->cut_slices[i]);
+	free(part->cut_slices);
+	part->cut_slices = NULL;
+	part->cut_slice_count = 0;
 }
 
 static int
@@ -998,24 +1134,30 @@ vy_task_compact_complete(struct vy_scheduler *scheduler, struct vy_task *task)
 {
 	struct vy_index *index = task->index;
 	struct vy_range *range = task->range;
-	struct vy_run *new_run = task->new_run;
 	struct vy_slice *first_slice = task->first_slice;
 	struct vy_slice *last_slice = task->last_slice;
-	struct vy_slice *slice, *next_slice, *new_slice = NULL;
+	struct vy_slice *slice, *next_slice;
+	struct vy_task *part;
 	struct vy_run *run;
 
 	/*
-	 * Allocate a slice of the new run.
+	 * Allocate a slice of each new run, bounded by the part
+	 * the run was written for.
 	 *
-	 * If the run is empty, we don't need to allocate a new slice
+	 * If a run is empty, we don't need to allocate a new slice
 	 * and insert it into the range, but we still need to delete
 	 * compacted runs.
 	 */
-	if (!vy_run_is_empty(new_run)) {
-		new_slice = vy_slice_new(vy_log_next_id(), new_run, NULL, NULL,
-					 index->cmp_def);
-		if (new_slice == NULL)
-			return -1;
+	RLIST_HEAD(new_slices);
+	vy_task_foreach_part(task, part) {
+		vy_task_compact_part_cleanup(part);
+		if (vy_run_is_empty(part->new_run))
+			continue;
+		slice = vy_slice_new(vy_log_next_id(), part->new_run,
+				     part->begin, part->end, index->cmp_def);
+		if (slice == NULL)
+			goto fail;
+		rlist_add_tail_entry(&new_slices, slice, in_range);
 	}
 
 	/*
@@ -1049,44 +1191,46 @@ vy_task_compact_complete(struct vy_scheduler *scheduler, struct vy_task *task)
 	int64_t gc_lsn = checkpoint_last(NULL);
 	rlist_foreach_entry(run, &unused_runs, in_unused)
 		vy_log_drop_run(run->id, gc_lsn);
-	if (new_slice != NULL) {
-		vy_log_create_run(index->commit_lsn, new_run->id,
-				  new_run->dump_lsn);
-		vy_log_insert_slice(range->id, new_run->id, new_slice->id,
-				    tuple_data_or_null(new_slice->begin),
-				    tuple_data_or_null(new_slice->end));
-	}
-	if (vy_log_tx_commit() < 0) {
-		if (new_slice != NULL)
-			vy_slice_delete(new_slice);
-		return -1;
+	rlist_foreach_entry(slice, &new_slices, in_range) {
+		vy_log_create_run(index->commit_lsn, slice->run->id,
+				  slice->run->dump_lsn);
+		vy_log_insert_slice(range->id, slice->run->id, slice->id,
+				    tuple_data_or_null(slice->begin),
+				    tuple_data_or_null(slice->end));
 	}
+	if (vy_log_tx_commit() < 0)
+		goto fail;
 
 	/*
-	 * Account the new run if it is not empty,
-	 * otherwise discard it.
+	 * Account the new runs if they are not empty,
+	 * otherwise discard them.
 	 */
-	if (new_slice != NULL) {
-		vy_index_add_run(index, new_run);
-		vy_stmt_counter_add_disk(&index->stat.disk.compact.out,
-					 &new_run->count);
-		/* Drop the reference held by the task. */
-		vy_run_unref(new_run);
-	} else
-		vy_run_discard(new_run);
+	vy_task_foreach_part(task, part) {
+		run = part->new_run;
+		if (!vy_run_is_empty(run)) {
+			vy_index_add_run(index, run);
+			vy_stmt_counter_add_disk(&index->stat.disk.compact.out,
+						 &run->count);
+			/* Drop the reference held by the task. */
+			vy_run_unref(run);
+		} else
+			vy_run_discard(run);
+	}
 
 	/*
-	 * Replace compacted slices with the resulting slice.
+	 * Replace compacted slices with the resulting slices.
 	 *
 	 * Note, since a slice might have been added to the range
 	 * by a concurrent dump while compaction was in progress,
-	 * we must insert the new slice at the same position where
+	 * we must insert the new slices at the same position where
 	 * the compacted slices were.
 	 */
 	RLIST_HEAD(compacted_slices);
 	vy_index_unacct_range(index, range);
-	if (new_slice != NULL)
-		vy_range_add_slice_before(range, new_slice, first_slice);
+	rlist_foreach_entry_safe(slice, &new_slices, in_range, next_slice) {
+		rlist_del_entry(slice, in_range);
+		vy_range_add_slice_before(range, slice, first_slice);
+	}
 	for (slice = first_slice; ; slice = next_slice) {
 		next_slice = rlist_next_entry(slice, in_range);
 		vy_range_remove_slice(range, slice);
@@ -1113,9 +1257,6 @@ vy_task_compact_complete(struct vy_scheduler *scheduler, struct vy_task *task)
 		vy_slice_delete(slice);
 	}
 
-	/* The iterator has been cleaned up in worker. */
-	task->wi->iface->close(task->wi);
-
 	assert(range->heap_node.pos == UINT32_MAX);
 	vy_range_heap_insert(&index->range_heap, &range->heap_node);
 	vy_scheduler_update_index(scheduler, index);
@@ -1123,6 +1264,10 @@ vy_task_compact_complete(struct vy_scheduler *scheduler, struct vy_task *task)
 	say_info("%s: completed compacting range %s",
 		 vy_index_name(index), vy_range_str(range));
 	return 0;
+fail:
+	rlist_foreach_entry_safe(slice, &new_slices, in_range, next_slice)
+		vy_slice_delete(slice);
+	return -1;
 }
 
 static void
@@ -1131,9 +1276,7 @@ vy_task_compact_abort(struct vy_scheduler *scheduler, struct vy_task *task,
 {
 	struct vy_index *index = task->index;
 	struct vy_range *range = task->range;
-
-	/* The iterator has been cleaned up in worker. */
-	task->wi->iface->close(task->wi);
+	struct vy_task *part;
 
 	/*
 	 * It's no use alerting the user if the server is
@@ -1145,17 +1288,201 @@ vy_task_compact_abort(struct vy_scheduler *scheduler, struct vy_task *task,
 			  diag_last_error(&task->diag)->errmsg);
 	}
 
-	/* The metadata log is unavailable on shutdown. */
-	if (!in_shutdown)
-		vy_run_discard(task->new_run);
-	else
-		vy_run_unref(task->new_run);
+	vy_task_foreach_part(task, part) {
+		vy_task_compact_part_cleanup(part);
+		/* The metadata log is unavailable on shutdown. */
+		if (!in_shutdown)
+			vy_run_discard(part->new_run);
+		else
+			vy_run_unref(part->new_run);
+	}
 
 	assert(range->heap_node.pos == UINT32_MAX);
 	vy_range_heap_insert(&index->range_heap, &range->heap_node);
 	vy_scheduler_update_index(scheduler, index);
 }
 
+/**
+ * Prepare a new run and a write iterator for a part of
+ * compaction task @task. If the part is bounded, the compacted
+ * slices are cut to fit in the part boundaries.
+ */
+static int
+vy_task_compact_prepare_part(struct vy_scheduler *scheduler,
+			     struct vy_task *task, struct vy_task *part)
+{
+	struct tx_manager *xm = scheduler->env->xm;
+	struct vy_index *index = task->index;
+	struct vy_range *range = task->range;
+	bool is_bounded = (part->begin != NULL || part->end != NULL);
+
+	part->bloom_fpr = task->bloom_fpr;
+	part->page_size = task->page_size;
+	part->throttle = &scheduler->env->run_env.compact_throttle;
+
+	part->new_run = vy_run_prepare(index);
+	if (part->new_run == NULL)
+		return -1;
+
+	bool is_last_level = (range->compact_priority == range->slice_count);
+	part->wi = vy_write_iterator_new(index->cmp_def, index->disk_format,
+					 index->upsert_format, index->id == 0,
+					 is_last_level, &xm->read_views);
+	if (part->wi == NULL)
+		return -1;
+
+	if (is_bounded) {
+		size_t size = range->compact_priority *
+			      sizeof(*part->cut_slices);
+		part->cut_slices = malloc(size);
+		if (part->cut_slices == NULL) {
+			diag_set(OutOfMemory, size, "malloc",
+				 "struct vy_slice *");
+			return -1;
+		}
+	}
+
+	struct vy_slice *src, *slice;
+	for (src = task->first_slice; ; src = rlist_next_entry(src, in_range)) {
+		part->new_run->dump_lsn = MAX(part->new_run->dump_lsn,
+					      src->run->dump_lsn);
+		slice = src;
+		if (is_bounded) {
+			if (vy_slice_cut(src, vy_log_next_id(), part->begin,
+					 part->end, index->cmp_def,
+					 &slice) != 0)
+				return -1;
+			if (slice != NULL)
+				part->cut_slices[part->cut_slice_count++] = slice;
+		}
+		if (slice != NULL) {
+			if (vy_write_iterator_new_slice(part->wi, slice,
+					&scheduler->env->run_env) != 0)
+				return -1;
+			part->max_output_count += slice->count.rows;
+		}
+		if (src == task->last_slice)
+			break;
+	}
+	assert(part->new_run->dump_lsn >= 0);
+	return 0;
+}
+
+/**
+ * Return the number of parts compaction task @task should be
+ * split into so that the parts can be executed in parallel.
+ */
+static int
+vy_task_compact_part_count(struct vy_scheduler *scheduler,
+			   struct vy_task *task)
+{
+	/*
+	 * Don't take extra worker threads while a dump round is
+	 * in progress, because dump must not wait for compaction.
+	 */
+	if (scheduler->dump_generation < scheduler->generation)
+		return 1;
+
+	uint64_t size = 0;
+	uint32_t page_count = 0;
+	struct vy_slice *slice;
+	for (slice = task->first_slice; ;
+	     slice = rlist_next_entry(slice, in_range)) {
+		size += slice->count.bytes;
+		page_count = MAX(page_count, slice->count.pages);
+		if (slice == task->last_slice)
+			break;
+	}
+
+	uint64_t part_size_min = VY_COMPACT_PART_SIZE_MIN;
+	struct errinj *inj = errinj(ERRINJ_VY_COMPACT_PART_SIZE, ERRINJ_INT);
+	if (inj != NULL && inj->iparam > 0)
+		part_size_min = inj->iparam;
+
+	/* One thread is reserved for dumps, see vy_schedule(). */
+	int count = scheduler->workers_available - 1;
+	count = MIN(count, VY_COMPACT_PART_COUNT_MAX);
+	count = MIN((uint64_t)count, size / part_size_min);
+	count = MIN((uint32_t)count, page_count);
+	return MAX(count, 1);
+}
+
+/**
+ * Split compaction task @task into @part_count parts.
+ *
+ * Part boundaries are taken from the page index of the largest
+ * compacted slice so that the parts are of about the same size.
+ * A boundary that would make a part empty is skipped, so there
+ * may be fewer parts than requested.
+ */
+static int
+vy_task_compact_split(struct vy_scheduler *scheduler, struct vy_task *task,
+		      int part_count)
+{
+	static struct vy_task_ops compact_part_ops = {
+		.execute = vy_task_compact_execute,
+		.complete = NULL,
+		.abort = NULL,
+	};
+
+	struct vy_index *index = task->index;
+	struct vy_range *range = task->range;
+	struct tuple_format *key_format = index->env->key_format;
+
+	struct vy_slice *slice, *largest = task->first_slice;
+	for (slice = task->first_slice; ;
+	     slice = rlist_next_entry(slice, in_range)) {
+		if (slice->count.pages > largest->count.pages)
+			largest = slice;
+		if (slice == task->last_slice)
+			break;
+	}
+	uint32_t page_count = largest->last_page_no -
+			      largest->first_page_no + 1;
+
+	struct tuple *begin = NULL;
+	for (int i = 1; i <= part_count; i++) {
+		struct tuple *end = NULL;
+		if (i < part_count) {
+			uint32_t page_no = largest->first_page_no +
+					   page_count * i / part_count;
+			const char *key = vy_run_page_info(largest->run,
+							   page_no)->min_key;
+			if ((begin != NULL &&
+			     key_compare(key, tuple_data(begin),
+					 index->cmp_def) <= 0) ||
+			    (range->begin != NULL &&
+			     key_compare(key, tuple_data(range->begin),
+					 index->cmp_def) <= 0) ||
+			    (range->end != NULL &&
+			     key_compare(key, tuple_data(range->end),
+					 index->cmp_def) >= 0))
+				continue;
+			end = vy_key_from_msgpack(key_format, key);
+			if (end == NULL)
+				return -1;
+		}
+		struct vy_task *part = vy_task_new(&scheduler->task_pool,
+						   index, &compact_part_ops);
+		if (part == NULL) {
+			if (end != NULL)
+				tuple_unref(end);
+			return -1;
+		}
+		if (begin != NULL)
+			tuple_ref(begin);
+		part->begin = begin;
+		part->end = end;
+		part->parent = task;
+		rlist_add_tail_entry(&task->parts, part, in_parent);
+		task->pending_parts++;
+		if (vy_task_compact_prepare_part(scheduler, task, part) != 0)
+			return -1;
+		begin = end;
+	}
+	return 0;
+}
+
 static int
 vy_task_compact_new(struct vy_scheduler *scheduler, struct vy_index *index,
 		    struct vy_task **p_task)
@@ -1166,9 +1493,9 @@ vy_task_compact_new(struct vy_scheduler *scheduler, struct vy_index *index,
 		.abort = vy_task_compact_abort,
 	};
 
-	struct tx_manager *xm = scheduler->env->xm;
 	struct heap_node *range_node;
 	struct vy_range *range;
+	struct vy_task *part;
 
 	assert(!index->is_dropped);
 
@@ -1188,46 +1515,31 @@ vy_task_compact_new(struct vy_scheduler *scheduler, struct vy_index *index,
 	if (task == NULL)
 		goto err_task;
 
-	struct vy_run *new_run = vy_run_prepare(index);
-	if (new_run == NULL)
-		goto err_run;
-
-	struct vy_stmt_stream *wi;
-	bool is_last_level = (range->compact_priority == range->slice_count);
-	wi = vy_write_iterator_new(index->cmp_def, index->disk_format,
-				   index->upsert_format, index->id == 0,
-				   is_last_level, &xm->read_views);
-	if (wi == NULL)
-		goto err_wi;
-
+	/* Remember the slices we are compacting. */
 	struct vy_slice *slice;
 	int n = range->compact_priority;
 	rlist_foreach_entry(slice, &range->slices, in_range) {
-		if (vy_write_iterator_new_slice(wi, slice,
-						&scheduler->env->run_env) != 0)
-			goto err_wi_sub;
-
-		task->max_output_count += slice->count.rows;
-		new_run->dump_lsn = MAX(new_run->dump_lsn,
-					slice->run->dump_lsn);
-
-		/* Remember the slices we are compacting. */
 		if (task->first_slice == NULL)
 			task->first_slice = slice;
 		task->last_slice = slice;
-
 		if (--n == 0)
 			break;
 	}
 	assert(n == 0);
-	assert(new_run->dump_lsn >= 0);
 
 	task->range = range;
-	task->new_run = new_run;
-	task->wi = wi;
 	task->bloom_fpr = index->opts.bloom_fpr;
 	task->page_size = index->opts.page_size;
 
+	int part_count = vy_task_compact_part_count(scheduler, task);
+	if (part_count > 1) {
+		if (vy_task_compact_split(scheduler, task, part_count) != 0)
+			goto err_part;
+	} else {
+		if (vy_task_compact_prepare_part(scheduler, task, task) != 0)
+			goto err_part;
+	}
+
 	/*
 	 * Remove the range we are going to compact from the heap
 	 * so that it doesn't get selected again.
@@ -1236,17 +1548,19 @@ vy_task_compact_new(struct vy_scheduler *scheduler, struct vy_index *index,
 	range_node->pos = UINT32_MAX;
 	vy_scheduler_update_index(scheduler, index);
 
-	say_info("%s: started compacting range %s, runs %d/%d",
+	say_info("%s: started compacting range %s, runs %d/%d, parts %d",
 		 vy_index_name(index), vy_range_str(range),
-                 range->compact_priority, range->slice_count);
+		 range->compact_priority, range->slice_count,
+		 MAX(task->pending_parts, 1));
 	*p_task = task;
 	return 0;
 
-err_wi_sub:
-	task->wi->iface->close(wi);
-err_wi:
-	vy_run_discard(new_run);
-err_run:
+err_part:
+	vy_task_foreach_part(task, part) {
+		vy_task_compact_part_cleanup(part);
+		if (part->new_run != NULL)
+			vy_run_discard(part->new_run);
+	}
 	vy_task_delete(&scheduler->task_pool, task);
 err_task:
 	say_error("%s: could not start compacting range %s: %s",
@@ -1575,6 +1889,25 @@ fail:
 
 }
 
+/**
+ * Account a processed part of a partitioned task. If the part
+ * failed, its error is moved to the task. Return the task if
+ * all its parts have been processed, NULL otherwise.
+ */
+static struct vy_task *
+vy_task_complete_part(struct vy_task *part)
+{
+	struct vy_task *task = part->parent;
+	assert(task->pending_parts > 0);
+	if (part->status != 0) {
+		task->status = part->status;
+		diag_move(&part->diag, &task->diag);
+	}
+	if (--task->pending_parts > 0)
+		return NULL;
+	return task;
+}
+
 static int
 vy_scheduler_complete_task(struct vy_scheduler *scheduler,
 			   struct vy_task *task)
@@ -1658,14 +1991,23 @@ vy_scheduler_f(va_list va)
 
 		/* Complete and delete all processed tasks. */
 		stailq_foreach_entry_safe(task, next, &output_queue, link) {
+			scheduler->workers_available++;
+			assert(scheduler->workers_available <=
+			       scheduler->worker_pool_size);
+			if (task->parent != NULL) {
+				/*
+				 * A partitioned task is complete
+				 * when all its parts are processed.
+				 */
+				task = vy_task_complete_part(task);
+				if (task == NULL)
+					continue;
+			}
 			if (vy_scheduler_complete_task(scheduler, task) != 0)
 				tasks_failed++;
 			else
 				tasks_done++;
 			vy_task_delete(&scheduler->task_pool, task);
-			scheduler->workers_available++;
-			assert(scheduler->workers_available <=
-			       scheduler->worker_pool_size);
 		}
 		/*
 		 * Reset the timeout if we managed to successfully
@@ -1699,12 +2041,24 @@ vy_scheduler_f(va_list va)
 		/* Queue the task and notify workers if necessary. */
 		tt_pthread_mutex_lock(&scheduler->mutex);
 		was_empty = stailq_empty(&scheduler->input_queue);
-		stailq_add_tail_entry(&scheduler->input_queue, task, link);
+		if (rlist_empty(&task->parts)) {
+			stailq_add_tail_entry(&scheduler->input_queue,
+					      task, link);
+			scheduler->workers_available--;
+		} else {
+			/* Queue parts of a partitioned task instead. */
+			struct vy_task *part;
+			rlist_foreach_entry(part, &task->parts, in_parent) {
+				stailq_add_tail_entry(&scheduler->input_queue,
+						      part, link);
+				scheduler->workers_available--;
+			}
+		}
+		assert(scheduler->workers_available >= 0);
 		if (was_empty)
-			tt_pthread_cond_signal(&scheduler->worker_cond);
+			tt_pthread_cond_broadcast(&scheduler->worker_cond);
 		tt_pthread_mutex_unlock(&scheduler->mutex);
 
-		scheduler->workers_available--;
 		fiber_reschedule();
 		continue;
 error:
@@ -1830,6 +2184,11 @@ vy_scheduler_stop_workers(struct vy_scheduler *scheduler)
 	struct vy_task *task, *next;
 	stailq_concat(&task_queue, &scheduler->output_queue);
 	stailq_foreach_entry_safe(task, next, &task_queue, link) {
+		if (task->parent != NULL) {
+			task = vy_task_complete_part(task);
+			if (task == NULL)
+				continue;
+		}
 		if (task->ops->abort != NULL)
 			task->ops->abort(scheduler, task, true);
 		vy_task_delete(&scheduler->task_pool, task);
@@ -2011,6 +2370,7 @@ vy_info_append_memory(struct vy_env *env, struct info_handler *h)
 	info_append_int(h, "watermark", q->watermark);
 	snprintf(buf, sizeof(buf), "%d%%", (int)(100 * q->used / q->limit));
 	info_append_str(h, "ratio", buf);
+	info_append_int(h, "page_bloom", vy_run_page_bloom_size());
 	info_table_end(h);
 }
 
@@ -2045,6 +2405,10 @@ vy_info_append_performance(struct vy_env *env, struct info_handler *h)
 	info_append_int(h, "read_view", mstats.objcount);
 
 	info_append_int(h, "dump_bandwidth", vy_stat_dump_bandwidth(stat));
+	info_append_int(h, "dump_rate_limit",
+			vy_run_throttle_rate(&env->run_env.dump_throttle));
+	info_append_int(h, "compact_rate_limit",
+			vy_run_throttle_rate(&env->run_env.compact_throttle));
 
 	struct vy_cache_env *ce = &env->cache_env;
 	info_table_begin(h, "cache");
@@ -2052,6 +2416,16 @@ vy_info_append_performance(struct vy_env *env, struct info_handler *h)
 	info_append_int(h, "used", ce->mem_used);
 	info_table_end(h);
 
+	struct vy_page_cache *pc = &env->run_env.page_cache;
+	tt_pthread_mutex_lock(&pc->mutex);
+	info_table_begin(h, "page_cache");
+	info_append_int(h, "count", pc->page_count);
+	info_append_int(h, "used", pc->mem_used);
+	info_append_int(h, "limit", pc->mem_quota);
+	info_append_int(h, "evict", pc->evict_count);
+	info_table_end(h);
+	tt_pthread_mutex_unlock(&pc->mutex);
+
 	info_table_end(h);
 }
 
@@ -2153,6 +2527,10 @@ vy_index_info(struct vy_index *index, struct info_handler *h)
 	info_append_int(h, "hit", stat->disk.iterator.bloom_hit);
 	info_append_int(h, "miss", stat->disk.iterator.bloom_miss);
 	info_table_end(h);
+	info_table_begin(h, "page_cache");
+	info_append_int(h, "hit", stat->disk.iterator.page_cache_hit);
+	info_append_int(h, "miss", stat->disk.iterator.page_cache_miss);
+	info_table_end(h);
 	info_table_end(h);
 	vy_info_append_compact_stat(h, "dump", &stat->disk.dump);
 	vy_info_append_compact_stat(h, "compact", &stat->disk.compact);
@@ -2222,10 +2600,33 @@ vy_new_index(struct vy_env *env, struct index_def *index_def,
 			    index_def, format, pk);
 }
 
+/** Delete all files of a run of the given index. */
+static void
+vy_index_remove_run_files(struct vy_index *index, int64_t run_id)
+{
+	char path[PATH_MAX];
+	for (int type = 0; type < vy_file_MAX; type++) {
+		vy_run_snprint_path(path, sizeof(path), index->env->path,
+				    index->space_id, index->id, run_id, type);
+		if (unlink(path) < 0 && errno != ENOENT)
+			say_syserror("failed to delete file '%s'", path);
+	}
+}
+
 void
 vy_delete_index(struct vy_env *env, struct vy_index *index)
 {
 	(void)env;
+	/*
+	 * Runs of an index whose creation was never committed,
+	 * e.g. built by an aborted DDL, are not in the metadata
+	 * log and so won't be collected by garbage collection.
+	 */
+	if (index->commit_lsn < 0) {
+		struct vy_run *run;
+		rlist_foreach_entry(run, &index->runs, in_index)
+			vy_index_remove_run_files(index, run->id);
+	}
 	/*
 	 * There still may be a task scheduled for this index
 	 * so postpone actual deletion until the last reference
@@ -2336,6 +2737,19 @@ vy_index_commit_create(struct vy_env *env, struct vy_index *index, int64_t lsn)
 	vy_log_create_index(index->commit_lsn, index->id,
 			    index->space_id, index->key_def);
 	vy_log_insert_range(index->commit_lsn, range->id, NULL, NULL);
+	/*
+	 * Log runs written by vy_build_secondary_key(), oldest
+	 * first, because recovery adds slices to the range head.
+	 */
+	struct vy_slice *slice;
+	rlist_foreach_entry_reverse(slice, &range->slices, in_range) {
+		vy_log_create_run(index->commit_lsn, slice->run->id,
+				  slice->run->dump_lsn);
+		vy_log_insert_slice(range->id, slice->run->id, slice->id,
+				    NULL, NULL);
+	}
+	if (index->dump_lsn >= 0)
+		vy_log_dump_index(index->commit_lsn, index->dump_lsn);
 	if (vy_log_tx_try_commit() != 0)
 		say_warn("failed to log index creation: %s",
 			 diag_last_error(diag_get())->errmsg);
@@ -2551,12 +2965,6 @@ vy_prepare_alter_space(struct vy_env *env, struct space *old_space,
 	if (space_def_check_compatibility(old_space->def, new_space->def,
 					  false) != 0)
 		return -1;
-	if (old_space->index_count < new_space->index_count) {
-		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
-			 "adding an index to a non-empty space");
-		return -1;
-	}
-
 	if (old_space->index_count == new_space->index_count) {
 		/* Check index_defs to be unchanged. */
 		for (uint32_t i = 0; i < old_space->index_count; ++i) {
@@ -2670,43 +3078,748 @@ vy_index_bsize(struct vy_index *index)
 	return index->stat.memory.count.bytes;
 }
 
-/* {{{ Public API of transaction control: start/end transaction,
- * read, write data in the context of a transaction.
- */
+/* {{{ Secondary index build */
 
 /**
- * Check if a request has already been committed to an index.
- *
- * If we're recovering the WAL, it may happen so that this
- * particular run was dumped after the checkpoint, and we're
- * replaying records already present in the database. In this
- * case avoid overwriting a newer version with an older one.
- *
- * If the index is going to be dropped or truncated on WAL
- * recovery, there's no point in replaying statements for it,
- * either.
+ * Max size of statements accumulated by an index build before
+ * they are sorted and written to a run.
  */
-static inline bool
-vy_is_committed_one(struct vy_env *env, struct space *space,
-		    struct vy_index *index)
-{
-	if (likely(env->status != VINYL_FINAL_RECOVERY_LOCAL))
-		return false;
-	if (index->is_dropped)
-		return true;
-	if (index->truncate_count > space->truncate_count)
-		return true;
-	if (vclock_sum(env->recovery_vclock) <= index->dump_lsn)
-		return true;
-	return false;
-}
+enum { VY_BUILD_RUN_SIZE = 128 * 1024 * 1024 };
+
+/** A statement to be written to a run by an index build. */
+struct vy_build_stmt {
+	struct tuple *stmt;
+	/**
+	 * Order of the statement in the build buffer, used to
+	 * tell the newest of statements with the same key and
+	 * LSN, e.g. DELETE and REPLACE made by an update.
+	 */
+	size_t seq;
+};
+
+/** A change committed to the space while its index was built. */
+struct vy_build_change {
+	struct tuple *old_tuple;
+	struct tuple *new_tuple;
+	int64_t lsn;
+};
 
 /**
- * Check if a request has already been committed to a space.
- * See also vy_is_committed_one().
+ * Context of a secondary index build. It is reference counted,
+ * because transaction triggers may outlive the build.
  */
-static inline bool
-vy_is_committed(struct vy_env *env, struct space *space)
+struct vy_build {
+	struct vy_env *env;
+	/** Space the index is built for. */
+	struct space *space;
+	/** Primary index of the space. */
+	struct vy_index *pk;
+	/** Index being built. */
+	struct vy_index *index;
+	/** Name of the index being built, for error messages. */
+	const char *index_name;
+	/** Statements to be written to the next run. */
+	struct vy_build_stmt *stmts;
+	size_t stmt_count;
+	size_t stmt_capacity;
+	/** Total size of statements in the buffer. */
+	size_t stmt_size;
+	/** Changes committed to the space during the build. */
+	struct vy_build_change *changes;
+	size_t change_count;
+	size_t change_capacity;
+	/** Set if a change couldn't be logged. */
+	bool is_broken;
+	/** Set when the build stops logging changes. */
+	bool is_closed;
+	/** Transactions that have written to the space, vy_build_txn. */
+	struct rlist txns;
+	/** Signaled when a transaction is over. */
+	struct fiber_cond txn_cond;
+	/** Space trigger used to track writers. */
+	struct trigger on_replace;
+	int refs;
+};
+
+/** A transaction that has written to the space being built. */
+struct vy_build_txn {
+	struct vy_build *build;
+	struct txn *txn;
+	struct trigger on_commit;
+	struct trigger on_rollback;
+	/** Link in vy_build::txns. */
+	struct rlist in_build;
+};
+
+static struct vy_build *
+vy_build_new(struct vy_env *env, struct space *space,
+	     struct vy_index *index, const char *index_name)
+{
+	struct vy_build *build = calloc(1, sizeof(*build));
+	if (build == NULL) {
+		diag_set(OutOfMemory, sizeof(*build),
+			 "calloc", "struct vy_build");
+		return NULL;
+	}
+	build->env = env;
+	build->space = space;
+	build->pk = vy_index(space->index[0]);
+	build->index = index;
+	build->index_name = index_name;
+	rlist_create(&build->txns);
+	fiber_cond_create(&build->txn_cond);
+	build->refs = 1;
+	return build;
+}
+
+static void
+vy_build_unref(struct vy_build *build)
+{
+	assert(build->refs > 0);
+	if (--build->refs > 0)
+		return;
+	assert(rlist_empty(&build->txns));
+	for (size_t i = 0; i < build->stmt_count; i++)
+		tuple_unref(build->stmts[i].stmt);
+	for (size_t i = 0; i < build->change_count; i++) {
+		struct vy_build_change *change = &build->changes[i];
+		if (change->old_tuple != NULL)
+			tuple_unref(change->old_tuple);
+		if (change->new_tuple != NULL)
+			tuple_unref(change->new_tuple);
+	}
+	fiber_cond_destroy(&build->txn_cond);
+	free(build->stmts);
+	free(build->changes);
+	free(build);
+}
+
+/**
+ * Append a statement to the build buffer. The buffer takes
+ * the reference to the statement, even on failure.
+ */
+static int
+vy_build_add_stmt(struct vy_build *build, struct tuple *stmt)
+{
+	if (build->stmt_count == build->stmt_capacity) {
+		size_t capacity = MAX(build->stmt_capacity * 2, 1024);
+		struct vy_build_stmt *stmts = realloc(build->stmts,
+						capacity * sizeof(*stmts));
+		if (stmts == NULL) {
+			tuple_unref(stmt);
+			diag_set(OutOfMemory, capacity * sizeof(*stmts),
+				 "realloc", "struct vy_build_stmt");
+			return -1;
+		}
+		build->stmts = stmts;
+		build->stmt_capacity = capacity;
+	}
+	struct vy_build_stmt *entry = &build->stmts[build->stmt_count];
+	entry->stmt = stmt;
+	entry->seq = build->stmt_count++;
+	build->stmt_size += tuple_size(stmt);
+	return 0;
+}
+
+/**
+ * Check a tuple against the format of the new index and add
+ * a REPLACE statement for it to the build buffer.
+ */
+static int
+vy_build_add_tuple(struct vy_build *build, struct tuple *tuple, int64_t lsn)
+{
+	struct vy_index *index = build->index;
+	uint32_t size;
+	const char *data = tuple_data_range(tuple, &size);
+	if (tuple_validate_raw(index->mem_format, data) != 0)
+		return -1;
+	struct tuple *stmt = vy_stmt_new_replace(index->mem_format,
+						 data, data + size);
+	if (stmt == NULL)
+		return -1;
+	vy_stmt_set_lsn(stmt, lsn);
+	return vy_build_add_stmt(build, stmt);
+}
+
+/** Add a DELETE statement for a tuple to the build buffer. */
+static int
+vy_build_add_delete(struct vy_build *build, struct tuple *tuple, int64_t lsn)
+{
+	struct tuple *stmt = vy_stmt_new_surrogate_delete(
+					build->index->mem_format, tuple);
+	if (stmt == NULL)
+		return -1;
+	vy_stmt_set_lsn(stmt, lsn);
+	return vy_build_add_stmt(build, stmt);
+}
+
+/**
+ * Order statements by key, then newest first: by LSN and by
+ * the order they were added to the buffer.
+ */
+static int
+vy_build_stmt_cmp(const void *a, const void *b, void *arg)
+{
+	const struct vy_build_stmt *stmt_a = a;
+	const struct vy_build_stmt *stmt_b = b;
+	const struct key_def *cmp_def = arg;
+	int rc = vy_stmt_compare(stmt_a->stmt, stmt_b->stmt, cmp_def);
+	if (rc != 0)
+		return rc;
+	int64_t lsn_a = vy_stmt_lsn(stmt_a->stmt);
+	int64_t lsn_b = vy_stmt_lsn(stmt_b->stmt);
+	if (lsn_a != lsn_b)
+		return lsn_a > lsn_b ? -1 : 1;
+	return stmt_a->seq > stmt_b->seq ? -1 : 1;
+}
+
+/**
+ * A stream over the sorted build buffer. Of statements with
+ * the same key it only returns the newest one.
+ */
+struct vy_build_stream {
+	struct vy_stmt_stream base;
+	struct vy_build *build;
+	/** Run the stream is written to. */
+	struct vy_run *run;
+	/** Position of the next statement in the buffer. */
+	size_t pos;
+};
+
+static NODISCARD int
+vy_build_stream_start(struct vy_stmt_stream *virt_stream)
+{
+	(void)virt_stream;
+	return 0;
+}
+
+static NODISCARD int
+vy_build_stream_next(struct vy_stmt_stream *virt_stream, struct tuple **ret)
+{
+	struct vy_build_stream *stream = (struct vy_build_stream *)virt_stream;
+	struct vy_build *build = stream->build;
+	const struct key_def *cmp_def = build->index->cmp_def;
+	*ret = NULL;
+	if (stream->pos >= build->stmt_count)
+		return 0;
+	*ret = build->stmts[stream->pos++].stmt;
+	while (stream->pos < build->stmt_count &&
+	       vy_stmt_compare(build->stmts[stream->pos].stmt, *ret,
+			       cmp_def) == 0)
+		stream->pos++;
+	return 0;
+}
+
+static void
+vy_build_stream_stop(struct vy_stmt_stream *virt_stream)
+{
+	(void)virt_stream;
+}
+
+static const struct vy_stmt_stream_iface vy_build_stream_iface = {
+	.start = vy_build_stream_start,
+	.next = vy_build_stream_next,
+	.stop = vy_build_stream_stop,
+	.close = vy_build_stream_stop,
+};
+
+/** Sort the build buffer and write it to a run. */
+static int
+vy_build_write_run_f(va_list ap)
+{
+	struct vy_build_stream *stream = va_arg(ap, struct vy_build_stream *);
+	struct vy_build *build = stream->build;
+	struct vy_index *index = build->index;
+	qsort_arg(build->stmts, build->stmt_count, sizeof(*build->stmts),
+		  vy_build_stmt_cmp, (void *)index->cmp_def);
+	return vy_run_write(stream->run, index->env->path,
+			    index->space_id, index->id, &stream->base,
+			    index->opts.page_size, index->cmp_def,
+			    index->key_def, build->stmt_count,
+			    index->opts.bloom_fpr, NULL);
+}
+
+/**
+ * Write statements accumulated in the build buffer to a new run
+ * and add it to the index on top of the runs written before.
+ * Sorting and writing is done in a separate thread so as not to
+ * stall the tx thread. The run isn't logged until the index
+ * creation is committed, see vy_index_commit_create().
+ */
+static int
+vy_build_write_run(struct vy_build *build)
+{
+	struct vy_index *index = build->index;
+	if (build->stmt_count == 0)
+		return 0;
+
+	struct vy_run *run = vy_run_new(vy_log_next_id());
+	if (run == NULL)
+		return -1;
+
+	struct vy_build_stream stream;
+	stream.base.iface = &vy_build_stream_iface;
+	stream.build = build;
+	stream.run = run;
+	stream.pos = 0;
+	struct cord cord;
+	int rc = cord_costart(&cord, "vinyl.build", vy_build_write_run_f,
+			      &stream);
+	if (rc == 0)
+		rc = cord_cojoin(&cord);
+
+	for (size_t i = 0; i < build->stmt_count; i++)
+		tuple_unref(build->stmts[i].stmt);
+	build->stmt_count = 0;
+	build->stmt_size = 0;
+
+	struct vy_slice *slice = NULL;
+	if (rc == 0)
+		slice = vy_slice_new(vy_log_next_id(), run, NULL, NULL,
+				     index->cmp_def);
+	if (slice == NULL) {
+		vy_index_remove_run_files(index, run->id);
+		vy_run_unref(run);
+		return -1;
+	}
+	run->dump_lsn = run->info.max_lsn;
+	vy_index_add_run(index, run);
+	vy_run_unref(run);
+
+	struct vy_range *range = vy_range_tree_first(index->tree);
+	assert(index->range_count == 1);
+	vy_index_unacct_range(index, range);
+	vy_range_add_slice(range, slice);
+	vy_index_acct_range(index, range);
+	vy_range_update_compact_priority(range, &index->opts);
+	vy_range_heap_update(&index->range_heap, &range->heap_node);
+	range->version++;
+	/* Make the run visible to read iterators. */
+	index->dump_lsn = MAX(index->dump_lsn, run->dump_lsn);
+	return 0;
+}
+
+/**
+ * Load all tuples visible from a read view of the primary
+ * index to the index being built.
+ */
+static int
+vy_build_load(struct vy_build *build, const struct vy_read_view **rv)
+{
+	struct vy_env *env = build->env;
+	struct vy_index *pk = build->pk;
+	struct tuple *key = vy_stmt_new_select(pk->env->key_format, NULL, 0);
+	if (key == NULL)
+		return -1;
+	struct vy_read_iterator itr;
+	vy_read_iterator_open(&itr, &env->run_env, pk, NULL, ITER_GE,
+			      key, rv);
+	struct tuple *tuple;
+	int rc, loops = 0;
+	while ((rc = vy_read_iterator_next(&itr, &tuple)) == 0 &&
+	       tuple != NULL) {
+		rc = vy_build_add_tuple(build, tuple, vy_stmt_lsn(tuple));
+		if (rc == 0 && build->stmt_size >= VY_BUILD_RUN_SIZE)
+			rc = vy_build_write_run(build);
+		if (rc != 0)
+			break;
+		if (++loops % VY_YIELD_LOOPS == 0)
+			fiber_sleep(0);
+	}
+	vy_read_iterator_close(&itr);
+	tuple_unref(key);
+	if (rc != 0)
+		return -1;
+	return vy_build_write_run(build);
+}
+
+/**
+ * Check that the index being built has no duplicates of the
+ * given key or, if the key is empty, no duplicates at all.
+ * Tuples with nulls in the key are never duplicates.
+ */
+static int
+vy_build_check_unique(struct vy_build *build, const char *key,
+		      uint32_t part_count)
+{
+	struct vy_env *env = build->env;
+	struct vy_index *index = build->index;
+	struct tuple *vykey = vy_stmt_new_select(index->env->key_format,
+						 key, part_count);
+	if (vykey == NULL)
+		return -1;
+	struct vy_read_iterator itr;
+	vy_read_iterator_open(&itr, &env->run_env, index, NULL,
+			      part_count > 0 ? ITER_EQ : ITER_GE, vykey,
+			      &env->xm->p_global_read_view);
+	struct tuple *prev = NULL;
+	struct tuple *stmt;
+	int rc, loops = 0;
+	while ((rc = vy_read_iterator_next(&itr, &stmt)) == 0 &&
+	       stmt != NULL) {
+		if (index->key_def->is_nullable &&
+		    vy_tuple_key_contains_null(stmt, index->key_def))
+			continue;
+		if (prev != NULL &&
+		    vy_stmt_compare(prev, stmt, index->key_def) == 0) {
+			diag_set(ClientError, ER_TUPLE_FOUND,
+				 build->index_name, space_name(build->space));
+			rc = -1;
+			break;
+		}
+		if (prev != NULL)
+			tuple_unref(prev);
+		tuple_ref(stmt);
+		prev = stmt;
+		if (++loops % VY_YIELD_LOOPS == 0)
+			fiber_sleep(0);
+	}
+	if (prev != NULL)
+		tuple_unref(prev);
+	vy_read_iterator_close(&itr);
+	tuple_unref(vykey);
+	return rc;
+}
+
+/** Log a change committed to the space during the build. */
+static void
+vy_build_log_change(struct vy_build *build, struct tuple *old_tuple,
+		    struct tuple *new_tuple, int64_t lsn)
+{
+	if (build->change_count == build->change_capacity) {
+		size_t capacity = MAX(build->change_capacity * 2, 64);
+		struct vy_build_change *changes = realloc(build->changes,
+						capacity * sizeof(*changes));
+		if (changes == NULL) {
+			build->is_broken = true;
+			return;
+		}
+		build->changes = changes;
+		build->change_capacity = capacity;
+	}
+	if (old_tuple != NULL && tuple_ref(old_tuple) != 0) {
+		build->is_broken = true;
+		return;
+	}
+	if (new_tuple != NULL && tuple_ref(new_tuple) != 0) {
+		if (old_tuple != NULL)
+			tuple_unref(old_tuple);
+		build->is_broken = true;
+		return;
+	}
+	struct vy_build_change *change = &build->changes[build->change_count++];
+	change->old_tuple = old_tuple;
+	change->new_tuple = new_tuple;
+	change->lsn = lsn;
+}
+
+static void
+vy_build_txn_delete(struct vy_build_txn *build_txn)
+{
+	struct vy_build *build = build_txn->build;
+	trigger_clear(&build_txn->on_commit);
+	trigger_clear(&build_txn->on_rollback);
+	rlist_del_entry(build_txn, in_build);
+	fiber_cond_broadcast(&build->txn_cond);
+	free(build_txn);
+	vy_build_unref(build);
+}
+
+static void
+vy_build_txn_on_commit(struct trigger *trigger, void *event)
+{
+	struct txn *txn = event;
+	struct vy_build_txn *build_txn = trigger->data;
+	struct vy_build *build = build_txn->build;
+	struct txn_stmt *stmt;
+	stailq_foreach_entry(stmt, &txn->stmts, next) {
+		/* Skip statements of other spaces and failed ones. */
+		if (stmt->space != build->space || stmt->row == NULL)
+			continue;
+		if (stmt->old_tuple == NULL && stmt->new_tuple == NULL)
+			continue;
+		vy_build_log_change(build, stmt->old_tuple,
+				    stmt->new_tuple, txn->signature);
+	}
+	vy_build_txn_delete(build_txn);
+}
+
+static void
+vy_build_txn_on_rollback(struct trigger *trigger, void *event)
+{
+	(void)event;
+	vy_build_txn_delete(trigger->data);
+}
+
+/**
+ * Space on_replace trigger: make sure changes done by the
+ * transaction will be logged on commit. Once the build is
+ * closed, abort the transaction instead.
+ */
+static void
+vy_build_on_replace(struct trigger *trigger, void *event)
+{
+	struct txn *txn = event;
+	struct vy_build *build = trigger->data;
+	if (build->is_closed) {
+		if (tx_manager_abort_writers(build->env->xm, build->pk) != 0)
+			build->is_broken = true;
+		return;
+	}
+	struct vy_build_txn *build_txn;
+	rlist_foreach_entry(build_txn, &build->txns, in_build) {
+		if (build_txn->txn == txn)
+			return;
+	}
+	build_txn = malloc(sizeof(*build_txn));
+	if (build_txn == NULL) {
+		build->is_broken = true;
+		return;
+	}
+	build_txn->build = build;
+	build_txn->txn = txn;
+	trigger_create(&build_txn->on_commit, vy_build_txn_on_commit,
+		       build_txn, NULL);
+	trigger_create(&build_txn->on_rollback, vy_build_txn_on_rollback,
+		       build_txn, NULL);
+	txn_on_commit(txn, &build_txn->on_commit);
+	txn_on_rollback(txn, &build_txn->on_rollback);
+	rlist_add_tail_entry(&build->txns, build_txn, in_build);
+	build->refs++;
+}
+
+/**
+ * Return true if a transaction that has written to the space
+ * is waiting for WAL and so can't be aborted.
+ */
+static bool
+vy_build_has_prepared_txns(struct vy_build *build)
+{
+	struct vy_build_txn *build_txn;
+	rlist_foreach_entry(build_txn, &build->txns, in_build) {
+		struct vy_tx *tx = build_txn->txn->engine_tx;
+		if (tx != NULL && tx->state == VINYL_TX_COMMIT)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Stop logging changes: abort transactions that are still
+ * writing to the space and wait for those that are being
+ * committed, then write logged changes to a run.
+ */
+static int
+vy_build_close(struct vy_build *build)
+{
+	build->is_closed = true;
+	if (tx_manager_abort_writers(build->env->xm, build->pk) != 0)
+		return -1;
+	while (vy_build_has_prepared_txns(build))
+		fiber_cond_wait(&build->txn_cond);
+	if (build->is_broken) {
+		diag_set(OutOfMemory, sizeof(struct vy_build_change),
+			 "realloc", "struct vy_build_change");
+		return -1;
+	}
+
+	for (size_t i = 0; i < build->change_count; i++) {
+		struct vy_build_change *change = &build->changes[i];
+		if (change->old_tuple != NULL &&
+		    vy_build_add_delete(build, change->old_tuple,
+					change->lsn) != 0)
+			return -1;
+		if (change->new_tuple != NULL &&
+		    vy_build_add_tuple(build, change->new_tuple,
+				       change->lsn) != 0)
+			return -1;
+	}
+	if (vy_build_write_run(build) != 0)
+		return -1;
+
+	struct vy_index *index = build->index;
+	if (!index->opts.is_unique)
+		return 0;
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	int rc = 0;
+	for (size_t i = 0; i < build->change_count && rc == 0; i++) {
+		struct tuple *tuple = build->changes[i].new_tuple;
+		if (tuple == NULL)
+			continue;
+		if (index->key_def->is_nullable &&
+		    vy_tuple_key_contains_null(tuple, index->key_def))
+			continue;
+		const char *key = tuple_extract_key(tuple, index->key_def,
+						    NULL);
+		if (key == NULL) {
+			rc = -1;
+			break;
+		}
+		uint32_t part_count = mp_decode_array(&key);
+		rc = vy_build_check_unique(build, key, part_count);
+		region_truncate(region, region_svp);
+	}
+	region_truncate(region, region_svp);
+	return rc;
+}
+
+/**
+ * Build an index while the space is being written to. Changes
+ * are tracked with a space trigger from the moment we take the
+ * read view the index is loaded from, so the two together give
+ * the up-to-date contents of the space.
+ */
+static int
+vy_build_online(struct vy_build *build)
+{
+	struct tx_manager *xm = build->env->xm;
+	const struct vy_read_view *rv = NULL;
+	int rc = -1;
+	/*
+	 * Transactions that have written to the space before
+	 * the trigger was installed aren't tracked, so abort
+	 * them, unless they have been prepared, in which case
+	 * their changes are in the read view. Don't yield until
+	 * the read view is created.
+	 */
+	trigger_create(&build->on_replace, vy_build_on_replace, build, NULL);
+	trigger_add(&build->space->on_replace, &build->on_replace);
+	if (tx_manager_abort_writers(xm, build->pk) != 0)
+		goto out;
+	rv = tx_manager_read_view(xm);
+	if (rv == NULL)
+		goto out;
+	/*
+	 * Wait until prepared transactions seen by the read view
+	 * are committed, so that its LSN is known.
+	 */
+	while (rv->vlsn >= MAX_LSN && !rv->is_aborted)
+		fiber_sleep(0.01);
+	if (rv->is_aborted) {
+		diag_set(ClientError, ER_TRANSACTION_CONFLICT);
+		goto out;
+	}
+	if (vy_build_load(build, &rv) != 0)
+		goto out;
+	if (build->index->opts.is_unique &&
+	    vy_build_check_unique(build, NULL, 0) != 0)
+		goto out;
+	rc = vy_build_close(build);
+out:
+	if (rv != NULL)
+		tx_manager_destroy_read_view(xm, rv);
+	build->is_closed = true;
+	trigger_clear(&build->on_replace);
+	/*
+	 * Transactions that are still tracked may outlive
+	 * the space, which is deleted once the alter commits.
+	 */
+	build->space = NULL;
+	return rc;
+}
+
+int
+vy_build_secondary_key(struct vy_env *env, struct space *space,
+		       struct index *new_index)
+{
+	struct vy_index *index = vy_index(new_index);
+	assert(space->index_count > 0);
+	struct vy_index *pk = vy_index(space->index[0]);
+	switch (env->status) {
+	case VINYL_INITIAL_RECOVERY_LOCAL:
+		/* The index is loaded from disk. */
+		return 0;
+	case VINYL_INITIAL_RECOVERY_REMOTE:
+		/* Indexes go before data in a snapshot. */
+		return 0;
+	case VINYL_FINAL_RECOVERY_LOCAL:
+		/*
+		 * The index has been loaded from disk, unless it
+		 * was created after the last checkpoint and we
+		 * failed to log it or crashed before that.
+		 */
+		if (index->commit_lsn >= 0)
+			return 0;
+		break;
+	case VINYL_FINAL_RECOVERY_REMOTE:
+	case VINYL_ONLINE:
+		break;
+	default:
+		unreachable();
+	}
+	if (pk->stat.disk.count.rows == 0 &&
+	    pk->stat.memory.count.rows == 0) {
+		/*
+		 * The space is empty, but there may be active
+		 * transactions writing to it, which will not
+		 * write to the new index.
+		 */
+		return tx_manager_abort_writers(env->xm, pk);
+	}
+
+	struct vy_build *build = vy_build_new(env, space, index,
+					      new_index->def->name);
+	if (build == NULL)
+		return -1;
+	say_info("building index '%s' of space '%s'",
+		 build->index_name, space_name(space));
+	int rc;
+	if (env->status == VINYL_ONLINE) {
+		rc = vy_build_online(build);
+	} else {
+		/* No one can write to the space during recovery. */
+		rc = vy_build_load(build, &env->xm->p_global_read_view);
+		if (rc == 0 && index->opts.is_unique)
+			rc = vy_build_check_unique(build, NULL, 0);
+	}
+	vy_build_unref(build);
+	if (rc != 0)
+		return -1;
+	say_info("index '%s' of space '%s' is built",
+		 new_index->def->name, space_name(space));
+	return 0;
+}
+
+/* }}} Secondary index build */
+
+/* {{{ Public API of transaction control: start/end transaction,
+ * read, write data in the context of a transaction.
+ */
+
+/**
+ * Check if a request has already been committed to an index.
+ *
+ * If we're recovering the WAL, it may happen so that this
+ * particular run was dumped after the checkpoint, and we're
+ * replaying records already present in the database. In this
+ * case avoid overwriting a newer version with an older one.
+ *
+ * If the index is going to be dropped or truncated on WAL
+ * recovery, there's no point in replaying statements for it,
+ * either.
+ */
+static inline bool
+vy_is_committed_one(struct vy_env *env, struct space *space,
+		    struct vy_index *index)
+{
+	if (likely(env->status != VINYL_FINAL_RECOVERY_LOCAL))
+		return false;
+	if (index->is_dropped)
+		return true;
+	if (index->truncate_count > space->truncate_count)
+		return true;
+	if (vclock_sum(env->recovery_vclock) <= index->dump_lsn)
+		return true;
+	return false;
+}
+
+/**
+ * Check if a request has already been committed to a space.
+ * See also vy_is_committed_one().
+ */
+static inline bool
+vy_is_committed(struct vy_env *env, struct space *space)
 {
 	if (likely(env->status != VINYL_FINAL_RECOVERY_LOCAL))
 		return false;
@@ -3738,8 +4851,20 @@ vy_prepare(struct vy_env *env, struct vy_tx *tx)
 	 * the transaction to be sent to read view or aborted, we call
 	 * it before checking for conflicts.
 	 */
-	if (vy_quota_use(&env->quota, tx->write_size,
-			 env->timeout) != 0) {
+	double timeout = env->timeout;
+	double delay = vy_quota_delay(&env->quota, tx->write_size,
+				      vy_stat_dump_bandwidth(env->stat),
+				      ev_monotonic_now(loop()));
+	if (delay > 0) {
+		/*
+		 * Memory is running out. Slow the transaction down
+		 * so that dump catches up before the limit is hit.
+		 */
+		delay = MIN(delay, timeout);
+		fiber_sleep(delay);
+		timeout -= delay;
+	}
+	if (vy_quota_use(&env->quota, tx->write_size, timeout) != 0) {
 		diag_set(ClientError, ER_VY_QUOTA_TIMEOUT);
 		return -1;
 	}
@@ -3837,6 +4962,52 @@ vy_get(struct vy_env *env, struct vy_tx *tx, struct vy_index *index,
 
 /** {{{ Environment */
 
+/** Min compaction write rate set by adaptive throttling. */
+enum { VY_COMPACT_RATE_MIN = 1024 * 1024 };
+
+/**
+ * Adjust the compaction write rate to WAL commit latency.
+ *
+ * While the average commit latency observed since the previous
+ * call exceeds box.cfg.vinyl_wal_latency_target, the rate is
+ * halved: compaction is the main competitor of WAL for the disk
+ * and can wait. Otherwise the rate is raised by a tenth of the
+ * configured limit (or of dump bandwidth if there's no limit)
+ * until it gets back to the limit. Dumps are not slowed down
+ * this way, because that would stall transactions on memory
+ * quota instead.
+ */
+static void
+vy_env_update_compact_rate(struct vy_env *e)
+{
+	double latency_sum;
+	int64_t latency_count;
+	wal_get_latency_total(&latency_sum, &latency_count);
+	double sum = latency_sum - e->wal_latency_sum;
+	int64_t count = latency_count - e->wal_latency_count;
+	e->wal_latency_sum = latency_sum;
+	e->wal_latency_count = latency_count;
+
+	struct vy_run_throttle *throttle = &e->run_env.compact_throttle;
+	double limit = e->compact_rate_limit;
+	double rate = vy_run_throttle_rate(throttle);
+	double ceiling = limit > 0 ? limit :
+			 vy_stat_dump_bandwidth(e->stat);
+	if (e->wal_latency_target > 0 && count > 0 &&
+	    sum / count > e->wal_latency_target) {
+		if (rate == 0)
+			rate = ceiling;
+		rate = MAX(rate / 2, VY_COMPACT_RATE_MIN);
+		if (limit > 0)
+			rate = MIN(rate, limit);
+	} else if (rate != limit) {
+		rate += ceiling / 10;
+		if (rate >= ceiling)
+			rate = limit;
+	}
+	vy_run_throttle_set_rate(throttle, rate);
+}
+
 static void
 vy_env_quota_timer_cb(ev_loop *loop, ev_timer *timer, int events)
 {
@@ -3845,6 +5016,8 @@ vy_env_quota_timer_cb(ev_loop *loop, ev_timer *timer, int events)
 
 	struct vy_env *e = timer->data;
 
+	vy_env_update_compact_rate(e);
+
 	int64_t tx_write_rate = vy_stat_tx_write_rate(e->stat);
 	int64_t dump_bandwidth = vy_stat_dump_bandwidth(e->stat);
 
@@ -3978,6 +5151,31 @@ vy_set_timeout(struct vy_env *env, double timeout)
 	env->timeout = timeout;
 }
 
+void
+vy_set_page_cache(struct vy_env *env, size_t quota)
+{
+	vy_run_env_set_page_cache(&env->run_env, quota);
+}
+
+void
+vy_set_dump_rate_limit(struct vy_env *env, double limit)
+{
+	vy_run_throttle_set_rate(&env->run_env.dump_throttle, limit);
+}
+
+void
+vy_set_compact_rate_limit(struct vy_env *env, double limit)
+{
+	env->compact_rate_limit = limit;
+	vy_run_throttle_set_rate(&env->run_env.compact_throttle, limit);
+}
+
+void
+vy_set_wal_latency_target(struct vy_env *env, double target)
+{
+	env->wal_latency_target = target;
+}
+
 /** }}} Environment */
 
 /* {{{ Checkpoint */
@@ -4262,7 +5460,8 @@ vy_join_cb(const struct vy_log_record *record, void *arg)
 		if (ctx->format != NULL)
 			tuple_format_unref(ctx->format);
 		ctx->format = tuple_format_new(&vy_tuple_format_vtab,
-					       &ctx->key_def, 1, 0, NULL, 0);
+					       &ctx->key_def, 1, 0, NULL, 0,
+					       false);
 		if (ctx->format == NULL)
 			return -1;
 		tuple_format_ref(ctx->format);
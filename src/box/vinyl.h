@@ -305,6 +305,25 @@ vy_prepare_alter_space(struct vy_env *env, struct space *old_space,
 int
 vy_check_format(struct vy_env *env, struct space *old_space);
 
+/**
+ * Build a new secondary index of a space.
+ *
+ * If the space is not empty, load all its tuples to the new
+ * index, checking them against the new format and, if the
+ * index is unique, for duplicates. When online, the space
+ * remains writable during the build.
+ *
+ * @param env       Vinyl environment.
+ * @param space     Space the index is built for.
+ * @param new_index New index.
+ *
+ * @retval  0 Success.
+ * @retval -1 Error.
+ */
+int
+vy_build_secondary_key(struct vy_env *env, struct space *space,
+		       struct index *new_index);
+
 /**
  * Hook on an alter space commit event. It is called on each
  * create_index(), drop_index() and is used for update
@@ -403,6 +422,33 @@ vy_set_max_tuple_size(struct vy_env *env, size_t max_size);
 void
 vy_set_timeout(struct vy_env *env, double timeout);
 
+/**
+ * Update the memory limit of the page cache.
+ */
+void
+vy_set_page_cache(struct vy_env *env, size_t quota);
+
+/**
+ * Update the dump write rate limit, in bytes per second.
+ * Zero removes the limit.
+ */
+void
+vy_set_dump_rate_limit(struct vy_env *env, double limit);
+
+/**
+ * Update the compaction write rate limit, in bytes per second.
+ * Zero removes the limit.
+ */
+void
+vy_set_compact_rate_limit(struct vy_env *env, double limit);
+
+/**
+ * Update the WAL commit latency compaction is slowed down at,
+ * in seconds. Zero disables adaptive compaction throttling.
+ */
+void
+vy_set_wal_latency_target(struct vy_env *env, double target);
+
 #ifdef __cplusplus
 }
 #endif
@@ -301,3 +301,27 @@ vinyl_engine_set_timeout(struct vinyl_engine *vinyl, double timeout)
 {
 	vy_set_timeout(vinyl->env, timeout);
 }
+
+void
+vinyl_engine_set_page_cache(struct vinyl_engine *vinyl, size_t quota)
+{
+	vy_set_page_cache(vinyl->env, quota);
+}
+
+void
+vinyl_engine_set_dump_rate_limit(struct vinyl_engine *vinyl, double limit)
+{
+	vy_set_dump_rate_limit(vinyl->env, limit);
+}
+
+void
+vinyl_engine_set_compact_rate_limit(struct vinyl_engine *vinyl, double limit)
+{
+	vy_set_compact_rate_limit(vinyl->env, limit);
+}
+
+void
+vinyl_engine_set_wal_latency_target(struct vinyl_engine *vinyl, double target)
+{
+	vy_set_wal_latency_target(vinyl->env, target);
+}
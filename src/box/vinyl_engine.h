@@ -58,6 +58,18 @@ vinyl_engine_set_max_tuple_size(struct vinyl_engine *vinyl, size_t max_size);
 void
 vinyl_engine_set_timeout(struct vinyl_engine *vinyl, double timeout);
 
+void
+vinyl_engine_set_page_cache(struct vinyl_engine *vinyl, size_t quota);
+
+void
+vinyl_engine_set_dump_rate_limit(struct vinyl_engine *vinyl, double limit);
+
+void
+vinyl_engine_set_compact_rate_limit(struct vinyl_engine *vinyl, double limit);
+
+void
+vinyl_engine_set_wal_latency_target(struct vinyl_engine *vinyl, double target);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 
@@ -252,29 +252,16 @@ vinyl_space_build_secondary_key(struct space *old_space,
 				struct space *new_space,
 				struct index *new_index)
 {
-	(void)old_space;
 	(void)new_space;
+	struct vinyl_engine *engine = (struct vinyl_engine *)old_space->engine;
+	if (vinyl_index_open((struct vinyl_index *)new_index) != 0)
+		return -1;
 	/*
-	 * Unlike Memtx, Vinyl does not need building of a secondary index.
-	 * This is true because of two things:
-	 * 1) Vinyl does not support alter of non-empty spaces
-	 * 2) During recovery a Vinyl index already has all needed data on disk.
-	 * And there are 3 cases:
-	 * I. The secondary index is added in snapshot. Then Vinyl was
-	 * snapshotted too and all necessary for that moment data is on disk.
-	 * II. The secondary index is added in WAL. That means that vinyl
-	 * space had no data at that point and had nothing to build. The
-	 * index actually could contain recovered data, but it will handle it
-	 * by itself during WAL recovery.
-	 * III. Vinyl is online. The space is definitely empty and there's
-	 * nothing to build.
-	 *
-	 * When we start to implement alter of non-empty vinyl spaces, it
-	 *  seems that we should call here:
-	 *   Engine::buildSecondaryKey(old_space, new_space, new_index_arg);
-	 *  but aware of three cases mentioned above.
+	 * During recovery, the index is either loaded from disk
+	 * or built from the primary index if it was created after
+	 * the last checkpoint, see vy_build_secondary_key().
 	 */
-	return vinyl_index_open((struct vinyl_index *)new_index);
+	return vy_build_secondary_key(engine->env, old_space, new_index);
 }
 
 static int
@@ -367,7 +354,8 @@ vinyl_space_new(struct vinyl_engine *vinyl,
 		keys[key_count++] = index_def->key_def;
 
 	struct tuple_format *format = tuple_format_new(&vy_tuple_format_vtab,
-			keys, key_count, 0, def->fields, def->field_count);
+			keys, key_count, 0, def->fields, def->field_count,
+			def->opts.full_field_map);
 	if (format == NULL) {
 		free(space);
 		return NULL;
@@ -31,10 +31,13 @@
 #include "vy_index.h"
 
 #include "trivia/util.h"
+#include <dirent.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include "assoc.h"
 #include "diag.h"
@@ -86,7 +89,7 @@ vy_index_env_create(struct vy_index_env *env, const char *path,
 		    void *upsert_thresh_arg)
 {
 	env->key_format = tuple_format_new(&vy_tuple_format_vtab,
-					   NULL, 0, 0, NULL, 0);
+					   NULL, 0, 0, NULL, 0, false);
 	if (env->key_format == NULL)
 		return -1;
 	tuple_format_ref(env->key_format);
@@ -166,7 +169,8 @@ vy_index_new(struct vy_index_env *index_env, struct vy_cache_env *cache_env,
 		tuple_format_ref(format);
 	} else {
 		index->disk_format = tuple_format_new(&vy_tuple_format_vtab,
-						      &cmp_def, 1, 0, NULL, 0);
+						      &cmp_def, 1, 0, NULL, 0,
+						      false);
 		if (index->disk_format == NULL)
 			goto fail_format;
 		for (uint32_t i = 0; i < cmp_def->part_count; ++i) {
@@ -335,6 +339,36 @@ vy_index_init_range_tree(struct vy_index *index)
 	return 0;
 }
 
+/**
+ * Remove run files left in an index directory by an index build
+ * that was interrupted by restart, see vy_build_secondary_key().
+ * Runs written by a build are only logged when the index creation
+ * is committed, so their ids may be reused after restart. Since
+ * all logged objects have ids less than the next id to allocate,
+ * any file with a greater id is garbage.
+ */
+static void
+vy_index_remove_garbage(const char *path)
+{
+	DIR *dh = opendir(path);
+	if (dh == NULL)
+		return;
+	int64_t next_id = vy_log_next_id();
+	struct dirent *dent;
+	while ((dent = readdir(dh)) != NULL) {
+		char *end;
+		long long id = strtoll(dent->d_name, &end, 10);
+		if (end == dent->d_name || *end != '.' || id < next_id)
+			continue;
+		char file[PATH_MAX];
+		snprintf(file, sizeof(file), "%s/%s", path, dent->d_name);
+		say_info("removing garbage file '%s'", file);
+		if (unlink(file) < 0)
+			say_syserror("failed to remove file '%s'", file);
+	}
+	closedir(dh);
+}
+
 int
 vy_index_create(struct vy_index *index)
 {
@@ -367,6 +401,8 @@ vy_index_create(struct vy_index *index)
 			 path);
 		return -1;
 	}
+	if (rc == -1)
+		vy_index_remove_garbage(path);
 
 	/* Allocate initial range. */
 	return vy_index_init_range_tree(index);
@@ -598,8 +634,13 @@ vy_index_recover(struct vy_index *index, struct vy_recovery *recovery,
 		 * we won't find it in the log on recovery. This is
 		 * OK as the index doesn't have any runs in this case.
 		 * We will retry to log index in vy_index_commit_create().
-		 * For now, just create the initial range.
+		 * For now, just create the initial range and remove
+		 * runs written by the index build before restart.
 		 */
+		char path[PATH_MAX];
+		vy_index_snprint_path(path, sizeof(path), index->env->path,
+				      index->space_id, index->id);
+		vy_index_remove_garbage(path);
 		return vy_index_init_range_tree(index);
 	}
 
@@ -32,6 +32,7 @@
  */
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include <tarantool_ev.h> /* ev_tstamp */
 
@@ -41,6 +42,9 @@ extern "C" {
 
 struct vy_quota;
 
+/** Max time a consumer is delayed for by vy_quota_delay(). */
+#define VY_QUOTA_DELAY_MAX 0.1
+
 /**
  * Called when quota is consumed if used >= watermark.
  * It is supposed to instigate memory reclaim.
@@ -83,6 +87,11 @@ struct vy_quota {
 	size_t watermark;
 	/** Current memory consumption. */
 	size_t used;
+	/**
+	 * Time when the last consumer slowed down by
+	 * vy_quota_delay() is allowed to proceed.
+	 */
+	double delay_deadline;
 	/** Used-defined callbacks. */
 	vy_quota_exceeded_f quota_exceeded_cb;
 	vy_quota_throttled_f quota_throttled_cb;
@@ -98,6 +107,7 @@ vy_quota_init(struct vy_quota *q,
 	q->limit = SIZE_MAX;
 	q->watermark = SIZE_MAX;
 	q->used = 0;
+	q->delay_deadline = 0;
 	q->quota_exceeded_cb = quota_exceeded_cb;
 	q->quota_throttled_cb = quota_throttled_cb;
 	q->quota_released_cb = quota_released_cb;
@@ -160,6 +170,39 @@ vy_quota_release(struct vy_quota *q, size_t size)
 		q->quota_released_cb(q);
 }
 
+/**
+ * Return the time, in seconds, the consumer of @size bytes of
+ * memory should wait for, starting at @now, before using quota.
+ *
+ * Once the watermark is exceeded, consumers are slowed down
+ * gradually rather than stalled when the limit is hit. The rate
+ * at which memory is consumed falls from infinity at the watermark
+ * to zero at the limit, and equals @dump_bandwidth halfway between:
+ *
+ *   rate = dump_bandwidth * (limit - used) / (used - watermark)
+ *
+ * Consumers share the deadline, like vy_run_throttle does, so it
+ * is the total rate of all of them that is limited, not the rate
+ * of each one. The time a consumer adds to the deadline is capped
+ * by VY_QUOTA_DELAY_MAX: close to the limit it is better to wait
+ * for memory to be released, which is what vy_quota_use() does.
+ */
+static inline double
+vy_quota_delay(struct vy_quota *q, size_t size, int64_t dump_bandwidth,
+	       double now)
+{
+	if (q->used <= q->watermark || q->used >= q->limit ||
+	    dump_bandwidth <= 0)
+		return 0;
+	double delay = (double)size * (q->used - q->watermark) /
+		       (q->limit - q->used) / dump_bandwidth;
+	if (q->delay_deadline < now)
+		q->delay_deadline = now;
+	q->delay_deadline += delay < VY_QUOTA_DELAY_MAX ?
+			     delay : VY_QUOTA_DELAY_MAX;
+	return q->delay_deadline - now;
+}
+
 /**
  * Try to consume @size bytes of memory, throttle the caller
  * if the limit is exceeded. @timeout specifies the maximal
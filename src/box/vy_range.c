@@ -265,6 +265,21 @@ vy_range_remove_slice(struct vy_range *range, struct vy_slice *slice)
 	vy_disk_stmt_counter_sub(&range->count, &slice->count);
 }
 
+/**
+ * Return true if slice @next continues slice @prev, i.e. the two
+ * slices were written by different parts of the same partitioned
+ * compaction task. Such slices are adjacent by key and contain
+ * data of the same age, so they are treated as one run.
+ */
+static bool
+vy_slice_is_chained(struct vy_slice *prev, struct vy_slice *next,
+		    const struct key_def *cmp_def)
+{
+	return prev->end != NULL && next->begin != NULL &&
+	       prev->run->dump_lsn == next->run->dump_lsn &&
+	       vy_key_compare(prev->end, next->begin, cmp_def) == 0;
+}
+
 /**
  * To reduce write amplification caused by compaction, we follow
  * the LSM tree design. Runs in each range are divided into groups
@@ -297,7 +312,11 @@ vy_range_update_compact_priority(struct vy_range *range,
 
 	range->compact_priority = 0;
 
-	/* Total number of checked runs. */
+	/*
+	 * Total number of checked runs. Runs chained together
+	 * are counted separately here so that compaction never
+	 * takes only some of them.
+	 */
 	uint32_t total_run_count = 0;
 	/* The total size of runs checked so far. */
 	uint64_t total_size = 0;
@@ -313,9 +332,22 @@ vy_range_update_compact_priority(struct vy_range *range,
 	 */
 	uint64_t target_run_size = 0;
 
-	struct vy_slice *slice;
-	rlist_foreach_entry(slice, &range->slices, in_range) {
-		uint64_t size = slice->count.bytes_compressed;
+	struct vy_slice *slice = rlist_first_entry(&range->slices,
+						   struct vy_slice, in_range);
+	while (&slice->in_range != &range->slices) {
+		/*
+		 * Runs written by a partitioned compaction are
+		 * accounted as one run, see vy_slice_is_chained().
+		 */
+		uint64_t size = 0;
+		struct vy_slice *prev;
+		do {
+			size += slice->count.bytes_compressed;
+			total_run_count++;
+			prev = slice;
+			slice = rlist_next_entry(slice, in_range);
+		} while (&slice->in_range != &range->slices &&
+			 vy_slice_is_chained(prev, slice, range->cmp_def));
 		/*
 		 * The size of the first level is defined by
 		 * the size of the most recent run.
@@ -324,7 +356,6 @@ vy_range_update_compact_priority(struct vy_range *range,
 			target_run_size = size;
 		total_size += size;
 		level_run_count++;
-		total_run_count++;
 		while (size > target_run_size) {
 			/*
 			 * The run size exceeds the threshold
@@ -394,10 +425,35 @@ vy_range_needs_split(struct vy_range *range, const struct index_opts *opts,
 	assert(!rlist_empty(&range->slices));
 	slice = rlist_last_entry(&range->slices, struct vy_slice, in_range);
 
+	/*
+	 * The oldest run may consist of several chained slices
+	 * if it was written by a partitioned compaction. Then
+	 * split the range at the boundary of the middle slice.
+	 */
+	int64_t size = slice->count.bytes_compressed;
+	int chain_length = 1;
+	struct vy_slice *prev = slice;
+	while (prev != rlist_first_entry(&range->slices,
+					 struct vy_slice, in_range)) {
+		prev = rlist_prev_entry(prev, in_range);
+		if (!vy_slice_is_chained(prev, slice, range->cmp_def))
+			break;
+		size += prev->count.bytes_compressed;
+		chain_length++;
+		slice = prev;
+	}
+
 	/* The range is too small to be split. */
-	if (slice->count.bytes_compressed < opts->range_size * 4 / 3)
+	if (size < opts->range_size * 4 / 3)
 		return false;
 
+	if (chain_length > 1) {
+		for (int i = 0; i < chain_length / 2; i++)
+			slice = rlist_next_entry(slice, in_range);
+		*p_split_key = tuple_data(slice->begin);
+		return true;
+	}
+
 	/* Find the median key in the oldest run (approximately). */
 	struct vy_page_info *mid_page;
 	mid_page = vy_run_page_info(slice->run, slice->first_page_no +
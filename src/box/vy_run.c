@@ -36,12 +36,15 @@
 #include "fiber_cond.h"
 #include "fio.h"
 #include "cbus.h"
+#include "clock.h"
 #include "memory.h"
 
 #include "replication.h"
 #include "tuple_hash.h" /* for bloom filter */
+#include <pmatomic.h>
 #include "xlog.h"
 #include "xrow.h"
+#include "tt_pthread.h"
 
 static const uint64_t vy_page_info_key_map = (1 << VY_PAGE_INFO_OFFSET) |
 					     (1 << VY_PAGE_INFO_SIZE) |
@@ -56,7 +59,12 @@ static const uint64_t vy_run_info_key_map = (1 << VY_RUN_INFO_MIN_KEY) |
 					    (1 << VY_RUN_INFO_MAX_LSN) |
 					    (1 << VY_RUN_INFO_PAGE_COUNT);
 
-enum { VY_BLOOM_VERSION = 0 };
+enum {
+	/** Bloom filter of full keys. */
+	VY_BLOOM_VERSION_FULL_KEY = 0,
+	/** Bloom filter of full keys and all their prefixes. */
+	VY_BLOOM_VERSION = 1,
+};
 
 /** xlog meta type for .run files */
 #define XLOG_META_TYPE_RUN "RUN"
@@ -161,6 +169,272 @@ vy_run_env_stop_readers(struct vy_run_env *env)
 	free(env->reader_pool);
 }
 
+/** {{{ Page cache */
+
+/** Page cache lookup key. */
+struct vy_page_cache_key {
+	int64_t run_id;
+	uint32_t page_no;
+};
+
+static inline uint32_t
+vy_page_cache_hash(int64_t run_id, uint32_t page_no)
+{
+	uint64_t h = (uint64_t)run_id * 0x9E3779B97F4A7C15ULL;
+	return (uint32_t)(h >> 32) ^ page_no;
+}
+
+typedef struct vy_page *vy_page_ptr;
+
+#define mh_name _vy_page
+#define mh_key_t const struct vy_page_cache_key *
+#define mh_node_t vy_page_ptr
+#define mh_arg_t void *
+#define mh_hash(a, arg) vy_page_cache_hash((*(a))->run_id, (*(a))->page_no)
+#define mh_hash_key(a, arg) vy_page_cache_hash((a)->run_id, (a)->page_no)
+#define mh_cmp(a, b, arg) ((*(a))->run_id != (*(b))->run_id || \
+			   (*(a))->page_no != (*(b))->page_no)
+#define mh_cmp_key(a, b, arg) ((a)->run_id != (*(b))->run_id || \
+			       (a)->page_no != (*(b))->page_no)
+#define MH_SOURCE 1
+#include "salad/mhash.h"
+
+static void
+vy_page_delete(struct vy_page *page);
+
+/** Memory occupied by a page. */
+static inline size_t
+vy_page_mem_used(struct vy_page *page)
+{
+	return sizeof(*page) + page->unpacked_size +
+	       page->row_count * sizeof(uint32_t);
+}
+
+static void
+vy_page_cache_create(struct vy_page_cache *cache)
+{
+	memset(cache, 0, sizeof(*cache));
+	cache->hash = mh_vy_page_new();
+	if (cache->hash == NULL)
+		panic("failed to allocate vinyl page cache");
+	rlist_create(&cache->lru);
+	tt_pthread_mutex_init(&cache->mutex, NULL);
+}
+
+/**
+ * Remove a page from the cache and drop the cache reference.
+ * Returns true if the page must be deleted by the caller,
+ * after the cache mutex is released.
+ */
+static bool
+vy_page_cache_remove(struct vy_page_cache *cache, struct vy_page *page)
+{
+	struct vy_page_cache_key key = { page->run_id, page->page_no };
+	mh_int_t k = mh_vy_page_find(cache->hash, &key, NULL);
+	assert(k != mh_end(cache->hash));
+	mh_vy_page_del(cache->hash, k, NULL);
+	rlist_del_entry(page, in_lru);
+	page->in_cache = false;
+	cache->mem_used -= vy_page_mem_used(page);
+	cache->page_count--;
+	return --page->refs == 0;
+}
+
+static void
+vy_page_cache_destroy(struct vy_page_cache *cache)
+{
+	struct vy_page *page, *tmp;
+	rlist_foreach_entry_safe(page, &cache->lru, in_lru, tmp) {
+		/* Iterators are closed by now. */
+		if (vy_page_cache_remove(cache, page))
+			vy_page_delete(page);
+	}
+	mh_vy_page_delete(cache->hash);
+	tt_pthread_mutex_destroy(&cache->mutex);
+}
+
+/**
+ * Evict least recently used pages until the cache fits in
+ * its quota. Pages, which are still read by iterators, are
+ * freed when the last iterator releases them.
+ */
+static void
+vy_page_cache_evict(struct vy_page_cache *cache, struct rlist *garbage)
+{
+	while (cache->mem_used > cache->mem_quota) {
+		assert(!rlist_empty(&cache->lru));
+		struct vy_page *page = rlist_last_entry(&cache->lru,
+							struct vy_page, in_lru);
+		cache->evict_count++;
+		if (vy_page_cache_remove(cache, page))
+			rlist_add_entry(garbage, page, in_lru);
+	}
+}
+
+/**
+ * Look up a page in the cache. On success, the page is
+ * referenced and must be released with vy_page_cache_release().
+ */
+static struct vy_page *
+vy_page_cache_get(struct vy_page_cache *cache, int64_t run_id,
+		  uint32_t page_no)
+{
+	struct vy_page *page = NULL;
+	struct vy_page_cache_key key = { run_id, page_no };
+	tt_pthread_mutex_lock(&cache->mutex);
+	mh_int_t k = mh_vy_page_find(cache->hash, &key, NULL);
+	if (k != mh_end(cache->hash)) {
+		page = *mh_vy_page_node(cache->hash, k);
+		rlist_move_entry(&cache->lru, page, in_lru);
+		page->refs++;
+	}
+	tt_pthread_mutex_unlock(&cache->mutex);
+	return page;
+}
+
+/**
+ * Add a page just read from disk to the cache. If the cache
+ * is disabled or a concurrent reader has already cached the
+ * same page, the page stays private to the caller.
+ */
+static void
+vy_page_cache_put(struct vy_page_cache *cache, struct vy_page *page)
+{
+	assert(!page->in_cache);
+	struct vy_page_cache_key key = { page->run_id, page->page_no };
+	RLIST_HEAD(garbage);
+	tt_pthread_mutex_lock(&cache->mutex);
+	if (vy_page_mem_used(page) <= cache->mem_quota &&
+	    mh_vy_page_find(cache->hash, &key, NULL) == mh_end(cache->hash) &&
+	    /* Caching is optional, ignore OOM. */
+	    mh_vy_page_put(cache->hash, &page, NULL,
+			   NULL) != mh_end(cache->hash)) {
+		rlist_add_entry(&cache->lru, page, in_lru);
+		page->in_cache = true;
+		page->refs++;
+		cache->mem_used += vy_page_mem_used(page);
+		cache->page_count++;
+		vy_page_cache_evict(cache, &garbage);
+	}
+	tt_pthread_mutex_unlock(&cache->mutex);
+	struct vy_page *victim, *tmp;
+	rlist_foreach_entry_safe(victim, &garbage, in_lru, tmp)
+		vy_page_delete(victim);
+}
+
+/**
+ * Remove all pages of a run from the cache. Called when
+ * the run is deleted, since its pages can't be read any more.
+ */
+static void
+vy_page_cache_remove_run(struct vy_page_cache *cache, int64_t run_id,
+			 uint32_t page_count)
+{
+	RLIST_HEAD(garbage);
+	tt_pthread_mutex_lock(&cache->mutex);
+	for (uint32_t page_no = 0; page_no < page_count &&
+	     cache->page_count > 0; page_no++) {
+		struct vy_page_cache_key key = { run_id, page_no };
+		mh_int_t k = mh_vy_page_find(cache->hash, &key, NULL);
+		if (k == mh_end(cache->hash))
+			continue;
+		struct vy_page *page = *mh_vy_page_node(cache->hash, k);
+		if (vy_page_cache_remove(cache, page))
+			rlist_add_entry(&garbage, page, in_lru);
+	}
+	tt_pthread_mutex_unlock(&cache->mutex);
+	struct vy_page *page, *tmp;
+	rlist_foreach_entry_safe(page, &garbage, in_lru, tmp)
+		vy_page_delete(page);
+}
+
+/** Release a page returned by vy_page_cache_get() or vy_page_new(). */
+static void
+vy_page_cache_release(struct vy_page_cache *cache, struct vy_page *page)
+{
+	tt_pthread_mutex_lock(&cache->mutex);
+	assert(page->refs > 0);
+	bool is_garbage = --page->refs == 0;
+	tt_pthread_mutex_unlock(&cache->mutex);
+	if (is_garbage) {
+		assert(!page->in_cache);
+		vy_page_delete(page);
+	}
+}
+
+void
+vy_run_env_set_page_cache(struct vy_run_env *env, size_t quota)
+{
+	struct vy_page_cache *cache = &env->page_cache;
+	RLIST_HEAD(garbage);
+	tt_pthread_mutex_lock(&cache->mutex);
+	cache->mem_quota = quota;
+	vy_page_cache_evict(cache, &garbage);
+	tt_pthread_mutex_unlock(&cache->mutex);
+	struct vy_page *page, *tmp;
+	rlist_foreach_entry_safe(page, &garbage, in_lru, tmp)
+		vy_page_delete(page);
+}
+
+/** }}} Page cache */
+
+/** {{{ Write throttling */
+
+static void
+vy_run_throttle_create(struct vy_run_throttle *throttle)
+{
+	tt_pthread_mutex_init(&throttle->mutex, NULL);
+	throttle->rate = 0;
+	throttle->deadline = 0;
+}
+
+static void
+vy_run_throttle_destroy(struct vy_run_throttle *throttle)
+{
+	tt_pthread_mutex_destroy(&throttle->mutex);
+}
+
+void
+vy_run_throttle_set_rate(struct vy_run_throttle *throttle, double rate)
+{
+	tt_pthread_mutex_lock(&throttle->mutex);
+	throttle->rate = rate;
+	tt_pthread_mutex_unlock(&throttle->mutex);
+}
+
+double
+vy_run_throttle_rate(struct vy_run_throttle *throttle)
+{
+	tt_pthread_mutex_lock(&throttle->mutex);
+	double rate = throttle->rate;
+	tt_pthread_mutex_unlock(&throttle->mutex);
+	return rate;
+}
+
+/**
+ * Account @size bytes written with a throttle and sleep as long
+ * as it takes to write them at the configured rate. Since all
+ * writers share the deadline, their total rate fits in the limit.
+ */
+static void
+vy_run_throttle_consume(struct vy_run_throttle *throttle, size_t size)
+{
+	double delay = 0;
+	tt_pthread_mutex_lock(&throttle->mutex);
+	if (throttle->rate > 0) {
+		double now = clock_monotonic();
+		if (throttle->deadline < now)
+			throttle->deadline = now;
+		throttle->deadline += size / throttle->rate;
+		delay = throttle->deadline - now;
+	}
+	tt_pthread_mutex_unlock(&throttle->mutex);
+	if (delay > 0)
+		fiber_sleep(delay);
+}
+
+/** }}} Write throttling */
+
 /**
  * Initialize vinyl run environment
  */
@@ -171,6 +445,9 @@ vy_run_env_create(struct vy_run_env *env)
 	tt_pthread_key_create(&env->zdctx_key, vy_free_zdctx);
 	mempool_create(&env->read_task_pool, cord_slab_cache(),
 		       sizeof(struct vy_page_read_task));
+	vy_page_cache_create(&env->page_cache);
+	vy_run_throttle_create(&env->dump_throttle);
+	vy_run_throttle_create(&env->compact_throttle);
 }
 
 /**
@@ -183,6 +460,9 @@ vy_run_env_destroy(struct vy_run_env *env)
 		vy_run_env_stop_readers(env);
 	mempool_destroy(&env->read_task_pool);
 	tt_pthread_key_delete(env->zdctx_key);
+	vy_page_cache_destroy(&env->page_cache);
+	vy_run_throttle_destroy(&env->dump_throttle);
+	vy_run_throttle_destroy(&env->compact_throttle);
 }
 
 /**
@@ -213,6 +493,17 @@ vy_page_info_create(struct vy_page_info *page_info, uint64_t offset,
 	return page_info->min_key == NULL ? -1 : 0;
 }
 
+/**
+ * Destroy the bloom filter of a page if any.
+ */
+static void
+vy_page_info_destroy_bloom(struct vy_page_info *page_info)
+{
+	if (page_info->has_bloom)
+		bloom_destroy(&page_info->bloom, NULL);
+	page_info->has_bloom = false;
+}
+
 /**
  * Destroy page info struct
  */
@@ -221,6 +512,7 @@ vy_page_info_destroy(struct vy_page_info *page_info)
 {
 	if (page_info->min_key != NULL)
 		free(page_info->min_key);
+	vy_page_info_destroy_bloom(page_info);
 }
 
 struct vy_run *
@@ -242,9 +534,51 @@ vy_run_new(int64_t id)
 	return run;
 }
 
+/**
+ * Total size of page bloom filters of all runs. Runs are
+ * written by worker threads, so it's updated atomically.
+ */
+static size_t vy_page_bloom_size;
+
+size_t
+vy_run_page_bloom_size(void)
+{
+	return pm_atomic_load(&vy_page_bloom_size);
+}
+
+/**
+ * Charge the page bloom filters of a run to runtime.quota.
+ * Called once all pages of the run have been created.
+ */
+static int
+vy_run_use_page_bloom_quota(struct vy_run *run)
+{
+	assert(run->page_bloom_size == 0);
+	size_t size = 0;
+	for (uint32_t i = 0; i < run->info.page_count; i++) {
+		struct vy_page_info *page = &run->page_info[i];
+		if (page->has_bloom)
+			size += bloom_store_size(&page->bloom);
+	}
+	if (size == 0)
+		return 0;
+	if (quota_use(runtime.quota, size) < 0) {
+		diag_set(OutOfMemory, size, "runtime", "page bloom filters");
+		return -1;
+	}
+	run->page_bloom_size = size;
+	pm_atomic_fetch_add(&vy_page_bloom_size, size);
+	return 0;
+}
+
 static void
 vy_run_clear(struct vy_run *run)
 {
+	if (run->page_bloom_size > 0) {
+		quota_release(runtime.quota, run->page_bloom_size);
+		pm_atomic_fetch_sub(&vy_page_bloom_size, run->page_bloom_size);
+		run->page_bloom_size = 0;
+	}
 	if (run->page_info != NULL) {
 		uint32_t page_no;
 		for (page_no = 0; page_no < run->info.page_count; ++page_no)
@@ -256,6 +590,7 @@ vy_run_clear(struct vy_run *run)
 	if (run->info.has_bloom)
 		bloom_destroy(&run->info.bloom, runtime.quota);
 	run->info.has_bloom = false;
+	run->info.has_prefix_bloom = false;
 	free(run->info.min_key);
 	run->info.min_key = NULL;
 	free(run->info.max_key);
@@ -268,6 +603,9 @@ vy_run_delete(struct vy_run *run)
 	assert(run->refs == 0);
 	if (run->fd >= 0 && close(run->fd) < 0)
 		say_syserror("close failed");
+	if (run->page_cache != NULL)
+		vy_page_cache_remove_run(run->page_cache, run->id,
+					 run->info.page_count);
 	vy_run_clear(run);
 	TRASH(run);
 	free(run);
@@ -466,6 +804,62 @@ vy_slice_cut(struct vy_slice *slice, int64_t id,
 	return 0;
 }
 
+/**
+ * Read bloom filter from given buffer.
+ * @param bloom - a bloom filter to read.
+ * @param[out] has_prefix - set if the filter stores hashes of
+ *  key prefixes, see vy_run_info::has_prefix_bloom. May be NULL.
+ * @param buffer[in/out] - a buffer to read from.
+ *  The pointer is incremented on the number of bytes read.
+ * @param quota - quota for memory allocation, may be NULL.
+ * @param filename Filename for error reporting.
+ * @return - 0 on success or -1 on format/memory error
+ */
+static int
+vy_run_bloom_decode(struct bloom *bloom, bool *has_prefix,
+		    const char **buffer, struct quota *quota,
+		    const char *filename)
+{
+	const char **pos = buffer;
+	memset(bloom, 0, sizeof(*bloom));
+	uint32_t array_size = mp_decode_array(pos);
+	if (array_size != 4) {
+		diag_set(ClientError, ER_INVALID_INDEX_FILE, filename,
+			 tt_sprintf("Can't decode bloom meta: "
+				    "wrong array size (expected %d, got %u)",
+				    4, (unsigned)array_size));
+		return -1;
+	}
+	uint64_t version = mp_decode_uint(pos);
+	if (version != VY_BLOOM_VERSION &&
+	    version != VY_BLOOM_VERSION_FULL_KEY) {
+		diag_set(ClientError, ER_INVALID_INDEX_FILE, filename,
+			 tt_sprintf("Can't decode bloom meta: "
+				    "wrong version (expected %d, got %u)",
+				    VY_BLOOM_VERSION, (unsigned)version));
+		return -1;
+	}
+	if (has_prefix != NULL)
+		*has_prefix = version != VY_BLOOM_VERSION_FULL_KEY;
+	bloom->table_size = mp_decode_uint(pos);
+	bloom->hash_count = mp_decode_uint(pos);
+	size_t table_size = mp_decode_binl(pos);
+	if (table_size != bloom_store_size(bloom)) {
+		diag_set(ClientError, ER_INVALID_INDEX_FILE, filename,
+			 tt_sprintf("Can't decode bloom meta: "
+				    "wrong table size (expected %zu, got %zu)",
+				    bloom_store_size(bloom), table_size));
+		return -1;
+	}
+	if (bloom_load_table(bloom, *pos, quota) != 0) {
+		diag_set(OutOfMemory, bloom_store_size(bloom),
+			 "bloom_load_table", "bloom");
+		return -1;
+	}
+	*pos += table_size;
+	return 0;
+}
+
 /**
  * Decode page information from xrow.
  *
@@ -513,6 +907,13 @@ vy_page_info_decode(struct vy_page_info *page, const struct xrow_header *xrow,
 		case VY_PAGE_INFO_ROW_INDEX_OFFSET:
 			page->row_index_offset = mp_decode_uint(&pos);
 			break;
+		case VY_PAGE_INFO_BLOOM:
+			/* See vy_run_use_page_bloom_quota(). */
+			if (vy_run_bloom_decode(&page->bloom, NULL, &pos,
+						NULL, filename) != 0)
+				return -1;
+			page->has_bloom = true;
+			break;
 		default:
 			diag_set(ClientError, ER_INVALID_INDEX_FILE, filename,
 				 tt_sprintf("Can't decode page info: "
@@ -532,53 +933,6 @@ vy_page_info_decode(struct vy_page_info *page, const struct xrow_header *xrow,
 	return 0;
 }
 
-/**
- * Read bloom filter from given buffer.
- * @param bloom - a bloom filter to read.
- * @param buffer[in/out] - a buffer to read from.
- *  The pointer is incremented on the number of bytes read.
- * @param filename Filename for error reporting.
- * @return - 0 on success or -1 on format/memory error
- */
-static int
-vy_run_bloom_decode(struct bloom *bloom, const char **buffer,
-		    const char *filename)
-{
-	const char **pos = buffer;
-	memset(bloom, 0, sizeof(*bloom));
-	uint32_t array_size = mp_decode_array(pos);
-	if (array_size != 4) {
-		diag_set(ClientError, ER_INVALID_INDEX_FILE, filename,
-			 tt_sprintf("Can't decode bloom meta: "
-				    "wrong array size (expected %d, got %u)",
-				    4, (unsigned)array_size));
-		return -1;
-	}
-	uint64_t version = mp_decode_uint(pos);
-	if (version != VY_BLOOM_VERSION) {
-		diag_set(ClientError, ER_INVALID_INDEX_FILE, filename,
-			 tt_sprintf("Can't decode bloom meta: "
-				    "wrong version (expected %d, got %u)",
-				    VY_BLOOM_VERSION, (unsigned)version));
-	}
-	bloom->table_size = mp_decode_uint(pos);
-	bloom->hash_count = mp_decode_uint(pos);
-	size_t table_size = mp_decode_binl(pos);
-	if (table_size != bloom_store_size(bloom)) {
-		diag_set(ClientError, ER_INVALID_INDEX_FILE, filename,
-			 tt_sprintf("Can't decode bloom meta: "
-				    "wrong table size (expected %zu, got %zu)",
-				    bloom_store_size(bloom), table_size));
-		return -1;
-	}
-	if (bloom_load_table(bloom, *pos, runtime.quota) != 0) {
-		diag_set(OutOfMemory, bloom_store_size(bloom), "mmap", "bloom");
-		return -1;
-	}
-	*pos += table_size;
-	return 0;
-}
-
 /**
  * Decode the run metadata from xrow.
  *
@@ -631,7 +985,9 @@ vy_run_info_decode(struct vy_run_info *run_info,
 			run_info->page_count = mp_decode_uint(&pos);
 			break;
 		case VY_RUN_INFO_BLOOM:
-			if (vy_run_bloom_decode(&run_info->bloom, &pos,
+			if (vy_run_bloom_decode(&run_info->bloom,
+						&run_info->has_prefix_bloom,
+						&pos, runtime.quota,
 						filename) == 0)
 				run_info->has_bloom = true;
 			else
@@ -664,6 +1020,9 @@ vy_page_new(const struct vy_page_info *page_info)
 			 "load_page", "page cache");
 		return NULL;
 	}
+	page->refs = 1;
+	page->in_cache = false;
+	rlist_create(&page->in_lru);
 	page->unpacked_size = page_info->unpacked_size;
 	page->row_count = page_info->row_count;
 	page->row_index = calloc(page_info->row_count, sizeof(uint32_t));
@@ -778,14 +1137,13 @@ vy_run_iterator_cache_touch(struct vy_run_iterator *itr, uint32_t page_no)
  * Put page to LRU cache
  */
 static void
-vy_run_iterator_cache_put(struct vy_run_iterator *itr, struct vy_page *page,
-			  uint32_t page_no)
+vy_run_iterator_cache_put(struct vy_run_iterator *itr, struct vy_page *page)
 {
 	if (itr->prev_page != NULL)
-		vy_page_delete(itr->prev_page);
+		vy_page_cache_release(&itr->run_env->page_cache,
+				      itr->prev_page);
 	itr->prev_page = itr->curr_page;
 	itr->curr_page = page;
-	page->page_no = page_no;
 }
 
 /**
@@ -800,9 +1158,10 @@ vy_run_iterator_cache_clean(struct vy_run_iterator *itr)
 		itr->curr_stmt_pos.page_no = UINT32_MAX;
 	}
 	if (itr->curr_page != NULL) {
-		vy_page_delete(itr->curr_page);
+		struct vy_page_cache *cache = &itr->run_env->page_cache;
+		vy_page_cache_release(cache, itr->curr_page);
 		if (itr->prev_page != NULL)
-			vy_page_delete(itr->prev_page);
+			vy_page_cache_release(cache, itr->prev_page);
 		itr->curr_page = itr->prev_page = NULL;
 	}
 }
@@ -972,11 +1331,24 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 	if (*result != NULL)
 		return 0;
 
+	/* Check the page cache shared by all iterators. */
+	struct vy_page *page = vy_page_cache_get(&env->page_cache,
+						 slice->run->id, page_no);
+	if (page != NULL) {
+		itr->stat->page_cache_hit++;
+		vy_run_iterator_cache_put(itr, page);
+		*result = page;
+		return 0;
+	}
+	itr->stat->page_cache_miss++;
+
 	/* Allocate buffers */
 	struct vy_page_info *page_info = vy_run_page_info(slice->run, page_no);
-	struct vy_page *page = vy_page_new(page_info);
+	page = vy_page_new(page_info);
 	if (page == NULL)
 		return -1;
+	page->run_id = slice->run->id;
+	page->page_no = page_no;
 
 	/* Read page data from the disk */
 	int rc;
@@ -1043,7 +1415,9 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 	assert(vy_run_iterator_cache_get(itr, page_no) == NULL);
 
 	/* Update cache */
-	vy_run_iterator_cache_put(itr, page, page_no);
+	slice->run->page_cache = &env->page_cache;
+	vy_page_cache_put(&env->page_cache, page);
+	vy_run_iterator_cache_put(itr, page);
 
 	/* Update read statistics. */
 	itr->stat->read.rows += page_info->row_count;
@@ -1123,22 +1497,35 @@ vy_run_iterator_search_in_page(struct vy_run_iterator *itr,
  * Additionally *equal_key argument is set to true if the found value is
  * equal to given key (untouched otherwise)
  *
+ * If @a bloom_hash is not NULL, it is the hash of the EQ search key
+ * used for checking the bloom filter of the page that may contain the
+ * key, so that the page isn't read if it definitely doesn't.
+ *
  * @retval 0 success
+ * @retval 1 the key is absent according to the page bloom filter
  * @retval -1 read or memory error
  */
 static NODISCARD int
 vy_run_iterator_search(struct vy_run_iterator *itr,
 		       enum iterator_type iterator_type,
-		       const struct tuple *key,
+		       const struct tuple *key, const uint32_t *bloom_hash,
 		       struct vy_run_iterator_pos *pos, bool *equal_key)
 {
-	pos->page_no = vy_page_index_find_page(itr->slice->run, key,
-					       itr->cmp_def, iterator_type,
-					       equal_key);
-	if (pos->page_no == itr->slice->run->info.page_count) {
+	struct vy_run *run = itr->slice->run;
+	pos->page_no = vy_page_index_find_page(run, key, itr->cmp_def,
+					       iterator_type, equal_key);
+	if (pos->page_no == run->info.page_count) {
 		itr->search_ended = true;
 		return 0;
 	}
+	/*
+	 * If no page starts with the key, all statements
+	 * matching it must be stored in the found page.
+	 */
+	struct vy_page_info *page_info = vy_run_page_info(run, pos->page_no);
+	if (bloom_hash != NULL && !*equal_key && page_info->has_bloom &&
+	    !bloom_possible_has(&page_info->bloom, *bloom_hash))
+		return 1;
 	struct vy_page *page;
 	int rc = vy_run_iterator_load_page(itr, pos->page_no, &page);
 	if (rc != 0)
@@ -1313,6 +1700,40 @@ vy_run_iterator_find_lsn(struct vy_run_iterator *itr,
 	return 0;
 }
 
+/**
+ * Calculate the hash of a search key for looking it up in
+ * the run bloom filters.
+ *
+ * @retval true the hash is stored in @a hash
+ * @retval false bloom filters can't be used for the key
+ */
+static bool
+vy_run_iterator_bloom_hash(struct vy_run_iterator *itr,
+			   const struct tuple *key, uint32_t *hash)
+{
+	const struct vy_run_info *info = &itr->slice->run->info;
+	const struct key_def *key_def = itr->key_def;
+	if (!info->has_bloom)
+		return false;
+	uint32_t part_count = tuple_field_count(key);
+	if (vy_stmt_type(key) != IPROTO_SELECT) {
+		if (part_count < key_def->part_count)
+			return false;
+		*hash = tuple_hash(key, key_def);
+		return true;
+	}
+	const char *data = tuple_data(key);
+	mp_decode_array(&data);
+	if (part_count >= key_def->part_count) {
+		*hash = key_hash(data, key_def);
+		return true;
+	}
+	if (part_count == 0 || !info->has_prefix_bloom)
+		return false;
+	*hash = key_hash_prefix(data, key_def, part_count);
+	return true;
+}
+
 /*
  * FIXME: vy_run_iterator_next_key() calls vy_run_iterator_start() which
  * recursivly calls vy_run_iterator_next_key().
@@ -1338,22 +1759,13 @@ vy_run_iterator_start_from(struct vy_run_iterator *itr,
 	itr->search_started = true;
 	*ret = NULL;
 
-	const struct key_def *key_def = itr->key_def;
-	bool is_full_key = (tuple_field_count(key) >= key_def->part_count);
-	if (run->info.has_bloom && iterator_type == ITER_EQ && is_full_key) {
-		uint32_t hash;
-		if (vy_stmt_type(key) == IPROTO_SELECT) {
-			const char *data = tuple_data(key);
-			mp_decode_array(&data);
-			hash = key_hash(data, key_def);
-		} else {
-			hash = tuple_hash(key, key_def);
-		}
-		if (!bloom_possible_has(&run->info.bloom, hash)) {
-			itr->search_ended = true;
-			itr->stat->bloom_hit++;
-			return 0;
-		}
+	uint32_t hash;
+	bool use_bloom = iterator_type == ITER_EQ &&
+			 vy_run_iterator_bloom_hash(itr, key, &hash);
+	if (use_bloom && !bloom_possible_has(&run->info.bloom, hash)) {
+		itr->search_ended = true;
+		itr->stat->bloom_hit++;
+		return 0;
 	}
 
 	itr->stat->lookup++;
@@ -1382,9 +1794,16 @@ vy_run_iterator_start_from(struct vy_run_iterator *itr,
 	int rc;
 	if (tuple_field_count(key) > 0) {
 		rc = vy_run_iterator_search(itr, iterator_type, key,
+					    use_bloom ? &hash : NULL,
 					    &itr->curr_pos, &equal_found);
-		if (rc != 0)
+		if (rc < 0)
 			return rc;
+		if (rc > 0) {
+			vy_run_iterator_cache_clean(itr);
+			itr->search_ended = true;
+			itr->stat->bloom_hit++;
+			return 0;
+		}
 	} else if (iterator_type == ITER_LE) {
 		itr->curr_pos = end_pos;
 	} else {
@@ -1395,7 +1814,7 @@ vy_run_iterator_start_from(struct vy_run_iterator *itr,
 	if (iterator_type == ITER_EQ && !equal_found) {
 		vy_run_iterator_cache_clean(itr);
 		itr->search_ended = true;
-		if (run->info.has_bloom && is_full_key)
+		if (use_bloom)
 			itr->stat->bloom_miss++;
 		return 0;
 	}
@@ -1884,6 +2303,8 @@ vy_run_recover(struct vy_run *run, const char *dir,
 		}
 		vy_run_acct_page(run, page);
 	}
+	if (vy_run_use_page_bloom_quota(run) != 0)
+		goto fail_close;
 
 	/* We don't need to keep metadata file open any longer. */
 	xlog_cursor_close(&cursor, false);
@@ -1973,6 +2394,64 @@ vy_row_index_encode(const uint32_t *row_index, uint32_t row_count,
 	return 0;
 }
 
+/**
+ * Calculate hashes of a statement key and all its prefixes
+ * to be stored in bloom filters, see vy_run_info::has_prefix_bloom.
+ *
+ * @param stmt statement to hash
+ * @param key_def key definition of the index
+ * @param[out] hashes array of key_def->part_count hashes
+ */
+static void
+vy_stmt_bloom_hash(const struct tuple *stmt, const struct key_def *key_def,
+		   uint32_t *hashes)
+{
+	hashes[0] = tuple_hash(stmt, key_def);
+	for (uint32_t i = 1; i < key_def->part_count; i++)
+		hashes[i] = tuple_hash_prefix(stmt, key_def, i);
+}
+
+/**
+ * Same as vy_stmt_bloom_hash(), but takes a raw key.
+ */
+static void
+vy_key_bloom_hash(const char *key, const struct key_def *key_def,
+		  uint32_t *hashes)
+{
+	mp_decode_array(&key);
+	hashes[0] = key_hash(key, key_def);
+	for (uint32_t i = 1; i < key_def->part_count; i++)
+		hashes[i] = key_hash_prefix(key, key_def, i);
+}
+
+/**
+ * Create the bloom filter of a page from hashes of
+ * the page keys. The filter is charged to the quota
+ * by vy_run_use_page_bloom_quota().
+ *
+ * @param page page information
+ * @param hashes hashes of the keys stored in the page
+ * @param hash_count number of hashes
+ * @param bloom_fpr desired false positive rate
+ * @retval 0 for success
+ * @retval -1 for error
+ */
+static int
+vy_page_info_create_bloom(struct vy_page_info *page, const uint32_t *hashes,
+			  uint32_t hash_count, double bloom_fpr)
+{
+	assert(!page->has_bloom);
+	if (bloom_create_compact(&page->bloom, hash_count,
+				 bloom_fpr, NULL) != 0) {
+		diag_set(OutOfMemory, 0, "bloom_create_compact", "bloom");
+		return -1;
+	}
+	for (uint32_t i = 0; i < hash_count; i++)
+		bloom_add(&page->bloom, hashes[i]);
+	page->has_bloom = true;
+	return 0;
+}
+
 /**
  * Helper to extend run page info array
  */
@@ -2005,7 +2484,7 @@ static int
 vy_run_write_page(struct vy_run *run, struct xlog *data_xlog,
 		  struct vy_stmt_stream *wi, struct tuple **curr_stmt,
 		  uint64_t page_size, struct bloom_spectrum *bs,
-		  const struct key_def *cmp_def,
+		  double bloom_fpr, const struct key_def *cmp_def,
 		  const struct key_def *key_def, bool is_primary,
 		  uint32_t *page_info_capacity)
 {
@@ -2021,6 +2500,9 @@ vy_run_write_page(struct vy_run *run, struct xlog *data_xlog,
 	/* row offsets accumulator */
 	struct ibuf row_index_buf;
 	ibuf_create(&row_index_buf, &cord()->slabc, sizeof(uint32_t) * 4096);
+	/* key hashes accumulator for the page bloom filter */
+	struct ibuf bloom_hash_buf;
+	ibuf_create(&bloom_hash_buf, &cord()->slabc, sizeof(uint32_t) * 4096);
 
 	if (run->info.page_count >= *page_info_capacity &&
 	    vy_run_alloc_page_info(run, page_info_capacity) != 0)
@@ -2058,7 +2540,17 @@ vy_run_write_page(struct vy_run *run, struct xlog *data_xlog,
 				     cmp_def, is_primary) != 0)
 			goto error_rollback;
 
-		bloom_spectrum_add(bs, tuple_hash(*curr_stmt, key_def));
+		uint32_t *hashes = (uint32_t *) ibuf_alloc(&bloom_hash_buf,
+				sizeof(uint32_t) * key_def->part_count);
+		if (hashes == NULL) {
+			diag_set(OutOfMemory,
+				 sizeof(uint32_t) * key_def->part_count,
+				 "ibuf", "bloom hashes");
+			goto error_rollback;
+		}
+		vy_stmt_bloom_hash(*curr_stmt, key_def, hashes);
+		for (uint32_t i = 0; i < key_def->part_count; i++)
+			bloom_spectrum_add(bs, hashes[i]);
 
 		int64_t lsn = vy_stmt_lsn(*curr_stmt);
 		run->info.min_lsn = MIN(run->info.min_lsn, lsn);
@@ -2128,13 +2620,20 @@ vy_run_write_page(struct vy_run *run, struct xlog *data_xlog,
 	run->info.page_count++;
 	vy_run_acct_page(run, page);
 
+	if (vy_page_info_create_bloom(page, (uint32_t *) bloom_hash_buf.rpos,
+			ibuf_used(&bloom_hash_buf) / sizeof(uint32_t),
+			bloom_fpr) != 0)
+		goto error_row_index;
+
 	ibuf_destroy(&row_index_buf);
+	ibuf_destroy(&bloom_hash_buf);
 	return !end_of_run ? 0: 1;
 
 error_rollback:
 	xlog_tx_rollback(data_xlog);
 error_row_index:
 	ibuf_destroy(&row_index_buf);
+	ibuf_destroy(&bloom_hash_buf);
 	if (last_stmt != NULL)
 		vy_stmt_unref_if_possible(last_stmt);
 	return -1;
@@ -2152,7 +2651,8 @@ vy_run_write_data(struct vy_run *run, const char *dirpath,
 		  struct vy_stmt_stream *wi, uint64_t page_size,
 		  const struct key_def *cmp_def,
 		  const struct key_def *key_def,
-		  size_t max_output_count, double bloom_fpr)
+		  size_t max_output_count, double bloom_fpr,
+		  struct vy_run_throttle *throttle)
 {
 	struct tuple *stmt;
 
@@ -2166,8 +2666,9 @@ vy_run_write_data(struct vy_run *run, const char *dirpath,
 	if (stmt == NULL)
 		goto done;
 
+	/* The bloom filter stores hashes of all key prefixes. */
 	struct bloom_spectrum bs;
-	if (bloom_spectrum_create(&bs, max_output_count,
+	if (bloom_spectrum_create(&bs, max_output_count * key_def->part_count,
 				  bloom_fpr, runtime.quota) != 0) {
 		diag_set(OutOfMemory, 0,
 			 "bloom_spectrum_create", "bloom_spectrum");
@@ -2193,13 +2694,24 @@ vy_run_write_data(struct vy_run *run, const char *dirpath,
 	int rc;
 	do {
 		rc = vy_run_write_page(run, &data_xlog, wi, &stmt,
-				       page_size, &bs, cmp_def, key_def,
-				       iid == 0, &page_info_capacity);
+				       page_size, &bs, bloom_fpr, cmp_def,
+				       key_def, iid == 0, &page_info_capacity);
 		if (rc < 0)
 			goto err_close_xlog;
 		fiber_gc();
+		if (throttle != NULL) {
+			struct vy_page_info *page = run->page_info +
+						    run->info.page_count - 1;
+			vy_run_throttle_consume(throttle, page->size);
+		}
 	} while (rc == 0);
 
+	/* The page bloom filter duplicates the run bloom filter. */
+	if (run->info.page_count == 1)
+		vy_page_info_destroy_bloom(&run->page_info[0]);
+	if (vy_run_use_page_bloom_quota(run) != 0)
+		goto err_close_xlog;
+
 	/* Sync data and link the file to the final name. */
 	if (xlog_sync(&data_xlog) < 0 ||
 	    xlog_rename(&data_xlog) < 0)
@@ -2211,6 +2723,7 @@ vy_run_write_data(struct vy_run *run, const char *dirpath,
 
 	bloom_spectrum_choose(&bs, &run->info.bloom);
 	run->info.has_bloom = true;
+	run->info.has_prefix_bloom = true;
 	bloom_spectrum_destroy(&bs, runtime.quota);
 	done:
 	wi->iface->stop(wi);
@@ -2226,6 +2739,12 @@ vy_run_write_data(struct vy_run *run, const char *dirpath,
 	return -1;
 }
 
+static size_t
+vy_run_bloom_encode_size(const struct bloom *bloom);
+
+char *
+vy_run_bloom_encode(const struct bloom *bloom, char *buffer);
+
 /** {{{ vy_page_info */
 
 /**
@@ -2250,10 +2769,12 @@ vy_page_info_encode(const struct vy_page_info *page_info,
 	mp_next(&tmp);
 	min_key_size = tmp - page_info->min_key;
 
+	uint32_t map_size = page_info->has_bloom ? 7 : 6;
+
 	/* calc tuple size */
 	uint32_t size;
 	/* 3 items: page offset, size, and map */
-	size = mp_sizeof_map(6) +
+	size = mp_sizeof_map(map_size) +
 	       mp_sizeof_uint(VY_PAGE_INFO_OFFSET) +
 	       mp_sizeof_uint(page_info->offset) +
 	       mp_sizeof_uint(VY_PAGE_INFO_SIZE) +
@@ -2266,6 +2787,9 @@ vy_page_info_encode(const struct vy_page_info *page_info,
 	       mp_sizeof_uint(page_info->unpacked_size) +
 	       mp_sizeof_uint(VY_PAGE_INFO_ROW_INDEX_OFFSET) +
 	       mp_sizeof_uint(page_info->row_index_offset);
+	if (page_info->has_bloom)
+		size += mp_sizeof_uint(VY_PAGE_INFO_BLOOM) +
+			vy_run_bloom_encode_size(&page_info->bloom);
 
 	char *pos = region_alloc(region, size);
 	if (pos == NULL) {
@@ -2276,7 +2800,7 @@ vy_page_info_encode(const struct vy_page_info *page_info,
 	memset(xrow, 0, sizeof(*xrow));
 	/* encode page */
 	xrow->body->iov_base = pos;
-	pos = mp_encode_map(pos, 6);
+	pos = mp_encode_map(pos, map_size);
 	pos = mp_encode_uint(pos, VY_PAGE_INFO_OFFSET);
 	pos = mp_encode_uint(pos, page_info->offset);
 	pos = mp_encode_uint(pos, VY_PAGE_INFO_SIZE);
@@ -2290,6 +2814,10 @@ vy_page_info_encode(const struct vy_page_info *page_info,
 	pos = mp_encode_uint(pos, page_info->unpacked_size);
 	pos = mp_encode_uint(pos, VY_PAGE_INFO_ROW_INDEX_OFFSET);
 	pos = mp_encode_uint(pos, page_info->row_index_offset);
+	if (page_info->has_bloom) {
+		pos = mp_encode_uint(pos, VY_PAGE_INFO_BLOOM);
+		pos = vy_run_bloom_encode(&page_info->bloom, pos);
+	}
 	xrow->body->iov_len = (void *)pos - xrow->body->iov_base;
 	xrow->bodycnt = 1;
 
@@ -2456,17 +2984,14 @@ fail:
 	return -1;
 }
 
-/*
- * Create a run file, write statements returned by a write
- * iterator to it, and create an index file.
- */
 int
 vy_run_write(struct vy_run *run, const char *dirpath,
 	     uint32_t space_id, uint32_t iid,
 	     struct vy_stmt_stream *wi, uint64_t page_size,
 	     const struct key_def *cmp_def,
 	     const struct key_def *key_def,
-	     size_t max_output_count, double bloom_fpr)
+	     size_t max_output_count, double bloom_fpr,
+	     struct vy_run_throttle *throttle)
 {
 	ERROR_INJECT(ERRINJ_VY_RUN_WRITE,
 		     {diag_set(ClientError, ER_INJECTION,
@@ -2478,7 +3003,7 @@ vy_run_write(struct vy_run *run, const char *dirpath,
 
 	if (vy_run_write_data(run, dirpath, space_id, iid,
 			      wi, page_size, cmp_def, key_def,
-			      max_output_count, bloom_fpr) != 0)
+			      max_output_count, bloom_fpr, throttle) != 0)
 		return -1;
 
 	if (vy_run_is_empty(run))
@@ -2516,6 +3041,8 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 	int rc = 0;
 	uint32_t page_info_capacity = 0;
 	uint32_t run_row_count = 0;
+	struct ibuf bloom_hash_buf;
+	ibuf_create(&bloom_hash_buf, &cord()->slabc, sizeof(uint32_t) * 4096);
 
 	const char *key = NULL;
 	int64_t max_lsn = 0;
@@ -2547,6 +3074,16 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 						  iid == 0);
 			if (key == NULL)
 				goto close_err;
+			uint32_t *hashes = (uint32_t *) ibuf_alloc(
+				&bloom_hash_buf,
+				sizeof(uint32_t) * key_def->part_count);
+			if (hashes == NULL) {
+				diag_set(OutOfMemory,
+					 sizeof(uint32_t) * key_def->part_count,
+					 "ibuf", "bloom hashes");
+				goto close_err;
+			}
+			vy_key_bloom_hash(key, key_def, hashes);
 			if (run->info.min_key == NULL) {
 				run->info.min_key = vy_key_dup(key);
 				if (run->info.min_key == NULL)
@@ -2570,8 +3107,19 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 		info->row_index_offset = page_row_index_offset;
 		++run->info.page_count;
 		run_row_count += page_row_count;
+		if (vy_page_info_create_bloom(info,
+				(uint32_t *) bloom_hash_buf.rpos,
+				ibuf_used(&bloom_hash_buf) / sizeof(uint32_t),
+				opts->bloom_fpr) != 0)
+			goto close_err;
+		ibuf_reset(&bloom_hash_buf);
 		region_truncate(region, mem_used);
 	}
+	/* The page bloom filter duplicates the run bloom filter. */
+	if (run->info.page_count == 1)
+		vy_page_info_destroy_bloom(&run->page_info[0]);
+	if (vy_run_use_page_bloom_quota(run) != 0)
+		goto close_err;
 
 	if (key != NULL) {
 		run->info.max_key = vy_key_dup(key);
@@ -2582,7 +3130,8 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 	run->info.min_lsn = min_lsn;
 	if (xlog_cursor_reset(&cursor) != 0)
 		goto close_err;
-	if (bloom_create(&run->info.bloom, run_row_count,
+	if (bloom_create(&run->info.bloom,
+			 run_row_count * key_def->part_count,
 			 opts->bloom_fpr, runtime.quota) != 0) {
 		diag_set(OutOfMemory, 0,
 			 "bloom_create", "bloom");
@@ -2597,9 +3146,13 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 						     upsert_format, iid == 0);
 		if (tuple == NULL)
 			goto close_err;
-		bloom_add(&run->info.bloom, tuple_hash(tuple, key_def));
+		uint32_t hashes[key_def->part_count];
+		vy_stmt_bloom_hash(tuple, key_def, hashes);
+		for (uint32_t i = 0; i < key_def->part_count; i++)
+			bloom_add(&run->info.bloom, hashes[i]);
 	}
 	run->info.has_bloom = true;
+	run->info.has_prefix_bloom = true;
 
 	region_truncate(region, mem_used);
 	run->fd = cursor.fd;
@@ -2614,11 +3167,13 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 	}
 	if (vy_run_write_index(run, dir, space_id, iid) != 0)
 		goto close_err;
+	ibuf_destroy(&bloom_hash_buf);
 	return 0;
 close_err:
 	vy_run_clear(run);
 	region_truncate(region, mem_used);
 	xlog_cursor_close(&cursor, false);
+	ibuf_destroy(&bloom_hash_buf);
 	return -1;
 }
 
@@ -2632,18 +3187,30 @@ static NODISCARD int
 vy_slice_stream_read_page(struct vy_slice_stream *stream)
 {
 	assert(stream->page == NULL);
+	struct vy_run *run = stream->slice->run;
+	/*
+	 * Dump and compaction read every page of the slice once,
+	 * so pages read by the stream are not added to the page
+	 * cache, lest they should evict hot pages.
+	 */
+	stream->page = vy_page_cache_get(&stream->run_env->page_cache,
+					 run->id, stream->page_no);
+	if (stream->page != NULL)
+		return 0;
+
 	ZSTD_DStream *zdctx = vy_env_get_zdctx(stream->run_env);
 	if (zdctx == NULL)
 		return -1;
 
-	struct vy_page_info *page_info = vy_run_page_info(stream->slice->run,
+	struct vy_page_info *page_info = vy_run_page_info(run,
 							  stream->page_no);
 	stream->page = vy_page_new(page_info);
 	if (stream->page == NULL)
 		return -1;
+	stream->page->run_id = run->id;
+	stream->page->page_no = stream->page_no;
 
-	if (vy_page_read(stream->page, page_info,
-			 stream->slice->run->fd, zdctx) != 0) {
+	if (vy_page_read(stream->page, page_info, run->fd, zdctx) != 0) {
 		vy_page_delete(stream->page);
 		stream->page = NULL;
 		return -1;
@@ -2651,6 +3218,14 @@ vy_slice_stream_read_page(struct vy_slice_stream *stream)
 	return 0;
 }
 
+/** Release the current page of a slice stream. */
+static void
+vy_slice_stream_release_page(struct vy_slice_stream *stream)
+{
+	vy_page_cache_release(&stream->run_env->page_cache, stream->page);
+	stream->page = NULL;
+}
+
 /**
  * Binary search in a run for the given key. Find the first position with
  * a tuple greater or equal to slice
@@ -2699,8 +3274,7 @@ vy_slice_stream_search(struct vy_stmt_stream *virt_stream)
 
 	if (stream->pos_in_page == stream->page->row_count) {
 		/* The first tuple is in the beginning of the next page */
-		vy_page_delete(stream->page);
-		stream->page = NULL;
+		vy_slice_stream_release_page(stream);
 		stream->page_no++;
 		stream->pos_in_page = 0;
 	}
@@ -2761,8 +3335,7 @@ vy_slice_stream_next(struct vy_stmt_stream *virt_stream, struct tuple **ret)
 		 * Out of page. Free page, move the position to the next page
 		 * and * nullify page pointer to read it on the next iteration.
 		 */
-		vy_page_delete(stream->page);
-		stream->page = NULL;
+		vy_slice_stream_release_page(stream);
 		stream->page_no++;
 		stream->pos_in_page = 0;
 	}
@@ -2779,8 +3352,7 @@ vy_slice_stream_close(struct vy_stmt_stream *virt_stream)
 	assert(virt_stream->iface->close == vy_slice_stream_close);
 	struct vy_slice_stream *stream = (struct vy_slice_stream *)virt_stream;
 	if (stream->page != NULL) {
-		vy_page_delete(stream->page);
-		stream->page = NULL;
+		vy_slice_stream_release_page(stream);
 	}
 	if (stream->tuple != NULL) {
 		tuple_unref(stream->tuple);
@@ -33,6 +33,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <pthread.h>
 
 #include "fiber_cond.h"
 #include "iterator_type.h"
@@ -49,6 +50,50 @@ extern "C" {
 #endif /* defined(__cplusplus) */
 
 struct vy_run_reader;
+struct mh_vy_page_t;
+
+/**
+ * Cache of decompressed run pages shared by all run iterators
+ * and slice streams, see box.cfg.vinyl_page_cache. Pages are
+ * looked up by run id and page number and evicted in LRU order.
+ */
+struct vy_page_cache {
+	/**
+	 * The cache is accessed from tx as well as from dump
+	 * and compaction threads.
+	 */
+	pthread_mutex_t mutex;
+	/** Run id and page number -> struct vy_page. */
+	struct mh_vy_page_t *hash;
+	/** Cached pages, the most recently used first. */
+	struct rlist lru;
+	/** Memory used by cached pages. */
+	size_t mem_used;
+	/** Memory limit, box.cfg.vinyl_page_cache. */
+	size_t mem_quota;
+	/** Number of pages in the cache. */
+	int64_t page_count;
+	/** Number of pages evicted from the cache. */
+	int64_t evict_count;
+};
+
+/**
+ * Limits the rate at which run files are written. A throttle
+ * is shared by all threads writing runs of the same kind, see
+ * box.cfg.vinyl_dump_rate_limit and vinyl_compact_rate_limit.
+ */
+struct vy_run_throttle {
+	/** The throttle is updated by all writers and by tx. */
+	pthread_mutex_t mutex;
+	/** Max write rate, in bytes per second. 0 means no limit. */
+	double rate;
+	/**
+	 * Time by which all the data written so far would have
+	 * been written at the configured rate. A writer sleeps
+	 * until then after writing a page.
+	 */
+	double deadline;
+};
 
 /** Part of vinyl environment for run read/write */
 struct vy_run_env {
@@ -65,6 +110,12 @@ struct vy_run_env {
 	 * processing the next read request.
 	 */
 	int next_reader;
+	/** Cache of decompressed pages. */
+	struct vy_page_cache page_cache;
+	/** Throttle for dumps. */
+	struct vy_run_throttle dump_throttle;
+	/** Throttle for compaction. */
+	struct vy_run_throttle compact_throttle;
 };
 
 /**
@@ -83,6 +134,12 @@ struct vy_run_info {
 	uint32_t page_count;
 	/** Set iff bloom filter is available. */
 	bool has_bloom;
+	/**
+	 * Set iff bloom filters of the run and its pages store
+	 * hashes of all key prefixes besides full keys, so they
+	 * can be used for lookups by a partial key.
+	 */
+	bool has_prefix_bloom;
 	/** Bloom filter of all tuples in run */
 	struct bloom bloom;
 };
@@ -103,6 +160,14 @@ struct vy_page_info {
 	char *min_key;
 	/** Offset of the row index in the page. */
 	uint32_t row_index_offset;
+	/** Set iff bloom filter is available. */
+	bool has_bloom;
+	/**
+	 * Bloom filter of all tuples in the page. It is used to
+	 * avoid reading the page if the run bloom filter gives
+	 * a false positive. Not created for single page runs.
+	 */
+	struct bloom bloom;
 };
 
 /**
@@ -140,6 +205,18 @@ struct vy_run {
 	struct rlist in_unused;
 	/** Link in vy_index::runs list. */
 	struct rlist in_index;
+	/**
+	 * Page cache the run pages may be stored in, NULL if
+	 * no page of the run has been read yet. The pages are
+	 * removed from the cache when the run is deleted.
+	 */
+	struct vy_page_cache *page_cache;
+	/**
+	 * Size of the page bloom filters charged to runtime.quota.
+	 * The filters are small, so they are charged all at once
+	 * when the run is written or loaded.
+	 */
+	size_t page_bloom_size;
 };
 
 /**
@@ -264,6 +341,8 @@ struct vy_run_iterator {
  * Vinyl page stored in memory.
  */
 struct vy_page {
+	/** ID of the run the page belongs to. */
+	int64_t run_id;
 	/** Page position in the run file. */
 	uint32_t page_no;
 	/** Size of page data in memory, i.e. unpacked. */
@@ -274,6 +353,16 @@ struct vy_page {
 	uint32_t *row_index;
 	/** Pointer to the page data. */
 	char *data;
+	/**
+	 * Number of holders of the page: the page cache and
+	 * iterators reading the page. Protected by the page
+	 * cache mutex.
+	 */
+	int refs;
+	/** Set if the page is in the page cache. */
+	bool in_cache;
+	/** Link in vy_page_cache::lru. */
+	struct rlist in_lru;
 };
 
 /**
@@ -288,6 +377,29 @@ vy_run_env_create(struct vy_run_env *env);
 void
 vy_run_env_destroy(struct vy_run_env *env);
 
+/**
+ * Set the memory limit of the page cache, evicting pages
+ * if the cache does not fit in it any more. Zero disables
+ * the cache.
+ */
+void
+vy_run_env_set_page_cache(struct vy_run_env *env, size_t quota);
+
+/**
+ * Set the max write rate of a run throttle, in bytes per
+ * second. Zero removes the limit.
+ */
+void
+vy_run_throttle_set_rate(struct vy_run_throttle *throttle, double rate);
+
+/** Return the current write rate limit of a run throttle. */
+double
+vy_run_throttle_rate(struct vy_run_throttle *throttle);
+
+/** Return the total size of page bloom filters of all runs. */
+size_t
+vy_run_page_bloom_size(void);
+
 /**
  * Enable coio reads for a vinyl run environment.
  *
@@ -394,13 +506,19 @@ vy_run_snprint_path(char *buf, int size, const char *dir,
 	return total;
 }
 
+/**
+ * Create a run file, write statements returned by a write
+ * iterator to it, and create an index file. If @throttle is
+ * not NULL, writing is slowed down to fit in its rate limit.
+ */
 int
 vy_run_write(struct vy_run *run, const char *dirpath,
 	     uint32_t space_id, uint32_t iid,
 	     struct vy_stmt_stream *wi, uint64_t page_size,
 	     const struct key_def *cmp_def,
 	     const struct key_def *key_def,
-	     size_t max_output_count, double bloom_fpr);
+	     size_t max_output_count, double bloom_fpr,
+	     struct vy_run_throttle *throttle);
 
 /**
  * Allocate a new run slice.
@@ -84,6 +84,10 @@ struct vy_run_iterator_stat {
 	 * prevent a disk read.
 	 */
 	int64_t bloom_miss;
+	/** Number of pages found in the page cache. */
+	int64_t page_cache_hit;
+	/** Number of pages not found in the page cache. */
+	int64_t page_cache_miss;
 	/**
 	 * Number of statements actually read from the disk.
 	 * It may be greater than the number of statements
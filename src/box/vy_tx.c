@@ -106,6 +106,7 @@ tx_manager_new(void)
 	}
 
 	rlist_create(&xm->read_views);
+	rlist_create(&xm->writers);
 	vy_global_read_view_create((struct vy_read_view *)&xm->global_read_view,
 				   INT64_MAX);
 	xm->p_global_read_view = &xm->global_read_view;
@@ -134,7 +135,7 @@ tx_manager_delete(struct tx_manager *xm)
 }
 
 /** Create or reuse an instance of a read view. */
-static struct vy_read_view *
+struct vy_read_view *
 tx_manager_read_view(struct tx_manager *xm)
 {
 	struct vy_read_view *rv;
@@ -177,8 +178,7 @@ tx_manager_read_view(struct tx_manager *xm)
 	return rv;
 }
 
-/** Dereference and possibly destroy a read view. */
-static void
+void
 tx_manager_destroy_read_view(struct tx_manager *xm,
 			     const struct vy_read_view *read_view)
 {
@@ -289,6 +289,7 @@ vy_tx_create(struct tx_manager *xm, struct vy_tx *tx)
 	vy_tx_read_set_new(&tx->read_set);
 	tx->psn = 0;
 	rlist_create(&tx->on_destroy);
+	rlist_create(&tx->in_writers);
 	xm->stat.active++;
 }
 
@@ -297,6 +298,7 @@ vy_tx_destroy(struct vy_tx *tx)
 {
 	trigger_run(&tx->on_destroy, NULL);
 	trigger_destroy(&tx->on_destroy);
+	rlist_del_entry(tx, in_writers);
 
 	tx_manager_destroy_read_view(tx->xm, tx->read_view);
 
@@ -375,6 +377,39 @@ vy_tx_abort_readers(struct vy_tx *tx, struct txv *v)
 	}
 }
 
+/** Return true if the transaction has written to an index. */
+static bool
+vy_tx_writes_index(struct vy_tx *tx, struct vy_index *index)
+{
+	struct txv *v;
+	stailq_foreach_entry(v, &tx->log, next_in_log) {
+		if (v->index == index)
+			return true;
+	}
+	return false;
+}
+
+int
+tx_manager_abort_writers(struct tx_manager *xm, struct vy_index *index)
+{
+	struct vy_tx *tx;
+	rlist_foreach_entry(tx, &xm->writers, in_writers) {
+		/* Prepared TXs are too late to abort. */
+		if (tx->state != VINYL_TX_READY)
+			continue;
+		/* Already in read view, will fail to commit anyway. */
+		if (vy_tx_is_in_read_view(tx))
+			continue;
+		if (!vy_tx_writes_index(tx, index))
+			continue;
+		struct vy_read_view *rv = tx_manager_read_view(xm);
+		if (rv == NULL)
+			return -1;
+		tx->read_view = rv;
+	}
+	return 0;
+}
+
 struct vy_tx *
 vy_tx_begin(struct tx_manager *xm)
 {
@@ -842,6 +877,8 @@ vy_tx_set(struct vy_tx *tx, struct vy_index *index, struct tuple *stmt)
 	tx->write_size += tuple_size(stmt);
 	vy_stmt_counter_acct_tuple(&index->stat.txw.count, stmt);
 	stailq_add_tail_entry(&tx->log, v, next_in_log);
+	if (rlist_empty(&tx->in_writers))
+		rlist_add_entry(&tx->xm->writers, tx, in_writers);
 	return 0;
 }
 
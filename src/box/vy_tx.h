@@ -175,6 +175,8 @@ struct vy_tx {
 	int64_t psn;
 	/* List of triggers invoked when this transaction ends. */
 	struct rlist on_destroy;
+	/** Link in tx_manager::writers. */
+	struct rlist in_writers;
 };
 
 /** Transaction manager object. */
@@ -200,6 +202,11 @@ struct tx_manager {
 	 * The list of TXs with a read view in order of vlsn.
 	 */
 	struct rlist read_views;
+	/**
+	 * The list of TXs that have written anything,
+	 * linked by vy_tx::in_writers.
+	 */
+	struct rlist writers;
 	/**
 	 * Global read view - all prepared transactions are
 	 * visible in this view. The global read view
@@ -258,6 +265,32 @@ tx_manager_delete(struct tx_manager *xm);
 int64_t
 tx_manager_vlsn(struct tx_manager *xm);
 
+/**
+ * Create a read view of the current database state.
+ * Changes of prepared transactions are visible in the
+ * view: if such a transaction commits, the view LSN is
+ * set to its LSN, if it rolls back, the view is marked
+ * as aborted.
+ */
+struct vy_read_view *
+tx_manager_read_view(struct tx_manager *xm);
+
+/** Dereference and possibly destroy a read view. */
+void
+tx_manager_destroy_read_view(struct tx_manager *xm,
+			     const struct vy_read_view *read_view);
+
+/**
+ * Abort all active transactions that have written to
+ * the given index. Such transactions are sent to read
+ * view and so will fail to commit with a conflict error.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+tx_manager_abort_writers(struct tx_manager *xm, struct vy_index *index);
+
 /** Initialize a tx object. */
 void
 vy_tx_create(struct tx_manager *xm, struct vy_tx *tx);
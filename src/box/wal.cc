@@ -41,6 +41,8 @@
 #include "cbus.h"
 #include "coio_task.h"
 #include "replication.h"
+#include "histogram.h"
+#include "latency.h"
 
 
 const char *wal_mode_STRS[] = { "none", "write", "fsync", NULL };
@@ -82,6 +84,11 @@ struct wal_writer
 	 * the wal-tx bus and are rolled back "on arrival".
 	 */
 	struct stailq rollback;
+	/** Commit latency in microseconds, box.stat.wal(). */
+	struct histogram *latency_hist;
+	/** Total commit latency in seconds and commit count. */
+	double latency_sum;
+	int64_t latency_count;
 	/* ----------------- wal ------------------- */
 	/** A setting from instance configuration - rows_per_wal */
 	int64_t wal_max_rows;
@@ -117,6 +124,26 @@ struct wal_writer
 	 * Used for replication relays.
 	 */
 	struct rlist watchers;
+	/**
+	 * Group commit: batches received from tx but not
+	 * written yet. They are held for up to
+	 * group_commit_delay seconds or until their total
+	 * size reaches group_commit_size, so that more
+	 * transactions share a single write and fsync.
+	 */
+	struct stailq pending;
+	/** Approximate size of pending batches, in bytes. */
+	size_t pending_size;
+	/** Timer writing pending batches. */
+	struct ev_timer group_commit_timer;
+	/** box.cfg.wal_group_commit_delay, 0 disables group commit. */
+	double group_commit_delay;
+	/** box.cfg.wal_group_commit_size. */
+	size_t group_commit_size;
+	/** Number of transactions per disk write, box.stat.wal(). */
+	struct histogram *batch_hist;
+	/** Number of disk writes. */
+	int64_t write_count;
 };
 
 struct wal_msg: public cmsg {
@@ -127,6 +154,8 @@ struct wal_msg: public cmsg {
 	 * be rolled back.
 	 */
 	struct stailq rollback;
+	/** Approximate size of the requests, in bytes. */
+	size_t approx_len;
 };
 
 /**
@@ -153,8 +182,12 @@ wal_write_to_disk(struct cmsg *msg);
 static void
 tx_schedule_commit(struct cmsg *msg);
 
+/**
+ * The batch is sent back to tx by wal_writer_flush(), which
+ * may happen later than wal_write_to_disk() returns.
+ */
 static struct cmsg_hop wal_request_route[] = {
-	{wal_write_to_disk, &wal_thread.tx_pipe},
+	{wal_write_to_disk, NULL},
 	{tx_schedule_commit, NULL},
 };
 
@@ -164,6 +197,30 @@ wal_msg_create(struct wal_msg *batch)
 	cmsg_init(batch, wal_request_route);
 	stailq_create(&batch->commit);
 	stailq_create(&batch->rollback);
+	batch->approx_len = 0;
+}
+
+/** Return a batch processed by the WAL thread to tx. */
+static void
+wal_msg_complete(struct wal_msg *batch)
+{
+	assert(batch->hop == &wal_request_route[0]);
+	batch->hop++;
+	cpipe_push(&wal_thread.tx_pipe, batch);
+}
+
+/** Approximate size of a request in the WAL. */
+static size_t
+journal_entry_approx_len(struct journal_entry *entry)
+{
+	size_t len = 0;
+	for (int i = 0; i < entry->n_rows; i++) {
+		struct xrow_header *row = entry->rows[i];
+		len += XROW_HEADER_LEN_MAX;
+		for (int j = 0; j < row->bodycnt; j++)
+			len += row->body[j].iov_len;
+	}
+	return len;
 }
 
 static struct wal_msg *
@@ -254,6 +311,9 @@ tx_schedule_rollback(struct cmsg *msg)
 	stailq_create(&writer->rollback);
 }
 
+static void
+wal_group_commit_timer_cb(ev_loop *loop, ev_timer *timer, int events);
+
 /**
  * Initialize WAL writer context. Even though it's a singleton,
  * encapsulate the details just in case we may use
@@ -279,6 +339,23 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 	stailq_create(&writer->rollback);
 	cmsg_init(&writer->in_rollback, NULL);
 
+	stailq_create(&writer->pending);
+	writer->pending_size = 0;
+	ev_timer_init(&writer->group_commit_timer,
+		      wal_group_commit_timer_cb, 0, 0);
+	writer->group_commit_delay = 0;
+	writer->group_commit_size = 0;
+	writer->write_count = 0;
+
+	static const int64_t batch_buckets[] = {
+		1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096,
+	};
+	writer->batch_hist = histogram_new(batch_buckets,
+					   lengthof(batch_buckets));
+	writer->latency_hist = latency_histogram_new();
+	if (writer->batch_hist == NULL || writer->latency_hist == NULL)
+		panic("failed to allocate WAL statistics");
+
 	/* Create and fill writer->vclock. */
 	vclock_create(&writer->vclock);
 	vclock_copy(&writer->vclock, vclock);
@@ -291,6 +368,8 @@ static void
 wal_writer_destroy(struct wal_writer *writer)
 {
 	xdir_destroy(&writer->wal_dir);
+	histogram_delete(writer->batch_hist);
+	histogram_delete(writer->latency_hist);
 }
 
 /** WAL thread routine. */
@@ -351,6 +430,9 @@ wal_thread_stop()
 		wal_writer_destroy(&wal_writer_singleton);
 }
 
+static void
+wal_writer_flush(struct wal_writer *writer);
+
 struct wal_checkpoint: public cmsg
 {
 	struct vclock *vclock;
@@ -364,6 +446,8 @@ wal_checkpoint_f(struct cmsg *data)
 {
 	struct wal_checkpoint *msg = (struct wal_checkpoint *) data;
 	struct wal_writer *writer = &wal_writer_singleton;
+	/* The checkpoint must include all transactions sent before. */
+	wal_writer_flush(writer);
 	if (writer->in_rollback.route != NULL) {
 		/* We're rolling back a failed write. */
 		msg->res = -1;
@@ -581,27 +665,33 @@ wal_assign_lsn(struct wal_writer *writer, struct xrow_header **row,
 	}
 }
 
+/**
+ * Write all pending batches to disk in one go and return
+ * them to tx.
+ */
 static void
-wal_write_to_disk(struct cmsg *msg)
+wal_writer_flush(struct wal_writer *writer)
 {
-	struct wal_writer *writer = &wal_writer_singleton;
-	struct wal_msg *wal_msg = (struct wal_msg *) msg;
+	ev_timer_stop(loop(), &writer->group_commit_timer);
+	if (stailq_empty(&writer->pending))
+		return;
 
-	struct errinj *inj = errinj(ERRINJ_WAL_DELAY, ERRINJ_BOOL);
-	while (inj != NULL && inj->bparam)
-		usleep(10);
+	struct stailq batches;
+	stailq_create(&batches);
+	stailq_concat(&batches, &writer->pending);
+	writer->pending_size = 0;
 
-	if (writer->in_rollback.route != NULL) {
-		/* We're rolling back a failed write. */
-		stailq_concat(&wal_msg->rollback, &wal_msg->commit);
-		return;
-	}
+	struct cmsg *msg;
+	struct wal_msg *batch;
+	struct journal_entry *entry;
+	/* The last written request and the batch it belongs to. */
+	struct journal_entry *last_commit_entry = NULL;
+	struct wal_msg *last_commit_batch = NULL;
+	int64_t entry_count = 0;
 
 	/* Xlog is only rotated between queue processing  */
-	if (wal_opt_rotate(writer) != 0) {
-		stailq_concat(&wal_msg->rollback, &wal_msg->commit);
-		return wal_writer_begin_rollback(writer);
-	}
+	if (wal_opt_rotate(writer) != 0)
+		goto done;
 
 	/*
 	 * This code tries to write queued requests (=transactions) using as
@@ -623,28 +713,38 @@ wal_write_to_disk(struct cmsg *msg)
 	 * the file to the last fully written request. The absolute position
 	 * of request in xlog file is stored inside `struct journal_entry`.
 	 */
-
-	struct xlog *l = &writer->current_wal;
+	struct xlog *l;
+	l = &writer->current_wal;
 
 	/*
 	 * Iterate over requests (transactions)
 	 */
-	struct journal_entry *entry, *last_commit_entry = NULL;
-	stailq_foreach_entry(entry, &wal_msg->commit, fifo) {
-		wal_assign_lsn(writer, entry->rows, entry->rows + entry->n_rows);
-		entry->res = vclock_sum(&writer->vclock);
-		int rc = xlog_write_entry(l, entry);
-		if (rc < 0)
-			goto done;
-		if (rc > 0)
-			last_commit_entry = entry;
-		/* rc == 0: the write is buffered in xlog_tx */
+	stailq_foreach_entry(msg, &batches, fifo) {
+		batch = (struct wal_msg *) msg;
+		stailq_foreach_entry(entry, &batch->commit, fifo) {
+			wal_assign_lsn(writer, entry->rows,
+				       entry->rows + entry->n_rows);
+			entry->res = vclock_sum(&writer->vclock);
+			int rc = xlog_write_entry(l, entry);
+			if (rc < 0)
+				goto done;
+			if (rc > 0) {
+				last_commit_entry = entry;
+				last_commit_batch = batch;
+			}
+			/* rc == 0: the write is buffered in xlog_tx */
+			entry_count++;
+		}
 	}
 	if (xlog_flush(l) < 0)
 		goto done;
 
-	last_commit_entry = stailq_last_entry(&wal_msg->commit,
+	last_commit_batch = (struct wal_msg *)
+		stailq_last_entry(&batches, struct cmsg, fifo);
+	last_commit_entry = stailq_last_entry(&last_commit_batch->commit,
 					      struct journal_entry, fifo);
+	writer->write_count++;
+	histogram_collect(writer->batch_hist, entry_count);
 
 done:
 	struct error *error = diag_last_error(diag_get());
@@ -660,11 +760,21 @@ done:
 	 * nothing, and need to start rollback from the first
 	 * request. Otherwise we rollback from the first request.
 	 */
-	struct journal_entry *rollback_entry = last_commit_entry ?
-		stailq_next_entry(last_commit_entry, fifo) :
-		stailq_first_entry(&wal_msg->commit, struct journal_entry,
-				   fifo);
-	if (rollback_entry) {
+	bool is_rollback = last_commit_entry == NULL;
+	bool rollback_started = false;
+	stailq_foreach_entry(msg, &batches, fifo) {
+		batch = (struct wal_msg *) msg;
+		struct journal_entry *rollback_entry = NULL;
+		if (is_rollback) {
+			rollback_entry = stailq_first_entry(&batch->commit,
+						struct journal_entry, fifo);
+		} else if (batch == last_commit_batch) {
+			rollback_entry = stailq_next_entry(last_commit_entry,
+							   fifo);
+			is_rollback = true;
+		}
+		if (rollback_entry == NULL)
+			continue;
 		/* Update status of the successfully committed requests. */
 		for (entry = rollback_entry; entry != NULL;
 		     entry = stailq_next_entry(entry, fifo)) {
@@ -672,14 +782,66 @@ done:
 			entry->res = -1;
 		}
 		/* Rollback unprocessed requests */
-		stailq_splice(&wal_msg->commit, &rollback_entry->fifo,
-			      &wal_msg->rollback);
-		wal_writer_begin_rollback(writer);
+		stailq_splice(&batch->commit, &rollback_entry->fifo,
+			      &batch->rollback);
+		if (!rollback_started) {
+			wal_writer_begin_rollback(writer);
+			rollback_started = true;
+		}
+	}
+	while (!stailq_empty(&batches)) {
+		msg = stailq_shift_entry(&batches, struct cmsg, fifo);
+		wal_msg_complete((struct wal_msg *) msg);
 	}
 	fiber_gc();
 	wal_notify_watchers(writer, WAL_EVENT_WRITE);
 }
 
+static void
+wal_group_commit_timer_cb(ev_loop *loop, ev_timer *timer, int events)
+{
+	(void) loop;
+	(void) timer;
+	(void) events;
+	wal_writer_flush(&wal_writer_singleton);
+}
+
+static void
+wal_write_to_disk(struct cmsg *msg)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_msg *wal_msg = (struct wal_msg *) msg;
+
+	struct errinj *inj = errinj(ERRINJ_WAL_DELAY, ERRINJ_BOOL);
+	while (inj != NULL && inj->bparam)
+		usleep(10);
+
+	if (writer->in_rollback.route != NULL) {
+		/*
+		 * We're rolling back a failed write. The failed
+		 * write has flushed all pending batches.
+		 */
+		assert(stailq_empty(&writer->pending));
+		stailq_concat(&wal_msg->rollback, &wal_msg->commit);
+		return wal_msg_complete(wal_msg);
+	}
+
+	stailq_add_tail_entry(&writer->pending, wal_msg, fifo);
+	writer->pending_size += wal_msg->approx_len;
+	if (writer->group_commit_delay <= 0 ||
+	    writer->pending_size >= writer->group_commit_size)
+		return wal_writer_flush(writer);
+	/*
+	 * Hold the batch to let more transactions arrive.
+	 * The first pending batch waits at most for the delay.
+	 */
+	if (!ev_is_active(&writer->group_commit_timer)) {
+		ev_timer_set(&writer->group_commit_timer,
+			     writer->group_commit_delay, 0);
+		ev_timer_start(loop(), &writer->group_commit_timer);
+	}
+}
+
 /** WAL thread main loop.  */
 static int
 wal_thread_f(va_list ap)
@@ -701,6 +863,7 @@ wal_thread_f(va_list ap)
 	cbus_loop(&endpoint);
 
 	struct wal_writer *writer = &wal_writer_singleton;
+	wal_writer_flush(writer);
 
 	if (xlog_is_open(&writer->current_wal))
 		xlog_close(&writer->current_wal, false);
@@ -756,6 +919,7 @@ wal_write(struct journal *journal, struct journal_entry *entry)
 		stailq_add_tail_entry(&batch->commit, entry, fifo);
 		cpipe_push(&wal_thread.wal_pipe, batch);
 	}
+	batch->approx_len += journal_entry_approx_len(entry);
 	wal_thread.wal_pipe.n_input += entry->n_rows * XROW_IOVMAX;
 	cpipe_flush_input(&wal_thread.wal_pipe);
 	/**
@@ -764,10 +928,15 @@ wal_write(struct journal *journal, struct journal_entry *entry)
 	 * error from WAL writer and not roll back the
 	 * transaction.
 	 */
+	double start = ev_monotonic_now(loop());
 	bool cancellable = fiber_set_cancellable(false);
 	fiber_yield(); /* Request was inserted. */
 	fiber_set_cancellable(cancellable);
 	if (entry->res > 0) {
+		double latency = ev_monotonic_now(loop()) - start;
+		histogram_collect(writer->latency_hist, latency * 1e6);
+		writer->latency_sum += latency;
+		writer->latency_count++;
 		struct xrow_header **last = entry->rows + entry->n_rows - 1;
 		while (last >= entry->rows) {
 			/*
@@ -800,6 +969,99 @@ wal_write_in_wal_mode_none(struct journal *journal,
 	return vclock_sum(&writer->vclock);
 }
 
+struct wal_group_commit_msg: public cbus_call_msg
+{
+	double delay;
+	size_t size;
+};
+
+static int
+wal_set_group_commit_f(struct cbus_call_msg *data)
+{
+	struct wal_group_commit_msg *msg =
+		(struct wal_group_commit_msg *) data;
+	struct wal_writer *writer = &wal_writer_singleton;
+	writer->group_commit_delay = msg->delay;
+	writer->group_commit_size = msg->size;
+	/* Do not hold pending batches with the old settings. */
+	wal_writer_flush(writer);
+	return 0;
+}
+
+void
+wal_set_group_commit(double delay, size_t size)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct wal_group_commit_msg msg;
+	msg.delay = delay;
+	msg.size = size;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&wal_thread.wal_pipe, &wal_thread.tx_pipe, &msg,
+		  wal_set_group_commit_f, NULL, TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
+struct wal_stat_msg: public cbus_call_msg
+{
+	struct wal_stat *stat;
+};
+
+static int
+wal_get_stat_f(struct cbus_call_msg *data)
+{
+	struct wal_stat *stat = ((struct wal_stat_msg *) data)->stat;
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct histogram *hist = writer->batch_hist;
+	stat->write_count = writer->write_count;
+	stat->batch.p50 = histogram_percentile(hist, 50);
+	stat->batch.p90 = histogram_percentile(hist, 90);
+	stat->batch.p99 = histogram_percentile(hist, 99);
+	stat->batch.max = hist->max;
+	return 0;
+}
+
+void
+wal_get_stat(struct wal_stat *stat)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	memset(stat, 0, sizeof(*stat));
+	if (!journal_is_initialized(&writer->base) ||
+	    writer->wal_mode == WAL_NONE)
+		return;
+	struct histogram *hist = writer->latency_hist;
+	stat->latency.p50 = histogram_percentile(hist, 50);
+	stat->latency.p90 = histogram_percentile(hist, 90);
+	stat->latency.p99 = histogram_percentile(hist, 99);
+	stat->latency.max = hist->max;
+
+	struct wal_stat_msg msg;
+	msg.stat = stat;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&wal_thread.wal_pipe, &wal_thread.tx_pipe, &msg,
+		  wal_get_stat_f, NULL, TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
+void
+wal_latency_merge(struct histogram *hist)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (!journal_is_initialized(&writer->base) ||
+	    writer->wal_mode == WAL_NONE)
+		return;
+	histogram_merge(hist, writer->latency_hist);
+}
+
+void
+wal_get_latency_total(double *sum, int64_t *count)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	*sum = writer->latency_sum;
+	*count = writer->latency_count;
+}
+
 void
 wal_init_vy_log()
 {
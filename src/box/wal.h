@@ -144,6 +144,49 @@ wal_atfork();
 extern "C" {
 #endif /* defined(__cplusplus) */
 
+/** WAL writer statistics, box.stat.wal(). */
+struct wal_stat {
+	/** Number of disk writes. */
+	int64_t write_count;
+	/** Percentiles of the number of transactions per write. */
+	struct {
+		int64_t p50, p90, p99, max;
+	} batch;
+	/** Percentiles of commit latency, in microseconds. */
+	struct {
+		int64_t p50, p90, p99, max;
+	} latency;
+};
+
+/** Collect WAL writer statistics. */
+void
+wal_get_stat(struct wal_stat *stat);
+
+struct histogram;
+
+/**
+ * Add commit latencies to @a hist, which must be created with
+ * latency_histogram_new(). Used by box.stat.latency().
+ */
+void
+wal_latency_merge(struct histogram *hist);
+
+/**
+ * Return the total latency of all commits, in seconds, and
+ * the number of commits. Unlike wal_get_stat(), doesn't yield.
+ */
+void
+wal_get_latency_total(double *sum, int64_t *count);
+
+/**
+ * Configure group commit: the WAL thread holds a batch of
+ * transactions for up to @a delay seconds or until it grows
+ * to @a size bytes to write and sync it at once. Zero delay
+ * disables group commit.
+ */
+void
+wal_set_group_commit(double delay, size_t size);
+
 /**
  * Wait till all pending changes to the WAL are flushed.
  * Rotates the WAL.
@@ -31,6 +31,8 @@
 #include "xlog.h"
 #include <dirent.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <ctype.h>
 
 #include "fiber.h"
@@ -887,13 +889,12 @@ xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 }
 
 /**
- * Write a sequence of uncompressed xrow objects.
+ * Encode a sequence of uncompressed xrow objects.
  *
- * @retval -1 error
- * @retval >= 0 the number of bytes written
+ * @retval the buffer with the encoded tx
  */
-static off_t
-xlog_tx_write_plain(struct xlog *log)
+static struct obuf *
+xlog_tx_encode_plain(struct xlog *log)
 {
 	/**
 	 * We created an obuf savepoint at start of xlog_tx,
@@ -930,28 +931,17 @@ xlog_tx_write_plain(struct xlog *log)
 			data += padding - 1;
 		}
 	}
-
-	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
-		diag_set(ClientError, ER_INJECTION, "xlog write injection");
-		return -1;
-	});
-
-	ssize_t written = fio_writevn(log->fd, log->obuf.iov, log->obuf.pos + 1);
-	if (written < 0) {
-		diag_set(SystemError, "failed to write to '%s' file",
-			 log->filename);
-		return -1;
-	}
-	return obuf_size(&log->obuf);
+	return &log->obuf;
 }
 
 /**
- * Write a compressed block of xrow objects.
- * @retval -1  error
- * @retval >= 0 the number of bytes written
+ * Encode a compressed block of xrow objects.
+ *
+ * @retval NULL error
+ * @retval the buffer with the encoded tx
  */
-static off_t
-xlog_tx_write_zstd(struct xlog *log)
+static struct obuf *
+xlog_tx_encode_zstd(struct xlog *log)
 {
 	char *fixheader = (char *)obuf_alloc(&log->zbuf,
 					     XLOG_FIXHEADER_SIZE);
@@ -1018,26 +1008,19 @@ xlog_tx_write_zstd(struct xlog *log)
 			data += padding - 1;
 		}
 	}
-
-	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
-		diag_set(ClientError, ER_INJECTION, "xlog write injection");
-		obuf_reset(&log->zbuf);
-		goto error;
-	});
-
-	ssize_t written;
-	written = fio_writevn(log->fd, log->zbuf.iov,
-			      log->zbuf.pos + 1);
-	if (written < 0) {
-		diag_set(SystemError, "failed to write to '%s' file",
-			 log->filename);
-		goto error;
-	}
-	obuf_reset(&log->zbuf);
-	return written;
+	return &log->zbuf;
 error:
 	obuf_reset(&log->zbuf);
-	return -1;
+	return NULL;
+}
+
+struct obuf *
+xlog_tx_encode(struct xlog *log)
+{
+	assert(obuf_size(&log->obuf) > XLOG_FIXHEADER_SIZE);
+	if (obuf_size(&log->obuf) >= XLOG_TX_COMPRESS_THRESHOLD)
+		return xlog_tx_encode_zstd(log);
+	return xlog_tx_encode_plain(log);
 }
 
 /* file syncing and posix_fadvise() should be rounded by a page boundary */
@@ -1045,27 +1028,25 @@ error:
 #define SYNC_ROUND_DOWN(size)	((size) & ~(4096 - 1))
 #define SYNC_ROUND_UP(size)	(SYNC_ROUND_DOWN(size + SYNC_MASK))
 
-/**
- * Writes xlog batch to file
- */
-static ssize_t
-xlog_tx_write(struct xlog *log)
+ssize_t
+xlog_write_tx(struct xlog *log, struct obuf *tx, int64_t rows)
 {
-	if (obuf_size(&log->obuf) == XLOG_FIXHEADER_SIZE)
-		return 0;
 	ssize_t written;
-
-	if (obuf_size(&log->obuf) >= XLOG_TX_COMPRESS_THRESHOLD) {
-		written = xlog_tx_write_zstd(log);
-	} else {
-		written = xlog_tx_write_plain(log);
+	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
+		diag_set(ClientError, ER_INJECTION, "xlog write injection");
+		written = -1;
+		goto out;
+	});
+	written = fio_writevn(log->fd, tx->iov, tx->pos + 1);
+	if (written < 0) {
+		diag_set(SystemError, "failed to write to '%s' file",
+			 log->filename);
 	}
+out:
 	ERROR_INJECT(ERRINJ_WAL_WRITE, {
 		diag_set(ClientError, ER_INJECTION, "xlog write injection");
 		written = -1;
 	});
-
-	obuf_reset(&log->obuf);
 	/*
 	 * Simplify recovery after a temporary write failure:
 	 * truncate the file to the best known good write
@@ -1078,8 +1059,7 @@ xlog_tx_write(struct xlog *log)
 		return -1;
 	}
 	log->offset += written;
-	log->rows += log->tx_rows;
-	log->tx_rows = 0;
+	log->rows += rows;
 	if ((log->sync_interval && log->offset >=
 	    (off_t)(log->synced_size + log->sync_interval)) ||
 	    (log->rate_limit && log->offset >=
@@ -1121,6 +1101,25 @@ xlog_tx_write(struct xlog *log)
 	return written;
 }
 
+/**
+ * Writes xlog batch to file
+ */
+static ssize_t
+xlog_tx_write(struct xlog *log)
+{
+	if (obuf_size(&log->obuf) == XLOG_FIXHEADER_SIZE)
+		return 0;
+	ssize_t written = -1;
+	struct obuf *tx = xlog_tx_encode(log);
+	if (tx != NULL)
+		written = xlog_write_tx(log, tx, log->tx_rows);
+	obuf_reset(&log->zbuf);
+	obuf_reset(&log->obuf);
+	if (written >= 0)
+		log->tx_rows = 0;
+	return written;
+}
+
 /*
  * Add a row to a log and possibly flush the log.
  *
@@ -1236,6 +1235,38 @@ xlog_flush(struct xlog *log)
 	return xlog_tx_write(log);
 }
 
+int
+xlog_create_buffer(struct xlog *xlog)
+{
+	if (xlog_init(xlog) != 0)
+		return -1;
+	xlog->fd = -1;
+	/* Never flush on threshold, there is no file to flush to. */
+	xlog->is_autocommit = false;
+	return 0;
+}
+
+void
+xlog_destroy_buffer(struct xlog *xlog)
+{
+	assert(xlog->fd == -1);
+	xlog_destroy(xlog);
+}
+
+bool
+xlog_tx_is_full(struct xlog *log)
+{
+	return obuf_size(&log->obuf) >= XLOG_TX_AUTOCOMMIT_THRESHOLD;
+}
+
+void
+xlog_tx_reset(struct xlog *log)
+{
+	log->tx_rows = 0;
+	obuf_reset(&log->obuf);
+	obuf_reset(&log->zbuf);
+}
+
 static int
 sync_cb(eio_req *req)
 {
@@ -1559,7 +1590,7 @@ xlog_tx_decode(const char *data, const char *data_end,
 ssize_t
 xlog_tx_cursor_create(struct xlog_tx_cursor *tx_cursor,
 		      const char **data, const char *data_end,
-		      ZSTD_DStream *zdctx)
+		      ZSTD_DStream *zdctx, bool in_place)
 {
 	const char *rpos = *data;
 	struct xlog_fixheader fixheader;
@@ -1585,6 +1616,17 @@ xlog_tx_cursor_create(struct xlog_tx_cursor *tx_cursor,
 
 	ibuf_create(&tx_cursor->rows, &cord()->slabc,
 		    XLOG_TX_AUTOCOMMIT_THRESHOLD);
+	tx_cursor->is_detached = false;
+	if (fixheader.magic == row_marker && in_place) {
+		tx_cursor->rows.buf = (char *)rpos;
+		tx_cursor->rows.rpos = (char *)rpos;
+		tx_cursor->rows.wpos = (char *)rpos + fixheader.len;
+		tx_cursor->rows.end = tx_cursor->rows.wpos;
+		tx_cursor->is_detached = true;
+		*data = tx_cursor->rows.wpos;
+		tx_cursor->size = fixheader.len;
+		return 0;
+	}
 	if (fixheader.magic == row_marker) {
 		void *dst = ibuf_alloc(&tx_cursor->rows, fixheader.len);
 		if (dst == NULL) {
@@ -1646,7 +1688,8 @@ xlog_tx_cursor_next_row(struct xlog_tx_cursor *tx_cursor,
 int
 xlog_tx_cursor_destroy(struct xlog_tx_cursor *tx_cursor)
 {
-	ibuf_destroy(&tx_cursor->rows);
+	if (!tx_cursor->is_detached)
+		ibuf_destroy(&tx_cursor->rows);
 	return 0;
 }
 
@@ -1696,7 +1739,8 @@ xlog_cursor_next_tx(struct xlog_cursor *i)
 	ssize_t to_load;
 	while ((to_load = xlog_tx_cursor_create(&i->tx_cursor,
 						(const char **)&i->rbuf.rpos,
-						i->rbuf.wpos, i->zdctx)) > 0) {
+						i->rbuf.wpos, i->zdctx,
+						i->map != NULL)) > 0) {
 		/* not enough data in read buffer */
 		int rc = xlog_cursor_ensure(i, ibuf_used(&i->rbuf) + to_load);
 		if (rc < 0)
@@ -1741,6 +1785,17 @@ xlog_cursor_next_row(struct xlog_cursor *cursor, struct xrow_header *xrow)
 	return rc;
 }
 
+bool
+xlog_cursor_detach_tx(struct xlog_cursor *cursor, struct ibuf *rows)
+{
+	if (cursor->state != XLOG_CURSOR_TX ||
+	    cursor->tx_cursor.is_detached)
+		return false;
+	*rows = cursor->tx_cursor.rows;
+	cursor->tx_cursor.is_detached = true;
+	return true;
+}
+
 int
 xlog_cursor_next(struct xlog_cursor *cursor,
 		 struct xrow_header *xrow, bool force_recovery)
@@ -1870,6 +1925,75 @@ error:
 	return -1;
 }
 
+int
+xlog_cursor_mmap(struct xlog_cursor *i, const char *name)
+{
+	memset(i, 0, sizeof(*i));
+	i->fd = -1;
+	int fd = open(name, O_RDONLY);
+	if (fd < 0) {
+		diag_set(SystemError, "failed to open '%s' file", name);
+		return -1;
+	}
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		diag_set(SystemError, "failed to stat '%s' file", name);
+		close(fd);
+		return -1;
+	}
+	if (st.st_size == 0) {
+		diag_set(XlogError, "Unexpected end of file");
+		close(fd);
+		return -1;
+	}
+	/*
+	 * The mapping is private and writable so that error
+	 * injection may corrupt the buffer like it does for
+	 * the regular read buffer; nothing reaches the file.
+	 */
+	void *map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		diag_set(SystemError, "failed to mmap '%s' file", name);
+		return -1;
+	}
+	/* The file is read once, from start to end. */
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+	i->map = map;
+	i->map_size = st.st_size;
+	/*
+	 * The read buffer is a view of the mapping, it is never
+	 * grown, since the cursor works in the in-memory mode.
+	 */
+	ibuf_create(&i->rbuf, &cord()->slabc, 0);
+	i->rbuf.buf = i->rbuf.rpos = (char *)map;
+	i->rbuf.wpos = i->rbuf.end = (char *)map + st.st_size;
+	i->read_offset = st.st_size;
+	int rc;
+	rc = xlog_meta_parse(&i->meta,
+			     (const char **)&i->rbuf.rpos,
+			     (const char *)i->rbuf.wpos);
+	if (rc < 0)
+		goto error;
+	if (rc > 0) {
+		diag_set(XlogError, "Unexpected end of file");
+		goto error;
+	}
+	snprintf(i->name, PATH_MAX, "%s", name);
+	i->zdctx = ZSTD_createDStream();
+	if (i->zdctx == NULL) {
+		diag_set(ClientError, ER_DECOMPRESSION,
+			 "failed to create context");
+		goto error;
+	}
+	i->state = XLOG_CURSOR_ACTIVE;
+	return 0;
+error:
+	munmap(i->map, i->map_size);
+	return -1;
+}
+
 int
 xlog_cursor_reset(struct xlog_cursor *cursor)
 {
@@ -1902,6 +2026,11 @@ xlog_cursor_close(struct xlog_cursor *i, bool reuse_fd)
 	bool eof = (i->state == XLOG_CURSOR_EOF);
 	if (i->fd >= 0 && !reuse_fd)
 		close(i->fd);
+	if (i->map != NULL) {
+		munmap(i->map, i->map_size);
+		/* The read buffer doesn't own the memory. */
+		i->rbuf.buf = NULL;
+	}
 	ibuf_destroy(&i->rbuf);
 	if (i->state == XLOG_CURSOR_TX)
 		xlog_tx_cursor_destroy(&i->tx_cursor);
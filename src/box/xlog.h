@@ -435,6 +435,69 @@ xlog_tx_rollback(struct xlog *log);
 ssize_t
 xlog_flush(struct xlog *log);
 
+/**
+ * Initialize an xlog object which is not backed by a file.
+ * Such an object only accumulates rows written with
+ * xlog_write_row() and never flushes them on its own: once
+ * xlog_tx_is_full() returns true the buffered rows should be
+ * encoded with xlog_tx_encode() and appended to a real xlog
+ * with xlog_write_tx(). This allows several threads to prepare
+ * (and compress) tx blocks of the same file in parallel.
+ *
+ * @retval 0 success
+ * @retval -1 error
+ */
+int
+xlog_create_buffer(struct xlog *xlog);
+
+/**
+ * Free an xlog object created with xlog_create_buffer().
+ */
+void
+xlog_destroy_buffer(struct xlog *xlog);
+
+/**
+ * Return true if the rows buffered in the current xlog tx are
+ * big enough to be flushed.
+ */
+bool
+xlog_tx_is_full(struct xlog *log);
+
+/**
+ * Encode the rows buffered in the current xlog tx into a single
+ * tx block: a fixed header followed by the rows, compressed if
+ * the tx is big enough. The buffered rows are not discarded,
+ * @sa xlog_tx_reset().
+ *
+ * @retval the buffer with the encoded tx block
+ * @retval NULL on error
+ */
+struct obuf *
+xlog_tx_encode(struct xlog *log);
+
+/**
+ * Append a tx block encoded with xlog_tx_encode() to a log file.
+ * The tx may have been encoded by another xlog object, possibly
+ * in another thread, but the writes to the same file must be
+ * serialized by the caller.
+ *
+ * @param log  xlog to write to
+ * @param tx   encoded tx block
+ * @param rows the number of rows in the block
+ *
+ * @retval -1 error
+ * @retval >= 0 the number of bytes written
+ */
+ssize_t
+xlog_write_tx(struct xlog *log, struct obuf *tx, int64_t rows);
+
+/**
+ * Discard the rows buffered in the current xlog tx, e.g.
+ * once they have been encoded and written elsewhere.
+ */
+void
+xlog_tx_reset(struct xlog *log);
+
 
 /**
  * Sync a log file. The exact action is defined
@@ -473,12 +536,22 @@ struct xlog_tx_cursor
 	struct ibuf rows;
 	/** tx size */
 	size_t size;
+	/**
+	 * Set if the rows buffer isn't owned by the cursor:
+	 * the rows are decoded in place or the buffer has been
+	 * detached with xlog_cursor_detach_tx().
+	 */
+	bool is_detached;
 };
 
 /**
  * Create xlog tx iterator from memory data.
  * *data will be adjusted to end of tx
  *
+ * If @a in_place is set, rows of an uncompressed tx are
+ * decoded right from @a data, which must then outlive
+ * the rows.
+ *
  * @retval 0 for Ok
  * @retval -1 for error
  * @retval >0 how many additional bytes should be read to parse tx
@@ -486,7 +559,7 @@ struct xlog_tx_cursor
 ssize_t
 xlog_tx_cursor_create(struct xlog_tx_cursor *cursor,
 		      const char **data, const char *data_end,
-		      ZSTD_DStream *zdctx);
+		      ZSTD_DStream *zdctx, bool in_place);
 
 /**
  * Destroy xlog tx cursor and free all associated memory
@@ -569,6 +642,13 @@ struct xlog_cursor
 	struct xlog_tx_cursor tx_cursor;
 	/** ZSTD context for decompression */
 	ZSTD_DStream *zdctx;
+	/**
+	 * File contents mapped to memory, read buffer points
+	 * here. NULL unless opened with xlog_cursor_mmap().
+	 */
+	void *map;
+	/** Size of the mapping. */
+	size_t map_size;
 };
 
 /**
@@ -627,6 +707,19 @@ int
 xlog_cursor_openmem(struct xlog_cursor *cursor, const char *data, size_t size,
 		    const char *name);
 
+/**
+ * Open cursor from file mapped to memory. Rows are decoded
+ * straight from the page cache without copying the file to
+ * the read buffer, which is suitable for reading a big file
+ * from start to end, e.g. a snapshot on recovery.
+ * @param cursor cursor
+ * @param name file name
+ * @retval 0 succes
+ * @retval -1 error, check diag
+ */
+int
+xlog_cursor_mmap(struct xlog_cursor *cursor, const char *name);
+
 /**
  * Reset cursor position
  * @param cursor cursor
@@ -663,6 +756,21 @@ xlog_cursor_next_tx(struct xlog_cursor *cursor);
 int
 xlog_cursor_next_row(struct xlog_cursor *cursor, struct xrow_header *xrow);
 
+/**
+ * Take over the rows buffer of the current tx, so that rows
+ * fetched from the tx stay valid after the cursor moves on.
+ * The cursor keeps reading the tx from the buffer, so it must
+ * not be freed before the tx is done. The buffer is freed with
+ * ibuf_destroy() in the thread reading the cursor.
+ *
+ * @retval true @a rows is the detached buffer
+ * @retval false the cursor doesn't own the buffer: it has
+ *         been detached already or the rows are decoded
+ *         in place from a mapped file
+ */
+bool
+xlog_cursor_detach_tx(struct xlog_cursor *cursor, struct ibuf *rows);
+
 /**
  * Fetch next row from cursor, ignores xlog tx boundary,
  * open a next one tx if current is done.
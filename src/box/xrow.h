@@ -348,6 +348,16 @@ void
 iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 		    uint32_t schema_version, uint32_t count);
 
+/**
+ * Same as iproto_reply_select(), but the result set continues
+ * past the end of the buffer with @a ext_size bytes of data the
+ * caller sends on its own, right after the buffer contents.
+ */
+void
+iproto_reply_select_ext(struct obuf *buf, struct obuf_svp *svp,
+			uint64_t sync, uint32_t schema_version,
+			uint32_t count, size_t ext_size);
+
 /**
  * Write header of the key to a preallocated buffer by svp.
  * @param buf Buffer to write to.
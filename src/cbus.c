@@ -31,6 +31,7 @@
 #include "cbus.h"
 
 #include <limits.h>
+#include <pmatomic.h>
 #include "fiber.h"
 #include "trigger.h"
 
@@ -56,6 +57,90 @@ const char *cbus_stat_strings[CBUS_STAT_LAST] = {
 	"LOCKS",
 };
 
+enum {
+	/** Bounds of cbus_endpoint::poll_budget. */
+	CBUS_POLL_BUDGET_MIN = 16,
+	CBUS_POLL_BUDGET_MAX = 256,
+	/**
+	 * Max number of message processing rounds in a row
+	 * before cbus_loop() lets the event loop run.
+	 */
+	CBUS_POLL_ROUNDS_MAX = 16,
+};
+
+static inline void
+cbus_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__asm__ __volatile__("pause");
+#endif
+}
+
+/**
+ * Push a batch of messages to the endpoint output.
+ * @retval true if the consumer needs to be woken up.
+ */
+static bool
+cbus_endpoint_push(struct cbus_endpoint *endpoint, struct stailq *batch)
+{
+	assert(!stailq_empty(batch));
+	/* The output is a stack, @sa cbus_endpoint_fetch(). */
+	stailq_reverse(batch);
+	struct stailq_entry *last = stailq_last(batch);
+	struct stailq_entry *head = pm_atomic_load(&endpoint->output);
+	do {
+		last->next = head;
+	} while (!pm_atomic_compare_exchange_weak(&endpoint->output, &head,
+						  stailq_first(batch)));
+	stailq_create(batch);
+	/*
+	 * The consumer has already been woken up by the producer
+	 * which made the output non-empty. A polling consumer
+	 * rechecks the output after it stops polling,
+	 * @sa cbus_endpoint_poll().
+	 */
+	return head == NULL && !pm_atomic_load(&endpoint->is_polling);
+}
+
+static void
+cbus_endpoint_wakeup(struct cbus_endpoint *endpoint)
+{
+	/* Count statistics */
+	rmean_collect(cbus.stats, CBUS_STAT_EVENTS, 1);
+	pm_atomic_fetch_add_explicit(&endpoint->n_wakeups, 1,
+				     pm_memory_order_relaxed);
+	ev_async_send(endpoint->consumer, &endpoint->async);
+}
+
+/**
+ * Poll the endpoint output for a while before going to sleep,
+ * so that producers don't have to wake the consumer up when
+ * the message rate is high. The number of checks is doubled
+ * every time new messages arrive and halved otherwise.
+ * @retval true if there are new messages.
+ */
+static bool
+cbus_endpoint_poll(struct cbus_endpoint *endpoint)
+{
+	pm_atomic_store(&endpoint->is_polling, true);
+	for (int i = 0; i < endpoint->poll_budget; i++) {
+		if (pm_atomic_load_explicit(&endpoint->output,
+					    pm_memory_order_relaxed) != NULL)
+			break;
+		cbus_cpu_relax();
+	}
+	pm_atomic_store(&endpoint->is_polling, false);
+	/* Producers may have skipped the wakeup while we polled. */
+	if (pm_atomic_load(&endpoint->output) != NULL) {
+		endpoint->poll_budget = MIN(endpoint->poll_budget * 2,
+					    CBUS_POLL_BUDGET_MAX);
+		return true;
+	}
+	endpoint->poll_budget = MAX(endpoint->poll_budget / 2,
+				    CBUS_POLL_BUDGET_MIN);
+	return false;
+}
+
 /**
  * Find a joined cbus endpoint by name.
  * This is an internal helper method which should be called
@@ -148,21 +233,19 @@ cpipe_destroy(struct cpipe *pipe)
 	 * we want to control the way the poison message is
 	 * delivered.
 	 */
-	tt_pthread_mutex_lock(&endpoint->mutex);
-	/* Flush input */
-	stailq_concat(&endpoint->output, &pipe->input);
-	pipe->n_input = 0;
 	/* Add the pipe shutdown message as the last one. */
-	stailq_add_tail_entry(&endpoint->output, poison, msg.fifo);
-	/* Count statistics */
-	rmean_collect(cbus.stats, CBUS_STAT_EVENTS, 1);
+	stailq_add_tail_entry(&pipe->input, poison, msg.fifo);
+	pipe->n_input = 0;
 	/*
 	 * Keep the lock for the duration of ev_async_send():
 	 * this will avoid a race condition between
 	 * ev_async_send() and execution of the poison
 	 * message, after which the endpoint may disappear.
 	 */
-	ev_async_send(endpoint->consumer, &endpoint->async);
+	tt_pthread_mutex_lock(&endpoint->mutex);
+	/* Flush input */
+	cbus_endpoint_push(endpoint, &pipe->input);
+	cbus_endpoint_wakeup(endpoint);
 	tt_pthread_mutex_unlock(&endpoint->mutex);
 
 	TRASH(pipe);
@@ -218,7 +301,12 @@ cbus_endpoint_create(struct cbus_endpoint *endpoint, const char *name,
 	endpoint->n_pipes = 0;
 	fiber_cond_create(&endpoint->cond);
 	tt_pthread_mutex_init(&endpoint->mutex, NULL);
-	stailq_create(&endpoint->output);
+	endpoint->output = NULL;
+	endpoint->is_polling = false;
+	endpoint->poll_budget = CBUS_POLL_BUDGET_MIN;
+	endpoint->n_wakeups = 0;
+	endpoint->n_fetches = 0;
+	endpoint->n_messages = 0;
 	ev_async_init(&endpoint->async,
 		      (void (*)(ev_loop *, struct ev_async *, int)) fetch_cb);
 	endpoint->async.data = fetch_data;
@@ -252,14 +340,15 @@ cbus_endpoint_destroy(struct cbus_endpoint *endpoint,
 	while (true) {
 		if (process_cb)
 			process_cb(endpoint);
-		if (endpoint->n_pipes == 0 && stailq_empty(&endpoint->output))
+		if (endpoint->n_pipes == 0 &&
+		    pm_atomic_load(&endpoint->output) == NULL)
 			break;
 		 fiber_cond_wait(&endpoint->cond);
 	}
 
 	/*
-	 * Pipe flush func can still lock mutex, so just lock and unlock
-	 * it.
+	 * Pipe destroy func can still lock mutex, so just lock and
+	 * unlock it.
 	 */
 	tt_pthread_mutex_lock(&endpoint->mutex);
 	tt_pthread_mutex_unlock(&endpoint->mutex);
@@ -281,22 +370,60 @@ cpipe_flush_cb(ev_loop *loop, struct ev_async *watcher, int events)
 		return;
 
 	trigger_run(&pipe->on_flush, pipe);
-	/* Trigger task processing when the queue becomes non-empty. */
-	bool output_was_empty;
-
-	tt_pthread_mutex_lock(&endpoint->mutex);
-	output_was_empty = stailq_empty(&endpoint->output);
 	/** Flush input */
-	stailq_concat(&endpoint->output, &pipe->input);
-	tt_pthread_mutex_unlock(&endpoint->mutex);
-
+	bool need_wakeup = cbus_endpoint_push(endpoint, &pipe->input);
 	pipe->n_input = 0;
-	if (output_was_empty) {
-		/* Count statistics */
-		rmean_collect(cbus.stats, CBUS_STAT_EVENTS, 1);
+	/* Trigger task processing when the queue becomes non-empty. */
+	if (need_wakeup)
+		cbus_endpoint_wakeup(endpoint);
+}
+
+void
+cbus_endpoint_fetch(struct cbus_endpoint *endpoint, struct stailq *output)
+{
+	struct stailq_entry *item = pm_atomic_exchange(&endpoint->output,
+						       NULL);
+	if (item == NULL)
+		return;
+	/* Restore the order in which messages were pushed. */
+	struct stailq batch;
+	stailq_create(&batch);
+	int64_t count = 0;
+	while (item != NULL) {
+		struct stailq_entry *next = stailq_next(item);
+		stailq_add(&batch, item);
+		item = next;
+		count++;
+	}
+	stailq_concat(output, &batch);
+	pm_atomic_fetch_add_explicit(&endpoint->n_fetches, 1,
+				     pm_memory_order_relaxed);
+	pm_atomic_fetch_add_explicit(&endpoint->n_messages, count,
+				     pm_memory_order_relaxed);
+}
 
-		ev_async_send(endpoint->consumer, &endpoint->async);
+int
+cbus_get_stat(struct cbus_endpoint_stat *stat, int count)
+{
+	int n = 0;
+	tt_pthread_mutex_lock(&cbus.mutex);
+	struct cbus_endpoint *endpoint;
+	rlist_foreach_entry(endpoint, &cbus.endpoints, in_cbus) {
+		if (n < count) {
+			struct cbus_endpoint_stat *s = &stat[n];
+			snprintf(s->name, sizeof(s->name), "%s",
+				 endpoint->name);
+			s->wakeups = pm_atomic_load_explicit(
+				&endpoint->n_wakeups, pm_memory_order_relaxed);
+			s->fetches = pm_atomic_load_explicit(
+				&endpoint->n_fetches, pm_memory_order_relaxed);
+			s->messages = pm_atomic_load_explicit(
+				&endpoint->n_messages, pm_memory_order_relaxed);
+		}
+		n++;
 	}
+	tt_pthread_mutex_unlock(&cbus.mutex);
+	return n;
 }
 
 void
@@ -638,10 +765,20 @@ cbus_process(struct cbus_endpoint *endpoint)
 void
 cbus_loop(struct cbus_endpoint *endpoint)
 {
+	int rounds = 0;
 	while (true) {
 		cbus_process(endpoint);
 		if (fiber_is_cancelled())
 			break;
+		/*
+		 * Under load, wait for new messages a little
+		 * instead of sleeping until a producer wakes us
+		 * up, but let the event loop run once in a while.
+		 */
+		if (++rounds < CBUS_POLL_ROUNDS_MAX &&
+		    cbus_endpoint_poll(endpoint))
+			continue;
+		rounds = 0;
 		fiber_yield();
 	}
 }
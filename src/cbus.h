@@ -118,7 +118,8 @@ struct cpipe {
 	/**
 	 * When pushing messages, keep the staged input size under
 	 * this limit (speeds up message delivery and reduces
-	 * latency, while still keeping the bus mutex cold enough).
+	 * latency, while still keeping consumer wakeups rare
+	 * enough).
 	 */
 	int max_input;
 	/**
@@ -166,7 +167,7 @@ cpipe_destroy(struct cpipe *pipe);
  * Otherwise, the messages flushed once per event loop iteration.
  *
  * @todo: collect bus stats per second and adjust max_input once
- * a second to keep the mutex cold regardless of the message load,
+ * a second to keep wakeups rare regardless of the message load,
  * while still keeping the latency low if there are few
  * long-to-process messages.
  */
@@ -251,10 +252,29 @@ struct cbus_endpoint {
 	char name[FIBER_NAME_MAX];
 	/** Member of cbus->endpoints */
 	struct rlist in_cbus;
-	/** The lock around the pipe. */
+	/**
+	 * The lock serializing the last message of a pipe with
+	 * the endpoint destruction, @sa cpipe_destroy(). Message
+	 * delivery doesn't take it.
+	 */
 	pthread_mutex_t mutex;
-	/** A queue with incoming messages. */
-	struct stailq output;
+	/**
+	 * Incoming messages, a lock-free stack. Producers push
+	 * whole batches in reverse order with a single
+	 * compare-and-swap, the consumer takes everything with a
+	 * single exchange and reverses the list back.
+	 */
+	struct stailq_entry *output;
+	/**
+	 * Set while the consumer polls the output for new
+	 * messages, producers don't wake the consumer up then.
+	 */
+	bool is_polling;
+	/**
+	 * Number of output checks before the consumer goes
+	 * to sleep, adapts to the message rate.
+	 */
+	int poll_budget;
 	/** Consumer cord loop */
 	ev_loop *consumer;
 	/** Async to notify the consumer */
@@ -263,18 +283,39 @@ struct cbus_endpoint {
 	uint32_t n_pipes;
 	/** Condition for endpoint destroy */
 	struct fiber_cond cond;
+	/** Number of times producers woke the consumer up. */
+	int64_t n_wakeups;
+	/** Number of times the consumer fetched new messages. */
+	int64_t n_fetches;
+	/** Number of fetched messages. */
+	int64_t n_messages;
 };
 
 /**
  * Fetch incomming messages to output
  */
-static inline void
-cbus_endpoint_fetch(struct cbus_endpoint *endpoint, struct stailq *output)
-{
-	tt_pthread_mutex_lock(&endpoint->mutex);
-	stailq_concat(output, &endpoint->output);
-	tt_pthread_mutex_unlock(&endpoint->mutex);
-}
+void
+cbus_endpoint_fetch(struct cbus_endpoint *endpoint, struct stailq *output);
+
+/** Statistics of a cbus endpoint. */
+struct cbus_endpoint_stat {
+	/** Endpoint name. */
+	char name[FIBER_NAME_MAX];
+	/** @sa struct cbus_endpoint. */
+	int64_t wakeups;
+	int64_t fetches;
+	int64_t messages;
+};
+
+/**
+ * Get statistics of endpoints joined to the bus.
+ * @param[out] stat array to fill.
+ * @param count size of the array.
+ * @return the number of joined endpoints, may be greater
+ *         than @a count.
+ */
+int
+cbus_get_stat(struct cbus_endpoint_stat *stat, int count);
 
 /** Initialize the global singleton bus. */
 void
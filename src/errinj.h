@@ -105,6 +105,8 @@ struct errinj {
 	_(ERRINJ_BUILD_SECONDARY, ERRINJ_INT, {.iparam = -1}) \
 	_(ERRINJ_VY_POINT_ITER_WAIT, ERRINJ_BOOL, {.bparam = false}) \
 	_(ERRINJ_RELAY_EXIT_DELAY, ERRINJ_DOUBLE, {.dparam = 0}) \
+	_(ERRINJ_VY_COMPACT_PART_SIZE, ERRINJ_INT, {.iparam = -1}) \
+	_(ERRINJ_VY_COMPACT_PART_FAIL, ERRINJ_INT, {.iparam = -1}) \
 
 ENUM0(errinj_id, ERRINJ_LIST);
 extern struct errinj errinjs[];
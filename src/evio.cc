@@ -374,3 +374,32 @@ evio_service_stop(struct evio_service *service)
 		}
 	}
 }
+
+void
+evio_service_attach(struct evio_service *service,
+		    const struct evio_service *master)
+{
+	assert(! evio_service_is_active(service));
+	memcpy(service->host, master->host, sizeof(service->host));
+	memcpy(service->serv, master->serv, sizeof(service->serv));
+	memcpy(&service->addrstorage, &master->addrstorage,
+	       sizeof(service->addrstorage));
+	service->addr_len = master->addr_len;
+
+	int fd = dup(master->ev.fd);
+	if (fd < 0)
+		tnt_raise(SocketError, master->ev.fd, "dup");
+	ev_io_set(&service->ev, fd, EV_READ);
+	ev_io_start(service->loop, &service->ev);
+}
+
+void
+evio_service_detach(struct evio_service *service)
+{
+	if (ev_is_active(&service->ev))
+		ev_io_stop(service->loop, &service->ev);
+	if (service->ev.fd >= 0) {
+		close(service->ev.fd);
+		ev_io_set(&service->ev, -1, 0);
+	}
+}
@@ -116,6 +116,23 @@ evio_service_listen(struct evio_service *service);
 void
 evio_service_stop(struct evio_service *service);
 
+/**
+ * Start accepting connections on a duplicate of the listening
+ * socket of another service, possibly running in another
+ * thread. The kernel hands each incoming connection to one
+ * of the acceptors.
+ */
+void
+evio_service_attach(struct evio_service *service,
+		    const struct evio_service *master);
+
+/**
+ * Stop an attached service. Unlike evio_service_stop(), does
+ * not unlink the unix socket, which belongs to the master.
+ */
+void
+evio_service_detach(struct evio_service *service);
+
 void
 evio_socket(struct ev_io *coio, int domain, int type, int protocol);
 
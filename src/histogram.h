@@ -83,6 +83,20 @@ histogram_discard(struct histogram *hist, int64_t val);
 int64_t
 histogram_percentile(struct histogram *hist, int pct);
 
+/**
+ * Same as histogram_percentile(), but the percentage is given
+ * in tenths of a percent, e.g. 999 for the 99.9th percentile.
+ */
+int64_t
+histogram_permille(struct histogram *hist, int pml);
+
+/**
+ * Add all observations of @src to @dst. The histograms must
+ * have the same buckets.
+ */
+void
+histogram_merge(struct histogram *dst, const struct histogram *src);
+
 /**
  * Print string representation of a histogram.
  */
@@ -89,3 +89,20 @@ latency_get(struct latency *latency)
 						  LATENCY_PERCENTILE);
 	return (double)value_usec / USEC_PER_SEC;
 }
+
+struct histogram *
+latency_histogram_new(void)
+{
+	enum { US = 1, MS = USEC_PER_MSEC, S = USEC_PER_SEC };
+	static int64_t buckets[] = {
+		  1 * US,   2 * US,   3 * US,   5 * US,   7 * US,
+		 10 * US,  20 * US,  30 * US,  50 * US,  70 * US,
+		100 * US, 200 * US, 300 * US, 500 * US, 700 * US,
+		  1 * MS,   2 * MS,   3 * MS,   5 * MS,   7 * MS,
+		 10 * MS,  20 * MS,  30 * MS,  50 * MS,  70 * MS,
+		100 * MS, 200 * MS, 300 * MS, 500 * MS, 700 * MS,
+		  1 * S,    2 * S,    3 * S,    5 * S,    7 * S,
+		 10 * S,
+	};
+	return histogram_new(buckets, lengthof(buckets));
+}
@@ -31,6 +31,10 @@
  * SUCH DAMAGE.
  */
 
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
 struct histogram;
 
 /**
@@ -70,4 +74,17 @@ latency_collect(struct latency *latency, double value);
 double
 latency_get(struct latency *latency);
 
+/**
+ * Create a histogram of request latencies, in microseconds.
+ * Unlike the latency counter, it has buckets starting from
+ * one microsecond, so that it is usable for requests that
+ * don't involve disk access. Return NULL on OOM.
+ */
+struct histogram *
+latency_histogram_new(void);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
 #endif /* TARANTOOL_LATENCY_H_INCLUDED */
@@ -36,17 +36,69 @@
 #include <math.h>
 #include <assert.h>
 #include <string.h>
+#include <stdlib.h>
+
+/**
+ * Allocate a zeroed bloom table of the given size. Tables that
+ * occupy whole pages are mmapped, smaller ones are allocated
+ * with malloc, aligned by a cache line.
+ */
+static struct bloom_block *
+bloom_table_alloc(size_t size, struct quota *quota)
+{
+	if (quota != NULL && quota_use(quota, size) < 0)
+		return NULL;
+	void *table;
+	if (size % sysconf(_SC_PAGE_SIZE) == 0) {
+		table = mmap(NULL, size, PROT_READ | PROT_WRITE,
+			     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (table == MAP_FAILED)
+			table = NULL;
+	} else if (posix_memalign(&table, BLOOM_CACHE_LINE, size) == 0) {
+		memset(table, 0, size);
+	} else {
+		table = NULL;
+	}
+	if (table == NULL && quota != NULL)
+		quota_release(quota, size);
+	return (struct bloom_block *)table;
+}
+
+/**
+ * Free a bloom table allocated with bloom_table_alloc().
+ */
+static void
+bloom_table_free(struct bloom_block *table, size_t size, struct quota *quota)
+{
+	if (size % sysconf(_SC_PAGE_SIZE) == 0)
+		munmap(table, size);
+	else
+		free(table);
+	if (quota != NULL)
+		quota_release(quota, size);
+}
+
+/**
+ * Set the optimal number of hash functions for the given false
+ * positive rate and return the number of bits needed to store
+ * the given number of values.
+ */
+static uint64_t
+bloom_bit_count(struct bloom *bloom, uint32_t number_of_values,
+		double false_positive_rate)
+{
+	bloom->hash_count = (uint32_t)
+		(log(false_positive_rate) / log(0.5) + 0.99);
+	return (uint64_t)(number_of_values * bloom->hash_count / log(2) + 0.5);
+}
 
 int
 bloom_create(struct bloom *bloom, uint32_t number_of_values,
 	     double false_positive_rate, struct quota *quota)
 {
-	/* Optimal hash_count and bit count calculation */
-	bloom->hash_count = (uint32_t)
-		(log(false_positive_rate) / log(0.5) + 0.99);
 	/* Number of bits */
-	uint64_t m = (uint64_t)
-		(number_of_values * bloom->hash_count / log(2) + 0.5);
+	uint64_t m = bloom_bit_count(bloom, number_of_values,
+				     false_positive_rate);
 	/* mmap page size */
 	uint64_t page_size = sysconf(_SC_PAGE_SIZE);
 	/* Number of bits in one page */
@@ -56,27 +108,37 @@ bloom_create(struct bloom *bloom, uint32_t number_of_values,
 	/* bit array size in bytes */
 	size_t mmap_size = p * page_size;
 	bloom->table_size = p * page_size / sizeof(struct bloom_block);
-	if (quota_use(quota, mmap_size) < 0) {
-		bloom->table = NULL;
-		return -1;
-	}
-	bloom->table = (struct bloom_block *)
-		mmap(NULL, mmap_size, PROT_READ | PROT_WRITE,
-		     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-	if (bloom->table == MAP_FAILED) {
-		bloom->table = NULL;
-		quota_release(quota, mmap_size);
-		return -1;
-	}
-	return 0;
+	bloom->table = bloom_table_alloc(mmap_size, quota);
+	return bloom->table == NULL ? -1 : 0;
+}
+
+int
+bloom_create_compact(struct bloom *bloom, uint32_t number_of_values,
+		     double false_positive_rate, struct quota *quota)
+{
+	uint64_t m = bloom_bit_count(bloom, number_of_values,
+				     false_positive_rate);
+	/*
+	 * Values are spread among blocks unevenly so a blocked
+	 * filter needs more bits than a classic one to achieve
+	 * the same false positive rate. bloom_create() gets the
+	 * slack from rounding the table up to pages.
+	 */
+	m += m / 4;
+	/* Number of bits in one block */
+	uint64_t b = sizeof(struct bloom_block) * CHAR_BIT;
+	/* Number of blocks, round up */
+	bloom->table_size = (uint32_t)((m + b - 1) / b);
+	if (bloom->table_size == 0)
+		bloom->table_size = 1;
+	bloom->table = bloom_table_alloc(bloom_store_size(bloom), quota);
+	return bloom->table == NULL ? -1 : 0;
 }
 
 void
 bloom_destroy(struct bloom *bloom, struct quota *quota)
 {
-	size_t mmap_size = bloom->table_size * sizeof(struct bloom_block);
-	munmap(bloom->table, mmap_size);
-	quota_release(quota, mmap_size);
+	bloom_table_free(bloom->table, bloom_store_size(bloom), quota);
 }
 
 size_t
@@ -96,20 +158,11 @@ bloom_store(const struct bloom *bloom, char *table)
 int
 bloom_load_table(struct bloom *bloom, const char *table, struct quota *quota)
 {
-	size_t mmap_size = bloom->table_size * sizeof(struct bloom_block);
-	if (quota_use(quota, mmap_size) < 0) {
-		bloom->table = NULL;
+	size_t size = bloom_store_size(bloom);
+	bloom->table = bloom_table_alloc(size, quota);
+	if (bloom->table == NULL)
 		return -1;
-	}
-	bloom->table = (struct bloom_block *)
-		mmap(NULL, mmap_size, PROT_READ | PROT_WRITE,
-		     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-	if (bloom->table == MAP_FAILED) {
-		bloom->table = NULL;
-		quota_release(quota, mmap_size);
-		return -1;
-	}
-	memcpy(bloom->table, table, mmap_size);
+	memcpy(bloom->table, table, size);
 	return 0;
 }
 
@@ -97,6 +97,22 @@ int
 bloom_create(struct bloom *bloom, uint32_t number_of_values,
 	     double false_positive_rate, struct quota *quota);
 
+/**
+ * Allocate and initialize an instance of bloom filter of the minimal
+ * size sufficient for the given number of values. Unlike bloom_create()
+ * it doesn't round the table up to the system page size, so it is
+ * suitable for small data sets.
+ *
+ * @param bloom - structure to initialize
+ * @param number_of_values - estimated number of values to be added
+ * @param false_positive_rate - desired false positive rate
+ * @param quota - quota for memory allocation, may be NULL
+ * @return 0 - OK, -1 - memory error
+ */
+int
+bloom_create_compact(struct bloom *bloom, uint32_t number_of_values,
+		     double false_positive_rate, struct quota *quota);
+
 /**
  * Free resources of the bloom filter
  *
@@ -149,7 +165,7 @@ bloom_store(const struct bloom *bloom, char *table);
  *
  * @param bloom - structure to load to
  * @param table - data to load
- * @param quota - quota for memory allocation
+ * @param quota - quota for memory allocation, may be NULL
  * @return 0 - OK, -1 - memory error
  */
 int
@@ -0,0 +1,913 @@
+/*
+ * *No header guard*: the header is allowed to be included twice
+ * with different sets of defines.
+ */
+/*
+ * Copyright 2010-2018, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "small/matras.h"
+
+/**
+ * Swiss - an open addressing hash table with values stored in
+ * cache line sized groups.
+ *
+ * Each group holds SWISS_GROUP_SIZE values and a 64-bit control
+ * word. The control word has a one byte tag per slot: zero for
+ * an empty slot, or 7 bits of the value hash with the high bit
+ * set for an occupied one. A lookup matches the tag against all
+ * tags of a group at once with a few arithmetic operations and
+ * only compares values whose tags match. The last byte of the
+ * control word counts values that didn't fit into the group and
+ * were placed into one of the following groups. A lookup stops
+ * at the first group with a zero counter, so the table needs no
+ * tombstones.
+ *
+ * The table grows by linear hashing: a new group is appended at
+ * the end and the values of one old group are split between the
+ * old group and the new one. Once started, a doubling of the
+ * table is completed by a few group splits per insertion, so
+ * that the load of not yet split groups stays bounded and there
+ * is no pause to rehash the whole table.
+ *
+ * Groups are allocated with matras, so iterators may be frozen
+ * to iterate over a consistent read view of the table.
+ */
+
+/**
+ * Additional user defined name that appended to prefix 'swiss'
+ *  for all names of structs and functions in this header file.
+ * All names use pattern: swiss<SWISS_NAME>_<name of func/struct>
+ * May be empty, but still have to be defined (just #define SWISS_NAME)
+ */
+#ifndef SWISS_NAME
+#error "SWISS_NAME must be defined"
+#endif
+
+/**
+ * Data type that hash table holds. Must be not greater than
+ * 8 bytes.
+ */
+#ifndef SWISS_DATA_TYPE
+#error "SWISS_DATA_TYPE must be defined"
+#endif
+
+/**
+ * Data type that used to for finding values.
+ */
+#ifndef SWISS_KEY_TYPE
+#error "SWISS_KEY_TYPE must be defined"
+#endif
+
+/**
+ * Type of optional third parameter of comparing and hash
+ * functions. If not needed, simply use
+ * #define SWISS_CMP_ARG_TYPE int
+ */
+#ifndef SWISS_CMP_ARG_TYPE
+#error "SWISS_CMP_ARG_TYPE must be defined"
+#endif
+
+/**
+ * Data comparing function. Takes 3 parameters - value1, value2
+ * and optional value that stored in hash table struct.
+ */
+#ifndef SWISS_EQUAL
+#error "SWISS_EQUAL must be defined"
+#endif
+
+/**
+ * Data comparing function. Takes 3 parameters - value, key and
+ * optional value that stored in hash table struct.
+ */
+#ifndef SWISS_EQUAL_KEY
+#error "SWISS_EQUAL_KEY must be defined"
+#endif
+
+/**
+ * Hash function of a stored value. Takes 2 parameters - value
+ * and optional value that stored in hash table struct. Must
+ * return the same hash the value was inserted with. Hashes are
+ * not stored in the table, they are recalculated to split a
+ * group or to delete a value by its position.
+ */
+#ifndef SWISS_HASH
+#error "SWISS_HASH must be defined"
+#endif
+
+/**
+ * Tools for name substitution:
+ */
+#ifndef CONCAT4
+#define CONCAT4_R(a, b, c, d) a##b##c##d
+#define CONCAT4(a, b, c, d) CONCAT4_R(a, b, c, d)
+#endif
+
+#ifdef _
+#error '_' must be undefinded!
+#endif
+#define SWISS(name) CONCAT4(swiss, SWISS_NAME, _, name)
+
+#ifndef SWISS_GROUP_SIZE
+/** Number of values in a group. */
+#define SWISS_GROUP_SIZE 7
+/**
+ * Average number of values per group that starts doubling of
+ * the table.
+ */
+#define SWISS_GROUP_LOAD 5
+/** Number of group splits per insertion while doubling. */
+#define SWISS_SPLIT_STEPS 2
+/** Control word mask of high bits of the slot tags. */
+#define SWISS_CTRL_HIGH 0x0080808080808080ULL
+/** Control word mask of low bits of the slot tags. */
+#define SWISS_CTRL_LOW 0x0001010101010101ULL
+/** Control word mask of all bits of the slot tags. */
+#define SWISS_CTRL_TAGS 0x00FFFFFFFFFFFFFFULL
+/** Shift of the overflow counter in the control word. */
+#define SWISS_CTRL_OVERFLOW_SHIFT 56
+/** Max value of the overflow counter, it is sticky. */
+#define SWISS_OVERFLOW_MAX 255
+#endif
+
+/**
+ * A group of values, occupies exactly one cache line.
+ */
+struct SWISS(group) {
+	/**
+	 * Tags of the slots (bytes 0..6) and the overflow
+	 * counter (byte 7).
+	 */
+	uint64_t ctrl;
+	/** The values. */
+	SWISS_DATA_TYPE values[SWISS_GROUP_SIZE];
+} __attribute__((aligned(64)));
+
+/**
+ * Main struct for holding hash table
+ */
+struct SWISS(core) {
+	/* count of values in hash table */
+	uint32_t count;
+	/* number of groups ( equal to mtable.head.block_count ) */
+	uint32_t group_count;
+	/*
+	 * cover is power of two;
+	 * if group_count is positive, then
+	 * cover/2 < group_count <= cover
+	 * cover_mask is cover - 1
+	 */
+	uint32_t cover_mask;
+	/* additional parameter for data comparison */
+	SWISS_CMP_ARG_TYPE arg;
+	/* dynamic storage for groups */
+	struct matras mtable;
+};
+
+/**
+ * Iterator, for iterating all values in hash_table.
+ * It also may be used for restoring one value by key.
+ */
+struct SWISS(iterator) {
+	/* Current position on table (ID of a current slot) */
+	uint32_t slotpos;
+	/* Version of matras memory for MVCC */
+	struct matras_view view;
+};
+
+/**
+ * Type of functions for memory allocation and deallocation
+ */
+typedef void *(*SWISS(extent_alloc_t))(void *ctx);
+typedef void (*SWISS(extent_free_t))(void *ctx, void *extent);
+
+/**
+ * Special result of swiss_find that means that nothing was found
+ * Must be equal or greater than possible hash table size
+ */
+static const uint32_t SWISS(end) = 0xFFFFFFFF;
+
+/**
+ * @brief Hash table construction. Fills struct swiss members.
+ * @param ht - pointer to a hash table struct
+ * @param extent_size - size of allocating memory blocks
+ * @param extent_alloc_func - memory blocks allocation function
+ * @param extent_free_func - memory blocks allocation function
+ * @param alloc_ctx - argument passed to memory block allocator
+ * @param arg - optional parameter to save for comparing function
+ */
+static inline void
+SWISS(create)(struct SWISS(core) *ht, size_t extent_size,
+	      SWISS(extent_alloc_t) extent_alloc_func,
+	      SWISS(extent_free_t) extent_free_func,
+	      void *alloc_ctx, SWISS_CMP_ARG_TYPE arg)
+{
+	assert(sizeof(struct SWISS(group)) == 64);
+	ht->count = 0;
+	ht->group_count = 0;
+	ht->cover_mask = 0;
+	ht->arg = arg;
+	matras_create(&ht->mtable,
+		      extent_size, sizeof(struct SWISS(group)),
+		      extent_alloc_func, extent_free_func, alloc_ctx);
+}
+
+/**
+ * @brief Hash table destruction. Frees all allocated memory
+ * @param ht - pointer to a hash table struct
+ */
+static inline void
+SWISS(destroy)(struct SWISS(core) *ht)
+{
+	matras_destroy(&ht->mtable);
+}
+
+/**
+ * Number of slots in the table, all positions are less than
+ * that.
+ */
+static inline uint32_t
+SWISS(table_size)(const struct SWISS(core) *ht)
+{
+	return ht->group_count * SWISS_GROUP_SIZE;
+}
+
+/**
+ * Find a group where a value with given hash should be placed.
+ */
+static inline uint32_t
+SWISS(home)(const struct SWISS(core) *ht, uint32_t hash)
+{
+	uint32_t res = hash & ht->cover_mask;
+	if (res >= ht->group_count)
+		res &= ht->cover_mask >> 1;
+	return res;
+}
+
+/** The next group of a probe sequence. */
+static inline uint32_t
+SWISS(next)(const struct SWISS(core) *ht, uint32_t group_id)
+{
+	return group_id + 1 < ht->group_count ? group_id + 1 : 0;
+}
+
+/**
+ * Tag of a value with given hash. Low bits of the hash select
+ * the group, so the tag is taken from mixed bits.
+ */
+static inline uint64_t
+SWISS(tag)(uint32_t hash)
+{
+	return 0x80 | ((hash * 0x9E3779B1U) >> 25);
+}
+
+/** Mask of slots of a group with given tag (high bits). */
+static inline uint64_t
+SWISS(match)(uint64_t ctrl, uint64_t tag)
+{
+	uint64_t x = ctrl ^ (SWISS_CTRL_LOW * tag);
+	/* Set high bits of zero bytes of x, without false positives. */
+	uint64_t low = ~SWISS_CTRL_HIGH & SWISS_CTRL_TAGS;
+	return ~(((x & low) + low) | x | low) & SWISS_CTRL_HIGH;
+}
+
+/** Mask of occupied slots of a group (high bits). */
+static inline uint64_t
+SWISS(full)(uint64_t ctrl)
+{
+	return ctrl & SWISS_CTRL_HIGH;
+}
+
+/** Mask of empty slots of a group (high bits). */
+static inline uint64_t
+SWISS(empty)(uint64_t ctrl)
+{
+	return ~ctrl & SWISS_CTRL_HIGH;
+}
+
+/** Slot number of the lowest bit set in a mask. */
+static inline uint32_t
+SWISS(mask_slot)(uint64_t mask)
+{
+	return __builtin_ctzll(mask) / 8;
+}
+
+static inline uint32_t
+SWISS(overflow)(const struct SWISS(group) *group)
+{
+	return group->ctrl >> SWISS_CTRL_OVERFLOW_SHIFT;
+}
+
+static inline void
+SWISS(overflow_inc)(struct SWISS(group) *group)
+{
+	if (SWISS(overflow)(group) < SWISS_OVERFLOW_MAX)
+		group->ctrl += 1ULL << SWISS_CTRL_OVERFLOW_SHIFT;
+}
+
+static inline void
+SWISS(overflow_dec)(struct SWISS(group) *group)
+{
+	uint32_t overflow = SWISS(overflow)(group);
+	assert(overflow > 0);
+	/* A saturated counter can't be restored. */
+	if (overflow < SWISS_OVERFLOW_MAX)
+		group->ctrl -= 1ULL << SWISS_CTRL_OVERFLOW_SHIFT;
+}
+
+static inline void
+SWISS(set_tag)(struct SWISS(group) *group, uint32_t slot, uint64_t tag)
+{
+	group->ctrl &= ~(0xFFULL << (slot * 8));
+	group->ctrl |= tag << (slot * 8);
+}
+
+static inline struct SWISS(group) *
+SWISS(group_get)(const struct SWISS(core) *ht, uint32_t group_id)
+{
+	return (struct SWISS(group) *)matras_get(&ht->mtable, group_id);
+}
+
+/**
+ * @brief Find a record with given hash and value
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param data - value to find
+ * @return integer ID of found record or swiss_end if nothing found
+ */
+static inline uint32_t
+SWISS(find)(const struct SWISS(core) *ht, uint32_t hash,
+	    SWISS_DATA_TYPE value)
+{
+	if (ht->count == 0)
+		return SWISS(end);
+	uint64_t tag = SWISS(tag)(hash);
+	uint32_t group_id = SWISS(home)(ht, hash);
+	for (uint32_t i = 0; i < ht->group_count; i++) {
+		struct SWISS(group) *group = SWISS(group_get)(ht, group_id);
+		uint64_t match = SWISS(match)(group->ctrl, tag);
+		for (; match != 0; match &= match - 1) {
+			uint32_t slot = SWISS(mask_slot)(match);
+			if (SWISS_EQUAL((group->values[slot]), (value),
+					(ht->arg)))
+				return group_id * SWISS_GROUP_SIZE + slot;
+		}
+		if (SWISS(overflow)(group) == 0)
+			break;
+		group_id = SWISS(next)(ht, group_id);
+	}
+	return SWISS(end);
+}
+
+/**
+ * @brief Find a record with given hash and key
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param data - key to find
+ * @return integer ID of found record or swiss_end if nothing found
+ */
+static inline uint32_t
+SWISS(find_key)(const struct SWISS(core) *ht, uint32_t hash,
+		SWISS_KEY_TYPE key)
+{
+	if (ht->count == 0)
+		return SWISS(end);
+	uint64_t tag = SWISS(tag)(hash);
+	uint32_t group_id = SWISS(home)(ht, hash);
+	for (uint32_t i = 0; i < ht->group_count; i++) {
+		struct SWISS(group) *group = SWISS(group_get)(ht, group_id);
+		uint64_t match = SWISS(match)(group->ctrl, tag);
+		for (; match != 0; match &= match - 1) {
+			uint32_t slot = SWISS(mask_slot)(match);
+			if (SWISS_EQUAL_KEY((group->values[slot]), (key),
+					    (ht->arg)))
+				return group_id * SWISS_GROUP_SIZE + slot;
+		}
+		if (SWISS(overflow)(group) == 0)
+			break;
+		group_id = SWISS(next)(ht, group_id);
+	}
+	return SWISS(end);
+}
+
+/**
+ * Make groups of a probe sequence writable, from the group
+ * with id @a group_id until a group with at least @a count
+ * empty slots in total is met.
+ * @retval id of the last touched group or swiss_end on memory
+ *         error.
+ */
+static inline uint32_t
+SWISS(touch_probe)(struct SWISS(core) *ht, uint32_t group_id,
+		   uint32_t count)
+{
+	uint32_t empty = 0;
+	for (uint32_t i = 0; i < ht->group_count; i++) {
+		struct SWISS(group) *group = (struct SWISS(group) *)
+			matras_touch(&ht->mtable, group_id);
+		if (group == NULL)
+			return SWISS(end);
+		empty += __builtin_popcountll(SWISS(empty)(group->ctrl));
+		if (empty >= count)
+			return group_id;
+		group_id = SWISS(next)(ht, group_id);
+	}
+	assert(false);
+	return SWISS(end);
+}
+
+/**
+ * Place a value to the first empty slot of its probe sequence.
+ * The groups of the sequence must be writable, @sa
+ * swiss_touch_probe().
+ * @return ID of the slot.
+ */
+static inline uint32_t
+SWISS(place)(struct SWISS(core) *ht, uint32_t group_id, uint32_t hash,
+	     SWISS_DATA_TYPE value)
+{
+	for (uint32_t i = 0; i < ht->group_count; i++) {
+		struct SWISS(group) *group = SWISS(group_get)(ht, group_id);
+		uint64_t empty = SWISS(empty)(group->ctrl);
+		if (empty != 0) {
+			uint32_t slot = SWISS(mask_slot)(empty);
+			SWISS(set_tag)(group, slot, SWISS(tag)(hash));
+			group->values[slot] = value;
+			return group_id * SWISS_GROUP_SIZE + slot;
+		}
+		SWISS(overflow_inc)(group);
+		group_id = SWISS(next)(ht, group_id);
+	}
+	assert(false);
+	return SWISS(end);
+}
+
+/**
+ * Clear a slot, the value was placed into it starting from
+ * the group with id @a home_id. The groups from the home one
+ * to the slot must be writable.
+ */
+static inline void
+SWISS(unplace)(struct SWISS(core) *ht, uint32_t home_id, uint32_t slotpos)
+{
+	uint32_t group_id = slotpos / SWISS_GROUP_SIZE;
+	struct SWISS(group) *group = SWISS(group_get)(ht, group_id);
+	SWISS(set_tag)(group, slotpos % SWISS_GROUP_SIZE, 0);
+	for (; home_id != group_id; home_id = SWISS(next)(ht, home_id))
+		SWISS(overflow_dec)(SWISS(group_get)(ht, home_id));
+}
+
+/**
+ * Make groups from the group with id @a home_id to the group
+ * of a slot writable.
+ * @retval 0 on success, -1 on memory error.
+ */
+static inline int
+SWISS(touch_range)(struct SWISS(core) *ht, uint32_t home_id,
+		   uint32_t slotpos)
+{
+	uint32_t group_id = slotpos / SWISS_GROUP_SIZE;
+	while (true) {
+		if (matras_touch(&ht->mtable, home_id) == NULL)
+			return -1;
+		if (home_id == group_id)
+			return 0;
+		home_id = SWISS(next)(ht, home_id);
+	}
+}
+
+/*
+ * Allocate memory and initialize the first group to get ready
+ * for first insertion
+ */
+static inline int
+SWISS(prepare_first_insert)(struct SWISS(core) *ht)
+{
+	assert(ht->count == 0);
+	assert(ht->group_count == 0);
+	assert(ht->mtable.head.block_count == 0);
+	uint32_t group_id;
+	struct SWISS(group) *group = (struct SWISS(group) *)
+		matras_alloc(&ht->mtable, &group_id);
+	if (group == NULL)
+		return -1;
+	assert(group_id == 0);
+	group->ctrl = 0;
+	ht->group_count = 1;
+	ht->cover_mask = 0;
+	return 0;
+}
+
+/**
+ * Check if the table is in the middle of doubling.
+ */
+static inline bool
+SWISS(is_growing)(const struct SWISS(core) *ht)
+{
+	return ht->group_count != ht->cover_mask + 1;
+}
+
+/** A value moved to another group by a split. */
+struct SWISS(mover) {
+	uint32_t slotpos;
+	uint32_t hash;
+	SWISS_DATA_TYPE value;
+};
+
+/**
+ * Append a group to the table and move to it values of the
+ * group it splits.
+ * @retval 0 on success, -1 on memory error, the table is left
+ *         unchanged then.
+ */
+static inline int
+SWISS(grow)(struct SWISS(core) *ht)
+{
+	uint32_t old_group_count = ht->group_count;
+	uint32_t old_cover_mask = ht->cover_mask;
+	uint32_t new_id;
+	struct SWISS(group) *new_group = (struct SWISS(group) *)
+		matras_alloc(&ht->mtable, &new_id);
+	if (new_group == NULL)
+		return -1;
+	assert(new_id == old_group_count);
+	/*
+	 * Values that passed the last group in their probe
+	 * sequences now pass the new group too.
+	 */
+	new_group->ctrl = SWISS(group_get)(ht, new_id - 1)->ctrl &
+			  ~SWISS_CTRL_TAGS;
+	ht->group_count++;
+	if (new_id > ht->cover_mask)
+		ht->cover_mask = (ht->cover_mask << 1) | 1;
+	uint32_t split_id = new_id & (ht->cover_mask >> 1);
+	/*
+	 * Values that move to the new group are the ones of the
+	 * split group probe sequence, that have the new group as
+	 * their home now. Collect them and make writable all
+	 * groups that will be changed, so that the split can't
+	 * fail half way.
+	 */
+	struct SWISS(mover) stack_buf[SWISS_GROUP_SIZE * 4];
+	struct SWISS(mover) *buf = stack_buf;
+	uint32_t buf_capacity = sizeof(stack_buf) / sizeof(stack_buf[0]);
+	uint32_t move_count = 0;
+	uint32_t group_id = split_id;
+	for (uint32_t i = 0; i < ht->group_count; i++) {
+		struct SWISS(group) *group = (struct SWISS(group) *)
+			matras_touch(&ht->mtable, group_id);
+		if (group == NULL)
+			goto fail;
+		uint64_t full = SWISS(full)(group->ctrl);
+		for (; full != 0; full &= full - 1) {
+			uint32_t slot = SWISS(mask_slot)(full);
+			uint32_t value_hash =
+				SWISS_HASH((group->values[slot]), (ht->arg));
+			if (SWISS(home)(ht, value_hash) != new_id)
+				continue;
+			if (move_count == buf_capacity) {
+				buf_capacity *= 2;
+				struct SWISS(mover) *new_buf =
+					(struct SWISS(mover) *)
+					malloc(buf_capacity * sizeof(*buf));
+				if (new_buf == NULL)
+					goto fail;
+				memcpy(new_buf, buf, move_count * sizeof(*buf));
+				if (buf != stack_buf)
+					free(buf);
+				buf = new_buf;
+			}
+			buf[move_count].slotpos =
+				group_id * SWISS_GROUP_SIZE + slot;
+			buf[move_count].hash = value_hash;
+			buf[move_count].value = group->values[slot];
+			move_count++;
+		}
+		if (SWISS(overflow)(group) == 0)
+			break;
+		group_id = SWISS(next)(ht, group_id);
+	}
+	if (move_count > 0 &&
+	    SWISS(touch_probe)(ht, new_id, move_count) == SWISS(end))
+		goto fail;
+	/* Can't fail after this point. */
+	for (uint32_t i = 0; i < move_count; i++)
+		SWISS(unplace)(ht, split_id, buf[i].slotpos);
+	for (uint32_t i = 0; i < move_count; i++)
+		SWISS(place)(ht, new_id, buf[i].hash, buf[i].value);
+	if (buf != stack_buf)
+		free(buf);
+	return 0;
+fail:
+	if (buf != stack_buf)
+		free(buf);
+	ht->group_count = old_group_count;
+	ht->cover_mask = old_cover_mask;
+	matras_dealloc_range(&ht->mtable, 1);
+	return -1;
+}
+
+/**
+ * @brief Insert a record with given hash and value
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to insert
+ * @param data - value to insert
+ * @return integer ID of inserted record or swiss_end if failed
+ */
+static inline uint32_t
+SWISS(insert)(struct SWISS(core) *ht, uint32_t hash, SWISS_DATA_TYPE value)
+{
+	if (ht->group_count == 0)
+		if (SWISS(prepare_first_insert)(ht))
+			return SWISS(end);
+	if (SWISS(is_growing)(ht) ||
+	    ht->count >= ht->group_count * SWISS_GROUP_LOAD) {
+		for (int i = 0; i < SWISS_SPLIT_STEPS; i++) {
+			if (SWISS(grow)(ht) != 0)
+				return SWISS(end);
+			if (!SWISS(is_growing)(ht))
+				break;
+		}
+	}
+	assert(ht->group_count == ht->mtable.head.block_count);
+	uint32_t home_id = SWISS(home)(ht, hash);
+	if (SWISS(touch_probe)(ht, home_id, 1) == SWISS(end))
+		return SWISS(end);
+	ht->count++;
+	return SWISS(place)(ht, home_id, hash, value);
+}
+
+/**
+ * @brief Replace a record with given hash and value
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param data - value to find and replace
+ * @param replaced - pointer to a value that was stored in table before replace
+ * @return integer ID of found record or swiss_end if nothing found
+ */
+static inline uint32_t
+SWISS(replace)(struct SWISS(core) *ht, uint32_t hash,
+	       SWISS_DATA_TYPE value, SWISS_DATA_TYPE *replaced)
+{
+	uint32_t slotpos = SWISS(find)(ht, hash, value);
+	if (slotpos == SWISS(end))
+		return SWISS(end);
+	struct SWISS(group) *group = (struct SWISS(group) *)
+		matras_touch(&ht->mtable, slotpos / SWISS_GROUP_SIZE);
+	if (group == NULL)
+		return SWISS(end);
+	*replaced = group->values[slotpos % SWISS_GROUP_SIZE];
+	group->values[slotpos % SWISS_GROUP_SIZE] = value;
+	return slotpos;
+}
+
+/**
+ * Delete a value with given hash from given position.
+ */
+static inline int
+SWISS(delete_hash)(struct SWISS(core) *ht, uint32_t hash, uint32_t slotpos)
+{
+	uint32_t home_id = SWISS(home)(ht, hash);
+	if (SWISS(touch_range)(ht, home_id, slotpos) != 0)
+		return -1;
+	SWISS(unplace)(ht, home_id, slotpos);
+	ht->count--;
+	return 0;
+}
+
+/**
+ * @brief Get a value from a desired position
+ * @param ht - pointer to a hash table struct
+ * @param slotpos - ID of an record
+ *  ID must be vaild, check it by swiss_pos_valid (asserted).
+ */
+static inline SWISS_DATA_TYPE
+SWISS(get)(struct SWISS(core) *ht, uint32_t slotpos)
+{
+	assert(slotpos < SWISS(table_size)(ht));
+	struct SWISS(group) *group =
+		SWISS(group_get)(ht, slotpos / SWISS_GROUP_SIZE);
+	assert(SWISS(full)(group->ctrl) &
+	       (0x80ULL << (slotpos % SWISS_GROUP_SIZE * 8)));
+	return group->values[slotpos % SWISS_GROUP_SIZE];
+}
+
+/**
+ * @brief Determine if posision holds a value
+ * @param ht - pointer to a hash table struct
+ * @param slotpos - ID of an record
+ *  ID must be in valid range [0, swiss_table_size) (asserted).
+ */
+static inline bool
+SWISS(pos_valid)(struct SWISS(core) *ht, uint32_t slotpos)
+{
+	assert(slotpos < SWISS(table_size)(ht));
+	struct SWISS(group) *group =
+		SWISS(group_get)(ht, slotpos / SWISS_GROUP_SIZE);
+	return (SWISS(full)(group->ctrl) &
+		(0x80ULL << (slotpos % SWISS_GROUP_SIZE * 8))) != 0;
+}
+
+/**
+ * @brief Delete a record from a hash table by given record ID
+ * @param ht - pointer to a hash table struct
+ * @param slotpos - ID of an record. See SWISS(find) for details.
+ * @return 0 if ok, -1 on memory error (only with freezed iterators)
+ */
+static inline int
+SWISS(delete)(struct SWISS(core) *ht, uint32_t slotpos)
+{
+	SWISS_DATA_TYPE value = SWISS(get)(ht, slotpos);
+	return SWISS(delete_hash)(ht, SWISS_HASH((value), (ht->arg)),
+				  slotpos);
+}
+
+/**
+ * @brief Delete a record from a hash table by that value and its hash.
+ * @param ht - pointer to a hash table struct
+ * @param slotpos - ID of an record. See SWISS(find) for details.
+ * @return 0 if ok, 1 if not found or -1 on memory error
+ * (only with freezed iterators)
+ */
+static inline int
+SWISS(delete_value)(struct SWISS(core) *ht, uint32_t hash,
+		    SWISS_DATA_TYPE value)
+{
+	uint32_t slotpos = SWISS(find)(ht, hash, value);
+	if (slotpos == SWISS(end))
+		return 1; /* not found */
+	return SWISS(delete_hash)(ht, hash, slotpos);
+}
+
+/**
+ * @brief Set iterator to the beginning of hash table
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to set
+ */
+static inline void
+SWISS(iterator_begin)(const struct SWISS(core) *ht,
+		      struct SWISS(iterator) *itr)
+{
+	(void)ht;
+	itr->slotpos = 0;
+	matras_head_read_view(&itr->view);
+}
+
+/**
+ * @brief Set iterator to position determined by key
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to set
+ * @param hash - hash to find
+ * @param data - key to find
+ */
+static inline void
+SWISS(iterator_key)(const struct SWISS(core) *ht,
+		    struct SWISS(iterator) *itr,
+		    uint32_t hash, SWISS_KEY_TYPE data)
+{
+	itr->slotpos = SWISS(find_key)(ht, hash, data);
+	matras_head_read_view(&itr->view);
+}
+
+/**
+ * @brief Get the value that iterator currently points to
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to set
+ * @return poiner to the value or NULL if iteration is complete
+ */
+static inline SWISS_DATA_TYPE *
+SWISS(iterator_get_and_next)(const struct SWISS(core) *ht,
+			     struct SWISS(iterator) *itr)
+{
+	const struct matras_view *view;
+	view = matras_is_read_view_created(&itr->view) ?
+	       &itr->view : &ht->mtable.head;
+	uint64_t table_size = (uint64_t)view->block_count * SWISS_GROUP_SIZE;
+	while (itr->slotpos < table_size) {
+		uint32_t group_id = itr->slotpos / SWISS_GROUP_SIZE;
+		uint32_t slot = itr->slotpos % SWISS_GROUP_SIZE;
+		struct SWISS(group) *group = (struct SWISS(group) *)
+			matras_view_get(&ht->mtable, view, group_id);
+		/* Skip empty slots of the group at once. */
+		uint64_t full = SWISS(full)(group->ctrl) >> (slot * 8);
+		if (full == 0) {
+			itr->slotpos = (group_id + 1) * SWISS_GROUP_SIZE;
+			continue;
+		}
+		slot += SWISS(mask_slot)(full);
+		itr->slotpos = group_id * SWISS_GROUP_SIZE + slot + 1;
+		return &group->values[slot];
+	}
+	return NULL;
+}
+
+/**
+ * @brief Freezes state for given iterator. All following hash table modification
+ * will not apply to that iterator iteration. That iterator should be destroyed
+ * with a swiss_iterator_destroy call after usage.
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to freeze
+ */
+static inline void
+SWISS(iterator_freeze)(struct SWISS(core) *ht, struct SWISS(iterator) *itr)
+{
+	assert(!matras_is_read_view_created(&itr->view));
+	matras_create_read_view(&ht->mtable, &itr->view);
+}
+
+/**
+ * @brief Destroy an iterator that was frozen before. Useless for not frozen
+ * iterators.
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to destroy
+ */
+static inline void
+SWISS(iterator_destroy)(struct SWISS(core) *ht, struct SWISS(iterator) *itr)
+{
+	matras_destroy_read_view(&ht->mtable, &itr->view);
+}
+
+/*
+ * Selfcheck of the internal state of hash table. Used only for debugging.
+ * That means that you should not use this function.
+ * If return not zero, something went terribly wrong.
+ */
+static inline int
+SWISS(selfcheck)(const struct SWISS(core) *ht)
+{
+	int res = 0;
+	if (ht->group_count != ht->mtable.head.block_count)
+		res |= 1;
+	if (ht->group_count > 0 &&
+	    (ht->group_count > ht->cover_mask + 1 ||
+	     ht->group_count <= (ht->cover_mask + 1) / 2))
+		res |= 2;
+	uint32_t count = 0;
+	/* Expected values of the overflow counters. */
+	uint32_t *overflow = (uint32_t *)
+		calloc(ht->group_count + 1, sizeof(uint32_t));
+	if (overflow == NULL)
+		return res;
+	for (uint32_t group_id = 0; group_id < ht->group_count; group_id++) {
+		struct SWISS(group) *group = SWISS(group_get)(ht, group_id);
+		uint64_t full = SWISS(full)(group->ctrl);
+		for (; full != 0; full &= full - 1) {
+			uint32_t slot = SWISS(mask_slot)(full);
+			SWISS_DATA_TYPE value = group->values[slot];
+			uint32_t value_hash = SWISS_HASH((value), (ht->arg));
+			uint64_t tag = (group->ctrl >> (slot * 8)) & 0xFF;
+			if (tag != SWISS(tag)(value_hash))
+				res |= 4; /* wrong tag */
+			if (SWISS(find)(ht, value_hash, value) !=
+			    group_id * SWISS_GROUP_SIZE + slot)
+				res |= 8; /* value is not found */
+			uint32_t id = SWISS(home)(ht, value_hash);
+			for (; id != group_id; id = SWISS(next)(ht, id))
+				overflow[id]++;
+			count++;
+		}
+	}
+	if (count != ht->count)
+		res |= 16;
+	for (uint32_t group_id = 0; group_id < ht->group_count; group_id++) {
+		struct SWISS(group) *group = SWISS(group_get)(ht, group_id);
+		uint32_t counter = SWISS(overflow)(group);
+		/* A saturated counter is never decremented. */
+		if (counter < SWISS_OVERFLOW_MAX &&
+		    counter != overflow[group_id])
+			res |= 32; /* wrong overflow counter */
+	}
+	free(overflow);
+	return res;
+}
+
+#undef SWISS
@@ -0,0 +1,128 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+--
+-- Secondary indexes of a big memtx space are built in
+-- background, the space remains writable meanwhile.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+box.begin() for i = 1, 20000 do s:insert{i, i % 100, i} end box.commit()
+
+-- Tuples are checked against the new index in background, too.
+_ = s:replace{30001, 'x', 30001}
+s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+_ = s:replace{30001, 1, 1}
+s:create_index('uk', {parts = {3, 'unsigned'}})
+s:delete{30001}
+-- A unique nullable index doesn't allow equal non-null keys.
+s:create_index('un', {parts = {{2, 'unsigned', is_nullable = true}}})
+s.index.sk == nil and s.index.uk == nil and s.index.un == nil
+
+done = false
+writes = 0
+test_run:cmd("setopt delimiter ';'")
+function writer()
+    while not done do
+        local k = math.random(30000)
+        local op = math.random(3)
+        if op == 1 then
+            s:replace{k, k % 100, k}
+        elseif op == 2 then
+            s:delete{k}
+        else
+            s:update(k, {{'+', 2, 1}})
+        end
+        writes = writes + 1
+        fiber.sleep(0)
+    end
+end;
+function check(index)
+    if index:count() ~= s:count() then
+        return false
+    end
+    for _, t in index:pairs() do
+        local pk_t = s:get(t[1])
+        if pk_t == nil or pk_t[2] ~= t[2] or pk_t[3] ~= t[3] then
+            return false
+        end
+    end
+    return true
+end;
+test_run:cmd("setopt delimiter ''");
+
+f = fiber.create(writer)
+w = writes sk = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false}) w = writes - w
+w > 0
+uk = s:create_index('uk', {parts = {3, 'unsigned'}})
+done = true
+while f:status() ~= 'dead' do fiber.sleep(0.01) end
+check(sk)
+check(uk)
+
+-- A checkpoint may run concurrently with an online build:
+-- tuples must stay frozen until both of them are over.
+sk:drop()
+uk:drop()
+done = false
+f = fiber.create(writer)
+snap = nil
+_ = fiber.create(function() snap = box.snapshot() end)
+sk = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+while snap == nil do fiber.sleep(0.01) end
+snap
+ch = fiber.channel(1)
+_ = fiber.create(function() ch:put(s:create_index('uk', {parts = {3, 'unsigned'}})) end)
+box.snapshot()
+uk = ch:get()
+done = true
+while f:status() ~= 'dead' do fiber.sleep(0.01) end
+check(sk)
+check(uk)
+
+-- Changing the primary key parts rebuilds the non-unique
+-- secondary key along with it. Neither may be built online:
+-- the changes made while one of them yields would be lost
+-- for the other.
+done = false
+f = fiber.create(writer)
+s.index.pk:alter{parts = {3, 'unsigned'}}
+done = true
+while f:status() ~= 'dead' do fiber.sleep(0.01) end
+check(s.index.pk)
+check(s.index.sk)
+check(s.index.uk)
+
+-- Other DDL on the space is rejected while an index is built.
+test_run:cmd("setopt delimiter ';'")
+function ddl_during_build()
+    local ch = fiber.channel(1)
+    fiber.create(function()
+        ch:put(s:create_index('i3', {parts = {3, 'unsigned'}}))
+    end)
+    local errors = {}
+    for _, ddl in ipairs({
+        function() s:create_index('i4', {parts = {2, 'unsigned'},
+                                         unique = false}) end,
+        function() s:truncate() end,
+        function() s:format({{'a', 'unsigned'}}) end,
+        function() s:drop() end,
+    }) do
+        local ok, err = pcall(ddl)
+        table.insert(errors, ok or tostring(err))
+    end
+    return errors, ch:get() ~= nil
+end;
+test_run:cmd("setopt delimiter ''");
+ddl_during_build()
+check(s.index.i3)
+s.index.i4 == nil
+
+test_run:cmd('restart server default')
+s = box.space.test
+s.index.sk:count() == s:count()
+s.index.uk:count() == s:count()
+bad = 0
+for _, t in s:pairs() do if t[1] ~= t[3] then bad = bad + 1 end end
+bad
+s:drop()
@@ -0,0 +1,35 @@
+--
+-- Tuples of a space with full_field_map store offsets of all
+-- fields of the space format, not only of indexed ones.
+--
+format = {{'a', 'unsigned'}, {'b', 'unsigned'}, {'c', 'string'}, {'d', 'unsigned'}, {'e', 'unsigned'}}
+s = box.schema.space.create('full', {format = format, full_field_map = true})
+_ = s:create_index('pk')
+p = box.schema.space.create('plain', {format = format})
+_ = p:create_index('pk')
+s:insert{1, 2, 'three', 4, 5, 6}
+p:insert{1, 2, 'three', 4, 5, 6}
+t = s:get{1}
+t[2], t[3], t[5], t[6], t.c, t.e
+t:totable()
+-- The field map is accounted in bsize.
+p:bsize()
+s:bsize()
+_ = s:create_index('sk', {parts = {4, 'unsigned'}})
+s.index.sk:get{4}
+s:insert{2, 3, 'four', 5, 6}
+s:bsize()
+s:delete{1}
+s:bsize()
+s:update(2, {{'=', 5, 7}})
+s:bsize()
+-- The flag can't be switched on a non-empty space.
+_ = box.space._space:update(s.id, {{'=', 6, {}}})
+s:truncate()
+_ = box.space._space:update(s.id, {{'=', 6, {}}})
+s:insert{1, 2, 'three', 4, 5, 6}
+s:bsize()
+box.schema.space.create('test', {full_field_map = 1})
+t = nil
+s:drop()
+p:drop()
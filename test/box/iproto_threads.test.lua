@@ -0,0 +1,39 @@
+test_run = require('test_run').new()
+net_box = require('net.box')
+
+--
+-- Connections are served by several network threads.
+--
+box.cfg.iproto_threads
+#box.stat.net.thread
+
+test_run:cmd('create server iproto_threads with script = "box/lua/iproto_threads.lua"')
+test_run:cmd("start server iproto_threads")
+test_run:cmd('switch iproto_threads')
+box.cfg.iproto_threads
+_ = box.schema.space.create('test')
+_ = box.space.test:create_index('pk')
+test_run:cmd("switch default")
+
+uri = test_run:eval('iproto_threads', 'return box.cfg.listen')[1]
+conns = {}
+for i = 1, 16 do conns[i] = net_box.connect(uri) end
+for i = 1, 16 do conns[i].space.test:replace{i} end
+for i = 1, 16 do conns[i]:close() end
+
+test_run:cmd('switch iproto_threads')
+box.space.test:count()
+#box.stat.net.thread
+-- The totals are sums of per thread statistics.
+received = 0
+sent = 0
+for _, t in ipairs(box.stat.net.thread) do received = received + t.RECEIVED.total sent = sent + t.SENT.total end
+received == box.stat.net.RECEIVED.total
+sent == box.stat.net.SENT.total
+box.stat.net.RECEIVED.total > 0
+test_run:cmd("switch default")
+
+test_run:cmd("stop server iproto_threads")
+test_run:cmd("cleanup server iproto_threads")
+
+box.cfg{iproto_threads = 2}
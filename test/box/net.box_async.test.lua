@@ -0,0 +1,118 @@
+net = require('net.box')
+fiber = require('fiber')
+test_run = require('test_run').new()
+test_run:cmd("push filter ".."'\\.lua.*:[0-9]+: ' to '.lua...\"]:<line>: '")
+
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+function echo(...) return ... end
+function slow(t) fiber.sleep(t) return t end
+
+c = net.connect(box.cfg.listen)
+
+--
+-- Asynchronous requests return futures.
+--
+f = c:call('echo', {1, 2, 3}, {is_async = true})
+f:wait_result()
+f:is_ready()
+f = c:eval('return ...', {'a', 'b'}, {is_async = true})
+f:wait_result()
+f = c.space.test:insert({1, 'one'}, {is_async = true})
+f:wait_result()
+f = c.space.test:replace({2, 'two'}, {is_async = true})
+f:wait_result()
+f = c.space.test:select({}, {is_async = true})
+f:wait_result()
+f = c.space.test:update(1, {{'=', 2, 'uno'}}, {is_async = true})
+f:wait_result()
+f = c.space.test:delete(2, {is_async = true})
+f:wait_result()
+c.space.test.index.pk:get(1, {is_async = true})
+
+--
+-- Errors are returned, not raised.
+--
+f = c.space.test:insert({1}, {is_async = true})
+res, err = f:wait_result()
+res, err.code == box.error.TUPLE_FOUND
+f = c:call('no_such_function', {}, {is_async = true})
+res, err = f:wait_result()
+res, err.code == box.error.NO_SUCH_PROC
+
+--
+-- Timeout does not cancel the request.
+--
+f = c:call('slow', {0.1}, {is_async = true})
+f:is_ready()
+res, err = f:wait_result(0.001)
+res, err.code == box.error.TIMEOUT
+f:wait_result()
+f:is_ready()
+
+--
+-- Discarded futures never deliver the response.
+--
+f = c:call('slow', {0.01}, {is_async = true})
+f:discard()
+f:is_ready()
+res, err = f:wait_result()
+res, err.message
+
+--
+-- Several fibers may wait for the same future.
+--
+f = c:call('slow', {0.01}, {is_async = true})
+results = {}
+waiters = 0
+for i = 1, 3 do fiber.create(function() results[i] = f:wait_result() waiters = waiters + 1 end) end
+f:wait_result()
+while waiters < 3 do fiber.sleep(0.001) end
+results
+
+--
+-- A single fiber keeps many requests in flight.
+--
+futures = {}
+for i = 1, 1000 do futures[i] = c:call('echo', {i}, {is_async = true}) end
+ok = true
+for i = 1, 1000 do ok = ok and futures[i]:wait_result()[1] == i end
+ok
+
+--
+-- Pipeline encodes a batch of requests in one go.
+--
+batch = {}
+for i = 1, 1000 do batch[i] = {'call', 'echo', {i, i * 2}} end
+batch[1001] = {'eval', 'return 1 + ...', {41}}
+futures = c:pipeline(batch)
+#futures
+ok = true
+for i = 1, 1000 do ok = ok and futures[i]:wait_result()[2] == i * 2 end
+ok
+futures[1001]:wait_result()
+c:pipeline({{'select', 'test'}})
+
+--
+-- A request sent with a stale schema version is resent.
+--
+_ = box.schema.space.create('test2')
+f = c.space.test:select({}, {is_async = true})
+f:wait_result()
+c.space.test2 ~= nil
+
+--
+-- Requests in flight fail when the connection is closed.
+--
+f = c:call('slow', {0.1}, {is_async = true})
+c:close()
+res, err = f:wait_result()
+res, err.message
+f = c:call('echo', {}, {is_async = true})
+res, err = f:wait_result()
+res, err.message
+
+box.space.test2:drop()
+s:drop()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
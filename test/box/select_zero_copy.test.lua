@@ -0,0 +1,39 @@
+net = require('net.box')
+digest = require('digest')
+
+--
+-- Big select replies are written to the socket right from the
+-- tuples, small ones are copied to the output buffer.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 1000 do s:replace{i, string.rep(tostring(i % 10), 2000)} end
+box.schema.user.grant('guest', 'read', 'space', 'test')
+
+function checksum(tuples) local crc = 0 for _, t in ipairs(tuples) do crc = digest.crc32.update(crc, t[2]) end return #tuples .. ':' .. crc end
+
+c = net.connect(box.cfg.listen)
+checksum(c.space.test:select()) == checksum(s:select())
+checksum(c.space.test:select({}, {limit = 10})) == checksum(s:select({}, {limit = 10}))
+
+--
+-- Replies are delivered in order around a pinned one.
+--
+futures = {}
+for i = 1, 20 do futures[i] = c.space.test:select({}, {is_async = true, limit = i % 2 == 0 and 1000 or 1}) end
+ok = true
+for i = 1, 20 do local res = futures[i]:wait_result() ok = ok and #res == (i % 2 == 0 and 1000 or 1) end
+ok
+
+--
+-- Pinned tuples are released if the client goes away.
+--
+c2 = net.connect(box.cfg.listen)
+f = c2.space.test:select({}, {is_async = true})
+c2:close()
+s:truncate()
+s:select()
+
+c:close()
+box.schema.user.revoke('guest', 'read', 'space', 'test')
+s:drop()
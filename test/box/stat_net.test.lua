@@ -20,6 +20,20 @@ box.stat.net.SENT.total > 0
 box.stat.net.RECEIVED.total > 0
 -- box.stat.net.EVENTS.total > 0
 -- box.stat.net.LOCKS.total > 0
+-- inter-thread bus statistics
+stat = box.stat.cbus()
+stat.tx.messages > 0
+stat.tx.messages >= stat.tx.fetches
+stat.tx.wakeups > 0
+-- request latency statistics
+cn.space.tweedledum:insert{1}
+stat = box.stat.latency()
+stat.net.SELECT.count > 0
+stat.net.INSERT.count
+stat.net.INSERT.p50 <= stat.net.INSERT.p99
+stat.net.INSERT.p99 <= stat.net.INSERT.p999
+stat.space.tweedledum.count
+stat.wal.count > 0
 
 space:drop()
 cn:close()
@@ -0,0 +1,30 @@
+--
+-- Bulk build of a tree index sorts tuples by a prefix of the
+-- first key part in several threads.
+--
+box.cfg{memtx_snapshot_threads = 4}
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 100000 do s:insert{i, 50000 - i, 'key' .. (i * 7919 % 100000), i % 10, i % 3 == 0 and box.NULL or i % 100} end
+
+u = s:create_index('u', {parts = {2, 'integer'}})
+str = s:create_index('str', {parts = {3, 'string'}})
+multi = s:create_index('multi', {parts = {4, 'unsigned', 2, 'integer'}})
+nonuniq = s:create_index('nonuniq', {parts = {4, 'unsigned'}, unique = false})
+nullable = s:create_index('nullable', {parts = {{5, 'unsigned', is_nullable = true}}, unique = false})
+
+function is_sorted(index, cmp) local prev = nil local n = 0 for _, t in index:pairs() do if prev ~= nil and not cmp(prev, t) then return false end prev = t n = n + 1 end return n end
+
+is_sorted(u, function(a, b) return a[2] < b[2] end)
+u:min()
+u:max()
+is_sorted(str, function(a, b) return a[3] < b[3] end)
+str:get('key1')[3]
+is_sorted(multi, function(a, b) return a[4] < b[4] or (a[4] == b[4] and a[2] < b[2]) end)
+is_sorted(nonuniq, function(a, b) return a[4] < b[4] or (a[4] == b[4] and a[1] < b[1]) end)
+nonuniq:count(5)
+nullable:count(box.NULL)
+nullable:count(1)
+
+box.cfg{memtx_snapshot_threads = 1}
+s:drop()
@@ -0,0 +1,81 @@
+test_run = require('test_run').new()
+--
+-- TREE indexes with key hints store an order-preserving hint
+-- of the first key part along with each tuple.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk', {hint = true})
+for i = 1, 10 do s:replace{i * 2, -i, tostring(i)} end
+s:select({10}, {iterator = 'GE', limit = 3})
+s:select({10}, {iterator = 'LT', limit = 3})
+s:select({11}, {iterator = 'LE', limit = 1})
+s:get{4}
+s:get{5}
+s.index.pk:min(), s.index.pk:max()
+-- Integer key part: negative values and unsigned values
+-- greater than INT64_MAX share the extreme hints.
+i = s:create_index('i', {parts = {2, 'integer'}, hint = true})
+i:select({-3}, {iterator = 'LE', limit = 2})
+s:replace{100, 9223372036854775807LL, 'x'}
+s:replace{101, -9223372036854775807LL, 'y'}
+s:replace{102, 18446744073709551615ULL, 'z'}
+i:min()
+i:max()
+i:select({9223372036854775807LL}, {iterator = 'GE'})
+s:delete{100}
+s:delete{101}
+s:delete{102}
+-- String key part: hints of strings sharing the first
+-- eight bytes are equal.
+str = s:create_index('str', {parts = {3, 'string'}, unique = false, hint = true})
+s:replace{200, 100, 'abcdefghij'}
+s:replace{201, 101, 'abcdefghi'}
+s:replace{202, 102, 'abcdefgh'}
+str:select({'abcdefgh'}, {iterator = 'GE'})
+str:select({'abcdefghi'})
+str:select({'abcdefghi'}, {iterator = 'LT', limit = 2})
+str:select({'2'}, {iterator = 'REQ'})
+-- Collation: hints are taken from the sort key.
+box.internal.collation.create('hint_ci', 'ICU', 'ru-RU', {strength = 'secondary'})
+c = box.schema.space.create('coll')
+_ = c:create_index('pk', {parts = {{1, 'string', collation = 'hint_ci'}}, hint = true})
+c:replace{'Абв'}
+c:replace{'бук'}
+c:replace{'где'}
+c:replace{'абв'}
+c:select{}
+c:get{'БУК'}
+c:select({'Б'}, {iterator = 'GE'})
+-- Nullable key part: NULL is less than any value.
+n = box.schema.space.create('nullable')
+_ = n:create_index('pk')
+sk = n:create_index('sk', {parts = {{2, 'unsigned', is_nullable = true}}, unique = false, hint = true})
+n:replace{1, box.NULL}
+n:replace{2, 0}
+n:replace{3}
+n:replace{4, 18446744073709551615ULL}
+n:replace{5, 18446744073709551614ULL}
+sk:select{}
+sk:select({box.NULL})
+sk:select({0}, {iterator = 'GT'})
+-- Hints are only supported by TREE indexes.
+s:create_index('h', {type = 'hash', hint = true})
+-- Toggling hints rebuilds the index.
+s.index.pk:alter{hint = false}
+box.space._index:get{s.id, 0}[5].hint
+s.index.pk:select({10}, {iterator = 'GE', limit = 2})
+s.index.pk:alter{hint = true}
+box.space._index:get{s.id, 0}[5].hint
+-- Hinted indexes are built on recovery.
+box.snapshot()
+test_run:cmd('restart server default')
+s = box.space.test
+s.index.pk:select({10}, {iterator = 'GE', limit = 3})
+s.index.i:select({-3}, {iterator = 'LE', limit = 2})
+s.index.str:select({'abcdefgh'}, {iterator = 'GE'})
+box.space.coll:select{}
+box.space.nullable.index.sk:select{}
+s:drop()
+box.space.coll:drop()
+box.space.nullable:drop()
+box.internal.collation.drop('hint_ci')
@@ -0,0 +1,55 @@
+--
+-- Updates that change neither indexed fields nor field sizes
+-- are applied right to the data of the old tuple. The tuple
+-- must still look immutable to its users.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {3, 'string'}, unique = false})
+function gc() collectgarbage() collectgarbage() end
+s:insert{1, 10, 'a', 100, 1.5, 'abc'}
+gc()
+s:update(1, {{'+', 2, 1}, {'-', 4, 50}, {'=', 6, 'xyz'}, {'+', 5, 1}})
+s:get{1}
+-- The field size or type changes.
+s:update(1, {{'+', 2, 1000}})
+gc()
+s:update(1, {{'-', 2, 2000}})
+gc()
+s:update(1, {{'=', 2, 11}, {'=', 6, 'abcd'}})
+gc()
+-- Errors are the same as for a usual update.
+s:update(1, {{'+', 2, 1}, {'|', 2, 4}})
+s:update(1, {{'+', 2, 18446744073709551615ULL}})
+s:update(1, {{'+', 3, 1}})
+s:get{1}
+-- Indexed fields.
+s:update(1, {{'=', 1, 2}})
+gc()
+s:update(1, {{'=', 3, 'b'}})
+s.index.sk:select{'a'}
+s.index.sk:select{'b'}
+-- Rollback.
+gc()
+box.begin() s:update(1, {{'+', 2, 1}, {'^', 4, 3}}) box.rollback()
+s:get{1}
+-- A tuple referenced from Lua is not changed.
+t = s:get{1}
+s:update(1, {{'+', 2, 1}})
+t
+s:get{1}
+t = nil
+-- Rollback doesn't change the update result seen from Lua.
+gc()
+box.begin() t = s:update(1, {{'+', 2, 1}}) box.rollback()
+t
+s:get{1}
+t = nil
+-- on_replace triggers get both the old and the new tuple.
+gc()
+old_new = nil
+f = s:on_replace(function(old, new) old_new = {old[2], new[2]} end)
+s:update(1, {{'+', 2, 1}})
+old_new
+s:on_replace(nil, f)
+s:drop()
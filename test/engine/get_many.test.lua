@@ -0,0 +1,47 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+net = require('net.box')
+
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+sk = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+for i = 1, 10 do s:replace{i, i % 3} end
+
+--
+-- Local batched lookups.
+--
+s:get_many({1, 5, 100, {10}})
+s.index.pk:get_many({})
+sk:get_many({0, 1, 2}, {limit = 2})
+sk:get_many({1, 2}, {limit = 100})
+sk:get_many({1}, {iterator = 'GT'})
+s:get_many({'abc'})
+s:get_many({{1, 2}})
+s:get_many(1)
+box.stat.SELECT_MANY.total > 0
+
+--
+-- The same over the binary protocol, in one request.
+--
+box.schema.user.grant('guest', 'read', 'space', 'test')
+c = net.connect(box.cfg.listen)
+selects = box.stat.SELECT_MANY.total
+c.space.test:get_many({1, 5, 100, {10}})
+c.space.test.index.sk:get_many({0, 1, 2}, {limit = 2})
+c.space.test.index.sk:get_many({1}, {iterator = 'GT'})
+c.space.test:get_many({'abc'})
+box.stat.SELECT_MANY.total - selects
+f = c.space.test:get_many({2, 3}, {is_async = true})
+f:wait_result()
+keys = {}
+for i = 1, 1000 do keys[i] = i end
+res = c.space.test:get_many(keys)
+#res
+n = 0
+for i, tuples in ipairs(res) do n = n + #tuples end
+n
+res[7][1]
+c:close()
+box.schema.user.revoke('guest', 'read', 'space', 'test')
+
+s:drop()
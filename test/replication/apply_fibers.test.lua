@@ -0,0 +1,51 @@
+env = require('test_run')
+test_run = env.new()
+engine = test_run:get_cfg('engine')
+
+--
+-- Applier looks up keys of a batch in several fibers
+-- before applying it.
+--
+box.cfg{replication_apply_fibers = 0}
+box.cfg{replication_apply_fibers = 1000}
+box.cfg.replication_apply_fibers
+
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+test_run:cmd("switch replica")
+box.cfg{replication_apply_fibers = 8}
+box.cfg.replication_apply_fibers
+test_run:cmd("switch default")
+
+for i = 1, 1000 do s:insert{i, i} end
+test_run:cmd("switch replica")
+fiber = require('fiber')
+while box.space.test:count() < 1000 do fiber.sleep(0.01) end
+-- Make the replica read from disk.
+box.snapshot()
+test_run:cmd("switch default")
+
+-- Several rows for the same key in one batch.
+for i = 1, 1000 do s:update(i, {{'+', 2, 1}}) s:update(i, {{'+', 2, 1}}) end
+for i = 1, 1000, 2 do s:delete{i} end
+s:replace{1001, 1}
+test_run:cmd("switch replica")
+while box.space.test:get(1001) == nil do fiber.sleep(0.01) end
+box.space.test:count()
+box.space.test:get(1)
+box.space.test:get(2)
+box.space.test:get(1000)
+box.space.test.index.sk:count(1002)
+box.info.replication[1].upstream.status
+
+-- Cleanup.
+test_run:cmd("switch default")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+s:drop()
+box.schema.user.revoke('guest', 'replication')
@@ -0,0 +1,54 @@
+env = require('test_run')
+test_run = env.new()
+engine = test_run:get_cfg('engine')
+
+--
+-- Relay sends rows in batches, applier applies rows which
+-- have arrived together in one transaction.
+--
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+test_run:cmd("stop server replica")
+
+-- Accumulate rows on the master while the replica is down.
+for i = 1, 10000 do s:insert{i, 'batch test'} end
+
+test_run:cmd("start server replica")
+test_run:cmd("switch replica")
+fiber = require('fiber')
+while box.space.test:count() < 10000 do fiber.sleep(0.01) end
+box.space.test:count()
+box.space.test:get(10000)
+upstream = box.info.replication[1].upstream
+upstream.status
+upstream.rows >= 10000
+upstream.batch >= 1
+upstream.rps >= 0
+
+--
+-- A conflict in the middle of a batch: rows before the
+-- conflicting one must be applied, the applier must stop
+-- on the conflicting row.
+--
+box.cfg{read_only = false}
+_ = box.space.test:insert{10500, 'local'}
+test_run:cmd("switch default")
+for i = 10001, 11000 do s:insert{i, 'batch test'} end
+test_run:cmd("switch replica")
+while box.info.replication[1].upstream.status ~= 'stopped' do fiber.sleep(0.01) end
+box.info.replication[1].upstream.message:match('Duplicate') ~= nil
+box.space.test:count()
+box.space.test:get(10499)
+box.space.test:get(10500)
+box.space.test:get(10501)
+
+-- Cleanup.
+test_run:cmd("switch default")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+s:drop()
+box.schema.user.revoke('guest', 'replication')
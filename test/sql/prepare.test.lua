@@ -0,0 +1,93 @@
+remote = require('net.box')
+
+box.sql.execute('create table test (id primary key, a, b)')
+space = box.space.test
+space:replace{1, 2, '3'}
+space:replace{4, 5, '6'}
+box.schema.user.grant('guest','read,write,execute', 'universe')
+cn = remote.connect(box.cfg.listen)
+
+--
+-- Prepared statements are cached and can be executed by id.
+--
+stat = box.info.sql().cache
+s = cn:prepare('select * from test where id = ?')
+s.stmt_id > 0
+s.bind_count
+s.metadata
+cn:execute(s, {1})
+cn:execute(s, {4})
+-- Execution by text finds the same statement in the cache.
+cn:execute('select * from test where id = ?', {1})
+cn:prepare('select * from test where id = ?').stmt_id == s.stmt_id
+box.info.sql().cache.hit - stat.hit
+box.info.sql().cache.miss - stat.miss
+box.info.sql().cache.stmt_count - stat.stmt_count
+box.info.sql().cache.size > stat.size
+
+-- Statements without result set.
+ins = cn:prepare('insert into test values (?, ?, ?)')
+ins.bind_count
+ins.metadata
+cn:execute(ins, {7, 8, '9'})
+cn:execute(ins, {10, 11, '12'})
+space:select{}
+
+-- Errors.
+cn:prepare('select * from not_existing_table')
+cn:execute({stmt_id = 100500})
+
+--
+-- Schema change recompiles the statement, the id stays valid.
+--
+box.sql.execute('create index test_a on test(a)')
+cn:reload_schema()
+cn:execute(s, {7})
+box.sql.execute('drop table test')
+cn:reload_schema()
+cn:execute(s, {7})
+box.sql.execute('create table test (id primary key, a, b)')
+cn:reload_schema()
+ok, err = pcall(cn.execute, cn, s, {7})
+ok
+err.code == box.error.SQL_STMT_NOT_FOUND
+
+--
+-- box.sql support.
+--
+box.sql.execute('insert into test values (1, 2, 3), (4, 5, 6)')
+p = box.sql.prepare('select a from test order by id')
+p.bind_count
+box.sql.execute(p)
+box.sql.execute(p)
+
+--
+-- Cache size limit.
+--
+box.cfg{sql_cache_size = -1}
+box.cfg{sql_cache_size = 0}
+box.info.sql().cache.stmt_count
+box.info.sql().cache.size
+ok, err = pcall(box.sql.execute, p)
+ok
+err.code == box.error.SQL_STMT_NOT_FOUND
+-- Statements are still executed, but not cached.
+cn:execute('select a from test where id = ?', {4})
+box.info.sql().cache.stmt_count
+-- PREPARE fails if the statement can't be cached.
+ok, err = pcall(cn.prepare, cn, 'select a from test where id = ?')
+ok
+tostring(err)
+ok, err = pcall(box.sql.prepare, 'select a from test where id = ?')
+ok
+tostring(err)
+box.cfg{sql_cache_size = 512}
+ok, err = pcall(cn.prepare, cn, 'select a from test where id = ?')
+ok
+tostring(err)
+box.info.sql().cache.stmt_count
+box.cfg{sql_cache_size = 5 * 1024 * 1024}
+
+cn:close()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
+box.sql.execute('drop table test')
@@ -103,6 +103,54 @@ store_load_test()
 	cout << "memory after destruction = " << quota_used(&q) << endl << endl;
 }
 
+void
+compact_test()
+{
+	cout << "*** " << __func__ << " ***" << endl;
+	struct quota q;
+	quota_init(&q, 100500);
+	srand(time(0));
+	uint32_t error_count = 0;
+	uint32_t fp_rate_too_big = 0;
+	uint32_t table_too_big = 0;
+	for (double p = 0.001; p < 0.5; p *= 1.3) {
+		uint64_t tests = 0;
+		uint64_t false_positive = 0;
+		for (uint32_t count = 10; count <= 1000; count *= 2) {
+			struct bloom bloom;
+			bloom_create_compact(&bloom, count, p, &q);
+			/* Not rounded up to pages: < 64 bits per value. */
+			if (bloom_store_size(&bloom) > count * 8 +
+						       BLOOM_CACHE_LINE)
+				table_too_big++;
+			unordered_set<uint32_t> check;
+			for (uint32_t i = 0; i < count; i++) {
+				uint32_t val = rand() % (count * 10);
+				check.insert(val);
+				bloom_add(&bloom, h(val));
+			}
+			for (uint32_t i = 0; i < count * 10; i++) {
+				bool has = check.find(i) != check.end();
+				bool bloom_possible =
+					bloom_possible_has(&bloom, h(i));
+				tests++;
+				if (has && !bloom_possible)
+					error_count++;
+				if (!has && bloom_possible)
+					false_positive++;
+			}
+			bloom_destroy(&bloom, &q);
+		}
+		double fp_rate = (double)false_positive / tests;
+		if (fp_rate > p)
+			fp_rate_too_big++;
+	}
+	cout << "error_count = " << error_count << endl;
+	cout << "fp_rate_too_big = " << fp_rate_too_big << endl;
+	cout << "table_too_big = " << table_too_big << endl;
+	cout << "memory after destruction = " << quota_used(&q) << endl << endl;
+}
+
 void
 spectrum_test()
 {
@@ -170,5 +218,6 @@ main(void)
 {
 	simple_test();
 	store_load_test();
+	compact_test();
 	spectrum_test();
 }
@@ -171,6 +171,86 @@ test_percentile(void)
 	footer();
 }
 
+static void
+test_permille(void)
+{
+	header();
+
+	size_t n_buckets;
+	int64_t *buckets = gen_buckets(&n_buckets);
+
+	size_t data_len;
+	int64_t *data = gen_rand_data(&data_len);
+
+	int64_t max = -1;
+	for (size_t i = 0; i < data_len; i++) {
+		if (max < data[i])
+			max = data[i];
+	}
+
+	struct histogram *hist = histogram_new(buckets, n_buckets);
+	for (size_t i = 0; i < data_len; i++)
+		histogram_collect(hist, data[i]);
+
+	int64_sort(data, data_len);
+	for (int pml = 5; pml < 1000; pml += 5) {
+		int64_t val = data[data_len * pml / 1000];
+		int64_t expected = max;
+		for (size_t b = 0; b < n_buckets; b++) {
+			if (buckets[b] >= val) {
+				expected = buckets[b];
+				break;
+			}
+		}
+		int64_t result = histogram_permille(hist, pml);
+		fail_if(result != expected);
+	}
+
+	histogram_delete(hist);
+	free(data);
+	free(buckets);
+
+	footer();
+}
+
+static void
+test_merge(void)
+{
+	header();
+
+	size_t n_buckets;
+	int64_t *buckets = gen_buckets(&n_buckets);
+
+	size_t data_len;
+	int64_t *data = gen_rand_data(&data_len);
+
+	struct histogram *hist = histogram_new(buckets, n_buckets);
+	struct histogram *hist1 = histogram_new(buckets, n_buckets);
+	struct histogram *hist2 = histogram_new(buckets, n_buckets);
+	for (size_t i = 0; i < data_len; i++) {
+		histogram_collect(hist, data[i]);
+		histogram_collect(i % 3 == 0 ? hist1 : hist2, data[i]);
+	}
+
+	struct histogram *merged = histogram_new(buckets, n_buckets);
+	histogram_merge(merged, hist1);
+	histogram_merge(merged, hist2);
+
+	for (size_t b = 0; b < n_buckets; b++)
+		fail_if(merged->buckets[b].count != hist->buckets[b].count);
+	fail_if(merged->total != hist->total);
+	fail_if(merged->max != hist->max);
+
+	histogram_delete(merged);
+	histogram_delete(hist2);
+	histogram_delete(hist1);
+	histogram_delete(hist);
+	free(data);
+	free(buckets);
+
+	footer();
+}
+
 int
 main()
 {
@@ -178,4 +258,6 @@ main()
 	test_counts();
 	test_discard();
 	test_percentile();
+	test_permille();
+	test_merge();
 }
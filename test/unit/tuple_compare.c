@@ -0,0 +1,351 @@
+#include "memory.h"
+#include "fiber.h"
+#include "tuple.h"
+#include "tuple_compare.h"
+#include "key_def.h"
+#include "unit.h"
+#include "msgpuck.h"
+#include "trivia/util.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+enum {
+	FIELD_COUNT = 4,
+	TUPLE_COUNT = 200,
+	MAX_PART_COUNT = 3,
+	STR_MAX_LEN = 3,
+	BUF_SIZE = 128,
+};
+
+/** A key part template. */
+struct part_template {
+	uint32_t fieldno;
+	enum field_type type;
+	bool is_nullable;
+};
+
+/** A key definition template. */
+struct schema_template {
+	const char *name;
+	struct part_template parts[MAX_PART_COUNT];
+	uint32_t part_count;
+};
+
+/** A decoded tuple field, used by the reference comparator. */
+struct test_field {
+	bool is_null;
+	int64_t ival;
+	double dval;
+	char sval[STR_MAX_LEN + 1];
+};
+
+struct test_tuple {
+	struct test_field fields[FIELD_COUNT];
+	struct tuple *tuple;
+	/** Raw key made of all key parts of the tuple. */
+	char key[BUF_SIZE];
+};
+
+static const struct schema_template schemas[] = {
+	{"unsigned, unsigned", {{2, FIELD_TYPE_UNSIGNED, false},
+				{1, FIELD_TYPE_UNSIGNED, false}}, 2},
+	{"string, unsigned", {{1, FIELD_TYPE_STRING, false},
+			      {3, FIELD_TYPE_UNSIGNED, false}}, 2},
+	{"integer, unsigned", {{0, FIELD_TYPE_INTEGER, false},
+			       {2, FIELD_TYPE_UNSIGNED, false}}, 2},
+	{"number, unsigned", {{3, FIELD_TYPE_NUMBER, false},
+			      {0, FIELD_TYPE_UNSIGNED, false}}, 2},
+	{"nullable unsigned, unsigned", {{1, FIELD_TYPE_UNSIGNED, true},
+					 {2, FIELD_TYPE_UNSIGNED, false}}, 2},
+	{"sequential nullable unsigned, string",
+	 {{0, FIELD_TYPE_UNSIGNED, true}, {1, FIELD_TYPE_STRING, false}}, 2},
+	{"string, unsigned, unsigned", {{3, FIELD_TYPE_STRING, false},
+					{0, FIELD_TYPE_UNSIGNED, false},
+					{1, FIELD_TYPE_UNSIGNED, false}}, 3},
+	{"sequential integer, unsigned, unsigned",
+	 {{0, FIELD_TYPE_INTEGER, false}, {1, FIELD_TYPE_UNSIGNED, false},
+	  {2, FIELD_TYPE_UNSIGNED, false}}, 3},
+};
+
+static enum field_type
+schema_field_type(const struct schema_template *schema, uint32_t fieldno,
+		  bool *is_nullable)
+{
+	*is_nullable = false;
+	for (uint32_t i = 0; i < schema->part_count; i++) {
+		if (schema->parts[i].fieldno == fieldno) {
+			*is_nullable = schema->parts[i].is_nullable;
+			return schema->parts[i].type;
+		}
+	}
+	return FIELD_TYPE_UNSIGNED;
+}
+
+/** Generate a random field, use small ranges to get ties. */
+static void
+test_field_create(struct test_field *field, enum field_type type,
+		  bool is_nullable)
+{
+	memset(field, 0, sizeof(*field));
+	if (is_nullable && rand() % 4 == 0) {
+		field->is_null = true;
+		return;
+	}
+	switch (type) {
+	case FIELD_TYPE_INTEGER:
+		field->ival = rand() % 7 - 3;
+		break;
+	case FIELD_TYPE_NUMBER:
+		field->ival = rand() % 5;
+		field->dval = field->ival + (rand() % 2 == 0 ? 0.5 : 0);
+		break;
+	case FIELD_TYPE_STRING: {
+		int len = rand() % (STR_MAX_LEN + 1);
+		for (int i = 0; i < len; i++)
+			field->sval[i] = 'a' + rand() % 2;
+		break;
+	}
+	default:
+		field->ival = rand() % 5;
+		break;
+	}
+}
+
+static char *
+test_field_encode(char *data, const struct test_field *field,
+		  enum field_type type)
+{
+	if (field->is_null)
+		return mp_encode_nil(data);
+	switch (type) {
+	case FIELD_TYPE_INTEGER:
+		if (field->ival < 0)
+			return mp_encode_int(data, field->ival);
+		return mp_encode_uint(data, field->ival);
+	case FIELD_TYPE_NUMBER:
+		/* Mix integers and doubles. */
+		if (field->dval == field->ival)
+			return mp_encode_uint(data, field->ival);
+		return mp_encode_double(data, field->dval);
+	case FIELD_TYPE_STRING:
+		return mp_encode_str(data, field->sval, strlen(field->sval));
+	default:
+		return mp_encode_uint(data, field->ival);
+	}
+}
+
+static int
+test_field_compare(const struct test_field *a, const struct test_field *b,
+		   enum field_type type)
+{
+	if (a->is_null || b->is_null)
+		return a->is_null == b->is_null ? 0 : a->is_null ? -1 : 1;
+	switch (type) {
+	case FIELD_TYPE_NUMBER:
+		return a->dval < b->dval ? -1 : a->dval > b->dval;
+	case FIELD_TYPE_STRING:
+		return strcmp(a->sval, b->sval);
+	default:
+		return a->ival < b->ival ? -1 : a->ival > b->ival;
+	}
+}
+
+/** Reference comparator of the first @a part_count parts. */
+static int
+test_tuple_compare(const struct test_tuple *a, const struct test_tuple *b,
+		   const struct schema_template *schema, uint32_t part_count)
+{
+	for (uint32_t i = 0; i < part_count; i++) {
+		const struct part_template *part = &schema->parts[i];
+		int rc = test_field_compare(&a->fields[part->fieldno],
+					    &b->fields[part->fieldno],
+					    part->type);
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
+}
+
+static int
+sign(int rc)
+{
+	return rc < 0 ? -1 : rc > 0;
+}
+
+static struct key_def *
+test_key_def_new(const struct schema_template *schema)
+{
+	struct key_def *def = key_def_new(schema->part_count);
+	fail_if(def == NULL);
+	for (uint32_t i = 0; i < schema->part_count; i++) {
+		const struct part_template *part = &schema->parts[i];
+		key_def_set_part(def, i, part->fieldno, part->type,
+				 part->is_nullable, NULL);
+	}
+	return def;
+}
+
+static struct test_tuple *
+test_tuples_new(const struct schema_template *schema,
+		struct tuple_format *format)
+{
+	struct test_tuple *tuples = calloc(TUPLE_COUNT, sizeof(*tuples));
+	fail_if(tuples == NULL);
+	char data[BUF_SIZE];
+	for (int i = 0; i < TUPLE_COUNT; i++) {
+		struct test_tuple *t = &tuples[i];
+		char *end = mp_encode_array(data, FIELD_COUNT);
+		for (uint32_t fieldno = 0; fieldno < FIELD_COUNT; fieldno++) {
+			bool is_nullable;
+			enum field_type type =
+				schema_field_type(schema, fieldno,
+						  &is_nullable);
+			test_field_create(&t->fields[fieldno], type,
+					  is_nullable);
+			end = test_field_encode(end, &t->fields[fieldno],
+						type);
+		}
+		t->tuple = tuple_new(format, data, end);
+		fail_if(t->tuple == NULL);
+		tuple_ref(t->tuple);
+		char *key_end = t->key;
+		for (uint32_t k = 0; k < schema->part_count; k++) {
+			const struct part_template *part = &schema->parts[k];
+			key_end = test_field_encode(key_end,
+						    &t->fields[part->fieldno],
+						    part->type);
+		}
+	}
+	return tuples;
+}
+
+static void
+test_tuples_delete(struct test_tuple *tuples)
+{
+	for (int i = 0; i < TUPLE_COUNT; i++)
+		tuple_unref(tuples[i].tuple);
+	free(tuples);
+}
+
+static void
+test_schema(const struct schema_template *schema)
+{
+	struct key_def *def = test_key_def_new(schema);
+	struct tuple_format *format = box_tuple_format_new(&def, 1);
+	fail_if(format == NULL);
+	struct test_tuple *tuples = test_tuples_new(schema, format);
+
+	int compare_errors = 0;
+	int compare_with_key_errors = 0;
+	for (int i = 0; i < TUPLE_COUNT; i++) {
+		for (int j = 0; j < TUPLE_COUNT; j++) {
+			struct test_tuple *a = &tuples[i];
+			struct test_tuple *b = &tuples[j];
+			int expected = test_tuple_compare(a, b, schema,
+							  schema->part_count);
+			int rc = tuple_compare(a->tuple, b->tuple, def);
+			if (sign(rc) != sign(expected))
+				compare_errors++;
+			for (uint32_t k = 1; k <= schema->part_count; k++) {
+				expected = test_tuple_compare(a, b, schema, k);
+				rc = tuple_compare_with_key(a->tuple, b->key,
+							    k, def);
+				if (sign(rc) != sign(expected))
+					compare_with_key_errors++;
+			}
+		}
+	}
+	is(compare_errors, 0, "%s: tuple_compare", schema->name);
+	is(compare_with_key_errors, 0, "%s: tuple_compare_with_key",
+	   schema->name);
+
+	test_tuples_delete(tuples);
+	tuple_format_unref(format);
+	box_key_def_delete(def);
+}
+
+static double
+clock_monotonic(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Print throughput of tuple_compare() and
+ * tuple_compare_with_key() for each schema.
+ */
+static void
+bench_schema(const struct schema_template *schema, int iterations)
+{
+	struct key_def *def = test_key_def_new(schema);
+	struct tuple_format *format = box_tuple_format_new(&def, 1);
+	fail_if(format == NULL);
+	struct test_tuple *tuples = test_tuples_new(schema, format);
+
+	int64_t count = 0;
+	int64_t sum = 0;
+	double start = clock_monotonic();
+	for (int n = 0; n < iterations; n++) {
+		for (int i = 0; i < TUPLE_COUNT; i++) {
+			for (int j = 0; j < TUPLE_COUNT; j++) {
+				sum += tuple_compare(tuples[i].tuple,
+						     tuples[j].tuple, def);
+				count++;
+			}
+		}
+	}
+	double compare_time = clock_monotonic() - start;
+
+	start = clock_monotonic();
+	for (int n = 0; n < iterations; n++) {
+		for (int i = 0; i < TUPLE_COUNT; i++) {
+			for (int j = 0; j < TUPLE_COUNT; j++) {
+				sum += tuple_compare_with_key(tuples[i].tuple,
+						tuples[j].key,
+						schema->part_count, def);
+			}
+		}
+	}
+	double compare_with_key_time = clock_monotonic() - start;
+
+	printf("%-40s compare: %6.1f Mops/s, with key: %6.1f Mops/s "
+	       "(checksum %lld)\n", schema->name,
+	       count / compare_time / 1e6,
+	       count / compare_with_key_time / 1e6, (long long)sum);
+
+	test_tuples_delete(tuples);
+	tuple_format_unref(format);
+	box_key_def_delete(def);
+}
+
+int
+main(int argc, char **argv)
+{
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	tuple_init(NULL);
+	srand(1);
+
+	int schema_count = sizeof(schemas) / sizeof(schemas[0]);
+	if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+		int iterations = argc > 2 ? atoi(argv[2]) : 100;
+		for (int i = 0; i < schema_count; i++)
+			bench_schema(&schemas[i], iterations);
+	} else {
+		header();
+		plan(2 * schema_count);
+		for (int i = 0; i < schema_count; i++)
+			test_schema(&schemas[i]);
+		footer();
+		check_plan();
+	}
+
+	tuple_free();
+	fiber_free();
+	memory_free();
+	return 0;
+}
@@ -34,6 +34,7 @@ test_basic()
 
 	struct vy_run_env run_env;
 	vy_run_env_create(&run_env);
+	vy_run_env_set_page_cache(&run_env, QUOTA);
 
 	struct vy_cache_env cache_env;
 	vy_cache_env_create(&cache_env, slab_cache, QUOTA);
@@ -47,7 +48,8 @@ test_basic()
 	vy_cache_create(&cache, &cache_env, key_def);
 
 	struct tuple_format *format = tuple_format_new(&vy_tuple_format_vtab,
-						       &key_def, 1, 0, NULL, 0);
+						       &key_def, 1, 0, NULL, 0,
+						       false);
 	isnt(format, NULL, "tuple_format_new is not NULL");
 	tuple_format_ref(format);
 
@@ -165,7 +167,7 @@ test_basic()
 
 	rc = vy_run_write(run, dir_name, 0, pk->id,
 			  write_stream, 4096, pk->cmp_def, pk->key_def,
-			  100500, 0.1);
+			  100500, 0.1, NULL);
 	is(rc, 0, "vy_run_write");
 
 	write_stream->iface->close(write_stream);
@@ -202,7 +204,7 @@ test_basic()
 
 	rc = vy_run_write(run, dir_name, 0, pk->id,
 			  write_stream, 4096, pk->cmp_def, pk->key_def,
-			  100500, 0.1);
+			  100500, 0.1, NULL);
 	is(rc, 0, "vy_run_write");
 
 	write_stream->iface->close(write_stream);
@@ -0,0 +1,126 @@
+#include <assert.h>
+#include <stdbool.h>
+
+#include "memory.h"
+#include "fiber.h"
+#include "unit.h"
+#include "vy_quota.h"
+
+enum {
+	WRITER_COUNT = 5,
+	WRITE_COUNT = 10,
+	WRITE_SIZE = 1000,
+	DUMP_BANDWIDTH = 100000,
+};
+
+static void
+quota_exceeded_cb(struct vy_quota *quota)
+{
+	(void)quota;
+}
+
+static ev_tstamp
+quota_throttled_cb(struct vy_quota *quota, ev_tstamp timeout)
+{
+	(void)quota;
+	(void)timeout;
+	return 0;
+}
+
+static void
+quota_released_cb(struct vy_quota *quota)
+{
+	(void)quota;
+}
+
+static void
+quota_create(struct vy_quota *quota, size_t used)
+{
+	vy_quota_init(quota, quota_exceeded_cb, quota_throttled_cb,
+		      quota_released_cb);
+	vy_quota_set_limit(quota, 2000);
+	vy_quota_set_watermark(quota, 1000);
+	vy_quota_force_use(quota, used);
+}
+
+static int
+writer_f(va_list ap)
+{
+	struct vy_quota *quota = va_arg(ap, struct vy_quota *);
+	for (int i = 0; i < WRITE_COUNT; i++) {
+		double delay = vy_quota_delay(quota, WRITE_SIZE,
+					      DUMP_BANDWIDTH,
+					      ev_monotonic_now(loop()));
+		fiber_sleep(delay);
+	}
+	return 0;
+}
+
+static void
+test_total_rate(void)
+{
+	header();
+
+	/* Halfway between the watermark and the limit. */
+	struct vy_quota quota;
+	quota_create(&quota, 1500);
+
+	struct fiber *writers[WRITER_COUNT];
+	double start = ev_monotonic_now(loop());
+	for (int i = 0; i < WRITER_COUNT; i++) {
+		writers[i] = fiber_new("writer", writer_f);
+		assert(writers[i] != NULL);
+		fiber_set_joinable(writers[i], true);
+		fiber_start(writers[i], &quota);
+	}
+	for (int i = 0; i < WRITER_COUNT; i++)
+		fiber_join(writers[i]);
+	double elapsed = ev_monotonic_now(loop()) - start;
+
+	/* The rate equals the dump bandwidth here. */
+	double min_elapsed = (double)WRITER_COUNT * WRITE_COUNT *
+			     WRITE_SIZE / DUMP_BANDWIDTH;
+	ok(elapsed >= min_elapsed * 0.9,
+	   "total rate of %d writers is limited", WRITER_COUNT);
+
+	footer();
+}
+
+static void
+test_delay_max(void)
+{
+	header();
+
+	/* Close to the limit, the rate is almost zero. */
+	struct vy_quota quota;
+	quota_create(&quota, 1999);
+	double delay = vy_quota_delay(&quota, WRITE_SIZE, DUMP_BANDWIDTH,
+				      ev_monotonic_now(loop()));
+	ok(delay == VY_QUOTA_DELAY_MAX, "delay is capped");
+
+	footer();
+}
+
+static int
+main_f(va_list ap)
+{
+	(void)ap;
+	test_total_rate();
+	test_delay_max();
+	ev_break(loop(), EVBREAK_ALL);
+	return 0;
+}
+
+int
+main()
+{
+	plan(2);
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	struct fiber *f = fiber_new("main", main_f);
+	fiber_wakeup(f);
+	ev_run(loop(), 0);
+	fiber_free();
+	memory_free();
+	return check_plan();
+}
@@ -0,0 +1,93 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+--
+-- Secondary indexes of a non-empty vinyl space are built from
+-- the primary index, the space remains writable meanwhile.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+for i = 1, 100 do s:replace{i, i % 10, i} end
+box.snapshot()
+for i = 51, 150 do s:replace{i, i % 10, i} end
+for i = 141, 150 do s:delete{i} end
+
+-- Tuples are checked against the new index.
+_ = s:replace{1000, 'x', 1000}
+s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+s:delete{1000}
+s:create_index('uk', {parts = {2, 'unsigned'}})
+s.index.sk == nil and s.index.uk == nil
+
+sk = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+uk = s:create_index('uk', {parts = {3, 'unsigned'}})
+sk:count()
+uk:count()
+sk:select(5, {limit = 3})
+uk:get(77)
+s:drop()
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+for i = 1, 1000 do s:replace{i, i % 10} end
+box.snapshot()
+
+done = false
+test_run:cmd("setopt delimiter ';'")
+function writer()
+    while not done do
+        local k = math.random(1000)
+        if math.random(2) == 1 then
+            pcall(s.replace, s, {k, math.random(10)})
+        else
+            pcall(s.delete, s, {k})
+        end
+        fiber.sleep(0)
+    end
+end;
+function check(index)
+    local count = 0
+    for v = 0, 10 do
+        for _, t in index:pairs(v) do
+            if t[2] ~= v then
+                return false
+            end
+            count = count + 1
+        end
+    end
+    return count == s:count()
+end;
+test_run:cmd("setopt delimiter ''");
+
+f = fiber.create(writer)
+sk = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+done = true
+while f:status() ~= 'dead' do fiber.sleep(0.01) end
+check(sk)
+
+-- Other DDL on the space is rejected while an index is built.
+test_run:cmd("setopt delimiter ';'")
+function ddl_during_build()
+    local ch = fiber.channel(1)
+    fiber.create(function()
+        ch:put(s:create_index('i3', {parts = {2, 'unsigned'},
+                                     unique = false}))
+    end)
+    local errors = {}
+    for _, ddl in ipairs({
+        function() s:create_index('i4', {parts = {2, 'unsigned'},
+                                         unique = false}) end,
+        function() s:truncate() end,
+        function() s:format({{'a', 'unsigned'}}) end,
+        function() s:drop() end,
+    }) do
+        local ok, err = pcall(ddl)
+        table.insert(errors, ok or tostring(err))
+    end
+    return errors, ch:get() ~= nil
+end;
+test_run:cmd("setopt delimiter ''");
+ddl_during_build()
+check(s.index.i3)
+s.index.i4 == nil
+s:drop()
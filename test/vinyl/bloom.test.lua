@@ -48,3 +48,30 @@ new_reflects() > 980
 new_seeks() < 20
 
 s:drop()
+
+-- Bloom filter is used for lookups by a key prefix.
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {parts = {1, 'unsigned', 2, 'unsigned'}})
+
+for i = 1,1000 do s:replace{i, i} end
+box.snapshot()
+_ = new_reflects()
+_ = new_seeks()
+
+for i = 1,1000 do s:select{i} end
+new_reflects() == 0
+new_seeks() == 1000
+
+for i = 1001,2000 do s:select{i} end
+new_reflects() > 980
+new_seeks() < 20
+
+s:drop()
+
+-- Page bloom filters are accounted in box.info.vinyl().
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 256})
+for i = 1,1000 do s:replace{i} end
+box.snapshot()
+box.info.vinyl().memory.page_bloom > 0
+s:drop()
@@ -12,8 +12,8 @@ space = box.schema.space.create('test', { engine = 'vinyl' })
 index = space:create_index('primary', {type = 'hash'})
 space:drop()
 
--- creation of a new index and altering the definition of an existing
--- index are unsupported for non-empty spaces
+-- altering the definition of an existing index is unsupported for
+-- non-empty spaces
 space = box.schema.space.create('test', { engine = 'vinyl' })
 index = space:create_index('primary')
 space:insert({1})
@@ -36,14 +36,12 @@ space:drop()
 space = box.schema.space.create('test', { engine = 'vinyl' })
 index = space:create_index('primary')
 space:insert({1, 2})
-index2 = space:create_index('secondary', { parts = {2, 'unsigned'} })
 space.index.primary:alter({parts = {1, 'unsigned', 2, 'unsigned'}})
 #box.space._index:select({space.id})
 box.space._index:get{space.id, 0}[6]
 space:delete({1})
 
 -- must fail because vy_mems have data
-index2 = space:create_index('secondary', { parts = {2, 'unsigned'} })
 space.index.primary:alter({parts = {1, 'unsigned', 2, 'unsigned'}})
 box.snapshot()
 while space.index.primary:info().rows ~= 0 do fiber.sleep(0.01) end
@@ -67,7 +65,6 @@ space:delete({1})
 box.snapshot()
 while space.index.primary:info().run_count ~= 2 do fiber.sleep(0.01) end
 -- must fail because vy_runs have data
-index2 = space:create_index('secondary', { parts = {2, 'unsigned'} })
 space.index.primary:alter({parts = {1, 'unsigned', 2, 'unsigned'}})
 
 -- After compaction the REPLACE + DELETE + DELETE = nothing, so
@@ -441,3 +441,37 @@ while wait_replace do fiber.sleep(0.01) end
 state, value = gen(param, state)
 value
 s:drop()
+
+--
+-- Compaction split into parts.
+--
+errinj.set('ERRINJ_VY_COMPACT_PART_SIZE', 1)
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk')
+for i = 1, 100 do s:replace{i, string.rep('x', 100)} end
+box.snapshot()
+for i = 1, 100, 2 do s:replace{i, string.rep('y', 100)} end
+box.snapshot()
+while pk:info().disk.compact.count < 1 do fiber.sleep(0.01) end
+-- Each part writes a run of its own.
+pk:info().run_count
+pk:info().range_count
+s:count()
+s:get(1)[2] == string.rep('y', 100)
+s:get(2)[2] == string.rep('x', 100)
+
+-- If a part fails, runs written by the other parts are discarded.
+errinj.set('ERRINJ_VY_COMPACT_PART_FAIL', 1)
+for i = 2, 100, 2 do s:replace{i, string.rep('z', 100)} end
+box.snapshot()
+while not test_run:grep_log('default', 'vinyl compaction part') do fiber.sleep(0.01) end
+pk:info().disk.compact.count
+pk:info().run_count
+errinj.set('ERRINJ_VY_COMPACT_PART_FAIL', -1)
+while pk:info().disk.compact.count < 2 do fiber.sleep(0.01) end
+pk:info().run_count
+s:count()
+s:get(1)[2] == string.rep('y', 100)
+s:get(2)[2] == string.rep('z', 100)
+s:drop()
+errinj.set('ERRINJ_VY_COMPACT_PART_SIZE', -1)
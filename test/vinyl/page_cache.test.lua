@@ -0,0 +1,50 @@
+test_run = require('test_run').new()
+
+--
+-- Decompressed pages are shared by all run iterators.
+--
+box.cfg.vinyl_page_cache
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 64 * 1024})
+for i = 1, 1000 do s:replace{i} end
+box.snapshot()
+
+function page_cache() return s.index.pk:info().disk.iterator.page_cache end
+for i = 1, 500 do s:get{i} end
+page_cache().miss <= 2
+page_cache().hit >= 498
+stat = box.info.vinyl().performance.page_cache
+stat.count > 0
+stat.used > 0
+stat.limit == box.cfg.vinyl_page_cache
+
+-- Shrinking the cache evicts pages.
+box.cfg{vinyl_page_cache = 0}
+stat = box.info.vinyl().performance.page_cache
+stat.count
+stat.used
+stat.evict > 0
+miss = page_cache().miss
+hit = page_cache().hit
+for i = 501, 600 do s:get{i} end
+page_cache().miss - miss
+page_cache().hit - hit
+box.info.vinyl().performance.page_cache.count
+
+box.cfg{vinyl_page_cache = -1}
+box.cfg{vinyl_page_cache = 64 * 1024 * 1024}
+
+s:drop()
+
+-- Pages of a deleted run are removed from the cache.
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 64 * 1024})
+for i = 1, 1000 do s:replace{i} end
+box.snapshot()
+for i = 1, 500 do s:get{i} end
+box.info.vinyl().performance.page_cache.count > 0
+s:drop()
+stat = box.info.vinyl().performance.page_cache
+stat.count
+stat.used
@@ -0,0 +1,48 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+digest = require('digest')
+
+--
+-- Dump and compaction write rate limits.
+--
+box.cfg.vinyl_dump_rate_limit
+box.cfg.vinyl_compact_rate_limit
+stat = box.info.vinyl().performance
+stat.dump_rate_limit
+stat.compact_rate_limit
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+for i = 1, 256 do s:replace{i, digest.urandom(1000)} end
+
+-- 256 KB at 1 MB/s.
+box.cfg{vinyl_dump_rate_limit = 1}
+box.info.vinyl().performance.dump_rate_limit
+t = fiber.time()
+box.snapshot()
+fiber.time() - t >= 0.2
+box.cfg{vinyl_dump_rate_limit = 0}
+box.info.vinyl().performance.dump_rate_limit
+
+box.cfg{vinyl_compact_rate_limit = 2}
+box.info.vinyl().performance.compact_rate_limit
+box.cfg{vinyl_compact_rate_limit = 0}
+box.info.vinyl().performance.compact_rate_limit
+
+box.cfg{vinyl_dump_rate_limit = -1}
+box.cfg{vinyl_compact_rate_limit = -1}
+box.cfg{vinyl_wal_latency_target = -1}
+
+--
+-- Compaction is slowed down while WAL commit latency
+-- exceeds the target.
+--
+box.cfg{vinyl_wal_latency_target = 0.000001}
+for i = 1, 30 do s:replace{i} fiber.sleep(0.05) end
+box.info.vinyl().performance.compact_rate_limit > 0
+box.cfg{vinyl_wal_latency_target = 0}
+box.cfg{vinyl_compact_rate_limit = 1000}
+box.cfg{vinyl_compact_rate_limit = 0}
+box.info.vinyl().performance.compact_rate_limit
+
+s:drop()
@@ -0,0 +1,41 @@
+env = require('test_run').new()
+fiber = require('fiber')
+--
+-- WAL group commit: transactions committed within
+-- wal_group_commit_delay are written to disk at once.
+--
+box.cfg{wal_group_commit_delay = -1}
+box.cfg{wal_group_commit_size = -1}
+box.cfg.wal_group_commit_delay
+box.cfg.wal_group_commit_size
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+
+stat = box.stat.wal()
+stat.batch.max >= 1
+stat.latency.max > 0
+
+box.cfg{wal_group_commit_delay = 0.05}
+writes = box.stat.wal().writes
+ch = fiber.channel(100)
+for i = 1, 100 do fiber.create(function() s:insert{i} ch:put(true) end) end
+for i = 1, 100 do ch:get() end
+s:count()
+-- 100 transactions took far fewer than 100 writes.
+box.stat.wal().writes - writes < 100
+box.stat.wal().batch.max > 1
+
+-- A batch is flushed once it reaches the size limit.
+box.cfg{wal_group_commit_delay = 100, wal_group_commit_size = 1}
+s:insert{101}
+
+-- Checkpoint does not wait for the batching window.
+box.cfg{wal_group_commit_size = 1024 * 1024}
+_ = fiber.create(function() s:insert{102} end)
+box.snapshot()
+s:get(102)
+
+box.cfg{wal_group_commit_delay = 0}
+s:insert{103}
+s:drop()
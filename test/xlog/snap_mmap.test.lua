@@ -0,0 +1,26 @@
+env = require('test_run').new()
+digest = require('digest')
+--
+-- Snapshot is read from a memory mapped file on recovery.
+-- Check small rows and rows bigger than a read-ahead block.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {2, 'string'}})
+for i = 1, 1000 do s:insert{i, string.rep('x', i % 100) .. i} end
+for i = 1001, 1010 do s:insert{i, digest.urandom(100000)} end
+crc = 0
+for _, t in s:pairs() do crc = digest.crc32.update(crc, t[2]) end
+_ = box.space._schema:replace{'test_crc', crc}
+box.snapshot()
+env:cmd('restart server default')
+digest = require('digest')
+s = box.space.test
+s:count()
+s.index.sk:count()
+s:get(500)
+crc2 = 0
+for _, t in s:pairs() do crc2 = digest.crc32.update(crc2, t[2]) end
+crc2 == box.space._schema:get('test_crc')[2]
+_ = box.space._schema:delete('test_crc')
+s:drop()
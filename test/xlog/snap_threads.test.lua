@@ -0,0 +1,26 @@
+env = require('test_run').new()
+
+--
+-- Snapshot written by several threads. It is also read
+-- in batches by a separate thread on recovery.
+--
+box.cfg{memtx_snapshot_threads = 0}
+box.cfg{memtx_snapshot_threads = 1001}
+box.cfg.memtx_snapshot_threads
+box.cfg{memtx_snapshot_threads = 4}
+box.cfg.memtx_snapshot_threads
+
+for i = 1, 8 do s = box.schema.space.create('test' .. i) s:create_index('pk') s:create_index('sk', {parts = {2, 'unsigned'}}) s:create_index('hk', {type = 'hash', parts = {2, 'unsigned'}}) end
+for i = 1, 8 do for j = 1, 5000 do box.space['test' .. i]:insert{j, i * j} end end
+box.snapshot()
+
+env:cmd('restart server default')
+
+cnt = 0
+for i = 1, 8 do cnt = cnt + box.space['test' .. i].index.sk:count() end
+cnt
+box.space.test8:get(5000)
+box.space.test8.index.sk:get(40000)
+box.space.test8.index.hk:get(40000)
+
+for i = 1, 8 do box.space['test' .. i]:drop() end